@@ -25,6 +25,7 @@ static AtlrInstance instance;
 static AtlrDevice device;
 static AtlrSingleRecordCommandContext commandContext;
 static AtlrBuffer storageBuffers[3];
+static float* hostVecs[3];
 static AtlrDescriptorSetLayout descriptorSetLayout;
 static AtlrDescriptorPool descriptorPool;
 static VkDescriptorSet descriptorSet;
@@ -45,13 +46,36 @@ static AtlrU8 initStorageBuffers()
       usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     else
       usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    
-    if (!atlrInitBuffer(storageBuffer, size, usage, memoryProperties, &device))
+
+    // the vectors live in host memory that the compute shader reads and writes directly
+    hostVecs[i] = NULL;
+    if (device.features.externalMemoryHost)
+    {
+      AtlrU64 importSize = size;
+      hostVecs[i] = atlrAllocHostImportMemory(&importSize, &device);
+      if (!hostVecs[i])
+      {
+	ATLR_ERROR_MSG("atlrAllocHostImportMemory returned NULL.");
+	return 0;
+      }
+      if (!atlrInitHostImportBuffer(storageBuffer, hostVecs[i], size, usage, &device))
+      {
+	ATLR_ERROR_MSG("atlrInitHostImportBuffer returned 0.");
+	return 0;
+      }
+    }
+    else if (!atlrInitBuffer(storageBuffer, size, usage, memoryProperties, &device))
     {
       ATLR_ERROR_MSG("atlrInitBuffer returned 0.");
       return 0;
     }
   }
+  if (device.features.externalMemoryHost)
+    atlrLog(ATLR_LOG_INFO, "The storage buffers are imported host memory with an alignment of %llu bytes.",
+	    (unsigned long long)atlrGetHostImportAlignment(&device));
+  else
+    atlrLog(ATLR_LOG_INFO, "The storage buffers are %s.",
+	    storageBuffers[0].isDirect ? "accessed in place by the host" : "staged through host memory");
 
   return 1;
 }
@@ -59,7 +83,11 @@ static AtlrU8 initStorageBuffers()
 static void deinitStorageBuffers()
 {
   for (AtlrU8 i = 0; i < 3; i++)
+  {
     atlrDeinitBuffer(storageBuffers + i);
+    if (hostVecs[i])
+      atlrAlignedFree(hostVecs[i]);
+  }
 }
 
 static AtlrU8 initDescriptor()
@@ -134,7 +162,7 @@ static AtlrU8 initAddVectors()
 {
   atlrLog(ATLR_LOG_INFO, "Starting 'Adding Vectors' demo ...");
 
-  if (!atlrInitInstanceHostHeadless(&instance, "Adding Vectors Demo"))
+  if (!atlrInitInstanceHostHeadless(&instance, "Adding Vectors Demo", NULL))
   {
     ATLR_ERROR_MSG("atlrInitHostGLFW returned 0.");
     return 0;
@@ -150,6 +178,10 @@ static AtlrU8 initAddVectors()
 			 ATLR_DEVICE_CRITERION_INTEGRATED_GPU_PHYSICAL_DEVICE,
 			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
 			 10);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_EXTERNAL_MEMORY_HOST,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 5);
   if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
   {
     ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
@@ -207,9 +239,14 @@ int main()
   }
 
   float result[VECTOR_DIM];
-  float inputVecs[2][VECTOR_DIM];
+  float localVecs[2][VECTOR_DIM];
   const AtlrU64 size = sizeof(float) * VECTOR_DIM;
 
+  // imported vectors are generated in place, so there is nothing to stage
+  float* inputVecs[2];
+  for (AtlrU8 i = 0; i < 2; i++)
+    inputVecs[i] = storageBuffers[i].isImported ? hostVecs[i] : localVecs[i];
+
   unsigned int seed;
   char choice;
 
@@ -227,7 +264,7 @@ int main()
       inputVecs[1][i] = (float)rand() / (float)RAND_MAX;
     }
 
-    for (AtlrU8 i = 0; i < 2; i++)
+    for (AtlrU8 i = 0; i < 2 && !storageBuffers[i].isImported; i++)
     {
       if (!atlrStageBuffer(storageBuffers + i, 0, size, inputVecs[i], &commandContext))
       {
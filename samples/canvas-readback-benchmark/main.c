@@ -0,0 +1,235 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "../../src/antler.h"
+#include "../../src/offscreen-canvas.h"
+
+// Every frame draws one triangle, so the cost per frame is dominated by getting the pixels back to the host.
+#define FRAME_COUNT 256
+#define SLOT_COUNT 4
+
+static AtlrInstance instance;
+static AtlrDevice device;
+static AtlrOffscreenCanvas canvas;
+static AtlrPipeline pipeline;
+
+// what the callback gathers from the delivered frames
+typedef struct _ReadbackStats
+{
+  AtlrU64 nextIndex;
+  AtlrU64 outOfOrderCount;
+  AtlrU64 checksum;
+  double depthSum;
+  
+} ReadbackStats;
+
+static void onFrame(const AtlrCanvasReadbackFrame* restrict frame, void* userData)
+{
+  ReadbackStats* stats = userData;
+  if (frame->index != stats->nextIndex)
+    stats->outOfOrderCount++;
+  stats->nextIndex = frame->index + 1;
+
+  // touch the center texel so the readback cannot be skipped
+  const AtlrU64 center = (AtlrU64)(frame->height / 2) * frame->width + frame->width / 2;
+  const AtlrU8* texel = frame->rgba + 4 * center;
+  stats->checksum += texel[0] + texel[1] + texel[2] + texel[3];
+  if (frame->depth)
+    stats->depthSum += frame->depth[center];
+}
+
+static AtlrU8 initPipeline()
+{
+  VkShaderModule modules[2] =
+  {
+    atlrInitShaderModule("triangle-vert.spv", &device),
+    atlrInitShaderModule("triangle-frag.spv", &device)
+  };
+  if (!modules[0] || !modules[1])
+  {
+    ATLR_ERROR_MSG("atlrInitShaderModule returned VK_NULL_HANDLE.");
+    return 0;
+  }
+  const VkPipelineShaderStageCreateInfo stageInfos[2] =
+  {
+    atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_VERTEX_BIT, modules[0]),
+    atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, modules[1])
+  };
+
+  VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+  vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+  const VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo = atlrInitPipelineInputAssemblyStateInfo();
+  const VkPipelineViewportStateCreateInfo viewportInfo           = atlrInitPipelineViewportStateInfo();
+  const VkPipelineRasterizationStateCreateInfo rasterizationInfo = atlrInitPipelineRasterizationStateInfo();
+  const VkPipelineMultisampleStateCreateInfo multisampleInfo     = atlrInitPipelineMultisampleStateInfo(VK_SAMPLE_COUNT_1_BIT);
+  const VkPipelineDepthStencilStateCreateInfo depthStencilInfo   = atlrInitPipelineDepthStencilStateInfo();
+  const VkPipelineColorBlendAttachmentState colorBlendAttachment = atlrInitPipelineColorBlendAttachmentStateAlpha();
+  const VkPipelineColorBlendStateCreateInfo colorBlendInfo       = atlrInitPipelineColorBlendStateInfo(&colorBlendAttachment);
+  const VkPipelineDynamicStateCreateInfo dynamicInfo             = atlrInitPipelineDynamicStateInfo();
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo            = atlrInitPipelineLayoutInfo(0, NULL, 0, NULL);
+  const VkPipelineRenderingCreateInfo renderingInfo              = atlrInitPipelineRenderingInfo(1, &canvas.colorImage.format, canvas.depthImage.format);
+
+  const AtlrU8 isInit = atlrInitGraphicsPipelineDynamicRendering(&pipeline,
+								 2, stageInfos, &vertexInputInfo, &inputAssemblyInfo, NULL, &viewportInfo, &rasterizationInfo, &multisampleInfo, &depthStencilInfo, &colorBlendInfo, &dynamicInfo, &pipelineLayoutInfo,
+								 &renderingInfo, &device);
+  atlrDeinitShaderModule(modules[0], &device);
+  atlrDeinitShaderModule(modules[1], &device);
+  if (!isInit)
+  {
+    ATLR_ERROR_MSG("atlrInitGraphicsPipelineDynamicRendering returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// With a single slot every frame waits on the one before it, as a blocking readback would; more slots keep the device busy.
+static AtlrU8 benchmark(const AtlrU32 slotCount)
+{
+  ReadbackStats stats = {.nextIndex = 0, .outOfOrderCount = 0, .checksum = 0, .depthSum = 0.0};
+  AtlrCanvasReadback readback;
+  if (!atlrInitCanvasReadback(&readback, &canvas, slotCount, 1, onFrame, &stats))
+  {
+    ATLR_ERROR_MSG("atlrInitCanvasReadback returned 0.");
+    return 0;
+  }
+
+  const AtlrU64 startTime = atlrGetTimeNanoseconds();
+  for (AtlrU32 i = 0; i < FRAME_COUNT; i++)
+  {
+    const VkCommandBuffer commandBuffer = atlrBeginCanvasReadbackFrame(&readback);
+    if (!commandBuffer)
+    {
+      ATLR_ERROR_MSG("atlrBeginCanvasReadbackFrame returned VK_NULL_HANDLE.");
+      return 0;
+    }
+    if (!atlrOffscreenCanvasBeginRendering(&canvas, commandBuffer))
+    {
+      ATLR_ERROR_MSG("atlrOffscreenCanvasBeginRendering returned 0.");
+      return 0;
+    }
+    vkCmdBindPipeline(commandBuffer, pipeline.bindPoint, pipeline.pipeline);
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+    if (!atlrOffscreenCanvasEndRendering(&canvas, commandBuffer))
+    {
+      ATLR_ERROR_MSG("atlrOffscreenCanvasEndRendering returned 0.");
+      return 0;
+    }
+    if (!atlrEndCanvasReadbackFrame(&readback))
+    {
+      ATLR_ERROR_MSG("atlrEndCanvasReadbackFrame returned 0.");
+      return 0;
+    }
+
+    atlrPollCanvasReadback(&readback);
+  }
+  if (!atlrFlushCanvasReadback(&readback))
+  {
+    ATLR_ERROR_MSG("atlrFlushCanvasReadback returned 0.");
+    return 0;
+  }
+  const AtlrU64 time = atlrGetTimeNanoseconds() - startTime;
+  atlrDeinitCanvasReadback(&readback);
+
+  if ((stats.nextIndex != FRAME_COUNT) || stats.outOfOrderCount)
+  {
+    ATLR_ERROR_MSG("Canvas readback frames were lost or delivered out of order.");
+    return 0;
+  }
+  atlrLog(ATLR_LOG_INFO, "%u slot(s): %.1f frames per second, %.3f ms per frame (checksum %lu, mean center depth %.3f).",
+	  slotCount, 1e9 * FRAME_COUNT / time, 1e-6 * time / FRAME_COUNT, (unsigned long)stats.checksum, stats.depthSum / FRAME_COUNT);
+  return 1;
+}
+
+static AtlrU8 initCanvasReadbackBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Starting 'Canvas Readback Benchmark' demo ...");
+
+  if (!atlrInitInstanceHostHeadless(&instance, "Canvas Readback Benchmark Demo", NULL))
+  {
+    ATLR_ERROR_MSG("atlrInitInstanceHostHeadless returned 0.");
+    return 0;
+  }
+
+  AtlrDeviceCriteria deviceCriteria;
+  atlrInitDeviceCriteria(deviceCriteria);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_QUEUE_FAMILY_GRAPHICS_SUPPORT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_DYNAMIC_RENDERING,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
+  {
+    ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
+    return 0;
+  }
+
+  // a BGRA canvas, so the frames go through the swizzle on the way out
+  const VkExtent2D extent = {.width = 1920, .height = 1080};
+  if (!atlrInitDynamicRenderingOffscreenCanvas(&canvas, &extent, VK_FORMAT_B8G8R8A8_UNORM, NULL, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDynamicRenderingOffscreenCanvas returned 0.");
+    return 0;
+  }
+
+  if (!initPipeline())
+  {
+    ATLR_ERROR_MSG("initPipeline returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitCanvasReadbackBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Ending 'Canvas Readback Benchmark' demo ...");
+
+  vkDeviceWaitIdle(device.logical);
+
+  atlrDeinitPipeline(&pipeline);
+  atlrDeinitOffscreenCanvas(&canvas, 0);
+  atlrDeinitDeviceHost(&device);
+  atlrDeinitInstanceHostHeadless(&instance);
+}
+
+int main()
+{
+  if (!initCanvasReadbackBenchmark())
+  {
+    ATLR_FATAL_MSG("initCanvasReadbackBenchmark returned 0.");
+    return -1;
+  }
+
+  // the first run warms up the driver, so that first use costs are not measured
+  if (!benchmark(SLOT_COUNT) || !benchmark(1) || !benchmark(SLOT_COUNT))
+  {
+    ATLR_FATAL_MSG("benchmark returned 0.");
+    return -1;
+  }
+
+  deinitCanvasReadbackBenchmark();
+  return 0;
+}
@@ -109,7 +109,7 @@ static AtlrU8 initConwayLife()
 {
   atlrLog(ATLR_LOG_INFO, "Starting 'Conway's Game of Life' demo ...");
 
-  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Game of Life Demo"))
+  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Game of Life Demo", NULL))
   {
     ATLR_ERROR_MSG("atlrInitHostGLFW returned 0.");
     return 0;
@@ -0,0 +1,34 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#version 460
+
+layout(local_size_x = 1) in;
+
+layout(std430, set = 0, binding = 0) buffer Object
+{
+	vec4 value;
+} object;
+
+void main()
+{
+	object.value += vec4(1.0);
+}
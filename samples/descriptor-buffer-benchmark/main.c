@@ -0,0 +1,412 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "../../src/antler.h"
+
+// Every dispatch binds its own range of the storage buffer, so no descriptor can be reused within a frame.
+// The pool path allocates, writes and binds a set per dispatch, while the descriptor buffer path writes the descriptor
+// straight into mapped memory and only sets an offset.
+#define OBJECT_COUNT 4096
+#define ITERATION_COUNT 16
+
+// a single storage buffer descriptor, aligned to the descriptor buffer offset alignment, is at most 256 bytes
+#define DESCRIPTOR_BUFFER_SIZE (OBJECT_COUNT * 256)
+
+static AtlrInstance instance;
+static AtlrDevice device;
+static AtlrSingleRecordCommandContext commandContext;
+static AtlrBuffer objectBuffer;
+static VkDeviceAddress objectBufferAddress;
+static AtlrU64 objectStride;
+static AtlrDescriptorSetLayout poolSetLayout;
+static AtlrDescriptorAllocator descriptorAllocator;
+static AtlrPipeline poolPipeline;
+static AtlrDescriptorSetLayout descriptorBufferSetLayout;
+static AtlrDescriptorBuffer descriptorBuffer;
+static AtlrPipeline descriptorBufferPipeline;
+
+#define OBJECT_SIZE (4 * sizeof(float))
+
+static AtlrU8 initObjectBuffer()
+{
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device.physical, &properties);
+  const AtlrU64 alignment = properties.limits.minStorageBufferOffsetAlignment;
+  objectStride = (OBJECT_SIZE + alignment - 1) / alignment * alignment;
+
+  const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+    | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  if (!atlrInitBuffer(&objectBuffer, OBJECT_COUNT * objectStride, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitBuffer returned 0.");
+    return 0;
+  }
+  objectBufferAddress = atlrGetBufferDeviceAddress(&objectBuffer);
+
+  VkCommandBuffer commandBuffer;
+  if (!atlrBeginSingleRecordCommands(&commandBuffer, &commandContext))
+  {
+    ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+    return 0;
+  }
+  vkCmdFillBuffer(commandBuffer, objectBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+  if (!atlrEndSingleRecordCommands(commandBuffer, &commandContext))
+  {
+    ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static AtlrU8 initComputePipeline(AtlrPipeline* restrict pipeline, const AtlrDescriptorSetLayout* restrict setLayout, const AtlrU8 isDescriptorBuffer)
+{
+  VkShaderModule module = atlrInitShaderModule("benchmark-comp.spv", &device);
+  if (!module)
+  {
+    ATLR_ERROR_MSG("atlrInitShaderModule returned VK_NULL_HANDLE.");
+    return 0;
+  }
+  const VkPipelineShaderStageCreateInfo stageInfo = atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_COMPUTE_BIT, module);
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo = atlrInitPipelineLayoutInfo(1, &setLayout->layout, 0, NULL);
+
+  const AtlrU8 isInit = isDescriptorBuffer ?
+    atlrInitDescriptorBufferComputePipeline(pipeline, &stageInfo, &pipelineLayoutInfo, &device) :
+    atlrInitComputePipeline(pipeline, &stageInfo, &pipelineLayoutInfo, &device);
+  atlrDeinitShaderModule(module, &device);
+  if (!isInit)
+  {
+    ATLR_ERROR_MSG("Compute pipeline creation returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static AtlrU8 initPoolPath()
+{
+  const VkDescriptorSetLayoutBinding binding = atlrInitDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+  if (!atlrInitDescriptorSetLayout(&poolSetLayout, 1, &binding, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorSetLayout returned 0.");
+    return 0;
+  }
+
+  const VkDescriptorPoolSize ratio = atlrInitDescriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+  if (!atlrInitDescriptorAllocator(&descriptorAllocator, OBJECT_COUNT, 1, &ratio, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorAllocator returned 0.");
+    return 0;
+  }
+
+  if (!initComputePipeline(&poolPipeline, &poolSetLayout, 0))
+  {
+    ATLR_ERROR_MSG("initComputePipeline returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitPoolPath()
+{
+  atlrDeinitPipeline(&poolPipeline);
+  atlrDeinitDescriptorAllocator(&descriptorAllocator);
+  atlrDeinitDescriptorSetLayout(&poolSetLayout);
+}
+
+static AtlrU8 initDescriptorBufferPath()
+{
+  const VkDescriptorSetLayoutBinding binding = atlrInitDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+  if (!atlrInitDescriptorBufferSetLayout(&descriptorBufferSetLayout, 1, &binding, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorBufferSetLayout returned 0.");
+    return 0;
+  }
+
+  if (!atlrInitDescriptorBuffer(&descriptorBuffer, DESCRIPTOR_BUFFER_SIZE, 0, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorBuffer returned 0.");
+    return 0;
+  }
+
+  if (!initComputePipeline(&descriptorBufferPipeline, &descriptorBufferSetLayout, 1))
+  {
+    ATLR_ERROR_MSG("initComputePipeline returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitDescriptorBufferPath()
+{
+  atlrDeinitPipeline(&descriptorBufferPipeline);
+  atlrDeinitDescriptorBuffer(&descriptorBuffer);
+  atlrDeinitDescriptorSetLayout(&descriptorBufferSetLayout);
+}
+
+static AtlrU8 recordPoolDispatches(const VkCommandBuffer commandBuffer)
+{
+  vkCmdBindPipeline(commandBuffer, poolPipeline.bindPoint, poolPipeline.pipeline);
+  
+  for (AtlrU32 i = 0; i < OBJECT_COUNT; i++)
+  {
+    VkDescriptorSet set;
+    if (!atlrDescriptorAllocatorAlloc(&descriptorAllocator, 1, &poolSetLayout.layout, &set))
+    {
+      ATLR_ERROR_MSG("atlrDescriptorAllocatorAlloc returned 0.");
+      return 0;
+    }
+    const VkDescriptorBufferInfo bufferInfo =
+    {
+      .buffer = objectBuffer.buffer,
+      .offset = i * objectStride,
+      .range = OBJECT_SIZE
+    };
+    const VkWriteDescriptorSet write = atlrWriteBufferDescriptorSet(set, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bufferInfo);
+    vkUpdateDescriptorSets(device.logical, 1, &write, 0, NULL);
+    
+    vkCmdBindDescriptorSets(commandBuffer, poolPipeline.bindPoint, poolPipeline.layout, 0, 1, &set, 0, NULL);
+    vkCmdDispatch(commandBuffer, 1, 1, 1);
+  }
+
+  return 1;
+}
+
+static AtlrU8 recordDescriptorBufferDispatches(const VkCommandBuffer commandBuffer)
+{
+  vkCmdBindPipeline(commandBuffer, descriptorBufferPipeline.bindPoint, descriptorBufferPipeline.pipeline);
+  atlrCommandBindDescriptorBuffer(commandBuffer, &descriptorBuffer);
+  
+  for (AtlrU32 i = 0; i < OBJECT_COUNT; i++)
+  {
+    AtlrU64 setOffset;
+    if (!atlrDescriptorBufferAllocSet(&descriptorBuffer, &descriptorBufferSetLayout, &setOffset))
+    {
+      ATLR_ERROR_MSG("atlrDescriptorBufferAllocSet returned 0.");
+      return 0;
+    }
+    atlrDescriptorBufferWriteBuffer(&descriptorBuffer, setOffset, &descriptorBufferSetLayout, 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				    objectBufferAddress + i * objectStride, OBJECT_SIZE);
+    
+    atlrCommandSetDescriptorBufferOffset(commandBuffer, descriptorBufferPipeline.bindPoint, descriptorBufferPipeline.layout, 0, setOffset, &device);
+    vkCmdDispatch(commandBuffer, 1, 1, 1);
+  }
+
+  return 1;
+}
+
+static void resetPoolPath()
+{
+  atlrResetDescriptorAllocator(&descriptorAllocator);
+}
+
+static void resetDescriptorBufferPath()
+{
+  atlrResetDescriptorBuffer(&descriptorBuffer);
+}
+
+// Recording time covers the descriptor writes, binds and dispatches; frame time also covers the submission and the wait on the device.
+// The previous frame has finished by the time the next one resets its descriptors, since every frame waits on its submission.
+static AtlrU8 benchmark(const char* restrict name, void (*reset)(), AtlrU8 (*record)(const VkCommandBuffer))
+{
+  const VkMemoryBarrier barrier =
+  {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+    .pNext = NULL,
+    .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+    .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+  };
+  
+  AtlrU64 recordTime = 0;
+  AtlrU64 frameTime = 0;
+  for (AtlrU32 i = 0; i < ITERATION_COUNT; i++)
+  {
+    const AtlrU64 frameStartTime = atlrGetTimeNanoseconds();
+    
+    reset();
+    VkCommandBuffer commandBuffer;
+    if (!atlrBeginSingleRecordCommands(&commandBuffer, &commandContext))
+    {
+      ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+      return 0;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			 0, 1, &barrier, 0, NULL, 0, NULL);
+
+    const AtlrU64 recordStartTime = atlrGetTimeNanoseconds();
+    if (!record(commandBuffer))
+    {
+      ATLR_ERROR_MSG("Recording the dispatches returned 0.");
+      return 0;
+    }
+    recordTime += atlrGetTimeNanoseconds() - recordStartTime;
+
+    if (!atlrEndSingleRecordCommands(commandBuffer, &commandContext))
+    {
+      ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+      return 0;
+    }
+
+    frameTime += atlrGetTimeNanoseconds() - frameStartTime;
+  }
+
+  atlrLog(ATLR_LOG_INFO, "%s: %.1f ns recording per binding and dispatch, %.3f ms per frame of %d dispatches.",
+	  name, (double)recordTime / (ITERATION_COUNT * OBJECT_COUNT), 1e-6 * frameTime / ITERATION_COUNT, OBJECT_COUNT);
+  return 1;
+}
+
+// every dispatch adds one to its object, so every object has been incremented once per frame of every run
+static AtlrU8 checkObjects(const AtlrU32 runCount)
+{
+  const AtlrU64 size = OBJECT_COUNT * objectStride;
+  AtlrU8* data = malloc(size);
+  if (!atlrReadbackBuffer(&objectBuffer, 0, size, data, &commandContext))
+  {
+    ATLR_ERROR_MSG("atlrReadbackBuffer returned 0.");
+    free(data);
+    return 0;
+  }
+
+  const float expected = (float)(runCount * ITERATION_COUNT);
+  AtlrU32 wrongCount = 0;
+  for (AtlrU32 i = 0; i < OBJECT_COUNT; i++)
+  {
+    const float* value = (const float*)(data + i * objectStride);
+    if (value[0] != expected) wrongCount++;
+  }
+  free(data);
+
+  if (wrongCount)
+  {
+    atlrLog(ATLR_LOG_ERROR, "%u of %d objects do not hold the expected value %.1f.", wrongCount, OBJECT_COUNT, expected);
+    return 0;
+  }
+
+  atlrLog(ATLR_LOG_INFO, "All %d objects hold the expected value %.1f.", OBJECT_COUNT, expected);
+  return 1;
+}
+
+static AtlrU8 initDescriptorBufferBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Starting 'Descriptor Buffer Benchmark' demo ...");
+
+  if (!atlrInitInstanceHostHeadless(&instance, "Descriptor Buffer Benchmark Demo", NULL))
+  {
+    ATLR_ERROR_MSG("atlrInitInstanceHostHeadless returned 0.");
+    return 0;
+  }
+
+  // lavapipe is preferred so that results are comparable across machines
+  AtlrDeviceCriteria deviceCriteria;
+  atlrInitDeviceCriteria(deviceCriteria);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_QUEUE_FAMILY_COMPUTE_SUPPORT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_DESCRIPTOR_BUFFER,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_CPU_PHYSICAL_DEVICE,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 10);
+  if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
+  {
+    ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
+    return 0;
+  }
+
+  if (!atlrInitSingleRecordCommandContext(&commandContext, device.queueFamilyIndices.graphicsComputeIndex, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitSingleRecordCommandContext returned 0.");
+    return 0;
+  }
+
+  if (!initObjectBuffer())
+  {
+    ATLR_ERROR_MSG("initObjectBuffer returned 0.");
+    return 0;
+  }
+
+  if (!initPoolPath())
+  {
+    ATLR_ERROR_MSG("initPoolPath returned 0.");
+    return 0;
+  }
+
+  if (!initDescriptorBufferPath())
+  {
+    ATLR_ERROR_MSG("initDescriptorBufferPath returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitDescriptorBufferBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Ending 'Descriptor Buffer Benchmark' demo ...");
+
+  vkDeviceWaitIdle(device.logical);
+
+  deinitDescriptorBufferPath();
+  deinitPoolPath();
+  atlrDeinitBuffer(&objectBuffer);
+  atlrDeinitSingleRecordCommandContext(&commandContext);
+  atlrDeinitDeviceHost(&device);
+  atlrDeinitInstanceHostHeadless(&instance);
+}
+
+int main()
+{
+  if (!initDescriptorBufferBenchmark())
+  {
+    ATLR_FATAL_MSG("initDescriptorBufferBenchmark returned 0.");
+    return -1;
+  }
+
+  // warm up both paths so that first use costs in the driver, such as growing the descriptor allocator, are not measured
+  if (!benchmark("Descriptor pool warm up", resetPoolPath, recordPoolDispatches)
+      || !benchmark("Descriptor buffer warm up", resetDescriptorBufferPath, recordDescriptorBufferDispatches))
+  {
+    ATLR_FATAL_MSG("benchmark returned 0.");
+    return -1;
+  }
+
+  if (!benchmark("Descriptor pool", resetPoolPath, recordPoolDispatches)
+      || !benchmark("Descriptor buffer", resetDescriptorBufferPath, recordDescriptorBufferDispatches))
+  {
+    ATLR_FATAL_MSG("benchmark returned 0.");
+    return -1;
+  }
+
+  if (!checkObjects(4))
+  {
+    ATLR_FATAL_MSG("checkObjects returned 0.");
+    return -1;
+  }
+
+  deinitDescriptorBufferBenchmark();
+  return 0;
+}
@@ -0,0 +1,120 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+
+#include "../../src/antler.h"
+
+// Grades the physical devices by their measured performance alongside the heap size and Vulkan 1.3 era criteria, then logs which device won
+// and what it measured. The benchmarks run once per device and driver; later runs read the scores back from the benchmark cache.
+
+static AtlrInstance instance;
+static AtlrDevice device;
+
+static AtlrU8 initDeviceSelection()
+{
+  atlrLog(ATLR_LOG_INFO, "Starting 'Device Selection' demo ...");
+
+  if (!atlrInitInstanceHostHeadless(&instance, "Device Selection Demo", NULL))
+  {
+    ATLR_ERROR_MSG("atlrInitInstanceHostHeadless returned 0.");
+    return 0;
+  }
+
+  // the measured score outweighs the other preferences, so a device only wins on them when the scores are close
+  AtlrDeviceCriteria deviceCriteria;
+  atlrInitDeviceCriteria(deviceCriteria);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_QUEUE_FAMILY_GRAPHICS_SUPPORT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_MEASURED_PERFORMANCE,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 100);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_DEVICE_LOCAL_HEAP_AT_LEAST_2_GIB,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 5);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_DEVICE_LOCAL_HEAP_AT_LEAST_8_GIB,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 5);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_TIMELINE_SEMAPHORE,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 10);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_SYNCHRONIZATION_2,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 10);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_MAINTENANCE_4,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 5);
+  if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
+  {
+    ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitDeviceSelection()
+{
+  atlrLog(ATLR_LOG_INFO, "Ending 'Device Selection' demo ...");
+
+  vkDeviceWaitIdle(device.logical);
+
+  atlrDeinitDeviceHost(&device);
+  atlrDeinitInstanceHostHeadless(&instance);
+}
+
+int main()
+{
+  if (!initDeviceSelection())
+  {
+    ATLR_FATAL_MSG("initDeviceSelection returned 0.");
+    return -1;
+  }
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device.physical, &properties);
+  atlrLog(ATLR_LOG_INFO, "Selected \"%s\".", properties.deviceName);
+
+  // grading already measured the device, so this reads the cached benchmark unless there is no cache directory
+  AtlrDeviceBenchmark benchmark;
+  if (!atlrMeasurePhysicalDevice(&benchmark, device.physical, &instance))
+  {
+    ATLR_FATAL_MSG("atlrMeasurePhysicalDevice returned 0.");
+    return -1;
+  }
+  atlrLog(ATLR_LOG_INFO, "Copy bandwidth %.2f GB/s, compute throughput %.2f GFLOP/s, fill rate %.2f Gpixel/s, score %.2f.",
+	  benchmark.copyBandwidth, benchmark.computeThroughput, benchmark.fillRate, benchmark.score);
+
+  atlrLog(ATLR_LOG_INFO, "Synchronization 2 %s, timeline semaphores %s, maintenance 4 %s.",
+	  device.features.synchronization2 ? "enabled" : "unavailable",
+	  device.features.timelineSemaphore ? "enabled" : "unavailable",
+	  device.features.maintenance4 ? "enabled" : "unavailable");
+
+  deinitDeviceSelection();
+  return 0;
+}
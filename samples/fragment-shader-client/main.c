@@ -20,8 +20,11 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "../../src/antler.h"
 #include <stdio.h>
+#include <string.h>
 
 #define MAX_FRAMES_IN_FLIGHT 2
+#define STREAM_WIDTH 1920
+#define STREAM_HEIGHT 1080
 
 static AtlrInstance instance;
 static AtlrDevice device;
@@ -38,6 +41,8 @@ static struct
 static AtlrBuffer uniformBuffers[MAX_FRAMES_IN_FLIGHT];
 static AtlrU8 hasTexture;
 static AtlrImage rgbaImageTexture;
+static AtlrU8 isStreaming;
+static AtlrStreamingTexture streamingTexture;
 static VkSampler sampler;
 static AtlrDescriptorSetLayout descriptorSetLayout;
 static AtlrDescriptorPool descriptorPool;
@@ -66,31 +71,12 @@ static const char* fragmentShaderSourceEntryPoint =
 
 static AtlrU8 initDescriptor(const char* restrict imageTexturePath)
 {
-  // sampler
-  VkSamplerCreateInfo samplerInfo =
+  // sampler, baked into the set layout
+  const VkSamplerCreateInfo samplerInfo = atlrInitSamplerInfo(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+  sampler = atlrAcquireSampler(&device, &samplerInfo);
+  if (!sampler)
   {
-    .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-    .pNext = NULL,
-    .flags = 0,
-    .magFilter = VK_FILTER_LINEAR,
-    .minFilter = VK_FILTER_LINEAR,
-    .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-    .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-    .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-    .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-    .mipLodBias = 0.0f,
-    .anisotropyEnable = VK_FALSE,
-    .maxAnisotropy = 1.0f,
-    .compareEnable = VK_FALSE,
-    .compareOp = VK_COMPARE_OP_ALWAYS,
-    .minLod =  0.0f,
-    .maxLod = 0.0f,
-    .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
-    .unnormalizedCoordinates = VK_FALSE
-  };
-  if (vkCreateSampler(device.logical, &samplerInfo, instance.allocator, &sampler) != VK_SUCCESS)
-  {
-    ATLR_ERROR_MSG("vkCreateSampler did not return VK_SUCCESS.");
+    ATLR_ERROR_MSG("atlrAcquireSampler returned VK_NULL_HANDLE.");
     return 0;
   }
   
@@ -120,19 +106,40 @@ static AtlrU8 initDescriptor(const char* restrict imageTexturePath)
   if (imageTexturePath)
   {
     hasTexture = 1;
-    if (!atlrInitImageRgbaTextureFromFile(&rgbaImageTexture, imageTexturePath, &device, &singleRecordCommandContext))
+    isStreaming = !strcmp(imageTexturePath, "-stream");
+    // block-compressed KTX2 textures are uploaded as stored, anything else is decoded to RGBA
+    const size_t pathLength = strlen(imageTexturePath);
+    if (isStreaming)
+    {
+      if (!atlrInitStreamingTexture(&streamingTexture, STREAM_WIDTH, STREAM_HEIGHT, VK_FORMAT_R8G8B8A8_UNORM, MAX_FRAMES_IN_FLIGHT, &device, &singleRecordCommandContext))
+      {
+	ATLR_ERROR_MSG("atlrInitStreamingTexture returned 0.");
+	return 0;
+      }
+    }
+    else if (pathLength > 5 && !strcmp(imageTexturePath + pathLength - 5, ".ktx2"))
+    {
+      const char* ktx2Paths[1] = {imageTexturePath};
+      if (!atlrInitImageKtx2TextureFromFiles(&rgbaImageTexture, 1, ktx2Paths, &device, &singleRecordCommandContext))
+      {
+	ATLR_ERROR_MSG("atlrInitImageKtx2TextureFromFiles returned 0.");
+	return 0;
+      }
+    }
+    else if (!atlrInitImageRgbaTextureFromFile(&rgbaImageTexture, imageTexturePath, 1, &device, &singleRecordCommandContext))
     {
       ATLR_ERROR_MSG("atlrInitImageRgbaTextureFromFile returned 0.");
       return 0;
     }
 #ifdef ATLR_DEBUG
-    atlrSetImageName(&rgbaImageTexture, imageTexturePath);
+    if (!isStreaming)
+      atlrSetImageName(&rgbaImageTexture, imageTexturePath);
 #endif
     
     const VkDescriptorSetLayoutBinding descriptorSetLayoutBindings[2] =
     {
       atlrInitDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT),
-      atlrInitDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+      atlrInitImmutableSamplerDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, &sampler)
     };
     if (!atlrInitDescriptorSetLayout(&descriptorSetLayout, 2, descriptorSetLayoutBindings, &device))
     {
@@ -154,6 +161,7 @@ static AtlrU8 initDescriptor(const char* restrict imageTexturePath)
   else
   {
     hasTexture = 0;
+    isStreaming = 0;
     
     const VkDescriptorSetLayoutBinding descriptorSetLayoutBinding = atlrInitDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
     if (!atlrInitDescriptorSetLayout(&descriptorSetLayout, 1, &descriptorSetLayoutBinding, &device))
@@ -179,16 +187,19 @@ static AtlrU8 initDescriptor(const char* restrict imageTexturePath)
   }
 
   VkDescriptorBufferInfo bufferInfos[MAX_FRAMES_IN_FLIGHT];
-  VkDescriptorImageInfo imageInfo;
-  if (hasTexture)
-    imageInfo = atlrInitDescriptorImageInfo(&rgbaImageTexture, sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  // a streaming texture has an image per frame in flight
+  VkDescriptorImageInfo imageInfos[MAX_FRAMES_IN_FLIGHT];
   VkWriteDescriptorSet descriptorWrites[2 * MAX_FRAMES_IN_FLIGHT];
   for (AtlrU8 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
   {
     bufferInfos[i]                               = atlrInitDescriptorBufferInfo(uniformBuffers + i, sizeof(uniformBufferData));
     descriptorWrites[(1 + hasTexture) * i]       = atlrWriteBufferDescriptorSet(descriptorSets[i], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, bufferInfos + i);
     if (hasTexture)
-      descriptorWrites[2 * i + 1] = atlrWriteImageDescriptorSet(descriptorSets[i], 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &imageInfo); 
+    {
+      const AtlrImage* image = isStreaming ? streamingTexture.images + i : &rgbaImageTexture;
+      imageInfos[i] = atlrInitDescriptorImageInfo(image, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+      descriptorWrites[2 * i + 1] = atlrWriteImageDescriptorSet(descriptorSets[i], 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageInfos + i);
+    }
   }
   vkUpdateDescriptorSets(device.logical, (1 + hasTexture) * MAX_FRAMES_IN_FLIGHT, descriptorWrites, 0, NULL);
 
@@ -200,7 +211,9 @@ static void deinitDescriptor()
   atlrDeinitDescriptorPool(&descriptorPool);
   atlrDeinitDescriptorSetLayout(&descriptorSetLayout);
 
-  if (hasTexture)
+  if (isStreaming)
+    atlrDeinitStreamingTexture(&streamingTexture);
+  else if (hasTexture)
     atlrDeinitImage(&rgbaImageTexture);
   
   for (AtlrU8 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
@@ -210,7 +223,25 @@ static void deinitDescriptor()
     atlrDeinitBuffer(uniformBuffer);
   }
 
-  vkDestroySampler(device.logical, sampler, instance.allocator);
+  atlrReleaseSampler(&device, sampler);
+}
+
+// A scrolling pattern generated on the host every frame, standing in for decoded video.
+// Whole texels are stored in order, since the staging memory is likely write-combined.
+static void generateStreamFrame(AtlrU32* restrict texels, const double time)
+{
+  const AtlrU32 shift = (AtlrU32)(time * 120.0);
+  for (AtlrU32 y = 0; y < STREAM_HEIGHT; y++)
+  {
+    AtlrU32* row = texels + (AtlrU64)y * STREAM_WIDTH;
+    for (AtlrU32 x = 0; x < STREAM_WIDTH; x++)
+    {
+      const AtlrU32 r = ((x + shift) ^ y) & 0xFF;
+      const AtlrU32 g = (x ^ (y + shift)) & 0xFF;
+      const AtlrU32 b = ((x + y + 2 * shift) >> 2) & 0xFF;
+      row[x] = r | (g << 8) | (b << 16) | 0xFF000000u;
+    }
+  }
 }
 
 static AtlrU8 initPipeline(const char* restrict fragmentShaderPath)
@@ -338,7 +369,7 @@ static AtlrU8 initFragmentShaderClient(const char* restrict fragmentShaderPath,
 {
   atlrLog(ATLR_LOG_INFO, "Starting 'Fragment Shader Client' demo ...");
 
-  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Fragment Shader Client"))
+  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Fragment Shader Client", NULL))
   {
     ATLR_ERROR_MSG("atlrInitHostGLFW returned 0.");
     return 0;
@@ -434,7 +465,7 @@ int main(int argc, char* argv[])
 {
   if (argc < 2 || argc > 3)
   {
-    ATLR_FATAL_MSG("Usage: %s <shader-file-path> <image-texture-path>\n<image-texture-path> is for shaders that use texture uniforms.", argv[0]);
+    ATLR_FATAL_MSG("Usage: %s <shader-file-path> <image-texture-path>\n<image-texture-path> is for shaders that use texture uniforms; pass -stream for a texture generated every frame.", argv[0]);
     return -1;
   }
   char* imageTexturePath = (argc == 2) ? NULL : argv[2];
@@ -457,6 +488,19 @@ int main(int argc, char* argv[])
       ATLR_FATAL_MSG("atlrBeginFrameCommands returned 0.");
       return -1;
     }
+    const VkCommandBuffer commandBuffer = atlrGetFrameCommandContextCommandBufferHostGLFW(&commandContext);
+
+    // the frame's fence has been waited on, so its staging memory is free to rewrite; the upload goes before the render pass
+    if (isStreaming)
+    {
+      generateStreamFrame(atlrGetStreamingTextureData(&streamingTexture, commandContext.currentFrame), glfwGetTime());
+      if (!atlrCommandUploadStreamingTexture(&streamingTexture, commandBuffer, commandContext.currentFrame))
+      {
+	ATLR_FATAL_MSG("atlrCommandUploadStreamingTexture returned 0.");
+	return -1;
+      }
+    }
+    
     // begin render pass
     if (!atlrFrameCommandContextBeginRenderPassHostGLFW(&commandContext))
     {
@@ -464,8 +508,6 @@ int main(int argc, char* argv[])
       return -1;
     }
 
-    const VkCommandBuffer commandBuffer = atlrGetFrameCommandContextCommandBufferHostGLFW(&commandContext);
-
     // update ubo
     {
       int width, height;
@@ -60,8 +60,8 @@ static AtlrU8 onReinitSwapchain(void* data)
 
   const VkDescriptorType type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 
-  const VkDescriptorImageInfo imageInfo = atlrInitDescriptorImageInfo(&offscreenCanvas.colorImage, sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-  const VkDescriptorImageInfo depthInfo = atlrInitDescriptorImageInfo(&offscreenCanvas.depthImage, sampler, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+  const VkDescriptorImageInfo imageInfo = atlrInitDescriptorImageInfo(&offscreenCanvas.colorImage, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  const VkDescriptorImageInfo depthInfo = atlrInitDescriptorImageInfo(&offscreenCanvas.depthImage, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
   VkWriteDescriptorSet descriptorWrites[2 * MAX_FRAMES_IN_FLIGHT];
   for (AtlrU8 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
   {
@@ -75,31 +75,12 @@ static AtlrU8 onReinitSwapchain(void* data)
 
 static AtlrU8 initDescriptor()
 {
-  // sampler
-  VkSamplerCreateInfo samplerInfo =
+  // sampler, baked into the set layout
+  const VkSamplerCreateInfo samplerInfo = atlrInitSamplerInfo(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+  sampler = atlrAcquireSampler(&device, &samplerInfo);
+  if (!sampler)
   {
-    .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-    .pNext = NULL,
-    .flags = 0,
-    .magFilter = VK_FILTER_LINEAR,
-    .minFilter = VK_FILTER_LINEAR,
-    .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-    .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-    .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-    .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-    .mipLodBias = 0.0f,
-    .anisotropyEnable = VK_FALSE,
-    .maxAnisotropy = 1.0f,
-    .compareEnable = VK_FALSE,
-    .compareOp = VK_COMPARE_OP_ALWAYS,
-    .minLod =  0.0f,
-    .maxLod = 0.0f,
-    .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
-    .unnormalizedCoordinates = VK_FALSE
-  };
-  if (vkCreateSampler(device.logical, &samplerInfo, instance.allocator, &sampler) != VK_SUCCESS)
-  {
-    ATLR_ERROR_MSG("vkCreateSampler did not return VK_SUCCESS.");
+    ATLR_ERROR_MSG("atlrAcquireSampler returned VK_NULL_HANDLE.");
     return 0;
   }
   
@@ -107,8 +88,8 @@ static AtlrU8 initDescriptor()
   
   const VkDescriptorSetLayoutBinding descriptorSetLayoutBindings[2] =
   {
-    atlrInitDescriptorSetLayoutBinding(0, type, VK_SHADER_STAGE_FRAGMENT_BIT),
-    atlrInitDescriptorSetLayoutBinding(1, type, VK_SHADER_STAGE_FRAGMENT_BIT)
+    atlrInitImmutableSamplerDescriptorSetLayoutBinding(0, type, VK_SHADER_STAGE_FRAGMENT_BIT, &sampler),
+    atlrInitImmutableSamplerDescriptorSetLayoutBinding(1, type, VK_SHADER_STAGE_FRAGMENT_BIT, &sampler)
   };
   if (!atlrInitDescriptorSetLayout(&descriptorSetLayout, 2, descriptorSetLayoutBindings, &device))
   {
@@ -132,8 +113,8 @@ static AtlrU8 initDescriptor()
     return 0;
   }
 
-  const VkDescriptorImageInfo imageInfo = atlrInitDescriptorImageInfo(&offscreenCanvas.colorImage, sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-  const VkDescriptorImageInfo depthInfo = atlrInitDescriptorImageInfo(&offscreenCanvas.depthImage, sampler, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+  const VkDescriptorImageInfo imageInfo = atlrInitDescriptorImageInfo(&offscreenCanvas.colorImage, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  const VkDescriptorImageInfo depthInfo = atlrInitDescriptorImageInfo(&offscreenCanvas.depthImage, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
   VkWriteDescriptorSet descriptorWrites[2 * MAX_FRAMES_IN_FLIGHT];
   for (AtlrU8 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
   {
@@ -147,9 +128,9 @@ static AtlrU8 initDescriptor()
 
 static void deinitDescriptor()
 {
-  vkDestroySampler(device.logical, sampler, instance.allocator);
   atlrDeinitDescriptorPool(&descriptorPool);
   atlrDeinitDescriptorSetLayout(&descriptorSetLayout);
+  atlrReleaseSampler(&device, sampler);
 }
 
 static AtlrU8 initPipelines()
@@ -233,7 +214,7 @@ static AtlrU8 initGooch()
 {
   atlrLog(ATLR_LOG_INFO, "Starting 'Gooch' demo ...");
 
-  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Gooch Demo"))
+  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Gooch Demo", NULL))
   {
     ATLR_ERROR_MSG("atlrInitHostGLFW returned 0.");
     return 0;
@@ -444,7 +425,7 @@ int main()
 #ifdef ATLR_DEBUG
     {
       const float color[4] = {0.9f, 0.2f, 0.2f, 1.0f};
-      atlrBeginCommandLabel(commandBuffer, "Offscreen render pass", color, &instance);
+      atlrBeginCommandLabel(commandBuffer, "Offscreen render pass", color, &device);
     }
 #endif
     atlrOffscreenCanvasBeginRenderPass(&offscreenCanvas, commandBuffer);
@@ -459,26 +440,26 @@ int main()
 #ifdef ATLR_DEBUG
     {
       const float color[4] = {0.2f, 0.9f, 0.9f, 1.0f};
-      atlrBeginCommandLabel(commandBuffer, "Sphere draw", color, &instance);
+      atlrBeginCommandLabel(commandBuffer, "Sphere draw", color, &device);
     }
 #endif
     atlrBindMesh(&sphereMesh, commandBuffer);
     atlrDrawMesh(&sphereMesh, commandBuffer);
 #ifdef ATLR_DEBUG
-    atlrEndCommandLabel(commandBuffer, &instance);
+    atlrEndCommandLabel(commandBuffer, &device);
 #endif
 
     // end offscreen render pass
-    atlrOffscreenCanvasEndRenderPass(commandBuffer);
+    atlrOffscreenCanvasEndRenderPass(&offscreenCanvas, commandBuffer);
 #ifdef ATLR_DEBUG
-    atlrEndCommandLabel(commandBuffer, &instance);
+    atlrEndCommandLabel(commandBuffer, &device);
 #endif
 
     // begin frame render pass
 #ifdef ATLR_DEBUG
     {
       const float color[4] = {0.2f, 0.2f, 0.9f, 1.0f};
-      atlrBeginCommandLabel(commandBuffer, "Swapchain render pass", color, &instance);
+      atlrBeginCommandLabel(commandBuffer, "Swapchain render pass", color, &device);
     }
 #endif
     if (!atlrFrameCommandContextBeginRenderPassHostGLFW(&commandContext))
@@ -493,13 +474,13 @@ int main()
 #ifdef ATLR_DEBUG
     {
       const float color[4] = {0.2f, 0.9f, 0.9f, 1.0f};
-      atlrBeginCommandLabel(commandBuffer, "Edge detection", color, &instance);
+      atlrBeginCommandLabel(commandBuffer, "Edge detection", color, &device);
     }
 #endif
     vkCmdBindIndexBuffer(commandBuffer, edgeDetectIndexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
     vkCmdDrawIndexed(commandBuffer, 6, 1, 0, 0, 0);
 #ifdef ATLR_DEBUG
-    atlrEndCommandLabel(commandBuffer, &instance);
+    atlrEndCommandLabel(commandBuffer, &device);
 #endif
 
     // end frame render pass
@@ -509,7 +490,7 @@ int main()
       return -1;
     }
 #ifdef ATLR_DEBUG
-    atlrEndCommandLabel(commandBuffer, &instance);
+    atlrEndCommandLabel(commandBuffer, &device);
 #endif
     
     // end recording
@@ -94,7 +94,7 @@ static AtlrU8 initHelloQuad()
 {
   atlrLog(ATLR_LOG_INFO, "Starting 'Hello Quad' demo ...");
 
-  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Hello Quad Demo"))
+  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Hello Quad Demo", NULL))
   {
     ATLR_ERROR_MSG("atlrInitHostGLFW returned 0.");
     return 0;
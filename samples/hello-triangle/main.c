@@ -24,15 +24,21 @@ static AtlrInstance instance;
 static AtlrDevice device;
 static AtlrSwapchain swapchain;
 static AtlrFrameCommandContext commandContext;
-static AtlrPipeline pipeline;
+static AtlrPipelineRegistry registry;
+static const AtlrPipeline* pipeline;
 
-static AtlrU8 initPipeline()
+static const AtlrPipeline* acquirePipeline()
 {
   VkShaderModule modules[2] =
   {
-    atlrInitShaderModule("triangle-vert.spv", &device),
-    atlrInitShaderModule("triangle-frag.spv", &device)
+    atlrPipelineRegistryAcquireShaderModuleFromFile(&registry, "triangle-vert.spv"),
+    atlrPipelineRegistryAcquireShaderModuleFromFile(&registry, "triangle-frag.spv")
   };
+  if ((modules[0] == VK_NULL_HANDLE) || (modules[1] == VK_NULL_HANDLE))
+  {
+    ATLR_ERROR_MSG("atlrPipelineRegistryAcquireShaderModuleFromFile returned VK_NULL_HANDLE.");
+    return NULL;
+  }
   VkPipelineShaderStageCreateInfo stageInfos[2] =
   {
     atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_VERTEX_BIT, modules[0]),
@@ -53,30 +59,56 @@ static AtlrU8 initPipeline()
 
   const VkPipelineLayoutCreateInfo pipelineLayoutInfo = atlrInitPipelineLayoutInfo(0, NULL, 0, NULL);
 
-  if(!atlrInitGraphicsPipeline(&pipeline,
-			       2, stageInfos, &vertexInputInfo, &inputAssemblyInfo, NULL, &viewportInfo, &rasterizationInfo, &multisampleInfo, &depthStencilInfo, &colorBlendInfo, &dynamicInfo, &pipelineLayoutInfo,
-			       &device, &swapchain.renderPass))
+  const AtlrPipeline* acquired = atlrPipelineRegistryAcquireGraphicsPipeline(&registry,
+									     2, stageInfos, &vertexInputInfo, &inputAssemblyInfo, NULL, &viewportInfo, &rasterizationInfo,
+									     &multisampleInfo, &depthStencilInfo, &colorBlendInfo, &dynamicInfo, &pipelineLayoutInfo,
+									     &swapchain.renderPass, NULL);
+  
+  atlrPipelineRegistryReleaseShaderModule(&registry, modules[0]);
+  atlrPipelineRegistryReleaseShaderModule(&registry, modules[1]);
+
+  return acquired;
+}
+
+// The pipeline is acquired twice from the same state, and the registry hands back the pipeline it already made.
+static AtlrU8 initPipeline()
+{
+  if (!atlrInitPipelineRegistry(&registry, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitPipelineRegistry returned 0.");
+    return 0;
+  }
+
+  pipeline = acquirePipeline();
+  if (!pipeline)
   {
-    ATLR_ERROR_MSG("atlrInitGraphicsPipeline returned 0.");
+    ATLR_ERROR_MSG("acquirePipeline returned NULL.");
     return 0;
   }
 
-  atlrDeinitShaderModule(modules[0], &device);
-  atlrDeinitShaderModule(modules[1], &device);
+  const AtlrPipeline* duplicate = acquirePipeline();
+  if (duplicate != pipeline)
+  {
+    ATLR_ERROR_MSG("The pipeline registry made a second pipeline from identical state.");
+    return 0;
+  }
+  atlrPipelineRegistryReleasePipeline(&registry, duplicate);
+  atlrLog(ATLR_LOG_INFO, "The pipeline registry reused the pipeline for identical state.");
 
   return 1;
 }
 
 static void deinitPipeline()
 {
-  atlrDeinitPipeline(&pipeline);
+  atlrPipelineRegistryReleasePipeline(&registry, pipeline);
+  atlrDeinitPipelineRegistry(&registry);
 }
   
 static AtlrU8 initHelloTriangle()
 {
   atlrLog(ATLR_LOG_INFO, "Starting 'Hello Triangle' demo ...");
 
-  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Hello Triangle Demo"))
+  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Hello Triangle Demo", NULL))
   {
     ATLR_ERROR_MSG("atlrInitHostGLFW returned 0.");
     return 0;
@@ -165,7 +197,7 @@ int main()
     }
 
     const VkCommandBuffer commandBuffer = atlrGetFrameCommandContextCommandBufferHostGLFW(&commandContext);
-    vkCmdBindPipeline(commandBuffer, pipeline.bindPoint, pipeline.pipeline);
+    vkCmdBindPipeline(commandBuffer, pipeline->bindPoint, pipeline->pipeline);
     vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 
     // end render pass
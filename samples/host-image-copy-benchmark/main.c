@@ -0,0 +1,218 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "../../src/antler.h"
+
+// Uploads textures of a few sizes through a staging buffer and through host image copy, logging the time each takes until the texture is usable.
+// The staging path is the one atlrInitImageRgbaTextureFromFile takes without host image copy: a staging buffer, two layout transitions and a copy,
+// each in its own submission. Host image copy writes the pixels from host memory and transitions the layout on the host.
+#define ITERATION_COUNT 8
+
+static AtlrInstance instance;
+static AtlrDevice device;
+static AtlrSingleRecordCommandContext commandContext;
+
+static const VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+
+static AtlrU8 uploadStaged(AtlrImage* restrict image, const AtlrU32 size, const AtlrU8* restrict pixels)
+{
+  const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  if (!atlrInitImage(image, size, size, 1, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage,
+		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitImage returned 0.");
+    return 0;
+  }
+
+  const AtlrU64 bufferSize = 4 * (AtlrU64)size * size;
+  AtlrBuffer stagingBuffer;
+  if (!atlrInitStagingBuffer(&stagingBuffer, bufferSize, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitStagingBuffer returned 0.");
+    return 0;
+  }
+  if (!atlrWriteBuffer(&stagingBuffer, 0, bufferSize, 0, pixels))
+  {
+    ATLR_ERROR_MSG("atlrWriteBuffer returned 0.");
+    atlrDeinitBuffer(&stagingBuffer);
+    return 0;
+  }
+
+  const VkOffset2D offset = {.x = 0, .y = 0};
+  const VkExtent2D extent = {.width = size, .height = size};
+  if (!atlrTransitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &commandContext)
+      || !atlrCopyBufferToImage(&stagingBuffer, image, &offset, &extent, &commandContext)
+      || !atlrTransitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &commandContext))
+  {
+    ATLR_ERROR_MSG("Failed to stage texture image.");
+    atlrDeinitBuffer(&stagingBuffer);
+    return 0;
+  }
+  atlrDeinitBuffer(&stagingBuffer);
+
+  return 1;
+}
+
+static AtlrU8 uploadHost(AtlrImage* restrict image, const AtlrU32 size, const AtlrU8* restrict pixels)
+{
+  const VkImageUsageFlags usage = VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  if (!atlrInitImage(image, size, size, 1, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage,
+		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitImage returned 0.");
+    return 0;
+  }
+  if (!atlrHostCopyMemoryToImage(image, pixels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL))
+  {
+    ATLR_ERROR_MSG("atlrHostCopyMemoryToImage returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// mean time per upload in nanoseconds, image creation included
+static AtlrU8 measure(AtlrU64* restrict time, AtlrU8 (*upload)(AtlrImage* restrict, const AtlrU32, const AtlrU8* restrict), const AtlrU32 size, const AtlrU8* restrict pixels)
+{
+  *time = 0;
+  for (AtlrU32 i = 0; i < ITERATION_COUNT; i++)
+  {
+    AtlrImage image;
+    const AtlrU64 startTime = atlrGetTimeNanoseconds();
+    if (!upload(&image, size, pixels))
+    {
+      ATLR_ERROR_MSG("Texture upload failed.");
+      return 0;
+    }
+    *time += atlrGetTimeNanoseconds() - startTime;
+    atlrDeinitImage(&image);
+  }
+  *time /= ITERATION_COUNT;
+
+  return 1;
+}
+
+static AtlrU8 benchmark(const AtlrU32 size, const AtlrU8 isHostImageCopy)
+{
+  const AtlrU64 texelCount = (AtlrU64)size * size;
+  AtlrU8* pixels = malloc(4 * texelCount);
+  for (AtlrU64 i = 0; i < texelCount; i++)
+  {
+    pixels[4 * i + 0] = i & 0xFF;
+    pixels[4 * i + 1] = (i >> 8) & 0xFF;
+    pixels[4 * i + 2] = (i >> 16) & 0xFF;
+    pixels[4 * i + 3] = 255;
+  }
+
+  AtlrU64 stagedTime, hostTime;
+  if (!measure(&stagedTime, uploadStaged, size, pixels) || (isHostImageCopy && !measure(&hostTime, uploadHost, size, pixels)))
+  {
+    ATLR_ERROR_MSG("measure returned 0.");
+    free(pixels);
+    return 0;
+  }
+  free(pixels);
+
+  if (isHostImageCopy)
+    atlrLog(ATLR_LOG_INFO, "%ux%u: staging %.3f ms, host image copy %.3f ms, %.2fx speedup.",
+	    size, size, 1e-6 * stagedTime, 1e-6 * hostTime, (double)stagedTime / hostTime);
+  else
+    atlrLog(ATLR_LOG_INFO, "%ux%u: staging %.3f ms.", size, size, 1e-6 * stagedTime);
+  return 1;
+}
+
+static AtlrU8 initHostImageCopyBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Starting 'Host Image Copy Benchmark' demo ...");
+
+  if (!atlrInitInstanceHostHeadless(&instance, "Host Image Copy Benchmark Demo", NULL))
+  {
+    ATLR_ERROR_MSG("atlrInitInstanceHostHeadless returned 0.");
+    return 0;
+  }
+
+  // lavapipe exposes host image copy, so a CPU device is preferred for comparable numbers
+  AtlrDeviceCriteria deviceCriteria;
+  atlrInitDeviceCriteria(deviceCriteria);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_QUEUE_FAMILY_GRAPHICS_SUPPORT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_HOST_IMAGE_COPY,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 10);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_CPU_PHYSICAL_DEVICE,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 5);
+  if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
+  {
+    ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
+    return 0;
+  }
+
+  if (!atlrInitSingleRecordCommandContext(&commandContext, device.queueFamilyIndices.graphicsComputeIndex, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitSingleRecordCommandContext returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitHostImageCopyBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Ending 'Host Image Copy Benchmark' demo ...");
+
+  vkDeviceWaitIdle(device.logical);
+
+  atlrDeinitSingleRecordCommandContext(&commandContext);
+  atlrDeinitDeviceHost(&device);
+  atlrDeinitInstanceHostHeadless(&instance);
+}
+
+int main()
+{
+  if (!initHostImageCopyBenchmark())
+  {
+    ATLR_FATAL_MSG("initHostImageCopyBenchmark returned 0.");
+    return -1;
+  }
+
+  const AtlrU8 isHostImageCopy = atlrIsHostImageCopySupported(format, VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &device);
+  if (!isHostImageCopy)
+    atlrLog(ATLR_LOG_WARN, "Host image copy is unavailable for sampled RGBA textures on this device; only the staging path is measured.");
+
+  // the first size is repeated as a warm up
+  const AtlrU32 sizes[4] = {256, 256, 1024, 4096};
+  for (AtlrU32 i = 0; i < 4; i++)
+  {
+    if (!benchmark(sizes[i], isHostImageCopy))
+    {
+      ATLR_FATAL_MSG("benchmark returned 0.");
+      return -1;
+    }
+  }
+
+  deinitHostImageCopyBenchmark();
+  return 0;
+}
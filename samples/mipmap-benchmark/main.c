@@ -0,0 +1,416 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "../../src/antler.h"
+#include "../../src/offscreen-canvas.h"
+
+// The plane covers the lower half of the canvas and is minified more and more towards the horizon.
+// It is drawn several times per frame, so that texture reads dominate the device time.
+#define TEXTURE_SIZE 4096
+#define DRAW_COUNT 32
+#define ITERATION_COUNT 16
+
+static AtlrInstance instance;
+static AtlrDevice device;
+static AtlrSingleRecordCommandContext commandContext;
+static AtlrOffscreenCanvas canvas;
+static AtlrImage texture;
+static VkSampler samplers[2];
+static AtlrDescriptorSetLayout descriptorSetLayout;
+static AtlrDescriptorPool descriptorPool;
+static VkDescriptorSet descriptorSets[2];
+static AtlrPipeline pipeline;
+static VkQueryPool queryPool;
+static float timestampPeriod;
+
+// a fine checkerboard with a coarser grid on top, so every level of the mip chain has detail to average away
+static AtlrU8 initTexture()
+{
+  const AtlrU64 size = 4 * TEXTURE_SIZE * TEXTURE_SIZE;
+  AtlrU8* pixels = malloc(size);
+  for (AtlrU32 y = 0; y < TEXTURE_SIZE; y++)
+    for (AtlrU32 x = 0; x < TEXTURE_SIZE; x++)
+    {
+      AtlrU8* pixel = pixels + 4 * (y * TEXTURE_SIZE + x);
+      const AtlrU8 isChecker = ((x >> 2) ^ (y >> 2)) & 1;
+      const AtlrU8 isGrid = !(x & 127) || !(y & 127);
+      pixel[0] = isGrid ? 255 : (isChecker ? 200 : 40);
+      pixel[1] = isGrid ? 64 : (isChecker ? 200 : 40);
+      pixel[2] = isGrid ? 0 : (isChecker ? 200 : 40);
+      pixel[3] = 255;
+    }
+  
+  const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+  const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | atlrGetMipmapImageUsage(device.physical, format);
+  const AtlrU32 mipLevels = atlrGetMipLevelCount(TEXTURE_SIZE, TEXTURE_SIZE);
+  if (!atlrInitImage(&texture, TEXTURE_SIZE, TEXTURE_SIZE, mipLevels, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage,
+		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitImage returned 0.");
+    free(pixels);
+    return 0;
+  }
+
+  AtlrBuffer stagingBuffer;
+  if (!atlrInitStagingBuffer(&stagingBuffer, size, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitStagingBuffer returned 0.");
+    free(pixels);
+    return 0;
+  }
+  const AtlrU8 isWritten = atlrWriteBuffer(&stagingBuffer, 0, size, 0, pixels);
+  free(pixels);
+  if (!isWritten)
+  {
+    ATLR_ERROR_MSG("atlrWriteBuffer returned 0.");
+    atlrDeinitBuffer(&stagingBuffer);
+    return 0;
+  }
+
+  const VkOffset2D offset = {.x = 0, .y = 0};
+  const VkExtent2D extent = {.width = TEXTURE_SIZE, .height = TEXTURE_SIZE};
+  if (!atlrTransitionImageLayout(&texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &commandContext)
+      || !atlrCopyBufferToImage(&stagingBuffer, &texture, &offset, &extent, &commandContext))
+  {
+    ATLR_ERROR_MSG("Failed to stage texture image.");
+    atlrDeinitBuffer(&stagingBuffer);
+    return 0;
+  }
+  atlrDeinitBuffer(&stagingBuffer);
+
+  const AtlrU64 startTime = atlrGetTimeNanoseconds();
+  if (!atlrGenerateMipmaps(&texture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &commandContext))
+  {
+    ATLR_ERROR_MSG("atlrGenerateMipmaps returned 0.");
+    return 0;
+  }
+  atlrLog(ATLR_LOG_INFO, "Generated %u mip levels with %s in %.3f ms.", mipLevels - 1,
+	  atlrIsMipmapBlitSupported(device.physical, format) ? "blits" : "compute", 1e-6 * (atlrGetTimeNanoseconds() - startTime));
+
+  return 1;
+}
+
+// the same texture is read through a sampler clamped to the top level and through one using the whole mip chain
+static AtlrU8 initDescriptor()
+{
+  VkSamplerCreateInfo samplerInfo = atlrInitSamplerInfo(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT);
+  samplers[1] = atlrAcquireSampler(&device, &samplerInfo);
+  samplerInfo.maxLod = 0.0f;
+  samplers[0] = atlrAcquireSampler(&device, &samplerInfo);
+  if (!samplers[0] || !samplers[1])
+  {
+    ATLR_ERROR_MSG("atlrAcquireSampler returned VK_NULL_HANDLE.");
+    return 0;
+  }
+
+  const VkDescriptorType type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  const VkDescriptorSetLayoutBinding binding = atlrInitDescriptorSetLayoutBinding(0, type, VK_SHADER_STAGE_FRAGMENT_BIT);
+  if (!atlrInitDescriptorSetLayout(&descriptorSetLayout, 1, &binding, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorSetLayout returned 0.");
+    return 0;
+  }
+
+  const VkDescriptorPoolSize poolSize = atlrInitDescriptorPoolSize(type, 2);
+  if (!atlrInitDescriptorPool(&descriptorPool, 2, 1, &poolSize, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorPool returned 0.");
+    return 0;
+  }
+
+  const VkDescriptorSetLayout setLayouts[2] = {descriptorSetLayout.layout, descriptorSetLayout.layout};
+  if (!atlrAllocDescriptorSets(&descriptorPool, 2, setLayouts, descriptorSets))
+  {
+    ATLR_ERROR_MSG("atlrAllocDescriptorSets returned 0.");
+    return 0;
+  }
+
+  const VkDescriptorImageInfo imageInfos[2] =
+  {
+    atlrInitDescriptorImageInfo(&texture, samplers[0], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+    atlrInitDescriptorImageInfo(&texture, samplers[1], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+  };
+  const VkWriteDescriptorSet descriptorWrites[2] =
+  {
+    atlrWriteImageDescriptorSet(descriptorSets[0], 0, type, imageInfos),
+    atlrWriteImageDescriptorSet(descriptorSets[1], 0, type, imageInfos + 1)
+  };
+  vkUpdateDescriptorSets(device.logical, 2, descriptorWrites, 0, NULL);
+
+  return 1;
+}
+
+static void deinitDescriptor()
+{
+  atlrDeinitDescriptorPool(&descriptorPool);
+  atlrDeinitDescriptorSetLayout(&descriptorSetLayout);
+  atlrReleaseSampler(&device, samplers[0]);
+  atlrReleaseSampler(&device, samplers[1]);
+}
+
+static AtlrU8 initPipeline()
+{
+  VkShaderModule modules[2] =
+  {
+    atlrInitShaderModule("plane-vert.spv", &device),
+    atlrInitShaderModule("plane-frag.spv", &device)
+  };
+  if (!modules[0] || !modules[1])
+  {
+    ATLR_ERROR_MSG("atlrInitShaderModule returned VK_NULL_HANDLE.");
+    return 0;
+  }
+  const VkPipelineShaderStageCreateInfo stageInfos[2] =
+  {
+    atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_VERTEX_BIT, modules[0]),
+    atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, modules[1])
+  };
+
+  VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+  vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+  // the plane is seen from above and the draws are meant to overlap, so neither culling nor depth testing is wanted
+  VkPipelineRasterizationStateCreateInfo rasterizationInfo = atlrInitPipelineRasterizationStateInfo();
+  rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+  VkPipelineDepthStencilStateCreateInfo depthStencilInfo = atlrInitPipelineDepthStencilStateInfo();
+  depthStencilInfo.depthTestEnable = VK_FALSE;
+  depthStencilInfo.depthWriteEnable = VK_FALSE;
+  
+  const VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo = atlrInitPipelineInputAssemblyStateInfo();
+  const VkPipelineViewportStateCreateInfo viewportInfo           = atlrInitPipelineViewportStateInfo();
+  const VkPipelineMultisampleStateCreateInfo multisampleInfo     = atlrInitPipelineMultisampleStateInfo(VK_SAMPLE_COUNT_1_BIT);
+  const VkPipelineColorBlendAttachmentState colorBlendAttachment = atlrInitPipelineColorBlendAttachmentStateAlpha();
+  const VkPipelineColorBlendStateCreateInfo colorBlendInfo       = atlrInitPipelineColorBlendStateInfo(&colorBlendAttachment);
+  const VkPipelineDynamicStateCreateInfo dynamicInfo             = atlrInitPipelineDynamicStateInfo();
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo            = atlrInitPipelineLayoutInfo(1, &descriptorSetLayout.layout, 0, NULL);
+  const VkPipelineRenderingCreateInfo renderingInfo              = atlrInitPipelineRenderingInfo(1, &canvas.colorImage.format, canvas.depthImage.format);
+
+  const AtlrU8 isInit = atlrInitGraphicsPipelineDynamicRendering(&pipeline,
+								 2, stageInfos, &vertexInputInfo, &inputAssemblyInfo, NULL, &viewportInfo, &rasterizationInfo, &multisampleInfo, &depthStencilInfo, &colorBlendInfo, &dynamicInfo, &pipelineLayoutInfo,
+								 &renderingInfo, &device);
+  atlrDeinitShaderModule(modules[0], &device);
+  atlrDeinitShaderModule(modules[1], &device);
+  if (!isInit)
+  {
+    ATLR_ERROR_MSG("atlrInitGraphicsPipelineDynamicRendering returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static AtlrU8 initQueryPool()
+{
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device.physical, &properties);
+  if (!properties.limits.timestampComputeAndGraphics)
+  {
+    ATLR_ERROR_MSG("The device does not support timestamps on its graphics queues.");
+    return 0;
+  }
+  timestampPeriod = properties.limits.timestampPeriod;
+  
+  const VkQueryPoolCreateInfo queryPoolInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .queryType = VK_QUERY_TYPE_TIMESTAMP,
+    .queryCount = 2,
+    .pipelineStatistics = 0
+  };
+  if (vkCreateQueryPool(device.logical, &queryPoolInfo, instance.allocator, &queryPool) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateQueryPool did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// Device time covers the draws only, between two timestamps; host time also covers the submission and the wait on the device.
+static AtlrU8 benchmark(const char* restrict name, const VkDescriptorSet descriptorSet)
+{
+  AtlrU64 deviceTime = 0;
+  AtlrU64 hostTime = 0;
+  for (AtlrU32 i = 0; i < ITERATION_COUNT; i++)
+  {
+    const AtlrU64 startTime = atlrGetTimeNanoseconds();
+    
+    VkCommandBuffer commandBuffer;
+    if (!atlrBeginSingleRecordCommands(&commandBuffer, &commandContext))
+    {
+      ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+      return 0;
+    }
+    vkCmdResetQueryPool(commandBuffer, queryPool, 0, 2);
+    if (!atlrOffscreenCanvasBeginRendering(&canvas, commandBuffer))
+    {
+      ATLR_ERROR_MSG("atlrOffscreenCanvasBeginRendering returned 0.");
+      return 0;
+    }
+
+    vkCmdBindPipeline(commandBuffer, pipeline.bindPoint, pipeline.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, pipeline.bindPoint, pipeline.layout, 0, 1, &descriptorSet, 0, NULL);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+    for (AtlrU32 j = 0; j < DRAW_COUNT; j++)
+      vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1);
+
+    if (!atlrOffscreenCanvasEndRendering(&canvas, commandBuffer))
+    {
+      ATLR_ERROR_MSG("atlrOffscreenCanvasEndRendering returned 0.");
+      return 0;
+    }
+    if (!atlrEndSingleRecordCommands(commandBuffer, &commandContext))
+    {
+      ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+      return 0;
+    }
+
+    hostTime += atlrGetTimeNanoseconds() - startTime;
+
+    AtlrU64 timestamps[2];
+    if (vkGetQueryPoolResults(device.logical, queryPool, 0, 2, sizeof(timestamps), timestamps, sizeof(AtlrU64),
+			      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+    {
+      ATLR_ERROR_MSG("vkGetQueryPoolResults did not return VK_SUCCESS.");
+      return 0;
+    }
+    deviceTime += (AtlrU64)((timestamps[1] - timestamps[0]) * timestampPeriod);
+  }
+
+  atlrLog(ATLR_LOG_INFO, "%s: %.3f ms of device time and %.3f ms of host time per frame of %d plane draws.",
+	  name, 1e-6 * deviceTime / ITERATION_COUNT, 1e-6 * hostTime / ITERATION_COUNT, DRAW_COUNT);
+  return 1;
+}
+
+static AtlrU8 initMipmapBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Starting 'Mipmap Benchmark' demo ...");
+
+  if (!atlrInitInstanceHostHeadless(&instance, "Mipmap Benchmark Demo", NULL))
+  {
+    ATLR_ERROR_MSG("atlrInitInstanceHostHeadless returned 0.");
+    return 0;
+  }
+
+  // texture bandwidth is what is measured, so a discrete GPU is preferred
+  AtlrDeviceCriteria deviceCriteria;
+  atlrInitDeviceCriteria(deviceCriteria);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_QUEUE_FAMILY_GRAPHICS_SUPPORT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_DYNAMIC_RENDERING,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_DISCRETE_GPU_PHYSICAL_DEVICE,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 10);
+  if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
+  {
+    ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
+    return 0;
+  }
+
+  if (!atlrInitSingleRecordCommandContext(&commandContext, device.queueFamilyIndices.graphicsComputeIndex, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitSingleRecordCommandContext returned 0.");
+    return 0;
+  }
+
+  const VkExtent2D extent = {.width = 1920, .height = 1080};
+  if (!atlrInitDynamicRenderingOffscreenCanvas(&canvas, &extent, VK_FORMAT_R8G8B8A8_UNORM, NULL, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDynamicRenderingOffscreenCanvas returned 0.");
+    return 0;
+  }
+
+  if (!initTexture())
+  {
+    ATLR_ERROR_MSG("initTexture returned 0.");
+    return 0;
+  }
+
+  if (!initDescriptor())
+  {
+    ATLR_ERROR_MSG("initDescriptor returned 0.");
+    return 0;
+  }
+
+  if (!initPipeline())
+  {
+    ATLR_ERROR_MSG("initPipeline returned 0.");
+    return 0;
+  }
+
+  if (!initQueryPool())
+  {
+    ATLR_ERROR_MSG("initQueryPool returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitMipmapBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Ending 'Mipmap Benchmark' demo ...");
+
+  vkDeviceWaitIdle(device.logical);
+
+  vkDestroyQueryPool(device.logical, queryPool, instance.allocator);
+  atlrDeinitPipeline(&pipeline);
+  deinitDescriptor();
+  atlrDeinitImage(&texture);
+  atlrDeinitOffscreenCanvas(&canvas, 0);
+  atlrDeinitSingleRecordCommandContext(&commandContext);
+  atlrDeinitDeviceHost(&device);
+  atlrDeinitInstanceHostHeadless(&instance);
+}
+
+int main()
+{
+  if (!initMipmapBenchmark())
+  {
+    ATLR_FATAL_MSG("initMipmapBenchmark returned 0.");
+    return -1;
+  }
+
+  // warm up both paths so that first use costs in the driver are not measured
+  if (!benchmark("Top level warm up", descriptorSets[0]) || !benchmark("Mip chain warm up", descriptorSets[1]))
+  {
+    ATLR_FATAL_MSG("benchmark returned 0.");
+    return -1;
+  }
+
+  if (!benchmark("Top level", descriptorSets[0]) || !benchmark("Mip chain", descriptorSets[1]))
+  {
+    ATLR_FATAL_MSG("benchmark returned 0.");
+    return -1;
+  }
+
+  deinitMipmapBenchmark();
+  return 0;
+}
@@ -0,0 +1,37 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#version 460
+
+layout(location = 0) out vec2 outUv;
+
+const vec2 corners[6] = vec2[6](vec2(-1.0, 0.0), vec2(1.0, 0.0), vec2(-1.0, 1.0), vec2(-1.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0));
+
+void main()
+{
+	// a ground plane below the camera, reaching from just in front of it far into the distance
+	const vec2 corner = corners[gl_VertexIndex];
+	const vec3 position = vec3(64.0 * corner.x, -1.0, 0.5 + 256.0 * corner.y);
+	outUv = 0.25 * position.xz;
+
+	// perspective projection with a 90 degree field of view, y points down in clip space
+	gl_Position = vec4(position.x, -position.y, 0.0, position.z);
+}
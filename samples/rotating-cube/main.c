@@ -109,7 +109,7 @@ static AtlrU8 initRotatingCube()
 {
   atlrLog(ATLR_LOG_INFO, "Starting 'Rotating Cube' demo ...");
 
-  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Rotating Cube Demo"))
+  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Rotating Cube Demo", NULL))
   {
     ATLR_ERROR_MSG("atlrInitHostGLFW returned 0.");
     return 0;
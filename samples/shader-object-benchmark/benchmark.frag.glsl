@@ -0,0 +1,33 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+#version 460
+
+// each material is a specialization of this shader, so switching materials switches shaders
+layout(constant_id = 0) const uint material = 0;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+	const float hue = float(material) / 8.0;
+	outColor = vec4(abs(hue * 6.0 - 3.0) - 1.0, 2.0 - abs(hue * 6.0 - 2.0), 2.0 - abs(hue * 6.0 - 4.0), 1.0);
+	outColor.rgb = clamp(outColor.rgb, 0.0, 1.0);
+}
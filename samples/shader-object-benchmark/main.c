@@ -0,0 +1,349 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+#include "../../src/antler.h"
+#include "../../src/offscreen-canvas.h"
+
+// Every draw switches material, and every material is a different fragment shader.
+// The pipeline path binds a whole pipeline per draw, while the shader object path only rebinds the fragment stage.
+#define MATERIAL_COUNT 8
+#define DRAW_COUNT 10000
+#define ITERATION_COUNT 16
+
+static AtlrHostAllocator hostAllocator;
+static AtlrInstance instance;
+static AtlrDevice device;
+static AtlrSingleRecordCommandContext commandContext;
+static AtlrOffscreenCanvas canvas;
+static AtlrPipeline pipelines[MATERIAL_COUNT];
+static AtlrShaderObject vertexShader;
+static AtlrShaderObject fragmentShaders[MATERIAL_COUNT];
+
+static AtlrU32 materials[MATERIAL_COUNT];
+static const VkSpecializationMapEntry specializationEntry =
+{
+  .constantID = 0,
+  .offset = 0,
+  .size = sizeof(AtlrU32)
+};
+static VkSpecializationInfo specializationInfos[MATERIAL_COUNT];
+
+static void initSpecializationInfos()
+{
+  for (AtlrU32 i = 0; i < MATERIAL_COUNT; i++)
+  {
+    materials[i] = i;
+    specializationInfos[i] = (VkSpecializationInfo)
+    {
+      .mapEntryCount = 1,
+      .pMapEntries = &specializationEntry,
+      .dataSize = sizeof(AtlrU32),
+      .pData = materials + i
+    };
+  }
+}
+
+static AtlrU8 initPipelines()
+{
+  const AtlrU64 startTime = atlrGetTimeNanoseconds();
+  
+  VkShaderModule modules[2] =
+  {
+    atlrInitShaderModule("benchmark-vert.spv", &device),
+    atlrInitShaderModule("benchmark-frag.spv", &device)
+  };
+  if (!modules[0] || !modules[1])
+  {
+    ATLR_ERROR_MSG("atlrInitShaderModule returned VK_NULL_HANDLE.");
+    return 0;
+  }
+  VkPipelineShaderStageCreateInfo stageInfos[2] =
+  {
+    atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_VERTEX_BIT, modules[0]),
+    atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, modules[1])
+  };
+
+  VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+  vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+  const VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo = atlrInitPipelineInputAssemblyStateInfo();
+  const VkPipelineViewportStateCreateInfo viewportInfo           = atlrInitPipelineViewportStateInfo();
+  const VkPipelineRasterizationStateCreateInfo rasterizationInfo = atlrInitPipelineRasterizationStateInfo();
+  const VkPipelineMultisampleStateCreateInfo multisampleInfo     = atlrInitPipelineMultisampleStateInfo(VK_SAMPLE_COUNT_1_BIT);
+  const VkPipelineDepthStencilStateCreateInfo depthStencilInfo   = atlrInitPipelineDepthStencilStateInfo();
+  const VkPipelineColorBlendAttachmentState colorBlendAttachment = atlrInitPipelineColorBlendAttachmentStateAlpha();
+  const VkPipelineColorBlendStateCreateInfo colorBlendInfo       = atlrInitPipelineColorBlendStateInfo(&colorBlendAttachment);
+  const VkPipelineDynamicStateCreateInfo dynamicInfo             = atlrInitPipelineDynamicStateInfo();
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo            = atlrInitPipelineLayoutInfo(0, NULL, 0, NULL);
+  const VkPipelineRenderingCreateInfo renderingInfo              = atlrInitPipelineRenderingInfo(1, &canvas.colorImage.format, canvas.depthImage.format);
+
+  for (AtlrU32 i = 0; i < MATERIAL_COUNT; i++)
+  {
+    stageInfos[1].pSpecializationInfo = specializationInfos + i;
+    if (!atlrInitGraphicsPipelineDynamicRendering(pipelines + i,
+						  2, stageInfos, &vertexInputInfo, &inputAssemblyInfo, NULL, &viewportInfo, &rasterizationInfo, &multisampleInfo, &depthStencilInfo, &colorBlendInfo, &dynamicInfo, &pipelineLayoutInfo,
+						  &renderingInfo, &device))
+    {
+      ATLR_ERROR_MSG("atlrInitGraphicsPipelineDynamicRendering returned 0.");
+      return 0;
+    }
+  }
+
+  atlrDeinitShaderModule(modules[0], &device);
+  atlrDeinitShaderModule(modules[1], &device);
+
+  atlrLog(ATLR_LOG_INFO, "Created %d pipelines in %.3f ms.", MATERIAL_COUNT, 1e-6 * (atlrGetTimeNanoseconds() - startTime));
+  return 1;
+}
+
+static void deinitPipelines()
+{
+  for (AtlrU32 i = 0; i < MATERIAL_COUNT; i++)
+    atlrDeinitPipeline(pipelines + i);
+}
+
+static AtlrU8 initShaderObjects()
+{
+  const AtlrU64 startTime = atlrGetTimeNanoseconds();
+  
+  AtlrSpirVBinary vertexBin, fragmentBin;
+  if (!atlrInitSpirVBinaryFromFile(&vertexBin, "benchmark-vert.spv"))
+  {
+    ATLR_ERROR_MSG("atlrInitSpirVBinaryFromFile returned 0.");
+    return 0;
+  }
+  if (!atlrInitSpirVBinaryFromFile(&fragmentBin, "benchmark-frag.spv"))
+  {
+    ATLR_ERROR_MSG("atlrInitSpirVBinaryFromFile returned 0.");
+    atlrDeinitSpirVBinary(&vertexBin);
+    return 0;
+  }
+
+  // the shaders are left unlinked so that any material can follow the one vertex shader
+  const VkShaderCreateInfoEXT vertexInfo = atlrInitShaderObjectInfo(VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT, &vertexBin, 0, NULL, 0, NULL);
+  VkShaderCreateInfoEXT fragmentInfos[MATERIAL_COUNT];
+  for (AtlrU32 i = 0; i < MATERIAL_COUNT; i++)
+  {
+    fragmentInfos[i] = atlrInitShaderObjectInfo(VK_SHADER_STAGE_FRAGMENT_BIT, 0, &fragmentBin, 0, NULL, 0, NULL);
+    fragmentInfos[i].pSpecializationInfo = specializationInfos + i;
+  }
+  const AtlrU8 isInit = atlrInitShaderObjects(&vertexShader, 1, &vertexInfo, 0, &device)
+    && atlrInitShaderObjects(fragmentShaders, MATERIAL_COUNT, fragmentInfos, 0, &device);
+  
+  atlrDeinitSpirVBinary(&fragmentBin);
+  atlrDeinitSpirVBinary(&vertexBin);
+  if (!isInit)
+  {
+    ATLR_ERROR_MSG("atlrInitShaderObjects returned 0.");
+    return 0;
+  }
+
+  atlrLog(ATLR_LOG_INFO, "Created %d shader objects in %.3f ms.", MATERIAL_COUNT + 1, 1e-6 * (atlrGetTimeNanoseconds() - startTime));
+  return 1;
+}
+
+static void deinitShaderObjects()
+{
+  for (AtlrU32 i = 0; i < MATERIAL_COUNT; i++)
+    atlrDeinitShaderObject(fragmentShaders + i);
+  atlrDeinitShaderObject(&vertexShader);
+}
+
+static void recordPipelineDraws(const VkCommandBuffer commandBuffer)
+{
+  for (AtlrU32 i = 0; i < DRAW_COUNT; i++)
+  {
+    const AtlrPipeline* pipeline = pipelines + (i % MATERIAL_COUNT);
+    device.pfnCmdBindPipeline(commandBuffer, pipeline->bindPoint, pipeline->pipeline);
+    device.pfnCmdDraw(commandBuffer, 3, 1, 0, 0);
+  }
+}
+
+static void recordShaderObjectDraws(const VkCommandBuffer commandBuffer)
+{
+  // the state is recorded once and persists across shader binds
+  const AtlrExtendedDynamicState state = atlrInitExtendedDynamicState();
+  atlrCommandSetShaderObjectState(commandBuffer, &state, canvas.extent, VK_SAMPLE_COUNT_1_BIT, 0, NULL, 0, NULL, &device);
+  const AtlrShaderObject shaders[2] = {vertexShader, fragmentShaders[0]};
+  atlrCommandBindShaderObjects(commandBuffer, 2, shaders, &device);
+  
+  for (AtlrU32 i = 0; i < DRAW_COUNT; i++)
+  {
+    atlrCommandBindShaderObject(commandBuffer, fragmentShaders + (i % MATERIAL_COUNT), &device);
+    device.pfnCmdDraw(commandBuffer, 3, 1, 0, 0);
+  }
+}
+
+// Recording time only covers the binds and draws; frame time also covers the submission and the wait on the device.
+static AtlrU8 benchmark(const char* restrict name, void (*record)(const VkCommandBuffer))
+{
+  AtlrU64 recordTime = 0;
+  AtlrU64 frameTime = 0;
+  for (AtlrU32 i = 0; i < ITERATION_COUNT; i++)
+  {
+    const AtlrU64 frameStartTime = atlrGetTimeNanoseconds();
+    
+    VkCommandBuffer commandBuffer;
+    if (!atlrBeginSingleRecordCommands(&commandBuffer, &commandContext))
+    {
+      ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+      return 0;
+    }
+    if (!atlrOffscreenCanvasBeginRendering(&canvas, commandBuffer))
+    {
+      ATLR_ERROR_MSG("atlrOffscreenCanvasBeginRendering returned 0.");
+      return 0;
+    }
+
+    const AtlrU64 recordStartTime = atlrGetTimeNanoseconds();
+    record(commandBuffer);
+    recordTime += atlrGetTimeNanoseconds() - recordStartTime;
+
+    if (!atlrOffscreenCanvasEndRendering(&canvas, commandBuffer))
+    {
+      ATLR_ERROR_MSG("atlrOffscreenCanvasEndRendering returned 0.");
+      return 0;
+    }
+    if (!atlrEndSingleRecordCommands(commandBuffer, &commandContext))
+    {
+      ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+      return 0;
+    }
+
+    frameTime += atlrGetTimeNanoseconds() - frameStartTime;
+  }
+
+  atlrLog(ATLR_LOG_INFO, "%s: %.1f ns recording per bind and draw, %.3f ms per frame of %d draws.",
+	  name, (double)recordTime / (ITERATION_COUNT * DRAW_COUNT), 1e-6 * frameTime / ITERATION_COUNT, DRAW_COUNT);
+  return 1;
+}
+
+static AtlrU8 initShaderObjectBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Starting 'Shader Object Benchmark' demo ...");
+
+  // the driver's host allocations are counted so that pipeline and shader object creation can be compared
+  if (!atlrInitHostAllocator(&hostAllocator))
+  {
+    ATLR_ERROR_MSG("atlrInitHostAllocator returned 0.");
+    return 0;
+  }
+
+  if (!atlrInitInstanceHostHeadless(&instance, "Shader Object Benchmark Demo", &hostAllocator.callbacks))
+  {
+    ATLR_ERROR_MSG("atlrInitInstanceHostHeadless returned 0.");
+    return 0;
+  }
+
+  // lavapipe is preferred so that results are comparable across machines
+  AtlrDeviceCriteria deviceCriteria;
+  atlrInitDeviceCriteria(deviceCriteria);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_QUEUE_FAMILY_GRAPHICS_SUPPORT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_DYNAMIC_RENDERING,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_SHADER_OBJECT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_CPU_PHYSICAL_DEVICE,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 10);
+  if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
+  {
+    ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
+    return 0;
+  }
+
+  if (!atlrInitSingleRecordCommandContext(&commandContext, device.queueFamilyIndices.graphicsComputeIndex, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitSingleRecordCommandContext returned 0.");
+    return 0;
+  }
+
+  const VkExtent2D extent = {.width = 256, .height = 256};
+  if (!atlrInitDynamicRenderingOffscreenCanvas(&canvas, &extent, VK_FORMAT_R8G8B8A8_UNORM, NULL, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDynamicRenderingOffscreenCanvas returned 0.");
+    return 0;
+  }
+
+  initSpecializationInfos();
+  
+  if (!initPipelines())
+  {
+    ATLR_ERROR_MSG("initPipelines returned 0.");
+    return 0;
+  }
+
+  if (!initShaderObjects())
+  {
+    ATLR_ERROR_MSG("initShaderObjects returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitShaderObjectBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Ending 'Shader Object Benchmark' demo ...");
+
+  vkDeviceWaitIdle(device.logical);
+
+  deinitShaderObjects();
+  deinitPipelines();
+  atlrDeinitOffscreenCanvas(&canvas, 0);
+  atlrDeinitSingleRecordCommandContext(&commandContext);
+  atlrDeinitDeviceHost(&device);
+  atlrDeinitInstanceHostHeadless(&instance);
+  atlrLogHostAllocatorStats(&hostAllocator);
+  atlrDeinitHostAllocator(&hostAllocator);
+}
+
+int main()
+{
+  if (!initShaderObjectBenchmark())
+  {
+    ATLR_FATAL_MSG("initShaderObjectBenchmark returned 0.");
+    return -1;
+  }
+
+  // warm up both paths so that first use costs in the driver are not measured
+  if (!benchmark("Pipeline warm up", recordPipelineDraws) || !benchmark("Shader object warm up", recordShaderObjectDraws))
+  {
+    ATLR_FATAL_MSG("benchmark returned 0.");
+    return -1;
+  }
+
+  if (!benchmark("Pipeline", recordPipelineDraws) || !benchmark("Shader object", recordShaderObjectDraws))
+  {
+    ATLR_FATAL_MSG("benchmark returned 0.");
+    return -1;
+  }
+
+  deinitShaderObjectBenchmark();
+  return 0;
+}
@@ -257,7 +257,7 @@ static AtlrU8 initShellTexturing()
 {
   atlrLog(ATLR_LOG_INFO, "Starting 'Shell Texturing' demo ...");
 
-  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Shell Texturing Demo"))
+  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Shell Texturing Demo", NULL))
   {
     ATLR_ERROR_MSG("atlrInitHostGLFW returned 0.");
     return 0;
@@ -520,7 +520,7 @@ int main()
 #ifdef ATLR_DEBUG
     {
       const float color[4] = {0.2f, 0.2f, 0.9f, 1.0f};
-      atlrBeginCommandLabel(commandBuffer, "Shells draw", color, &instance);
+      atlrBeginCommandLabel(commandBuffer, "Shells draw", color, &device);
     }
 #endif
 
@@ -541,7 +541,7 @@ int main()
     atlrDrawMesh(msh, commandBuffer);
 
 #ifdef ATLR_DEBUG
-    atlrEndCommandLabel(commandBuffer, &instance);
+    atlrEndCommandLabel(commandBuffer, &device);
 #endif
 
     // imgui
@@ -575,7 +575,7 @@ int main()
       ImGui::SliderFloat("diffuse contribution", &grassUniformData.diffuseContrib, 0.0f, 1.0f, "%.3f", 0);
     }
     ImGui::End();
-    imguiContext.draw(commandBuffer, commandContext.currentFrame);
+    imguiContext.draw(commandBuffer, &commandContext);
 
     // end render pass
     if (!atlrFrameCommandContextEndRenderPassHostGLFW(&commandContext))
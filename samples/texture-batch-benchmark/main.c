@@ -0,0 +1,134 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+
+#include "../../src/antler.h"
+
+// Loads the given image files one at a time and then as a single batch, logging the time each takes until the textures are resident.
+// The batch decodes on a pool of worker threads and uploads everything in one submission.
+
+static AtlrInstance instance;
+static AtlrDevice device;
+static AtlrSingleRecordCommandContext commandContext;
+
+static AtlrU8 initTextureBatchBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Starting 'Texture Batch Benchmark' demo ...");
+
+  if (!atlrInitInstanceHostHeadless(&instance, "Texture Batch Benchmark Demo", NULL))
+  {
+    ATLR_ERROR_MSG("atlrInitInstanceHostHeadless returned 0.");
+    return 0;
+  }
+
+  AtlrDeviceCriteria deviceCriteria;
+  atlrInitDeviceCriteria(deviceCriteria);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_QUEUE_FAMILY_GRAPHICS_SUPPORT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
+  {
+    ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
+    return 0;
+  }
+
+  if (!atlrInitSingleRecordCommandContext(&commandContext, device.queueFamilyIndices.graphicsComputeIndex, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitSingleRecordCommandContext returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitTextureBatchBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Ending 'Texture Batch Benchmark' demo ...");
+
+  atlrDeinitSingleRecordCommandContext(&commandContext);
+  atlrDeinitDeviceHost(&device);
+  atlrDeinitInstanceHostHeadless(&instance);
+}
+
+static AtlrU8 loadSerial(const AtlrU32 fileCount, const char* const* filePaths, AtlrImage* restrict images)
+{
+  const AtlrU64 start = atlrGetTimeNanoseconds();
+  for (AtlrU32 i = 0; i < fileCount; i++)
+    if (!atlrInitImageRgbaTextureFromFile(images + i, filePaths[i], 1, &device, &commandContext))
+    {
+      ATLR_ERROR_MSG("atlrInitImageRgbaTextureFromFile returned 0.");
+      return 0;
+    }
+  const AtlrU64 end = atlrGetTimeNanoseconds();
+  atlrLog(ATLR_LOG_INFO, "Serial: %u textures resident after %.3f ms.", fileCount, 1e-6 * (end - start));
+
+  for (AtlrU32 i = 0; i < fileCount; i++)
+    atlrDeinitImage(images + i);
+  return 1;
+}
+
+static AtlrU8 loadBatch(const AtlrU32 fileCount, const char* const* filePaths, AtlrImage* restrict images)
+{
+  AtlrTextureBatchTimings timings;
+  const AtlrU64 start = atlrGetTimeNanoseconds();
+  if (!atlrInitImageRgbaTexturesFromFiles(images, fileCount, filePaths, 1, &timings, &device, &commandContext))
+  {
+    ATLR_ERROR_MSG("atlrInitImageRgbaTexturesFromFiles returned 0.");
+    return 0;
+  }
+  const AtlrU64 end = atlrGetTimeNanoseconds();
+  atlrLog(ATLR_LOG_INFO, "Batch: %u textures resident after %.3f ms (decode %.3f ms, copy %.3f ms, device %.3f ms).", fileCount, 1e-6 * (end - start),
+	  1e-6 * timings.decodeNanoseconds, 1e-6 * timings.copyNanoseconds, 1e-6 * timings.gpuNanoseconds);
+
+  for (AtlrU32 i = 0; i < fileCount; i++)
+    atlrDeinitImage(images + i);
+  return 1;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    ATLR_FATAL_MSG("Usage: %s <image-path> ...", argv[0]);
+    return -1;
+  }
+  const AtlrU32 fileCount = argc - 1;
+  const char* const* filePaths = (const char* const*)(argv + 1);
+
+  if (!initTextureBatchBenchmark())
+  {
+    ATLR_FATAL_MSG("initTextureBatchBenchmark returned 0.");
+    return -1;
+  }
+
+  // the first batch is a warm up, so that both measured loads read the files from the page cache
+  AtlrImage* images = malloc(fileCount * sizeof(AtlrImage));
+  if (!loadBatch(fileCount, filePaths, images) || !loadSerial(fileCount, filePaths, images) || !loadBatch(fileCount, filePaths, images))
+  {
+    ATLR_FATAL_MSG("Texture loading failed.");
+    return -1;
+  }
+  free(images);
+
+  deinitTextureBatchBenchmark();
+  return 0;
+}
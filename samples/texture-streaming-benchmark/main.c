@@ -0,0 +1,190 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+
+#include "../../src/antler.h"
+
+// Streams a row of KTX2 textures while a focus point sweeps along it: textures near the focus ask for their finest levels,
+// those further away for coarser ones, and the budget only holds a few full mip chains, so levels are evicted as the focus moves on.
+// Every given file is added COPY_COUNT times. The host time spent recording each update and the time until its commands finish are logged.
+#define COPY_COUNT 16
+#define FRAME_COUNT 512
+#define BUDGET (64ULL << 20)
+#define UPLOAD_LIMIT (8ULL << 20)
+
+static AtlrInstance instance;
+static AtlrDevice device;
+static AtlrSingleRecordCommandContext commandContext;
+static AtlrBindlessTable table;
+static AtlrTextureResidency residency;
+static AtlrU32 textureCount;
+
+static AtlrU8 initTextureStreamingBenchmark(const AtlrU32 fileCount, char* const* filePaths)
+{
+  atlrLog(ATLR_LOG_INFO, "Starting 'Texture Streaming Benchmark' demo ...");
+
+  if (!atlrInitInstanceHostHeadless(&instance, "Texture Streaming Benchmark Demo", NULL))
+  {
+    ATLR_ERROR_MSG("atlrInitInstanceHostHeadless returned 0.");
+    return 0;
+  }
+
+  AtlrDeviceCriteria deviceCriteria;
+  atlrInitDeviceCriteria(deviceCriteria);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_QUEUE_FAMILY_GRAPHICS_SUPPORT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_DESCRIPTOR_INDEXING,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_TEXTURE_COMPRESSION_BC,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 10);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_TEXTURE_COMPRESSION_ETC2,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 5);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_MEMORY_BUDGET,
+			 ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT,
+			 5);
+  if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
+  {
+    ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
+    return 0;
+  }
+
+  if (!atlrInitSingleRecordCommandContext(&commandContext, device.queueFamilyIndices.graphicsComputeIndex, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitSingleRecordCommandContext returned 0.");
+    return 0;
+  }
+
+  // every update may retire a handle per texture, and those stay taken until the next update
+  textureCount = fileCount * COPY_COUNT;
+  if (!atlrInitBindlessTable(&table, 4 * textureCount, 1, VK_SHADER_STAGE_FRAGMENT_BIT, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitBindlessTable returned 0.");
+    return 0;
+  }
+
+  // each frame is waited on before the next one is recorded, so there is one frame in flight
+  if (!atlrInitTextureResidency(&residency, textureCount, BUDGET, UPLOAD_LIMIT, 1, &table, &commandContext, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitTextureResidency returned 0.");
+    return 0;
+  }
+  for (AtlrU32 i = 0; i < textureCount; i++)
+  {
+    AtlrU32 index;
+    if (!atlrAddStreamedTexture(&residency, &index, filePaths[i % fileCount]))
+    {
+      ATLR_ERROR_MSG("atlrAddStreamedTexture returned 0.");
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static void deinitTextureStreamingBenchmark()
+{
+  atlrLog(ATLR_LOG_INFO, "Ending 'Texture Streaming Benchmark' demo ...");
+
+  vkDeviceWaitIdle(device.logical);
+
+  atlrDeinitTextureResidency(&residency);
+  atlrDeinitBindlessTable(&table);
+  atlrDeinitSingleRecordCommandContext(&commandContext);
+  atlrDeinitDeviceHost(&device);
+  atlrDeinitInstanceHostHeadless(&instance);
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    ATLR_FATAL_MSG("Usage: %s <ktx2-file-path> ...\nThe KTX2 files can be made with the ktx2-convert tool.", argv[0]);
+    return -1;
+  }
+
+  if (!initTextureStreamingBenchmark(argc - 1, argv + 1))
+  {
+    ATLR_FATAL_MSG("initTextureStreamingBenchmark returned 0.");
+    return -1;
+  }
+
+  AtlrU64 recordTime = 0;
+  AtlrU64 frameTime = 0;
+  AtlrU32 handleChangeCount = 0;
+  AtlrU64 peakSize = 0;
+  AtlrU32* handles = malloc(textureCount * sizeof(AtlrU32));
+  for (AtlrU32 frame = 0; frame < FRAME_COUNT; frame++)
+  {
+    // the focus sweeps the row twice, and each level coarser per texture of distance
+    const AtlrU32 focus = (2 * frame * textureCount / FRAME_COUNT) % textureCount;
+    for (AtlrU32 i = 0; i < textureCount; i++)
+    {
+      const AtlrU32 distance = (i > focus) ? i - focus : focus - i;
+      atlrRequestStreamedTextureLevel(&residency, i, distance);
+    }
+
+    const AtlrU64 startTime = atlrGetTimeNanoseconds();
+    VkCommandBuffer commandBuffer;
+    if (!atlrBeginSingleRecordCommands(&commandBuffer, &commandContext))
+    {
+      ATLR_FATAL_MSG("atlrBeginSingleRecordCommands returned 0.");
+      return -1;
+    }
+    for (AtlrU32 i = 0; i < textureCount; i++)
+      handles[i] = atlrGetStreamedTextureHandle(&residency, i);
+    const AtlrU64 recordStartTime = atlrGetTimeNanoseconds();
+    if (!atlrUpdateTextureResidency(&residency, commandBuffer))
+    {
+      ATLR_FATAL_MSG("atlrUpdateTextureResidency returned 0.");
+      return -1;
+    }
+    recordTime += atlrGetTimeNanoseconds() - recordStartTime;
+    if (!atlrEndSingleRecordCommands(commandBuffer, &commandContext))
+    {
+      ATLR_FATAL_MSG("atlrEndSingleRecordCommands returned 0.");
+      return -1;
+    }
+    frameTime += atlrGetTimeNanoseconds() - startTime;
+
+    for (AtlrU32 i = 0; i < textureCount; i++)
+      handleChangeCount += atlrGetStreamedTextureHandle(&residency, i) != handles[i];
+    const AtlrU64 size = residency.residentSize + residency.retiredSize;
+    if (size > peakSize) peakSize = size;
+  }
+  free(handles);
+
+  atlrLog(ATLR_LOG_INFO, "%u textures over %u frames: %.3f ms recording and %.3f ms until done per update, %u level changes.",
+	  textureCount, FRAME_COUNT, 1e-6 * recordTime / FRAME_COUNT, 1e-6 * frameTime / FRAME_COUNT, handleChangeCount);
+  atlrLog(ATLR_LOG_INFO, "Peak streamed memory %.1f MiB of a %.1f MiB budget, retired images included.",
+	  (double)peakSize / (1 << 20), (double)BUDGET / (1 << 20));
+
+  deinitTextureStreamingBenchmark();
+  return 0;
+}
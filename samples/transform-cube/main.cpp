@@ -115,7 +115,7 @@ static AtlrU8 initTransformCube()
 {
   atlrLog(ATLR_LOG_INFO, "Starting 'Transform Cube' demo ...");
 
-  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Transform Cube Demo"))
+  if (!atlrInitInstanceHostGLFW(&instance, 800, 400, "Transform Cube Demo", NULL))
   {
     ATLR_ERROR_MSG("atlrInitHostGLFW returned 0.");
     return 0;
@@ -338,14 +338,14 @@ int main()
 #ifdef ATLR_DEBUG
     {
       const float color[4] = {0.2f, 0.2f, 0.9f, 1.0f};
-      atlrBeginCommandLabel(commandBuffer, "Cube draw", color, &instance);
+      atlrBeginCommandLabel(commandBuffer, "Cube draw", color, &device);
     }
 #endif
     atlrBindMesh(&cubeMesh, commandBuffer);
     vkCmdPushConstants(commandBuffer, pipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(WorldTransform), &world);
     atlrDrawMesh(&cubeMesh, commandBuffer);
 #ifdef ATLR_DEBUG
-    atlrEndCommandLabel(commandBuffer, &instance);
+    atlrEndCommandLabel(commandBuffer, &device);
 #endif
 
     // imgui
@@ -362,7 +362,7 @@ int main()
     ImGui::SliderFloat("translate.y", &node.translate.y, -1.0f, 1.0f, "%.3f", 0);
     ImGui::SliderFloat("translate.z", &node.translate.z, -1.0f, 1.0f, "%.3f", 0);
     ImGui::End();
-    imguiContext.draw(commandBuffer, commandContext.currentFrame);
+    imguiContext.draw(commandBuffer, &commandContext);
 
     // end render pass
     if (!atlrFrameCommandContextEndRenderPassHostGLFW(&commandContext))
@@ -59,7 +59,7 @@ void Atlr::ImguiContext::init(const AtlrU8 frameCount, const AtlrSwapchain* rest
   const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
   const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
   const VkMemoryPropertyFlags memoryProperties =  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-  if (!atlrInitImage(&this->fontImage, fontImageWidth, fontImageHeight, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage, memoryProperties, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, device))
+  if (!atlrInitImage(&this->fontImage, fontImageWidth, fontImageHeight, 1, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage, memoryProperties, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, device))
   {
     throw std::runtime_error("atlrInitImage returned 0.");
     return;
@@ -96,39 +96,18 @@ void Atlr::ImguiContext::init(const AtlrU8 frameCount, const AtlrSwapchain* rest
 
   atlrDeinitBuffer(&stagingBuffer);
 
-  VkSamplerCreateInfo samplerInfo =
+  // the sampler comes from the device's cache and is shared, so it is left unnamed
+  const VkSamplerCreateInfo samplerInfo = atlrInitSamplerInfo(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+  this->fontSampler = atlrAcquireSampler(device, &samplerInfo);
+  if (!this->fontSampler)
   {
-    .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-    .pNext = NULL,
-    .flags = 0,
-    .magFilter = VK_FILTER_LINEAR,
-    .minFilter = VK_FILTER_LINEAR,
-    .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-    .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-    .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-    .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-    .mipLodBias = 0.0f,
-    .anisotropyEnable = VK_FALSE,
-    .maxAnisotropy = 1.0f,
-    .compareEnable = VK_FALSE,
-    .compareOp = VK_COMPARE_OP_ALWAYS,
-    .minLod = 0.0f,
-    .maxLod = 0.0f,
-    .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
-    .unnormalizedCoordinates = VK_FALSE
-  };
-  if (vkCreateSampler(device->logical, &samplerInfo, device->instance->allocator, &this->fontSampler) != VK_SUCCESS)
-  {
-    throw std::runtime_error("vkCreateSampler did not return VK_SUCCESS.");
+    throw std::runtime_error("atlrAcquireSampler returned VK_NULL_HANDLE.");
     return;
   }
-#ifdef ATLR_DEBUG
-    atlrSetObjectName(VK_OBJECT_TYPE_SAMPLER, (AtlrU64)this->fontSampler, "Imgui Font Sampler", device);
-#endif
 
   const VkDescriptorType descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     
-  VkDescriptorSetLayoutBinding setLayoutBinding = atlrInitDescriptorSetLayoutBinding(0, descriptorType, VK_SHADER_STAGE_FRAGMENT_BIT);
+  VkDescriptorSetLayoutBinding setLayoutBinding = atlrInitImmutableSamplerDescriptorSetLayoutBinding(0, descriptorType, VK_SHADER_STAGE_FRAGMENT_BIT, &this->fontSampler);
   if (!atlrInitDescriptorSetLayout(&this->descriptorSetLayout, 1, &setLayoutBinding, device))
   {
     throw std::runtime_error("atlrInitDescriptorSetLayout returned 0.");
@@ -150,17 +129,25 @@ void Atlr::ImguiContext::init(const AtlrU8 frameCount, const AtlrSwapchain* rest
 
   this->descriptorSets.resize(frameCount);
 
-  std::vector<VkDescriptorSetLayout> setLayouts;
-  setLayouts.resize(frameCount, this->descriptorSetLayout.layout);
-  if (!atlrAllocDescriptorSets(&this->descriptorPool, frameCount, setLayouts.data(), this->descriptorSets.data()))
+  AtlrArena* scratch = device->instance->scratch;
+  const AtlrU64 scratchMark = atlrGetArenaMark(scratch);
+  VkDescriptorSetLayout* setLayouts = (VkDescriptorSetLayout*)atlrArenaAlloc(scratch, frameCount * sizeof(VkDescriptorSetLayout), ATLR_ARENA_ALIGNMENT);
+  VkWriteDescriptorSet* descriptorWrites = (VkWriteDescriptorSet*)atlrArenaAlloc(scratch, frameCount * sizeof(VkWriteDescriptorSet), ATLR_ARENA_ALIGNMENT);
+  if (!setLayouts || !descriptorWrites)
+  {
+    atlrRewindArena(scratch, scratchMark);
+    throw std::runtime_error("atlrArenaAlloc returned NULL.");
+    return;
+  }
+  for (AtlrU8 i = 0; i < frameCount; i++) setLayouts[i] = this->descriptorSetLayout.layout;
+  if (!atlrAllocDescriptorSets(&this->descriptorPool, frameCount, setLayouts, this->descriptorSets.data()))
   {
+    atlrRewindArena(scratch, scratchMark);
     throw std::runtime_error("atlrAllocDescriptorSets returned 0.");
     return;
   }
 
-  const VkDescriptorImageInfo imageInfo = atlrInitDescriptorImageInfo(&this->fontImage, this->fontSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-  std::vector<VkWriteDescriptorSet> descriptorWrites;
-  descriptorWrites.resize(frameCount);
+  const VkDescriptorImageInfo imageInfo = atlrInitDescriptorImageInfo(&this->fontImage, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
   for (AtlrU8 i = 0; i < frameCount; i++)
   {
 #ifdef ATLR_DEBUG
@@ -171,7 +158,8 @@ void Atlr::ImguiContext::init(const AtlrU8 frameCount, const AtlrSwapchain* rest
     
     descriptorWrites[i] = atlrWriteImageDescriptorSet(descriptorSets[i], 0, descriptorType, &imageInfo);
   }
-  vkUpdateDescriptorSets(device->logical, frameCount, descriptorWrites.data(), 0, NULL);
+  vkUpdateDescriptorSets(device->logical, frameCount, descriptorWrites, 0, NULL);
+  atlrRewindArena(scratch, scratchMark);
 
   const char* vertexShaderSource =
     "#version 460\n"
@@ -317,7 +305,7 @@ void Atlr::ImguiContext::deinit()
   atlrDeinitPipeline(&this->pipeline);
   atlrDeinitDescriptorPool(&this->descriptorPool);
   atlrDeinitDescriptorSetLayout(&this->descriptorSetLayout);
-  vkDestroySampler(device->logical, this->fontSampler, device->instance->allocator);
+  atlrReleaseSampler(device, this->fontSampler);
   atlrDeinitImage(&this->fontImage);
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
@@ -328,8 +316,8 @@ void Atlr::ImguiContext::bind(const VkCommandBuffer commandBuffer, const AtlrU8
   ImGuiIO& io = ImGui::GetIO();
   
   const VkDescriptorSet* set = &this->descriptorSets[currentFrame];
-  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline.layout, 0, 1, set, 0, NULL);
-  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline.pipeline);
+  this->device->pfnCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline.layout, 0, 1, set, 0, NULL);
+  this->device->pfnCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline.pipeline);
 
   GLFWwindow* window = (GLFWwindow*)this->device->instance->data;
   int width, height;
@@ -339,8 +327,10 @@ void Atlr::ImguiContext::bind(const VkCommandBuffer commandBuffer, const AtlrU8
   ImGui::NewFrame();
 }
 
-void Atlr::ImguiContext::draw(const VkCommandBuffer commandBuffer, const AtlrU8 currentFrame)
+// Resized buffers are deinitialized through the frame context's deletion queue, as submitted frames may still read them.
+void Atlr::ImguiContext::draw(const VkCommandBuffer commandBuffer, AtlrFrameCommandContext* restrict frameContext)
 {
+  const AtlrU8 currentFrame = frameContext->currentFrame;
   ImGui::Render();
   ImGuiIO& io = ImGui::GetIO();
   ImDrawData* drawData = ImGui::GetDrawData();
@@ -353,7 +343,7 @@ void Atlr::ImguiContext::draw(const VkCommandBuffer commandBuffer, const AtlrU8
 
 #ifdef ATLR_DEBUG
   const float color[4] = {0.2f, 0.9f, 0.9f, 1.0f};
-  atlrBeginCommandLabel(commandBuffer, "Imgui draw", color, this->device->instance);
+  atlrBeginCommandLabel(commandBuffer, "Imgui draw", color, this->device);
 #endif
   
   AtlrU32* vertexCount = &this->vertexCounts[currentFrame];
@@ -363,7 +353,11 @@ void Atlr::ImguiContext::draw(const VkCommandBuffer commandBuffer, const AtlrU8
     if (*vertexCount)
     {
       atlrUnmapBuffer(vertexBuffer);
-      atlrDeinitBuffer(vertexBuffer);
+      if (!atlrDeferDeinitBuffer(&frameContext->deletionQueue, vertexBuffer, frameContext->frameNumber))
+      {
+	throw std::runtime_error("atlrDeferDeinitBuffer returned 0.");
+	return;
+      }
     }
     
     *vertexCount = drawData->TotalVtxCount;
@@ -392,7 +386,11 @@ void Atlr::ImguiContext::draw(const VkCommandBuffer commandBuffer, const AtlrU8
     if (*indexCount)
     {
       atlrUnmapBuffer(indexBuffer);
-      atlrDeinitBuffer(indexBuffer);
+      if (!atlrDeferDeinitBuffer(&frameContext->deletionQueue, indexBuffer, frameContext->frameNumber))
+      {
+	throw std::runtime_error("atlrDeferDeinitBuffer returned 0.");
+	return;
+      }
     }
     
     *indexCount = drawData->TotalIdxCount;
@@ -433,15 +431,15 @@ void Atlr::ImguiContext::draw(const VkCommandBuffer commandBuffer, const AtlrU8
   
   this->transform.translate = (AtlrVec2){{-1.0f, -1.0f}};
   this->transform.scale     = (AtlrVec2){{2.0f / io.DisplaySize.x, 2.0f / io.DisplaySize.y}};
-  vkCmdPushConstants(commandBuffer, this->pipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(this->transform), &this->transform);
+  this->device->pfnCmdPushConstants(commandBuffer, this->pipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(this->transform), &this->transform);
 
-  atlrCommandSetViewport(commandBuffer, io.DisplaySize.x, io.DisplaySize.y);
+  atlrCommandSetViewport(commandBuffer, io.DisplaySize.x, io.DisplaySize.y, this->device);
   
   AtlrI32 vertexOffset = 0;
   AtlrI32 indexOffset = 0;
   const VkDeviceSize offset = 0;
-  vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer->buffer, &offset);
-  vkCmdBindIndexBuffer(commandBuffer, indexBuffer->buffer, 0, VK_INDEX_TYPE_UINT16);
+  this->device->pfnCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer->buffer, &offset);
+  this->device->pfnCmdBindIndexBuffer(commandBuffer, indexBuffer->buffer, 0, VK_INDEX_TYPE_UINT16);
   for (AtlrI32 i = 0; i < drawData->CmdListsCount; i++)
   {
     const ImDrawList* cmdList = drawData->CmdLists[i];
@@ -450,9 +448,9 @@ void Atlr::ImguiContext::draw(const VkCommandBuffer commandBuffer, const AtlrU8
       const ImDrawCmd* cmd = &cmdList->CmdBuffer[j];
       const VkOffset2D offset = {.x = std::max((AtlrI32)cmd->ClipRect.x, 0), .y = std::max((AtlrI32)cmd->ClipRect.y, 0)};
       const VkExtent2D extent = {.width = (AtlrU32)(cmd->ClipRect.z - cmd->ClipRect.x), .height = (AtlrU32)(cmd->ClipRect.w - cmd->ClipRect.y)};
-      atlrCommandSetScissor(commandBuffer, &offset, &extent);
+      atlrCommandSetScissor(commandBuffer, &offset, &extent, this->device);
 
-      vkCmdDrawIndexed(commandBuffer, cmd->ElemCount, 1, indexOffset, vertexOffset, 0);
+      this->device->pfnCmdDrawIndexed(commandBuffer, cmd->ElemCount, 1, indexOffset, vertexOffset, 0);
       indexOffset += cmd->ElemCount;
     }
 
@@ -460,6 +458,6 @@ void Atlr::ImguiContext::draw(const VkCommandBuffer commandBuffer, const AtlrU8
   }
 
 #ifdef ATLR_DEBUG
-  atlrEndCommandLabel(commandBuffer, this->device->instance);
+  atlrEndCommandLabel(commandBuffer, this->device);
 #endif
 }
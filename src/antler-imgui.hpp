@@ -42,7 +42,7 @@ namespace Atlr
     void deinit();
 
     void bind(const VkCommandBuffer, const AtlrU8 currentFrame);
-    void draw(const VkCommandBuffer, const AtlrU8 currentFrame);
+    void draw(const VkCommandBuffer, AtlrFrameCommandContext* restrict);
   };
 
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,11 +40,48 @@ typedef struct _AtlrSpirVBinary
   
 } AtlrSpirVBinary;
 
+typedef struct _AtlrArena
+{
+  AtlrU8* data;
+  AtlrU64 capacity;
+  AtlrU64 top;
+  AtlrU64 peak;
+  
+} AtlrArena;
+
+#define ATLR_SCRATCH_ARENA_SIZE (1 << 20)
+#define ATLR_ARENA_ALIGNMENT 16 // enough for any Vulkan structure
+
+// indexed by VkSystemAllocationScope
+#define ATLR_ALLOCATION_SCOPE_COUNT 5
+
+typedef struct _AtlrHostAllocatorStats
+{
+  AtlrU64 allocationCount[ATLR_ALLOCATION_SCOPE_COUNT];
+  AtlrU64 reallocationCount[ATLR_ALLOCATION_SCOPE_COUNT];
+  AtlrU64 freeCount[ATLR_ALLOCATION_SCOPE_COUNT];
+  AtlrU64 bytes[ATLR_ALLOCATION_SCOPE_COUNT];         // held now, counting pooled allocations at their size class
+  AtlrU64 peakBytes[ATLR_ALLOCATION_SCOPE_COUNT];
+  AtlrU64 internalBytes[ATLR_ALLOCATION_SCOPE_COUNT]; // allocated by the driver itself and only reported to the allocator
+  
+} AtlrHostAllocatorStats;
+
+// VkAllocationCallbacks serving small driver objects from size class pools and command scope allocations from a resetting arena.
+// It must outlive every instance and device created with its callbacks.
+typedef struct _AtlrHostAllocator
+{
+  VkAllocationCallbacks callbacks;
+  struct _AtlrHostAllocatorState* state;
+  
+} AtlrHostAllocator;
+
 typedef struct _AtlrInstance
 {
   VkInstance instance;
+  AtlrU32 apiVersion;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkAllocationCallbacks* allocator;
+  AtlrArena* scratch; // for transient arrays in init paths, which run on the thread that owns the instance
   VkSurfaceKHR surface;
   void* data;
   
@@ -65,6 +103,8 @@ typedef struct _AtlrSwapchainSupportDetails
   VkSurfaceFormatKHR* formats;
   AtlrU32 presentModeCount;
   VkPresentModeKHR* presentModes;
+  AtlrArena* scratch; // the arrays live in the instance's scratch arena, which deinitializing rewinds
+  AtlrU64 scratchMark;
   
 } AtlrSwapchainSupportDetails;
 
@@ -97,6 +137,85 @@ typedef enum
   // Otherwise, the geometry shader device feature is disabled.
   ATLR_DEVICE_CRITERION_GEOMETRY_SHADER,
 
+  // dynamic rendering feature (core in Vulkan 1.3)
+  // If the method is a nonegative point shift or a required method, dynamic rendering is enabled when possible.
+  // Otherwise, dynamic rendering is disabled and only render pass objects may be used.
+  ATLR_DEVICE_CRITERION_DYNAMIC_RENDERING,
+
+  // extended dynamic state 1 and 2 (core in Vulkan 1.3); cull mode, front face, topology and depth state become per draw
+  ATLR_DEVICE_CRITERION_EXTENDED_DYNAMIC_STATE,
+
+  // extended dynamic state 3 (VK_EXT_extended_dynamic_state3); polygon mode, color blend enable and color write mask become per draw
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_EXTENDED_DYNAMIC_STATE_3,
+
+  // graphics pipeline library (VK_EXT_graphics_pipeline_library); pipelines are linked from separately compiled parts
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_GRAPHICS_PIPELINE_LIBRARY,
+
+  // shader object (VK_EXT_shader_object); shaders are bound directly and all pipeline state is set by commands
+  // Shader objects render with dynamic rendering and set their state with extended dynamic state commands,
+  // so they are only enabled alongside the dynamic rendering and extended dynamic state features.
+  // The enabling rules otherwise match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_SHADER_OBJECT,
+
+  // descriptor indexing (core in Vulkan 1.2); large, partially bound, update-after-bind descriptor arrays indexed non-uniformly in shaders
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_DESCRIPTOR_INDEXING,
+
+  // push descriptor (VK_KHR_push_descriptor); descriptors are written straight into command buffers without sets
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_PUSH_DESCRIPTOR,
+
+  // descriptor buffer (VK_EXT_descriptor_buffer); descriptors are written into buffer memory and bound by offset
+  // Descriptor buffers are bound by device address, so they are only enabled alongside the buffer device address feature.
+  // The enabling rules otherwise match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_DESCRIPTOR_BUFFER,
+
+  // block-compressed texture formats (core Vulkan 1.0 features); BC1 to BC7 and ETC2/EAC images may be sampled
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_TEXTURE_COMPRESSION_BC,
+  ATLR_DEVICE_CRITERION_TEXTURE_COMPRESSION_ETC2,
+
+  // memory budget (VK_EXT_memory_budget); the device reports how much memory each heap may use and currently uses
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_MEMORY_BUDGET,
+
+  // host image copy (VK_EXT_host_image_copy); images are written from host memory and change layout on the host, without queue submissions
+  // Only offered on Vulkan 1.3 devices, where the extensions it depends on are core. The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_HOST_IMAGE_COPY,
+
+  // external memory host (VK_EXT_external_memory_host); suitably aligned host allocations are imported as buffer memory
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_EXTERNAL_MEMORY_HOST,
+
+  // timeline semaphores (core in Vulkan 1.2); one semaphore carries a counter the host and queues wait on and signal
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_TIMELINE_SEMAPHORE,
+
+  // buffer device address (core in Vulkan 1.2); shaders read buffers through 64-bit addresses
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_BUFFER_DEVICE_ADDRESS,
+
+  // synchronization 2 (core in Vulkan 1.3); barriers and submissions name their stages and accesses per dependency
+  // Image layout barriers are recorded with it when enabled.
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_SYNCHRONIZATION_2,
+
+  // maintenance 4 (core in Vulkan 1.3); memory requirements are queried without creating the object
+  // The enabling rules match the geometry shader feature.
+  ATLR_DEVICE_CRITERION_MAINTENANCE_4,
+
+  // device local memory criteria; met when the largest device local heap holds at least the size
+  ATLR_DEVICE_CRITERION_DEVICE_LOCAL_HEAP_AT_LEAST_2_GIB,
+  ATLR_DEVICE_CRITERION_DEVICE_LOCAL_HEAP_AT_LEAST_4_GIB,
+  ATLR_DEVICE_CRITERION_DEVICE_LOCAL_HEAP_AT_LEAST_8_GIB,
+
+  // measured performance criterion (see atlrMeasurePhysicalDevice); met when the physical device could be benchmarked
+  // Only this criterion runs the benchmarks, and only when it is required or a nonzero point shift; forbidding it measures nothing.
+  // A point shift is scaled by the device's score over the best score among the physical devices, so the fastest device gets all of it.
+  ATLR_DEVICE_CRITERION_MEASURED_PERFORMANCE,
+
   ATLR_DEVICE_CRITERION_TOT
   
 } AtlrDeviceCriterionType;
@@ -117,8 +236,63 @@ typedef struct _AtlrDeviceCriterion
 } AtlrDeviceCriterion;
 
 typedef AtlrDeviceCriterion AtlrDeviceCriteria[ATLR_DEVICE_CRITERION_TOT];
+
+// measured throughput of a physical device; the rates are per nanosecond, which makes them GB/s, GFLOP/s and Gpixel/s
+typedef struct _AtlrDeviceBenchmark
+{
+  float copyBandwidth;     // device local buffer copies, counting both the read and the write
+  float computeThroughput; // fused multiply-adds in a compute kernel, counting each as two operations
+  float fillRate;          // alpha blended full screen triangles
+  float score;             // geometric mean of the rates
+  
+} AtlrDeviceBenchmark;
+
+// measured devices are cached in the user's cache directory unless the build defines ATLR_DEVICE_BENCHMARK_CACHE_PATH
 #endif
 
+// optional device features; each flag is set only when the feature was enabled on the logical device
+// The flags are all AtlrU8, so device.c finds each one by its offset.
+typedef struct _AtlrDeviceFeatures
+{
+  AtlrU8 geometryShader;
+  AtlrU8 dynamicRendering;
+  AtlrU8 extendedDynamicState;
+  AtlrU8 extendedDynamicState3;
+  AtlrU8 graphicsPipelineLibrary;
+  AtlrU8 shaderObject;
+  AtlrU8 descriptorIndexing;
+  AtlrU8 pushDescriptor;
+  AtlrU8 descriptorBuffer;
+  AtlrU8 textureCompressionBC;
+  AtlrU8 textureCompressionETC2;
+  AtlrU8 memoryBudget;
+  AtlrU8 hostImageCopy;
+  AtlrU8 externalMemoryHost;
+  AtlrU8 timelineSemaphore;
+  AtlrU8 bufferDeviceAddress;
+  AtlrU8 synchronization2;
+  AtlrU8 maintenance4;
+  
+} AtlrDeviceFeatures;
+
+typedef struct _AtlrSamplerCacheEntry
+{
+  VkSamplerCreateInfo key;
+  AtlrU64 hash;
+  VkSampler sampler;
+  AtlrU32 referenceCount;
+  
+} AtlrSamplerCacheEntry;
+
+// reference-counted samplers shared across the device, keyed by their full state
+typedef struct _AtlrSamplerCache
+{
+  AtlrU32 count;
+  AtlrU32 capacity;
+  AtlrSamplerCacheEntry* entries;
+  
+} AtlrSamplerCache;
+
 typedef struct _AtlrDevice
 {
   const AtlrInstance* instance;
@@ -127,12 +301,113 @@ typedef struct _AtlrDevice
   AtlrU8 hasSwapchainSupport;
   AtlrSwapchainSupportDetails swapchainSupportDetails;
   VkSampleCountFlagBits msaaSamples;
+  AtlrDeviceFeatures features;
   VkDevice logical;
   VkQueue graphicsComputeQueue;
   VkQueue presentQueue;
+  AtlrSamplerCache* samplerCache;
+
+  // extension commands, loaded only when the corresponding feature is enabled
+  PFN_vkCmdSetPolygonModeEXT pfnCmdSetPolygonMode;
+  PFN_vkCmdSetColorBlendEnableEXT pfnCmdSetColorBlendEnable;
+  PFN_vkCmdSetColorWriteMaskEXT pfnCmdSetColorWriteMask;
+  PFN_vkCreateShadersEXT pfnCreateShaders;
+  PFN_vkDestroyShaderEXT pfnDestroyShader;
+  PFN_vkCmdBindShadersEXT pfnCmdBindShaders;
+  PFN_vkCmdSetVertexInputEXT pfnCmdSetVertexInput;
+  PFN_vkCmdSetRasterizationSamplesEXT pfnCmdSetRasterizationSamples;
+  PFN_vkCmdSetSampleMaskEXT pfnCmdSetSampleMask;
+  PFN_vkCmdSetAlphaToCoverageEnableEXT pfnCmdSetAlphaToCoverageEnable;
+  PFN_vkCmdSetColorBlendEquationEXT pfnCmdSetColorBlendEquation;
+  PFN_vkCmdPushDescriptorSetKHR pfnCmdPushDescriptorSet;
+  PFN_vkCmdPushDescriptorSetWithTemplateKHR pfnCmdPushDescriptorSetWithTemplate;
+  PFN_vkGetDescriptorSetLayoutSizeEXT pfnGetDescriptorSetLayoutSize;
+  PFN_vkGetDescriptorSetLayoutBindingOffsetEXT pfnGetDescriptorSetLayoutBindingOffset;
+  PFN_vkGetDescriptorEXT pfnGetDescriptor;
+  PFN_vkCmdBindDescriptorBuffersEXT pfnCmdBindDescriptorBuffers;
+  PFN_vkCmdSetDescriptorBufferOffsetsEXT pfnCmdSetDescriptorBufferOffsets;
+  PFN_vkCopyMemoryToImageEXT pfnCopyMemoryToImage;
+  PFN_vkTransitionImageLayoutEXT pfnTransitionImageLayout;
+  PFN_vkGetMemoryHostPointerPropertiesEXT pfnGetMemoryHostPointerProperties;
+
+  // Core commands used while recording and submitting, loaded with vkGetDeviceProcAddr so that calls skip the loader's dispatch.
+  // The Vulkan 1.3 commands are loaded only when the corresponding feature is enabled.
+  PFN_vkBeginCommandBuffer pfnBeginCommandBuffer;
+  PFN_vkEndCommandBuffer pfnEndCommandBuffer;
+  PFN_vkResetCommandBuffer pfnResetCommandBuffer;
+  PFN_vkQueueSubmit pfnQueueSubmit;
+  PFN_vkWaitForFences pfnWaitForFences;
+  PFN_vkResetFences pfnResetFences;
+  PFN_vkGetFenceStatus pfnGetFenceStatus;
+  PFN_vkAcquireNextImageKHR pfnAcquireNextImage;
+  PFN_vkQueuePresentKHR pfnQueuePresent;
+  PFN_vkCmdBindPipeline pfnCmdBindPipeline;
+  PFN_vkCmdBindDescriptorSets pfnCmdBindDescriptorSets;
+  PFN_vkCmdBindVertexBuffers pfnCmdBindVertexBuffers;
+  PFN_vkCmdBindIndexBuffer pfnCmdBindIndexBuffer;
+  PFN_vkCmdPushConstants pfnCmdPushConstants;
+  PFN_vkCmdSetViewport pfnCmdSetViewport;
+  PFN_vkCmdSetScissor pfnCmdSetScissor;
+  PFN_vkCmdSetLineWidth pfnCmdSetLineWidth;
+  PFN_vkCmdSetDepthBias pfnCmdSetDepthBias;
+  PFN_vkCmdDraw pfnCmdDraw;
+  PFN_vkCmdDrawIndexed pfnCmdDrawIndexed;
+  PFN_vkCmdDispatch pfnCmdDispatch;
+  PFN_vkCmdPipelineBarrier pfnCmdPipelineBarrier;
+  PFN_vkCmdCopyBuffer pfnCmdCopyBuffer;
+  PFN_vkCmdCopyImage pfnCmdCopyImage;
+  PFN_vkCmdCopyBufferToImage pfnCmdCopyBufferToImage;
+  PFN_vkCmdCopyImageToBuffer pfnCmdCopyImageToBuffer;
+  PFN_vkCmdBlitImage pfnCmdBlitImage;
+  PFN_vkCmdResetQueryPool pfnCmdResetQueryPool;
+  PFN_vkCmdWriteTimestamp pfnCmdWriteTimestamp;
+  PFN_vkCmdBeginRenderPass pfnCmdBeginRenderPass;
+  PFN_vkCmdEndRenderPass pfnCmdEndRenderPass;
+  PFN_vkCmdBeginRendering pfnCmdBeginRendering;
+  PFN_vkCmdEndRendering pfnCmdEndRendering;
+  PFN_vkCmdPipelineBarrier2 pfnCmdPipelineBarrier2;
+  PFN_vkCmdSetCullMode pfnCmdSetCullMode;
+  PFN_vkCmdSetFrontFace pfnCmdSetFrontFace;
+  PFN_vkCmdSetPrimitiveTopology pfnCmdSetPrimitiveTopology;
+  PFN_vkCmdSetPrimitiveRestartEnable pfnCmdSetPrimitiveRestartEnable;
+  PFN_vkCmdSetRasterizerDiscardEnable pfnCmdSetRasterizerDiscardEnable;
+  PFN_vkCmdSetDepthBiasEnable pfnCmdSetDepthBiasEnable;
+  PFN_vkCmdSetDepthTestEnable pfnCmdSetDepthTestEnable;
+  PFN_vkCmdSetDepthWriteEnable pfnCmdSetDepthWriteEnable;
+  PFN_vkCmdSetDepthCompareOp pfnCmdSetDepthCompareOp;
+  PFN_vkCmdSetStencilTestEnable pfnCmdSetStencilTestEnable;
+  PFN_vkCmdSetViewportWithCount pfnCmdSetViewportWithCount;
+  PFN_vkCmdSetScissorWithCount pfnCmdSetScissorWithCount;
+  PFN_vkCmdSetDepthBoundsTestEnable pfnCmdSetDepthBoundsTestEnable;
+#ifdef ATLR_DEBUG
+  PFN_vkCmdBeginDebugUtilsLabelEXT pfnCmdBeginDebugUtilsLabel;
+  PFN_vkCmdEndDebugUtilsLabelEXT pfnCmdEndDebugUtilsLabel;
+  PFN_vkSetDebugUtilsObjectNameEXT pfnSetDebugUtilsObjectName;
+#endif
   
 } AtlrDevice;
 
+// per-draw state for pipelines created with atlrInitPipelineExtendedDynamicStateInfo
+typedef struct _AtlrExtendedDynamicState
+{
+  VkCullModeFlags cullMode;
+  VkFrontFace frontFace;
+  VkPrimitiveTopology topology;
+  VkBool32 primitiveRestartEnable;
+  VkBool32 rasterizerDiscardEnable;
+  VkBool32 depthBiasEnable;
+  VkBool32 depthTestEnable;
+  VkBool32 depthWriteEnable;
+  VkCompareOp depthCompareOp;
+  VkBool32 stencilTestEnable;
+
+  // only used when extended dynamic state 3 or shader objects are enabled; applies to the first color attachment
+  VkPolygonMode polygonMode;
+  VkBool32 colorBlendEnable;
+  VkColorComponentFlags colorWriteMask;
+  
+} AtlrExtendedDynamicState;
+
 typedef struct _AtlrSingleRecordCommandContext
 {
   const AtlrDevice* device;
@@ -148,6 +423,9 @@ typedef struct _AtlrBuffer
   VkBuffer buffer;
   VkDeviceMemory memory;
   void* data;
+  AtlrU8 isDirect;       // the host accesses the memory in place through data, which stays valid for the lifetime of the buffer
+  AtlrU8 isDirectCached; // the direct memory is host cached, so reading it in place is fast
+  AtlrU8 isImported;     // the memory is a host allocation imported by atlrInitHostImportBuffer rather than mapped
   
 } AtlrBuffer;
 
@@ -169,10 +447,45 @@ typedef struct _AtlrImage
   VkFormat format;
   AtlrU32 width;
   AtlrU32 height;
+  AtlrU32 mipLevels;
   AtlrU32 layerCount;
   
 } AtlrImage;
 
+// a KTX2 file kept open so that its levels can be read on demand
+typedef struct _AtlrKtx2File
+{
+  void* file;
+  VkFormat format;
+  AtlrU32 width;
+  AtlrU32 height;
+  AtlrU32 levelCount;
+  AtlrU64* levelOffsets;
+  AtlrU64* levelLengths;
+  
+} AtlrKtx2File;
+
+// stage timings of a batch texture load, in nanoseconds
+typedef struct _AtlrTextureBatchTimings
+{
+  AtlrU64 decodeNanoseconds; // host wall time of the worker pool decoding into staging memory
+  AtlrU64 copyNanoseconds;   // device time of the layout transitions and buffer to image copies
+  AtlrU64 gpuNanoseconds;    // device time of the whole submission, including mip generation
+  
+} AtlrTextureBatchTimings;
+
+// A texture the host rewrites every frame.
+// Each frame in flight has its own image and persistently mapped staging buffer, so uploading one frame never waits on another frame sampling.
+typedef struct _AtlrStreamingTexture
+{
+  const AtlrDevice* device;
+  AtlrU8 frameCount;
+  AtlrU64 frameSize;
+  AtlrImage* images;
+  AtlrBuffer* stagingBuffers;
+  
+} AtlrStreamingTexture;
+
 typedef struct _AtlrDescriptorSetLayout
 {
   const AtlrDevice* device;
@@ -187,6 +500,127 @@ typedef struct _AtlrDescriptorPool
   
 } AtlrDescriptorPool;
 
+typedef struct _AtlrDescriptorUpdateTemplate
+{
+  const AtlrDevice* device;
+  VkDescriptorUpdateTemplate updateTemplate;
+  AtlrU8 isPush;
+  
+} AtlrDescriptorUpdateTemplate;
+
+// a chain of descriptor pools that grows on demand, with a cache of sets keyed by the resources written to them
+typedef struct _AtlrDescriptorAllocator
+{
+  const AtlrDevice* device;
+  AtlrU32 poolSizeCount;
+  VkDescriptorPoolSize* poolSizeRatios;
+  VkDescriptorPoolSize* poolSizes; // filled in by each new pool, allocated along with the ratios
+  AtlrU32 setsPerPool;
+  AtlrU32 poolCount;
+  AtlrU32 poolCapacity;
+  VkDescriptorPool* pools; // sets are allocated from the last pool
+  AtlrU32 poolSetCapacity;
+  AtlrU32 allocatedSetCount;
+  AtlrU32 cacheCount;
+  AtlrU32 cacheCapacity;
+  AtlrU64* cacheHashes;
+  VkDescriptorSet* cacheSets;
+  AtlrU32* cacheKeyOffsets; // each set's key is the layout and written resources, stored in cacheKeys and compared on a hash match
+  AtlrU32* cacheKeyLengths;
+  AtlrU32 cacheKeyCount;
+  AtlrU32 cacheKeyCapacity;
+  AtlrU64* cacheKeys;
+  
+} AtlrDescriptorAllocator;
+
+typedef struct _AtlrBindlessHandleList
+{
+  AtlrU32 capacity;
+  AtlrU32 count;
+  AtlrU32 freeCount;
+  AtlrU32* freeHandles;
+  
+} AtlrBindlessHandleList;
+
+// one descriptor set of texture and storage buffer arrays, bound once and indexed by integer handles
+typedef struct _AtlrBindlessTable
+{
+  const AtlrDevice* device;
+  AtlrDescriptorSetLayout setLayout;
+  AtlrDescriptorPool pool;
+  VkDescriptorSet set;
+  AtlrBindlessHandleList images;
+  AtlrBindlessHandleList buffers;
+  
+} AtlrBindlessTable;
+
+// A KTX2 texture whose finer levels are streamed in on demand. The mip tail always stays resident,
+// so the handle can be sampled from the moment the texture is added.
+typedef struct _AtlrStreamedTexture
+{
+  AtlrKtx2File ktx2;
+  AtlrU32 handle;
+  AtlrU32 tailLevel;
+  AtlrImage tail;
+  AtlrU8 isStreamed;
+  AtlrImage image;
+  AtlrU32 residentLevel;
+  AtlrU64 residentSize;
+  AtlrU32 requestedLevel;
+  AtlrU64 lastUsedFrame;
+  AtlrU64* levelSizes;      // per level above the tail, the device memory of an image holding the levels from there to the end of the mip chain
+  AtlrU64* levelUsedFrames; // per level above the tail, the last frame that requested it
+  
+} AtlrStreamedTexture;
+
+// an image, staging buffer and bindless handle waiting for the frames that may still use them to finish
+typedef struct _AtlrRetiredTexture
+{
+  AtlrU8 hasImage;
+  AtlrImage image;
+  AtlrU64 size;
+  AtlrU8 hasStagingBuffer;
+  AtlrBuffer stagingBuffer;
+  AtlrU8 hasHandle;
+  AtlrU32 handle;
+  AtlrU64 frame;
+  
+} AtlrRetiredTexture;
+
+typedef struct _AtlrTextureResidency
+{
+  const AtlrDevice* device;
+  AtlrBindlessTable* table;
+  const AtlrSingleRecordCommandContext* commandContext;
+  VkSampler sampler;
+  AtlrU64 budget;
+  AtlrU64 uploadLimit;
+  AtlrU64 residentSize;
+  AtlrU64 retiredSize;
+  AtlrU64 frame;
+  AtlrU32 framesInFlight;
+  AtlrU32 capacity;
+  AtlrU32 count;
+  AtlrStreamedTexture* textures;
+  AtlrU32 retiredCapacity;
+  AtlrU32 retiredCount;
+  AtlrRetiredTexture* retired;
+  
+} AtlrTextureResidency;
+
+// descriptors written with vkGetDescriptorEXT into a persistently mapped buffer, sets are offsets into it handed out as a ring
+typedef struct _AtlrDescriptorBuffer
+{
+  const AtlrDevice* device;
+  AtlrBuffer buffer;
+  VkDeviceAddress address;
+  VkBufferUsageFlags usage;
+  AtlrU64 size;
+  AtlrU64 head;
+  VkPhysicalDeviceDescriptorBufferPropertiesEXT properties;
+  
+} AtlrDescriptorBuffer;
+
 typedef struct _AtlrPipeline
 {
   const AtlrDevice* device;
@@ -196,15 +630,166 @@ typedef struct _AtlrPipeline
   
 } AtlrPipeline;
 
+typedef enum _AtlrDeletionType
+{
+  ATLR_DELETION_TYPE_BUFFER,
+  ATLR_DELETION_TYPE_IMAGE,
+  ATLR_DELETION_TYPE_IMAGE_VIEW,
+  ATLR_DELETION_TYPE_SAMPLER,
+  ATLR_DELETION_TYPE_PIPELINE
+  
+} AtlrDeletionType;
+
+// an object whose deinitialization waits for the device to pass value
+typedef struct _AtlrDeletion
+{
+  AtlrDeletionType type;
+  AtlrU64 value;
+  union
+  {
+    AtlrBuffer buffer;
+    AtlrImage image;
+    VkImageView imageView;
+    VkSampler sampler;
+    AtlrPipeline pipeline;
+    
+  } object;
+  
+} AtlrDeletion;
+
+// Values are whatever monotonic counter the device progress is measured in, such as frame numbers or timeline semaphore values.
+typedef struct _AtlrDeletionQueue
+{
+  const AtlrDevice* device;
+  AtlrU32 capacity;
+  AtlrU32 count;
+  AtlrDeletion* deletions;
+  
+} AtlrDeletionQueue;
+
+// A handle packs a slot index in its low ATLR_HANDLE_INDEX_BITS bits and the slot's generation above them.
+// Removing a resource bumps its slot's generation, so stale handles are detected instead of aliasing a newer resource.
+typedef AtlrU32 AtlrHandle;
+#define ATLR_HANDLE_INDEX_BITS 20
+#define ATLR_NULL_HANDLE 0
+
+// Slots map handles to indices into densely packed resource arrays; removals move the last resource into the hole.
+typedef struct _AtlrHandlePool
+{
+  AtlrU32 capacity;
+  AtlrU32 count;         // the number of live resources, which occupy the first count dense indices
+  AtlrU32 slotCount;
+  AtlrU32 freeCount;
+  AtlrU32* freeSlots;
+  AtlrU32* generations;  // per slot
+  AtlrU32* denseIndices; // per slot
+  AtlrU32* slots;        // per dense index
+  
+} AtlrHandlePool;
+
+// buffers stored as parallel arrays indexed by dense index
+typedef struct _AtlrBufferPool
+{
+  const AtlrDevice* device;
+  AtlrHandlePool handles;
+  VkBuffer* buffers;
+  VkDeviceMemory* memories;
+  void** data;
+  AtlrU8* isDirect;
+  AtlrU8* isDirectCached;
+  AtlrU8* isImported;
+  
+} AtlrBufferPool;
+
+typedef struct _AtlrImagePool
+{
+  const AtlrDevice* device;
+  AtlrHandlePool handles;
+  VkImage* images;
+  VkDeviceMemory* memories;
+  VkImageView* imageViews;
+  VkFormat* formats;
+  AtlrU32* widths;
+  AtlrU32* heights;
+  AtlrU32* mipLevels;
+  AtlrU32* layerCounts;
+  
+} AtlrImagePool;
+
+typedef struct _AtlrPipelinePool
+{
+  const AtlrDevice* device;
+  AtlrHandlePool handles;
+  VkPipelineLayout* layouts;
+  VkPipeline* pipelines;
+  VkPipelineBindPoint* bindPoints;
+  
+} AtlrPipelinePool;
+
 typedef struct _AtlrRenderPass
 {
   const AtlrDevice* device;
   VkRenderPass renderPass;
   AtlrU32 clearValueCount;
   VkClearValue* clearValues;
+  AtlrU64 compatibilityHash; // equal for render passes that are compatible in the Vulkan sense
   
 } AtlrRenderPass;
 
+// one of the four graphics pipeline parts: vertex input, pre-rasterization shaders, fragment shader, or fragment output
+typedef struct _AtlrPipelineLibrary
+{
+  const AtlrDevice* device;
+  VkPipelineLayout layout; // VK_NULL_HANDLE for the parts without shaders
+  VkPipeline pipeline;
+  VkGraphicsPipelineLibraryFlagsEXT flags;
+  
+} AtlrPipelineLibrary;
+
+// A fast-linked pipeline usable right away, replaced by a link-time optimized pipeline compiled on a background thread.
+// The optimized pipeline shares the layout of the fast-linked one.
+typedef struct _AtlrLinkedPipeline
+{
+  AtlrPipeline fast;
+  AtlrPipeline optimized;
+  AtlrU8 isOptimized;
+  struct _AtlrPipelineLinkJob* job;
+  
+} AtlrLinkedPipeline;
+
+typedef struct _AtlrShaderObject
+{
+  const AtlrDevice* device;
+  VkShaderEXT shader;
+  VkShaderStageFlagBits stage;
+  
+} AtlrShaderObject;
+
+// entries chained in buckets by the hash of their creation state, and again by their handle for releasing them
+typedef struct _AtlrPipelineRegistryTable
+{
+  AtlrU32 count;
+  AtlrU32 bucketCount; // a power of two
+  struct _AtlrPipelineRegistryEntry** buckets;
+  struct _AtlrPipelineRegistryEntry** handleBuckets; // allocated along with the buckets
+  
+} AtlrPipelineRegistryTable;
+
+// Shader modules, descriptor set layouts, pipeline layouts and pipelines deduplicated by their creation state.
+// Acquired objects are reference counted and shared between identical requests.
+// Pipelines and pipeline layouts only accept shader modules and descriptor set layouts acquired from the same registry.
+typedef struct _AtlrPipelineRegistry
+{
+  const AtlrDevice* device;
+  AtlrPipelineRegistryTable shaderModules;
+  AtlrPipelineRegistryTable descriptorSetLayouts;
+  AtlrPipelineRegistryTable pipelineLayouts;
+  AtlrPipelineRegistryTable pipelines;
+  AtlrU64 keyCapacity;
+  AtlrU8* keyData; // the key of the current lookup
+  
+} AtlrPipelineRegistry;
+
 #ifdef ATLR_BUILD_HOST_GLFW
 typedef struct _AtlrSwapchain
 {
@@ -221,6 +806,8 @@ typedef struct _AtlrSwapchain
 
   AtlrRenderPass renderPass;
   VkFramebuffer* framebuffers;
+  AtlrU8 isDynamicRendering;
+  VkClearValue clearColor;
 
   AtlrU8 (*onReinit)(void*);
   void* reinitData;
@@ -245,6 +832,8 @@ typedef struct _AtlrFrameCommandContext
   AtlrU8 currentFrame;
   AtlrU8 frameCount;
   AtlrFrame* frames;
+  AtlrU64 frameNumber;               // the number of frames ended so far; deletions enqueued against it wait for the current frame
+  AtlrDeletionQueue deletionQueue;
   
 } AtlrFrameCommandContext;
 #endif
@@ -258,6 +847,14 @@ void atlrLog(AtlrLoggerType, const char* restrict format, ...);
 #define ATLR_ERROR_MSG(format, ...) atlrLog(ATLR_LOG_ERROR, "{Location: %s:%d}: " format, __FILE__, __LINE__, ##__VA_ARGS__)
 #define ATLR_FATAL_MSG(format, ...) atlrLog(ATLR_LOG_FATAL, "{Location: %s:%d}: " format, __FILE__, __LINE__, ##__VA_ARGS__) 
 
+// arena.c
+AtlrU8 atlrInitArena(AtlrArena* restrict, const AtlrU64 capacity);
+void atlrDeinitArena(AtlrArena* restrict);
+void* atlrArenaAlloc(AtlrArena* restrict, const AtlrU64 size, const AtlrU64 alignment);
+void atlrResetArena(AtlrArena* restrict);
+AtlrU64 atlrGetArenaMark(const AtlrArena* restrict);
+void atlrRewindArena(AtlrArena* restrict, const AtlrU64 mark);
+
 // util.c
 float atlrClampFloat(const float x, const float min, const float max);
 void* atlrAlignedMalloc(const AtlrU64 size, const AtlrU64 alignment);
@@ -265,17 +862,32 @@ void atlrAlignedFree(void* data);
 AtlrU8 atlrAlign(AtlrU64* aligned, const AtlrU64 offset, const AtlrU64 alignment);
 AtlrU8 atlrGetVulkanMemoryTypeIndex(AtlrU32* restrict index, const VkPhysicalDevice physical, const AtlrU32 typeFilter, const VkMemoryPropertyFlags properties);
 AtlrU8 atlrInitSpirVBinary(AtlrSpirVBinary* restrict, glslang_stage_t stage, const char* restrict glsl, const char* restrict name);
+AtlrU8 atlrInitSpirVBinaryFromFile(AtlrSpirVBinary* restrict, const char* restrict path);
 void atlrDeinitSpirVBinary(AtlrSpirVBinary* restrict bin);
+AtlrU64 atlrGetTimeNanoseconds();
+#define ATLR_HASH_SEED 0xcbf29ce484222325ULL
+AtlrU64 atlrHash(const void* restrict data, const AtlrU64 size, const AtlrU64 hash);
+
+// host-allocator.c
+AtlrU8 atlrInitHostAllocator(AtlrHostAllocator* restrict);
+void atlrDeinitHostAllocator(AtlrHostAllocator* restrict);
+void atlrGetHostAllocatorStats(const AtlrHostAllocator* restrict, AtlrHostAllocatorStats* restrict);
+void atlrLogHostAllocatorStats(const AtlrHostAllocator* restrict);
 
 // instance.c
 #ifdef ATLR_BUILD_HOST_HEADLESS
-AtlrU8 atlrInitInstanceHostHeadless(AtlrInstance* restrict, const char* restrict name);
+AtlrU8 atlrInitInstanceHostHeadless(AtlrInstance* restrict, const char* restrict name, VkAllocationCallbacks* allocator);
 void atlrDeinitInstanceHostHeadless(const AtlrInstance* restrict);
 #elif ATLR_BUILD_HOST_GLFW
-AtlrU8 atlrInitInstanceHostGLFW(AtlrInstance* restrict, const int width, const int height, const char* restrict name);
+AtlrU8 atlrInitInstanceHostGLFW(AtlrInstance* restrict, const int width, const int height, const char* restrict name, VkAllocationCallbacks* allocator);
 void atlrDeinitInstanceHostGLFW(const AtlrInstance* restrict);
 #endif
 
+// device-benchmark.c
+#if defined(ATLR_BUILD_HOST_HEADLESS) || defined(ATLR_BUILD_HOST_GLFW)
+AtlrU8 atlrMeasurePhysicalDevice(AtlrDeviceBenchmark* restrict, const VkPhysicalDevice, const AtlrInstance* restrict);
+#endif
+
 // device.c
 #if defined(ATLR_BUILD_HOST_HEADLESS) || defined(ATLR_BUILD_HOST_GLFW)
 AtlrU8 atlrInitSwapchainSupportDetails(AtlrSwapchainSupportDetails* restrict, const AtlrInstance* restrict, const VkPhysicalDevice);
@@ -284,7 +896,9 @@ void atlrInitDeviceCriteria(AtlrDeviceCriterion* restrict);
 AtlrU8 atlrSetDeviceCriterion(AtlrDeviceCriterion* restrict criteria, AtlrDeviceCriterionType, AtlrDeviceCriterionMethod, AtlrI32 pointShift);
 AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict, const AtlrInstance* restrict, const AtlrDeviceCriterion* restrict);
 void atlrDeinitDeviceHost(AtlrDevice* restrict);
+void atlrLoadDeviceCommands(AtlrDevice* restrict);
 #endif
+AtlrU8 atlrGetDeviceLocalMemoryBudget(AtlrU64* restrict budget, AtlrU64* restrict usage, const AtlrDevice* restrict);
 #ifdef ATLR_DEBUG
 void atlrSetObjectName(const VkObjectType objectType, const AtlrU64 objectHandle, const char* restrict objectName, const AtlrDevice* restrict);
 #endif
@@ -293,18 +907,22 @@ void atlrSetObjectName(const VkObjectType objectType, const AtlrU64 objectHandle
 AtlrU8 atlrInitCommandPool(VkCommandPool* restrict, const VkCommandPoolCreateFlags, const AtlrU32 queueFamilyIndex, const AtlrDevice* restrict);
 void atlrDeinitCommandPool(const VkCommandPool, const AtlrDevice* restrict);
 AtlrU8 atlrAllocatePrimaryCommandBuffers(VkCommandBuffer* restrict commandBuffers, AtlrU32 commandBufferCount, const VkCommandPool, const AtlrDevice*);
-AtlrU8 atlrBeginCommandRecording(const VkCommandBuffer, const VkCommandBufferUsageFlags);
-AtlrU8 atlrEndCommandRecording(const VkCommandBuffer);
+AtlrU8 atlrBeginCommandRecording(const VkCommandBuffer, const VkCommandBufferUsageFlags, const AtlrDevice* restrict);
+AtlrU8 atlrEndCommandRecording(const VkCommandBuffer, const AtlrDevice* restrict);
 #ifdef ATLR_DEBUG
-void atlrBeginCommandLabel(const VkCommandBuffer, const char* restrict labelName, const float* restrict color4, const AtlrInstance* restrict instance);
-void atlrEndCommandLabel(const VkCommandBuffer, const AtlrInstance* restrict instance);
+void atlrBeginCommandLabel(const VkCommandBuffer, const char* restrict labelName, const float* restrict color4, const AtlrDevice* restrict);
+void atlrEndCommandLabel(const VkCommandBuffer, const AtlrDevice* restrict);
 #endif
 AtlrU8 atlrInitSingleRecordCommandContext(AtlrSingleRecordCommandContext* restrict, const AtlrU32 queueFamilyIndex, const AtlrDevice* restrict);
 void atlrDeinitSingleRecordCommandContext(AtlrSingleRecordCommandContext* restrict);
 AtlrU8 atlrBeginSingleRecordCommands(VkCommandBuffer* restrict, const AtlrSingleRecordCommandContext* restrict);
 AtlrU8 atlrEndSingleRecordCommands(const VkCommandBuffer, const AtlrSingleRecordCommandContext* restrict);
-void atlrCommandSetViewport(const VkCommandBuffer, const float width, const float height);
-void atlrCommandSetScissor(const VkCommandBuffer, const VkOffset2D* restrict, const VkExtent2D* restrict);
+void atlrCommandSetViewport(const VkCommandBuffer, const float width, const float height, const AtlrDevice* restrict);
+void atlrCommandSetScissor(const VkCommandBuffer, const VkOffset2D* restrict, const VkExtent2D* restrict, const AtlrDevice* restrict);
+AtlrExtendedDynamicState atlrInitExtendedDynamicState();
+void atlrCommandSetExtendedDynamicState(const VkCommandBuffer, const AtlrExtendedDynamicState* restrict, const AtlrDevice* restrict);
+void atlrCommandUpdateExtendedDynamicState(const VkCommandBuffer, AtlrExtendedDynamicState* restrict current, const AtlrExtendedDynamicState* restrict next,
+					   const AtlrDevice* restrict);
 
 #ifdef ATLR_BUILD_HOST_GLFW
 AtlrU8 atlrInitFrameCommandContextHostGLFW(AtlrFrameCommandContext* restrict, const AtlrU8 frameCount,
@@ -314,12 +932,43 @@ AtlrU8 atlrBeginFrameCommandsHostGLFW(AtlrFrameCommandContext* restrict);
 AtlrU8 atlrEndFrameCommandsHostGLFW(AtlrFrameCommandContext* restrict);
 AtlrU8 atlrFrameCommandContextBeginRenderPassHostGLFW(AtlrFrameCommandContext* restrict);
 AtlrU8 atlrFrameCommandContextEndRenderPassHostGLFW(AtlrFrameCommandContext* restrict);
+AtlrU8 atlrFrameCommandContextBeginRenderingHostGLFW(AtlrFrameCommandContext* restrict);
+AtlrU8 atlrFrameCommandContextEndRenderingHostGLFW(AtlrFrameCommandContext* restrict);
 VkCommandBuffer atlrGetFrameCommandContextCommandBufferHostGLFW(const AtlrFrameCommandContext* restrict);
 #endif
 
+// deletion-queue.c
+void atlrInitDeletionQueue(AtlrDeletionQueue* restrict, const AtlrDevice* restrict);
+void atlrDeinitDeletionQueue(AtlrDeletionQueue* restrict);
+AtlrU8 atlrDeferDeinitBuffer(AtlrDeletionQueue* restrict, const AtlrBuffer* restrict, const AtlrU64 value);
+AtlrU8 atlrDeferDeinitImage(AtlrDeletionQueue* restrict, const AtlrImage* restrict, const AtlrU64 value);
+AtlrU8 atlrDeferDeinitImageView(AtlrDeletionQueue* restrict, const VkImageView, const AtlrU64 value);
+AtlrU8 atlrDeferDeinitSampler(AtlrDeletionQueue* restrict, const VkSampler, const AtlrU64 value);
+AtlrU8 atlrDeferDeinitPipeline(AtlrDeletionQueue* restrict, const AtlrPipeline* restrict, const AtlrU64 value);
+void atlrFlushDeletionQueue(AtlrDeletionQueue* restrict, const AtlrU64 completedValue);
+
+// resource-pool.c
+AtlrU8 atlrGetPooledIndex(const AtlrHandlePool* restrict, const AtlrHandle, AtlrU32* restrict index);
+AtlrU8 atlrInitBufferPool(AtlrBufferPool* restrict, const AtlrU32 capacity, const AtlrDevice* restrict);
+void atlrDeinitBufferPool(AtlrBufferPool* restrict);
+AtlrU8 atlrAddPooledBuffer(AtlrBufferPool* restrict, AtlrHandle* restrict, const AtlrBuffer* restrict);
+AtlrU8 atlrGetPooledBuffer(const AtlrBufferPool* restrict, const AtlrHandle, AtlrBuffer* restrict);
+AtlrU8 atlrRemovePooledBuffer(AtlrBufferPool* restrict, const AtlrHandle, AtlrDeletionQueue* restrict, const AtlrU64 value);
+AtlrU8 atlrInitImagePool(AtlrImagePool* restrict, const AtlrU32 capacity, const AtlrDevice* restrict);
+void atlrDeinitImagePool(AtlrImagePool* restrict);
+AtlrU8 atlrAddPooledImage(AtlrImagePool* restrict, AtlrHandle* restrict, const AtlrImage* restrict);
+AtlrU8 atlrGetPooledImage(const AtlrImagePool* restrict, const AtlrHandle, AtlrImage* restrict);
+AtlrU8 atlrRemovePooledImage(AtlrImagePool* restrict, const AtlrHandle, AtlrDeletionQueue* restrict, const AtlrU64 value);
+AtlrU8 atlrInitPipelinePool(AtlrPipelinePool* restrict, const AtlrU32 capacity, const AtlrDevice* restrict);
+void atlrDeinitPipelinePool(AtlrPipelinePool* restrict);
+AtlrU8 atlrAddPooledPipeline(AtlrPipelinePool* restrict, AtlrHandle* restrict, const AtlrPipeline* restrict);
+AtlrU8 atlrGetPooledPipeline(const AtlrPipelinePool* restrict, const AtlrHandle, AtlrPipeline* restrict);
+AtlrU8 atlrRemovePooledPipeline(AtlrPipelinePool* restrict, const AtlrHandle, AtlrDeletionQueue* restrict, const AtlrU64 value);
+
 // buffer.c
 AtlrU8 atlrUniformBufferAlignment(AtlrU64* restrict aligned, const AtlrU64 offset, const AtlrDevice* restrict);
 AtlrU8 atlrInitBuffer(AtlrBuffer* restrict, const AtlrU64 size, const VkBufferUsageFlags, const VkMemoryPropertyFlags, const AtlrDevice*);
+VkDeviceAddress atlrGetBufferDeviceAddress(const AtlrBuffer* restrict);
 #ifdef ATLR_DEBUG
 void atlrSetBufferName(const AtlrBuffer* restrict buffer, const char* restrict bufferName);
 #endif
@@ -346,10 +995,15 @@ void atlrDrawMesh(const AtlrMesh* restrict mesh, const VkCommandBuffer);
 
 // image.c
 VkFormat atlrGetSupportedDepthImageFormat(const VkPhysicalDevice, const VkImageTiling);
-VkImageView atlrInitImageView(const VkImage, const VkImageViewType, const VkFormat, const VkImageAspectFlags, const AtlrU32 layerCount, const AtlrDevice* restrict);
+VkImageAspectFlags atlrGetDepthImageAspects(const VkFormat);
+VkImageView atlrInitImageView(const VkImage, const VkImageViewType, const VkFormat, const VkImageAspectFlags, const AtlrU32 mipLevels, const AtlrU32 layerCount,
+			      const AtlrDevice* restrict);
 void atlrDeinitImageView(const VkImageView, const AtlrDevice* restrict);
+AtlrU8 atlrCommandImageLayoutBarrier(const VkCommandBuffer, const VkImage, const VkImageSubresourceRange* restrict,
+				     const VkImageLayout oldLayout, const VkImageLayout newLayout, const AtlrDevice* restrict);
 AtlrU8 atlrTransitionImageLayout(const AtlrImage* restrict, const VkImageLayout oldLayout, const VkImageLayout newLayout, const AtlrSingleRecordCommandContext* restrict);
-AtlrU8 atlrInitImage(AtlrImage* restrict, const AtlrU32 width, const AtlrU32 height,
+AtlrU32 atlrGetMipLevelCount(const AtlrU32 width, const AtlrU32 height);
+AtlrU8 atlrInitImage(AtlrImage* restrict, const AtlrU32 width, const AtlrU32 height, const AtlrU32 mipLevels,
 		     const AtlrU32 layerCount,  const VkSampleCountFlagBits, const VkFormat, const VkImageTiling, const VkImageUsageFlags,
 		     const VkMemoryPropertyFlags, const VkImageViewType, const VkImageAspectFlags,
 		     const AtlrDevice* restrict);
@@ -357,9 +1011,48 @@ void atlrDeinitImage(const AtlrImage* restrict);
 #ifdef ATLR_DEBUG
 void atlrSetImageName(const AtlrImage* restrict, const char* restrict imageName);
 #endif
-AtlrU8 atlrInitImageRgbaTextureFromFile(AtlrImage* image, const char* filePath, const AtlrDevice* restrict, const AtlrSingleRecordCommandContext* restrict);
+AtlrU8 atlrInitImageRgbaTextureFromFile(AtlrImage* image, const char* filePath, const AtlrU8 hasMips, const AtlrDevice* restrict, const AtlrSingleRecordCommandContext* restrict);
 AtlrU8 atlrIsValidDepthImage(const AtlrImage* restrict);
 
+// host-image-copy.c
+AtlrU8 atlrIsHostImageCopySupported(const VkFormat, const VkImageUsageFlags, const VkImageLayout, const AtlrDevice* restrict);
+AtlrU8 atlrHostCopyMemoryToImage(const AtlrImage* restrict, const void* restrict texels, const VkImageLayout);
+
+// host-import.c
+AtlrU64 atlrGetHostImportAlignment(const AtlrDevice* restrict);
+void* atlrAllocHostImportMemory(AtlrU64* restrict size, const AtlrDevice* restrict);
+AtlrU8 atlrInitHostImportBuffer(AtlrBuffer* restrict, void* hostPointer, const AtlrU64 size, const VkBufferUsageFlags, const AtlrDevice*);
+
+// mipmap.c
+AtlrU8 atlrIsMipmapBlitSupported(const VkPhysicalDevice, const VkFormat);
+VkImageUsageFlags atlrGetMipmapImageUsage(const VkPhysicalDevice, const VkFormat);
+AtlrU8 atlrCommandGenerateMipmapsBlit(const VkCommandBuffer, const AtlrImage* restrict, const VkImageLayout finalLayout);
+AtlrU8 atlrGenerateMipmaps(const AtlrImage* restrict, const VkImageLayout finalLayout, const AtlrSingleRecordCommandContext* restrict);
+
+// ktx2.c
+AtlrU32 atlrGetCompressedFormatBlockSize(const VkFormat);
+AtlrU8 atlrIsCompressedFormatSupported(const VkFormat, const AtlrDevice* restrict);
+AtlrU8 atlrInitKtx2File(AtlrKtx2File* restrict, const char* restrict filePath);
+void atlrDeinitKtx2File(const AtlrKtx2File* restrict);
+AtlrU64 atlrGetKtx2LevelsSize(const AtlrKtx2File* restrict, const AtlrU32 baseLevel);
+AtlrU8 atlrCommandCopyKtx2Levels(const VkCommandBuffer, AtlrBuffer* restrict stagingBuffer, const AtlrImage* restrict, const AtlrU32 imageBaseLevel,
+				 const AtlrKtx2File* restrict, const AtlrU32 baseLevel, const AtlrU32 endLevel);
+AtlrU8 atlrInitImageKtx2Levels(AtlrImage* restrict, const AtlrKtx2File* restrict, const AtlrU32 baseLevel, const VkImageUsageFlags usage,
+			       const AtlrDevice* restrict, const AtlrSingleRecordCommandContext* restrict);
+AtlrU8 atlrInitImageKtx2TextureFromFiles(AtlrImage* restrict, const AtlrU32 fileCount, const char* const* filePaths,
+					 const AtlrDevice* restrict, const AtlrSingleRecordCommandContext* restrict);
+
+// texture-batch.c
+AtlrU8 atlrInitImageRgbaTexturesFromFiles(AtlrImage* restrict images, const AtlrU32 fileCount, const char* const* filePaths, const AtlrU8 hasMips,
+					  AtlrTextureBatchTimings* restrict, const AtlrDevice* restrict, const AtlrSingleRecordCommandContext* restrict);
+
+// streaming-texture.c
+AtlrU8 atlrInitStreamingTexture(AtlrStreamingTexture* restrict, const AtlrU32 width, const AtlrU32 height, const VkFormat, const AtlrU8 frameCount,
+				const AtlrDevice* restrict, const AtlrSingleRecordCommandContext* restrict);
+void atlrDeinitStreamingTexture(const AtlrStreamingTexture* restrict);
+void* atlrGetStreamingTextureData(const AtlrStreamingTexture* restrict, const AtlrU8 frame);
+AtlrU8 atlrCommandUploadStreamingTexture(const AtlrStreamingTexture* restrict, const VkCommandBuffer, const AtlrU8 frame);
+
 // descriptor.c
 VkDescriptorSetLayoutBinding atlrInitDescriptorSetLayoutBinding(const AtlrU32 binding, const VkDescriptorType, const VkShaderStageFlags);
 AtlrU8 atlrInitDescriptorSetLayout(AtlrDescriptorSetLayout* restrict, const AtlrU32 bindingCount, const VkDescriptorSetLayoutBinding* restrict,
@@ -374,6 +1067,80 @@ VkDescriptorBufferInfo atlrInitDescriptorBufferInfo(const AtlrBuffer* restrict,
 VkWriteDescriptorSet atlrWriteBufferDescriptorSet(const VkDescriptorSet, const AtlrU32 binding, const VkDescriptorType, const VkDescriptorBufferInfo* restrict);
 VkDescriptorImageInfo atlrInitDescriptorImageInfo(const AtlrImage* restrict, const VkSampler, const VkImageLayout);
 VkWriteDescriptorSet atlrWriteImageDescriptorSet(const VkDescriptorSet, const AtlrU32 binding, const VkDescriptorType, const VkDescriptorImageInfo* restrict);
+AtlrU8 atlrInitPushDescriptorSetLayout(AtlrDescriptorSetLayout* restrict, const AtlrU32 bindingCount, const VkDescriptorSetLayoutBinding* restrict,
+				       const AtlrDevice* restrict);
+void atlrCommandPushDescriptorSet(const VkCommandBuffer, const VkPipelineBindPoint, const VkPipelineLayout, const AtlrU32 set,
+				  const AtlrU32 writeCount, const VkWriteDescriptorSet* restrict writes, const AtlrDevice* restrict);
+VkDescriptorUpdateTemplateEntry atlrInitDescriptorUpdateTemplateEntry(const AtlrU32 binding, const VkDescriptorType, const AtlrU32 descriptorCount,
+								      const size_t offset, const size_t stride);
+AtlrU8 atlrInitDescriptorUpdateTemplate(AtlrDescriptorUpdateTemplate* restrict,
+					const AtlrU32 entryCount, const VkDescriptorUpdateTemplateEntry* restrict entries,
+					const AtlrDescriptorSetLayout* restrict,
+					const VkPipelineBindPoint, const VkPipelineLayout pipelineLayout, const AtlrU32 set,
+					const AtlrDevice* restrict);
+void atlrDeinitDescriptorUpdateTemplate(const AtlrDescriptorUpdateTemplate* restrict);
+void atlrUpdateDescriptorSetWithTemplate(const AtlrDescriptorUpdateTemplate* restrict, const VkDescriptorSet, const void* restrict data);
+void atlrCommandPushDescriptorSetWithTemplate(const VkCommandBuffer, const AtlrDescriptorUpdateTemplate* restrict,
+					      const VkPipelineLayout, const AtlrU32 set, const void* restrict data);
+
+// descriptor-allocator.c
+AtlrU8 atlrInitDescriptorAllocator(AtlrDescriptorAllocator* restrict, const AtlrU32 initialSetCount,
+				   const AtlrU32 poolSizeCount, const VkDescriptorPoolSize* restrict poolSizeRatios,
+				   const AtlrDevice* restrict);
+void atlrDeinitDescriptorAllocator(const AtlrDescriptorAllocator* restrict);
+AtlrU8 atlrDescriptorAllocatorAlloc(AtlrDescriptorAllocator* restrict, const AtlrU32 setCount, const VkDescriptorSetLayout* restrict setLayouts,
+				    VkDescriptorSet* restrict sets);
+AtlrU8 atlrDescriptorAllocatorGetSet(AtlrDescriptorAllocator* restrict, const VkDescriptorSetLayout,
+				     const AtlrU32 writeCount, const VkWriteDescriptorSet* restrict writes, VkDescriptorSet* restrict set);
+AtlrU8 atlrResetDescriptorAllocator(AtlrDescriptorAllocator* restrict);
+
+// bindless.c
+AtlrU8 atlrInitBindlessTable(AtlrBindlessTable* restrict, const AtlrU32 imageCapacity, const AtlrU32 bufferCapacity, const VkShaderStageFlags,
+			     const AtlrDevice* restrict);
+void atlrDeinitBindlessTable(const AtlrBindlessTable* restrict);
+AtlrU8 atlrBindlessTableAddImage(AtlrBindlessTable* restrict, AtlrU32* restrict handle, const AtlrImage* restrict, const VkSampler, const VkImageLayout);
+void atlrBindlessTableUpdateImage(const AtlrBindlessTable* restrict, const AtlrU32 handle, const AtlrImage* restrict, const VkSampler, const VkImageLayout);
+void atlrBindlessTableRemoveImage(AtlrBindlessTable* restrict, const AtlrU32 handle);
+AtlrU8 atlrBindlessTableAddBuffer(AtlrBindlessTable* restrict, AtlrU32* restrict handle, const AtlrBuffer* restrict, const AtlrU64 size);
+void atlrBindlessTableUpdateBuffer(const AtlrBindlessTable* restrict, const AtlrU32 handle, const AtlrBuffer* restrict, const AtlrU64 size);
+void atlrBindlessTableRemoveBuffer(AtlrBindlessTable* restrict, const AtlrU32 handle);
+void atlrCommandBindBindlessTable(const VkCommandBuffer, const AtlrBindlessTable* restrict, const VkPipelineBindPoint, const VkPipelineLayout, const AtlrU32 set);
+
+// texture-residency.c
+AtlrU8 atlrInitTextureResidency(AtlrTextureResidency* restrict, const AtlrU32 capacity, const AtlrU64 budget, const AtlrU64 uploadLimit,
+				const AtlrU32 framesInFlight, AtlrBindlessTable* restrict, const AtlrSingleRecordCommandContext* restrict,
+				const AtlrDevice* restrict);
+void atlrDeinitTextureResidency(AtlrTextureResidency* restrict);
+AtlrU8 atlrAddStreamedTexture(AtlrTextureResidency* restrict, AtlrU32* restrict index, const char* restrict filePath);
+void atlrRequestStreamedTextureLevel(AtlrTextureResidency* restrict, const AtlrU32 index, const AtlrU32 level);
+AtlrU32 atlrGetStreamedTextureHandle(const AtlrTextureResidency* restrict, const AtlrU32 index);
+AtlrU8 atlrUpdateTextureResidency(AtlrTextureResidency* restrict, const VkCommandBuffer);
+
+// sampler.c
+VkSamplerCreateInfo atlrInitSamplerInfo(const VkFilter, const VkSamplerAddressMode);
+void atlrInitSamplerCache(AtlrSamplerCache* restrict);
+void atlrDeinitSamplerCache(AtlrSamplerCache* restrict, const AtlrDevice* restrict);
+VkSampler atlrAcquireSampler(const AtlrDevice* restrict, const VkSamplerCreateInfo* restrict);
+void atlrReleaseSampler(const AtlrDevice* restrict, const VkSampler);
+VkDescriptorSetLayoutBinding atlrInitImmutableSamplerDescriptorSetLayoutBinding(const AtlrU32 binding, const VkDescriptorType, const VkShaderStageFlags,
+										 const VkSampler* restrict sampler);
+
+// descriptor-buffer.c
+AtlrU8 atlrInitDescriptorBufferSetLayout(AtlrDescriptorSetLayout* restrict, const AtlrU32 bindingCount, const VkDescriptorSetLayoutBinding* restrict,
+					 const AtlrDevice* restrict);
+AtlrU8 atlrInitDescriptorBuffer(AtlrDescriptorBuffer* restrict, const AtlrU64 size, const AtlrU8 hasSamplers, const AtlrDevice* restrict);
+void atlrDeinitDescriptorBuffer(AtlrDescriptorBuffer* restrict);
+AtlrU8 atlrDescriptorBufferAllocSet(AtlrDescriptorBuffer* restrict, const AtlrDescriptorSetLayout* restrict, AtlrU64* restrict offset);
+void atlrResetDescriptorBuffer(AtlrDescriptorBuffer* restrict);
+void atlrDescriptorBufferWriteBuffer(const AtlrDescriptorBuffer* restrict, const AtlrU64 setOffset, const AtlrDescriptorSetLayout* restrict,
+				     const AtlrU32 binding, const AtlrU32 arrayElement, const VkDescriptorType,
+				     const VkDeviceAddress address, const AtlrU64 range);
+void atlrDescriptorBufferWriteImage(const AtlrDescriptorBuffer* restrict, const AtlrU64 setOffset, const AtlrDescriptorSetLayout* restrict,
+				    const AtlrU32 binding, const AtlrU32 arrayElement, const VkDescriptorType,
+				    const VkDescriptorImageInfo* restrict);
+void atlrCommandBindDescriptorBuffer(const VkCommandBuffer, const AtlrDescriptorBuffer* restrict);
+void atlrCommandSetDescriptorBufferOffset(const VkCommandBuffer, const VkPipelineBindPoint, const VkPipelineLayout,
+					  const AtlrU32 set, const AtlrU64 setOffset, const AtlrDevice* restrict);
 
 // pipeline.c
 VkShaderModule atlrInitShaderModule(const char* restrict path, const AtlrDevice* restrict);
@@ -389,6 +1156,8 @@ VkPipelineColorBlendAttachmentState atlrInitPipelineColorBlendAttachmentStateAlp
 VkPipelineColorBlendAttachmentState atlrInitPipelineColorBlendAttachmentStateAdditive();
 VkPipelineColorBlendStateCreateInfo atlrInitPipelineColorBlendStateInfo(const VkPipelineColorBlendAttachmentState* restrict);
 VkPipelineDynamicStateCreateInfo atlrInitPipelineDynamicStateInfo();
+VkPipelineDynamicStateCreateInfo atlrInitPipelineExtendedDynamicStateInfo(const AtlrDevice* restrict);
+VkPipelineRenderingCreateInfo atlrInitPipelineRenderingInfo(const AtlrU32 colorAttachmentCount, const VkFormat* restrict colorFormats, const VkFormat depthFormat);
 VkPipelineLayoutCreateInfo atlrInitPipelineLayoutInfo(const AtlrU32 setLayoutCount, const VkDescriptorSetLayout* restrict setLayouts,
 						      const AtlrU32 pushConstantRangeCount, const VkPushConstantRange* restrict pushConstantRanges);
 AtlrU8 atlrInitGraphicsPipeline(AtlrPipeline* restrict,
@@ -404,12 +1173,113 @@ AtlrU8 atlrInitGraphicsPipeline(AtlrPipeline* restrict,
 				const VkPipelineDynamicStateCreateInfo* restrict,
 				const VkPipelineLayoutCreateInfo* restrict,
 				const AtlrDevice* restrict device, const AtlrRenderPass* restrict renderPass);
+AtlrU8 atlrInitGraphicsPipelineDynamicRendering(AtlrPipeline* restrict,
+						const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict,
+						const VkPipelineVertexInputStateCreateInfo* restrict,
+						const VkPipelineInputAssemblyStateCreateInfo* restrict,
+						const VkPipelineTessellationStateCreateInfo* restrict,
+						const VkPipelineViewportStateCreateInfo* restrict,
+						const VkPipelineRasterizationStateCreateInfo* restrict,
+						const VkPipelineMultisampleStateCreateInfo* restrict,
+						const VkPipelineDepthStencilStateCreateInfo* restrict,
+						const VkPipelineColorBlendStateCreateInfo* restrict,
+						const VkPipelineDynamicStateCreateInfo* restrict,
+						const VkPipelineLayoutCreateInfo* restrict,
+						const VkPipelineRenderingCreateInfo* restrict,
+						const AtlrDevice* restrict);
 AtlrU8 atlrInitComputePipeline(AtlrPipeline* restrict,
 			       const VkPipelineShaderStageCreateInfo* restrict,
 			       const VkPipelineLayoutCreateInfo* restrict,
 			       const AtlrDevice* restrict);
+AtlrU8 atlrInitDescriptorBufferComputePipeline(AtlrPipeline* restrict,
+					       const VkPipelineShaderStageCreateInfo* restrict,
+					       const VkPipelineLayoutCreateInfo* restrict,
+					       const AtlrDevice* restrict);
 void atlrDeinitPipeline(const AtlrPipeline* restrict);
 
+// pipeline-library.c
+// The parts that need attachment information take either a render pass or a dynamic rendering info, the other being NULL.
+AtlrU8 atlrInitVertexInputPipelineLibrary(AtlrPipelineLibrary* restrict,
+					  const VkPipelineVertexInputStateCreateInfo* restrict,
+					  const VkPipelineInputAssemblyStateCreateInfo* restrict,
+					  const VkPipelineDynamicStateCreateInfo* restrict,
+					  const AtlrDevice* restrict);
+AtlrU8 atlrInitPreRasterizationPipelineLibrary(AtlrPipelineLibrary* restrict,
+					       const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict,
+					       const VkPipelineTessellationStateCreateInfo* restrict,
+					       const VkPipelineViewportStateCreateInfo* restrict,
+					       const VkPipelineRasterizationStateCreateInfo* restrict,
+					       const VkPipelineDynamicStateCreateInfo* restrict,
+					       const VkPipelineLayoutCreateInfo* restrict,
+					       const AtlrRenderPass* restrict, const VkPipelineRenderingCreateInfo* restrict,
+					       const AtlrDevice* restrict);
+AtlrU8 atlrInitFragmentShaderPipelineLibrary(AtlrPipelineLibrary* restrict,
+					     const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict,
+					     const VkPipelineMultisampleStateCreateInfo* restrict,
+					     const VkPipelineDepthStencilStateCreateInfo* restrict,
+					     const VkPipelineDynamicStateCreateInfo* restrict,
+					     const VkPipelineLayoutCreateInfo* restrict,
+					     const AtlrRenderPass* restrict, const VkPipelineRenderingCreateInfo* restrict,
+					     const AtlrDevice* restrict);
+AtlrU8 atlrInitFragmentOutputPipelineLibrary(AtlrPipelineLibrary* restrict,
+					     const VkPipelineMultisampleStateCreateInfo* restrict,
+					     const VkPipelineColorBlendStateCreateInfo* restrict,
+					     const VkPipelineDynamicStateCreateInfo* restrict,
+					     const AtlrRenderPass* restrict, const VkPipelineRenderingCreateInfo* restrict,
+					     const AtlrDevice* restrict);
+void atlrDeinitPipelineLibrary(const AtlrPipelineLibrary* restrict);
+AtlrU8 atlrLinkGraphicsPipeline(AtlrPipeline* restrict, const AtlrU32 libraryCount, const AtlrPipelineLibrary* restrict libraries,
+				const VkPipelineLayoutCreateInfo* restrict, const AtlrU8 isOptimized, const AtlrDevice* restrict);
+AtlrU8 atlrInitLinkedPipeline(AtlrLinkedPipeline* restrict, const AtlrU32 libraryCount, const AtlrPipelineLibrary* restrict libraries,
+			      const VkPipelineLayoutCreateInfo* restrict, const AtlrDevice* restrict);
+const AtlrPipeline* atlrGetLinkedPipeline(AtlrLinkedPipeline* restrict);
+void atlrDeinitLinkedPipeline(AtlrLinkedPipeline* restrict);
+
+// shader-object.c
+// nextStage lists the stages that may follow this one; the binary must outlive the call to atlrInitShaderObjects.
+VkShaderCreateInfoEXT atlrInitShaderObjectInfo(const VkShaderStageFlagBits stage, const VkShaderStageFlags nextStage, const AtlrSpirVBinary* restrict,
+					       const AtlrU32 setLayoutCount, const VkDescriptorSetLayout* restrict setLayouts,
+					       const AtlrU32 pushConstantRangeCount, const VkPushConstantRange* restrict pushConstantRanges);
+AtlrU8 atlrInitShaderObjects(AtlrShaderObject* restrict shaders, const AtlrU32 shaderCount, const VkShaderCreateInfoEXT* restrict infos,
+			     const AtlrU8 isLinked, const AtlrDevice* restrict);
+void atlrDeinitShaderObject(const AtlrShaderObject* restrict);
+void atlrCommandBindShaderObjects(const VkCommandBuffer, const AtlrU32 shaderCount, const AtlrShaderObject* restrict shaders, const AtlrDevice* restrict);
+void atlrCommandBindShaderObject(const VkCommandBuffer, const AtlrShaderObject* restrict, const AtlrDevice* restrict);
+void atlrCommandSetShaderObjectState(const VkCommandBuffer, const AtlrExtendedDynamicState* restrict, const VkExtent2D extent,
+				     const VkSampleCountFlagBits samples,
+				     const AtlrU32 vertexBindingCount, const VkVertexInputBindingDescription2EXT* restrict vertexBindings,
+				     const AtlrU32 vertexAttributeCount, const VkVertexInputAttributeDescription2EXT* restrict vertexAttributes,
+				     const AtlrDevice* restrict);
+
+// pipeline-registry.c
+AtlrU8 atlrInitPipelineRegistry(AtlrPipelineRegistry* restrict, const AtlrDevice* restrict);
+void atlrDeinitPipelineRegistry(AtlrPipelineRegistry* restrict);
+VkShaderModule atlrPipelineRegistryAcquireShaderModule(AtlrPipelineRegistry* restrict, const AtlrSpirVBinary* restrict);
+VkShaderModule atlrPipelineRegistryAcquireShaderModuleFromFile(AtlrPipelineRegistry* restrict, const char* restrict path);
+void atlrPipelineRegistryReleaseShaderModule(AtlrPipelineRegistry* restrict, const VkShaderModule);
+const AtlrDescriptorSetLayout* atlrPipelineRegistryAcquireDescriptorSetLayout(AtlrPipelineRegistry* restrict,
+									      const AtlrU32 bindingCount, const VkDescriptorSetLayoutBinding* restrict);
+void atlrPipelineRegistryReleaseDescriptorSetLayout(AtlrPipelineRegistry* restrict, const AtlrDescriptorSetLayout* restrict);
+VkPipelineLayout atlrPipelineRegistryAcquirePipelineLayout(AtlrPipelineRegistry* restrict, const VkPipelineLayoutCreateInfo* restrict);
+void atlrPipelineRegistryReleasePipelineLayout(AtlrPipelineRegistry* restrict, const VkPipelineLayout);
+const AtlrPipeline* atlrPipelineRegistryAcquireGraphicsPipeline(AtlrPipelineRegistry* restrict,
+								const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict,
+								const VkPipelineVertexInputStateCreateInfo* restrict,
+								const VkPipelineInputAssemblyStateCreateInfo* restrict,
+								const VkPipelineTessellationStateCreateInfo* restrict,
+								const VkPipelineViewportStateCreateInfo* restrict,
+								const VkPipelineRasterizationStateCreateInfo* restrict,
+								const VkPipelineMultisampleStateCreateInfo* restrict,
+								const VkPipelineDepthStencilStateCreateInfo* restrict,
+								const VkPipelineColorBlendStateCreateInfo* restrict,
+								const VkPipelineDynamicStateCreateInfo* restrict,
+								const VkPipelineLayoutCreateInfo* restrict,
+								const AtlrRenderPass* restrict, const VkPipelineRenderingCreateInfo* restrict);
+const AtlrPipeline* atlrPipelineRegistryAcquireComputePipeline(AtlrPipelineRegistry* restrict,
+							       const VkPipelineShaderStageCreateInfo* restrict,
+							       const VkPipelineLayoutCreateInfo* restrict);
+void atlrPipelineRegistryReleasePipeline(AtlrPipelineRegistry* restrict, const AtlrPipeline* restrict);
+
 // render-pass.c
 VkAttachmentDescription atlrGetColorAttachmentDescription(const VkFormat, const VkSampleCountFlagBits, const VkImageLayout finalLayout);
 VkAttachmentDescription atlrGetDepthAttachmentDescription(const VkSampleCountFlagBits, const AtlrDevice* restrict, const VkImageLayout finalLayout);
@@ -424,12 +1294,20 @@ void atlrSetRenderPassName(const AtlrRenderPass* restrict, const char* restrict
 #endif
 void atlrBeginRenderPass(const AtlrRenderPass* restrict,
 			 const VkCommandBuffer, const VkFramebuffer, const VkExtent2D* restrict);
-void atlrEndRenderPass(const VkCommandBuffer);
+void atlrEndRenderPass(const VkCommandBuffer, const AtlrDevice* restrict);
+VkRenderingAttachmentInfo atlrGetColorRenderingAttachmentInfo(const VkImageView, const VkImageView resolveImageView, const VkClearValue* restrict clearColor);
+VkRenderingAttachmentInfo atlrGetDepthRenderingAttachmentInfo(const VkImageView);
+void atlrBeginRendering(const VkCommandBuffer,
+			const AtlrU32 colorAttachmentCount, const VkRenderingAttachmentInfo* restrict colorAttachments,
+			const VkRenderingAttachmentInfo* restrict depthAttachment, const VkExtent2D* restrict, const AtlrDevice* restrict);
+void atlrEndRendering(const VkCommandBuffer, const AtlrDevice* restrict);
 
 // swapchain.c
 #ifdef ATLR_BUILD_HOST_GLFW
 AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict, const AtlrU8 initRenderPass, AtlrU8 (*onReinit)(void*), void* reinitData, const VkClearValue* restrict clearColor,
 				 const AtlrDevice* restrict);
+AtlrU8 atlrInitDynamicRenderingSwapchainHostGLFW(AtlrSwapchain* restrict, AtlrU8 (*onReinit)(void*), void* reinitData, const VkClearValue* restrict clearColor,
+						 const AtlrDevice* restrict);
 void atlrDeinitSwapchainHostGLFW(AtlrSwapchain* restrict, const AtlrU8 deinitRenderPass);
 AtlrU8 atlrReinitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain);
 VkResult atlrNextSwapchainImage(const AtlrSwapchain* restrict, const VkSemaphore imageAvailableSemaphore, AtlrU32* imageIndex);
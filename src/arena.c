@@ -0,0 +1,87 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+// A linear arena hands out memory by bumping an offset, and everything it handed out is released at once by a reset or a rewind.
+// The instance's scratch arena is rewound to a mark at the end of each init path, so its transient arrays cost no heap allocations.
+// The frame paths need no arena, as their transient arrays are small and bounded and live on the stack.
+
+AtlrU8 atlrInitArena(AtlrArena* restrict arena, const AtlrU64 capacity)
+{
+  // the buffer is aligned generously, so the alignments requested later only depend on the offset
+  arena->data = atlrAlignedMalloc(capacity, 64);
+  if (!arena->data)
+  {
+    ATLR_ERROR_MSG("atlrAlignedMalloc returned NULL.");
+    return 0;
+  }
+  arena->capacity = capacity;
+  arena->top = 0;
+  arena->peak = 0;
+
+  return 1;
+}
+
+void atlrDeinitArena(AtlrArena* restrict arena)
+{
+  atlrAlignedFree(arena->data);
+  arena->data = NULL;
+  arena->capacity = 0;
+  arena->top = 0;
+}
+
+// The alignment must be a power of two no larger than 64; NULL is returned when the arena is full.
+void* atlrArenaAlloc(AtlrArena* restrict arena, const AtlrU64 size, const AtlrU64 alignment)
+{
+  AtlrU64 offset;
+  if (!atlrAlign(&offset, arena->top, alignment))
+  {
+    ATLR_ERROR_MSG("atlrAlign returned 0.");
+    return NULL;
+  }
+  if (offset + size > arena->capacity)
+  {
+    ATLR_ERROR_MSG("The arena of %llu bytes cannot fit %llu more bytes.", (unsigned long long)arena->capacity, (unsigned long long)size);
+    return NULL;
+  }
+
+  arena->top = offset + size;
+  if (arena->top > arena->peak)
+    arena->peak = arena->top;
+  return arena->data + offset;
+}
+
+void atlrResetArena(AtlrArena* restrict arena)
+{
+  arena->top = 0;
+}
+
+// Scratch allocations are released in reverse order by rewinding to the mark taken before them.
+AtlrU64 atlrGetArenaMark(const AtlrArena* restrict arena)
+{
+  return arena->top;
+}
+
+void atlrRewindArena(AtlrArena* restrict arena, const AtlrU64 mark)
+{
+  arena->top = mark;
+}
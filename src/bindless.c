@@ -0,0 +1,240 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+#define IMAGE_BINDING 0
+#define BUFFER_BINDING 1
+
+static void initHandleList(AtlrBindlessHandleList* restrict list, const AtlrU32 capacity)
+{
+  list->capacity = capacity;
+  list->count = 0;
+  list->freeCount = 0;
+  list->freeHandles = malloc(capacity * sizeof(AtlrU32));
+}
+
+// removed handles are reused before the list grows, so handles stay below the capacity
+static AtlrU8 takeHandle(AtlrBindlessHandleList* restrict list, AtlrU32* restrict handle)
+{
+  if (list->freeCount)
+  {
+    *handle = list->freeHandles[--list->freeCount];
+    return 1;
+  }
+  if (list->count == list->capacity) return 0;
+  
+  *handle = list->count++;
+  return 1;
+}
+
+static void giveHandle(AtlrBindlessHandleList* restrict list, const AtlrU32 handle)
+{
+  list->freeHandles[list->freeCount++] = handle;
+}
+
+// Shaders declare the table as
+//   layout(set = N, binding = 0) uniform sampler2D textures[];
+//   layout(set = N, binding = 1) buffer Buffers { ... } buffers[];
+// and index it with handles passed through push constants, wrapped in nonuniformEXT when they vary within a draw.
+// The capacities are clamped to the device's update-after-bind limits.
+AtlrU8 atlrInitBindlessTable(AtlrBindlessTable* restrict table, const AtlrU32 imageCapacity, const AtlrU32 bufferCapacity, const VkShaderStageFlags stageFlags,
+			     const AtlrDevice* restrict device)
+{
+  table->device = device;
+  
+  if (!device->features.descriptorIndexing)
+  {
+    ATLR_ERROR_MSG("Descriptor indexing is not enabled on the device.");
+    return 0;
+  }
+
+  VkPhysicalDeviceVulkan12Properties vulkan12Properties =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES,
+    .pNext = NULL
+  };
+  VkPhysicalDeviceProperties2 properties2 =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+    .pNext = &vulkan12Properties
+  };
+  vkGetPhysicalDeviceProperties2(device->physical, &properties2);
+  AtlrU32 maxImages = vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages;
+  if (vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages < maxImages) maxImages = vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages;
+  if (vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers < maxImages) maxImages = vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers;
+  AtlrU32 maxBuffers = vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers;
+  if (vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers < maxBuffers) maxBuffers = vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers;
+  
+  initHandleList(&table->images, (imageCapacity < maxImages) ? imageCapacity : maxImages);
+  initHandleList(&table->buffers, (bufferCapacity < maxBuffers) ? bufferCapacity : maxBuffers);
+  if ((table->images.capacity < imageCapacity) || (table->buffers.capacity < bufferCapacity))
+    atlrLog(ATLR_LOG_WARN, "Bindless table capacities were clamped to %u images and %u buffers.", table->images.capacity, table->buffers.capacity);
+
+  const VkDescriptorSetLayoutBinding bindings[2] =
+  {
+    {
+      .binding = IMAGE_BINDING,
+      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .descriptorCount = table->images.capacity,
+      .stageFlags = stageFlags,
+      .pImmutableSamplers = NULL
+    },
+    {
+      .binding = BUFFER_BINDING,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = table->buffers.capacity,
+      .stageFlags = stageFlags,
+      .pImmutableSamplers = NULL
+    }
+  };
+  // unused slots may stay unwritten, and slots may be written while the set is bound in pending command buffers
+  const VkDescriptorBindingFlags bindingFlags[2] =
+  {
+    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT,
+    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+  };
+  const VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+    .pNext = NULL,
+    .bindingCount = 2,
+    .pBindingFlags = bindingFlags
+  };
+  const VkDescriptorSetLayoutCreateInfo setLayoutInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .pNext = &bindingFlagsInfo,
+    .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+    .bindingCount = 2,
+    .pBindings = bindings
+  };
+  table->setLayout.device = device;
+  if (vkCreateDescriptorSetLayout(device->logical, &setLayoutInfo, device->instance->allocator, &table->setLayout.layout) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateDescriptorSetLayout did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  const VkDescriptorPoolSize poolSizes[2] =
+  {
+    atlrInitDescriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, table->images.capacity),
+    atlrInitDescriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, table->buffers.capacity)
+  };
+  const VkDescriptorPoolCreateInfo poolInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+    .pNext = NULL,
+    .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+    .maxSets = 1,
+    .poolSizeCount = 2,
+    .pPoolSizes = poolSizes
+  };
+  table->pool.device = device;
+  if (vkCreateDescriptorPool(device->logical, &poolInfo, device->instance->allocator, &table->pool.pool) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateDescriptorPool did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  if (!atlrAllocDescriptorSets(&table->pool, 1, &table->setLayout.layout, &table->set))
+  {
+    ATLR_ERROR_MSG("atlrAllocDescriptorSets returned 0.");
+    return 0;
+  }
+
+#ifdef ATLR_DEBUG
+  atlrSetObjectName(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, (AtlrU64)table->setLayout.layout, "Bindless Table Descriptor Layout", device);
+  atlrSetObjectName(VK_OBJECT_TYPE_DESCRIPTOR_SET, (AtlrU64)table->set, "Bindless Table Descriptor Set", device);
+#endif
+
+  return 1;
+}
+
+void atlrDeinitBindlessTable(const AtlrBindlessTable* restrict table)
+{
+  atlrDeinitDescriptorPool(&table->pool);
+  atlrDeinitDescriptorSetLayout(&table->setLayout);
+  free(table->buffers.freeHandles);
+  free(table->images.freeHandles);
+}
+
+// the handle is the index shaders use into the texture array
+AtlrU8 atlrBindlessTableAddImage(AtlrBindlessTable* restrict table, AtlrU32* restrict handle,
+				 const AtlrImage* restrict image, const VkSampler sampler, const VkImageLayout imageLayout)
+{
+  if (!takeHandle(&table->images, handle))
+  {
+    ATLR_ERROR_MSG("The bindless table is out of image handles.");
+    return 0;
+  }
+
+  atlrBindlessTableUpdateImage(table, *handle, image, sampler, imageLayout);
+  return 1;
+}
+
+// points an existing handle at another image; shaders pick it up on their next use of the handle
+void atlrBindlessTableUpdateImage(const AtlrBindlessTable* restrict table, const AtlrU32 handle,
+				  const AtlrImage* restrict image, const VkSampler sampler, const VkImageLayout imageLayout)
+{
+  const VkDescriptorImageInfo imageInfo = atlrInitDescriptorImageInfo(image, sampler, imageLayout);
+  VkWriteDescriptorSet descriptorWrite = atlrWriteImageDescriptorSet(table->set, IMAGE_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &imageInfo);
+  descriptorWrite.dstArrayElement = handle;
+  vkUpdateDescriptorSets(table->device->logical, 1, &descriptorWrite, 0, NULL);
+}
+
+// The slot is not cleared, so no draw still in flight may use the handle once it is reused.
+void atlrBindlessTableRemoveImage(AtlrBindlessTable* restrict table, const AtlrU32 handle)
+{
+  giveHandle(&table->images, handle);
+}
+
+AtlrU8 atlrBindlessTableAddBuffer(AtlrBindlessTable* restrict table, AtlrU32* restrict handle, const AtlrBuffer* restrict buffer, const AtlrU64 size)
+{
+  if (!takeHandle(&table->buffers, handle))
+  {
+    ATLR_ERROR_MSG("The bindless table is out of buffer handles.");
+    return 0;
+  }
+
+  atlrBindlessTableUpdateBuffer(table, *handle, buffer, size);
+  return 1;
+}
+
+void atlrBindlessTableUpdateBuffer(const AtlrBindlessTable* restrict table, const AtlrU32 handle, const AtlrBuffer* restrict buffer, const AtlrU64 size)
+{
+  const VkDescriptorBufferInfo bufferInfo = atlrInitDescriptorBufferInfo(buffer, size);
+  VkWriteDescriptorSet descriptorWrite = atlrWriteBufferDescriptorSet(table->set, BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bufferInfo);
+  descriptorWrite.dstArrayElement = handle;
+  vkUpdateDescriptorSets(table->device->logical, 1, &descriptorWrite, 0, NULL);
+}
+
+void atlrBindlessTableRemoveBuffer(AtlrBindlessTable* restrict table, const AtlrU32 handle)
+{
+  giveHandle(&table->buffers, handle);
+}
+
+// binds the whole table once; draws then only push the handles they use
+void atlrCommandBindBindlessTable(const VkCommandBuffer commandBuffer, const AtlrBindlessTable* restrict table, const VkPipelineBindPoint bindPoint,
+				  const VkPipelineLayout layout, const AtlrU32 set)
+{
+  table->device->pfnCmdBindDescriptorSets(commandBuffer, bindPoint, layout, set, 1, &table->set, 0, NULL);
+}
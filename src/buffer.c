@@ -33,9 +33,55 @@ AtlrU8 atlrUniformBufferAlignment(AtlrU64* restrict aligned, const AtlrU64 offse
   return 1;
 }
 
+// Memory that is both device local and host visible lets the host write and read a buffer in place.
+// It is only used when it lies in the largest device local heap, as on unified memory devices, CPU devices and with resizable BAR;
+// the small host visible window of other discrete GPUs is left to buffers that ask for it.
+static AtlrU8 getDirectMemoryTypeIndex(AtlrU32* restrict index, AtlrU8* restrict isCached, const AtlrU32 typeFilter, const AtlrDevice* restrict device)
+{
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  vkGetPhysicalDeviceMemoryProperties(device->physical, &memoryProperties);
+
+  VkDeviceSize largestHeapSize = 0;
+  for (AtlrU32 i = 0; i < memoryProperties.memoryHeapCount; i++)
+  {
+    const VkMemoryHeap* heap = memoryProperties.memoryHeaps + i;
+    if ((heap->flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && (heap->size > largestHeapSize))
+      largestHeapSize = heap->size;
+  }
+
+  const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  const VkMemoryPropertyFlags excludedProperties = VK_MEMORY_PROPERTY_DEVICE_COHERENT_BIT_AMD | VK_MEMORY_PROPERTY_DEVICE_UNCACHED_BIT_AMD;
+  AtlrU8 isFound = 0;
+  for (AtlrU32 i = 0; i < memoryProperties.memoryTypeCount; i++)
+  {
+    const VkMemoryType* type = memoryProperties.memoryTypes + i;
+    if (!(typeFilter & (1 << i)) || ((type->propertyFlags & properties) != properties) || (type->propertyFlags & excludedProperties)
+	|| (memoryProperties.memoryHeaps[type->heapIndex].size < largestHeapSize))
+      continue;
+
+    // reading uncached memory from the host is slow, so a cached type is preferred
+    const AtlrU8 isTypeCached = (type->propertyFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != 0;
+    if (!isFound || (isTypeCached && !*isCached))
+    {
+      *index = i;
+      *isCached = isTypeCached;
+      isFound = 1;
+    }
+  }
+
+  return isFound;
+}
+
+// Buffers that only ask for device local memory are placed in direct memory when the device has it (see getDirectMemoryTypeIndex),
+// so that atlrStageBuffer and atlrReadbackBuffer skip the staging copies.
 AtlrU8 atlrInitBuffer(AtlrBuffer* restrict buffer, const AtlrU64 size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties, const AtlrDevice* device)
 {
   buffer->device = device;
+  if ((usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) && !device->features.bufferDeviceAddress)
+  {
+    ATLR_ERROR_MSG("Buffer device address is not enabled on the device.");
+    return 0;
+  }
   
   const VkBufferCreateInfo bufferInfo =
   {
@@ -57,15 +103,28 @@ AtlrU8 atlrInitBuffer(AtlrBuffer* restrict buffer, const AtlrU64 size, const VkB
   VkMemoryRequirements memoryRequirements;
   vkGetBufferMemoryRequirements(device->logical, buffer->buffer, &memoryRequirements);
   AtlrU32 memoryTypeIndex;
-  if (!atlrGetVulkanMemoryTypeIndex(&memoryTypeIndex, device->physical, memoryRequirements.memoryTypeBits, properties))
+  buffer->isDirect = (properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    && getDirectMemoryTypeIndex(&memoryTypeIndex, &buffer->isDirectCached, memoryRequirements.memoryTypeBits, device);
+  if (!buffer->isDirect)
+    buffer->isDirectCached = 0;
+  buffer->isImported = 0;
+  if (!buffer->isDirect && !atlrGetVulkanMemoryTypeIndex(&memoryTypeIndex, device->physical, memoryRequirements.memoryTypeBits, properties))
   {
     ATLR_ERROR_MSG("atlrGetVulkanMemoryTypeIndex returned 0.");
     return 0;
   }
+  // buffers used through device addresses need memory allocated for it
+  const VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+    .pNext = NULL,
+    .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+    .deviceMask = 0
+  };
   const VkMemoryAllocateInfo memoryAllocateInfo =
   {
     .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    .pNext = NULL,
+    .pNext = (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? &memoryAllocateFlagsInfo : NULL,
     .allocationSize = memoryRequirements.size,
     .memoryTypeIndex = memoryTypeIndex
   };
@@ -82,10 +141,27 @@ AtlrU8 atlrInitBuffer(AtlrBuffer* restrict buffer, const AtlrU64 size, const VkB
   }
 
   buffer->data = NULL;
+  if (buffer->isDirect && !atlrMapBuffer(buffer, 0, VK_WHOLE_SIZE, 0))
+  {
+    ATLR_ERROR_MSG("atlrMapBuffer returned 0.");
+    return 0;
+  }
 
   return 1;
 }
 
+// the buffer must have been created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+VkDeviceAddress atlrGetBufferDeviceAddress(const AtlrBuffer* restrict buffer)
+{
+  const VkBufferDeviceAddressInfo addressInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+    .pNext = NULL,
+    .buffer = buffer->buffer
+  };
+  return vkGetBufferDeviceAddress(buffer->device->logical, &addressInfo);
+}
+
 #ifdef ATLR_DEBUG
 void atlrSetBufferName(const AtlrBuffer* restrict buffer, const char* restrict bufferName)
 {
@@ -126,6 +202,8 @@ AtlrU8 atlrInitReadbackingBuffer(AtlrBuffer* restrict buffer, const AtlrU64 size
 void atlrDeinitBuffer(AtlrBuffer* restrict buffer)
 {
   const AtlrDevice* device = buffer->device;
+  if (buffer->isDirect && !buffer->isImported)
+    atlrUnmapBuffer(buffer);
   vkFreeMemory(device->logical, buffer->memory, device->instance->allocator);
   vkDestroyBuffer(device->logical, buffer->buffer, device->instance->allocator);
 }
@@ -206,7 +284,7 @@ AtlrU8 atlrCopyBuffer(const AtlrBuffer* restrict dst, const AtlrBuffer* restrict
     .dstOffset = dstOffset,
     .size = size
   };
-  vkCmdCopyBuffer(commandBuffer, src->buffer, dst->buffer, 1, &copyRegion);
+  commandContext->device->pfnCmdCopyBuffer(commandBuffer, src->buffer, dst->buffer, 1, &copyRegion);
 
   if (!atlrEndSingleRecordCommands(commandBuffer, commandContext))
   {
@@ -251,7 +329,7 @@ AtlrU8 atlrCopyBufferToImage(const AtlrBuffer* buffer, const AtlrImage* restrict
       .depth = 1
     }
   };
-  vkCmdCopyBufferToImage(commandBuffer, buffer->buffer, image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+  commandContext->device->pfnCmdCopyBufferToImage(commandBuffer, buffer->buffer, image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
 
   if (!atlrEndSingleRecordCommands(commandBuffer, commandContext))
   {
@@ -262,8 +340,15 @@ AtlrU8 atlrCopyBufferToImage(const AtlrBuffer* buffer, const AtlrImage* restrict
   return 1;
 }
 
+// Direct buffers are written in place; the write is visible to the device from the next submission on.
 AtlrU8 atlrStageBuffer(AtlrBuffer* restrict buffer, const AtlrU64 offset, const AtlrU64 size, const void* restrict data, const AtlrSingleRecordCommandContext* restrict commandContext)
 {
+  if (buffer->isDirect)
+  {
+    memcpy((AtlrU8*)buffer->data + offset, data, size);
+    return 1;
+  }
+
   AtlrBuffer stagingBuffer;
   if (!atlrInitStagingBuffer(&stagingBuffer, size, buffer->device))
   {
@@ -288,8 +373,37 @@ AtlrU8 atlrStageBuffer(AtlrBuffer* restrict buffer, const AtlrU64 offset, const
   return 1;
 }
 
+// Direct buffers in cached memory are read in place.
+// A waited on fence does not make device writes visible to the host, so a barrier is still submitted, but nothing is copied.
+// Uncached direct memory is slow to read from the host, so it is copied to cached host memory as usual.
 AtlrU8 atlrReadbackBuffer(AtlrBuffer* restrict buffer, const AtlrU64 offset, const AtlrU64 size, void* restrict data, const AtlrSingleRecordCommandContext* restrict commandContext)
 {
+  if (buffer->isDirectCached)
+  {
+    VkCommandBuffer commandBuffer;
+    if (!atlrBeginSingleRecordCommands(&commandBuffer, commandContext))
+    {
+      ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+      return 0;
+    }
+    const VkMemoryBarrier barrier =
+    {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .pNext = NULL,
+      .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_HOST_READ_BIT
+    };
+    commandContext->device->pfnCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+    if (!atlrEndSingleRecordCommands(commandBuffer, commandContext))
+    {
+      ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+      return 0;
+    }
+
+    memcpy(data, (const AtlrU8*)buffer->data + offset, size);
+    return 1;
+  }
+
   AtlrBuffer readbackingBuffer;
   if (!atlrInitReadbackingBuffer(&readbackingBuffer, size, buffer->device))
   {
@@ -372,12 +486,13 @@ void atlrSetMeshName(const AtlrMesh* restrict mesh, const char* restrict meshNam
 
 void atlrBindMesh(const AtlrMesh* restrict mesh, const VkCommandBuffer commandBuffer)
 {
+  const AtlrDevice* device = mesh->vertexBuffer.device;
   const VkDeviceSize offsets[] = {0};
-  vkCmdBindVertexBuffers(commandBuffer, 0, 1, &mesh->vertexBuffer.buffer, offsets);
-  vkCmdBindIndexBuffer(commandBuffer, mesh->indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
+  device->pfnCmdBindVertexBuffers(commandBuffer, 0, 1, &mesh->vertexBuffer.buffer, offsets);
+  device->pfnCmdBindIndexBuffer(commandBuffer, mesh->indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
 }
 
 void atlrDrawMesh(const AtlrMesh* restrict mesh, const VkCommandBuffer commandBuffer)
 {
-  vkCmdDrawIndexed(commandBuffer, mesh->indexCount, 1, 0, 0, 0);
+  mesh->indexBuffer.device->pfnCmdDrawIndexed(commandBuffer, mesh->indexCount, 1, 0, 0, 0);
 }
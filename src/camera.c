@@ -64,29 +64,33 @@ AtlrU8 atlrInitPerspectiveCameraHostGLFW(AtlrPerspectiveCamera* restrict camera,
   atlrSetObjectName(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, (AtlrU64)camera->descriptorSetLayout.layout, "Camera Descriptor Layout", device);
 #endif
   
-  const VkDescriptorPoolSize poolSize = atlrInitDescriptorPoolSize(type, frameCount);
-  if (!atlrInitDescriptorPool(&camera->descriptorPool, frameCount, 1, &poolSize, device))
+  const VkDescriptorPoolSize poolSizeRatio = atlrInitDescriptorPoolSize(type, 1);
+  if (!atlrInitDescriptorAllocator(&camera->descriptorAllocator, frameCount, 1, &poolSizeRatio, device))
   {
-    ATLR_ERROR_MSG("atlrInitDescriptorPool returned 0.");
+    ATLR_ERROR_MSG("atlrInitDescriptorAllocator returned 0.");
     return 0;
   }
-#ifdef ATLR_DEBUG
-  atlrSetObjectName(VK_OBJECT_TYPE_DESCRIPTOR_POOL, (AtlrU64)camera->descriptorPool.pool, "Camera Descriptor Pool", device);
-#endif
 
   camera->descriptorSets = malloc(frameCount * sizeof(VkDescriptorSet));
-  VkDescriptorSetLayout* setLayouts = malloc(frameCount * sizeof(VkDescriptorSetLayout));
+  AtlrArena* scratch = device->instance->scratch;
+  const AtlrU64 scratchMark = atlrGetArenaMark(scratch);
+  VkDescriptorSetLayout* setLayouts = atlrArenaAlloc(scratch, frameCount * sizeof(VkDescriptorSetLayout), ATLR_ARENA_ALIGNMENT);
+  VkDescriptorBufferInfo* bufferInfos = atlrArenaAlloc(scratch, frameCount * sizeof(VkDescriptorBufferInfo), ATLR_ARENA_ALIGNMENT);
+  VkWriteDescriptorSet* descriptorWrites = atlrArenaAlloc(scratch, frameCount * sizeof(VkWriteDescriptorSet), ATLR_ARENA_ALIGNMENT);
+  if (!setLayouts || !bufferInfos || !descriptorWrites)
+  {
+    ATLR_ERROR_MSG("atlrArenaAlloc returned NULL.");
+    atlrRewindArena(scratch, scratchMark);
+    return 0;
+  }
   for (AtlrU8 i = 0; i < frameCount; i++) setLayouts[i] = camera->descriptorSetLayout.layout;
-  if (!atlrAllocDescriptorSets(&camera->descriptorPool, frameCount, setLayouts, camera->descriptorSets))
+  if (!atlrDescriptorAllocatorAlloc(&camera->descriptorAllocator, frameCount, setLayouts, camera->descriptorSets))
   {
-    ATLR_ERROR_MSG("atlrAllocDescriptorSets returned 0.");
-    free(setLayouts);
+    ATLR_ERROR_MSG("atlrDescriptorAllocatorAlloc returned 0.");
+    atlrRewindArena(scratch, scratchMark);
     return 0;
   }
-  free(setLayouts);
 
-  VkDescriptorBufferInfo* bufferInfos = malloc(frameCount * sizeof(VkDescriptorBufferInfo));
-  VkWriteDescriptorSet* descriptorWrites = malloc(frameCount * sizeof(VkWriteDescriptorSet));
   for (AtlrU8 i = 0; i < frameCount; i++)
   {
 #ifdef ATLR_DEBUG
@@ -99,8 +103,7 @@ AtlrU8 atlrInitPerspectiveCameraHostGLFW(AtlrPerspectiveCamera* restrict camera,
     descriptorWrites[i] = atlrWriteBufferDescriptorSet(camera->descriptorSets[i], 0, type, bufferInfos + i);
   }
   vkUpdateDescriptorSets(device->logical, frameCount, descriptorWrites, 0, NULL);
-  free(bufferInfos);
-  free(descriptorWrites);
+  atlrRewindArena(scratch, scratchMark);
 
   camera->fov = fov;
   camera->nearPlane = nearPlane;
@@ -119,7 +122,7 @@ AtlrU8 atlrInitPerspectiveCameraHostGLFW(AtlrPerspectiveCamera* restrict camera,
 
 void atlrDeinitPerspectiveCameraHostGLFW(const AtlrPerspectiveCamera* restrict camera)
 {
-  atlrDeinitDescriptorPool(&camera->descriptorPool);
+  atlrDeinitDescriptorAllocator(&camera->descriptorAllocator);
   free(camera->descriptorSets);
   atlrDeinitDescriptorSetLayout(&camera->descriptorSetLayout);
 
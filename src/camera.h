@@ -9,7 +9,7 @@ typedef struct _AtlrPerspectiveCamera
   AtlrU8 frameCount;
   AtlrBuffer* uniformBuffers;
   AtlrDescriptorSetLayout descriptorSetLayout;
-  AtlrDescriptorPool descriptorPool;
+  AtlrDescriptorAllocator descriptorAllocator;
   VkDescriptorSet* descriptorSets;
   
   float fov, nearPlane, farPlane;
@@ -0,0 +1,612 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "offscreen-canvas.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// swap the red and blue channels of BGRA8 texels
+static void swizzleBgraToRgba(AtlrU8* restrict dst, const AtlrU8* restrict src, const AtlrU64 texelCount)
+{
+  AtlrU64 i = 0;
+#if defined(__SSE2__)
+  // each texel is a little endian 32-bit word; the red and blue bytes trade places with a pair of 16-bit shifts
+  const __m128i redBlueMask = _mm_set1_epi32(0x00FF00FF);
+  for (; i + 4 <= texelCount; i += 4)
+  {
+    const __m128i texels = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+    const __m128i redBlue = _mm_and_si128(texels, redBlueMask);
+    const __m128i swapped = _mm_or_si128(_mm_slli_epi32(redBlue, 16), _mm_srli_epi32(redBlue, 16));
+    _mm_storeu_si128((__m128i*)(dst + 4 * i), _mm_or_si128(_mm_andnot_si128(redBlueMask, texels), swapped));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= texelCount; i += 16)
+  {
+    uint8x16x4_t texels = vld4q_u8(src + 4 * i);
+    const uint8x16_t blue = texels.val[0];
+    texels.val[0] = texels.val[2];
+    texels.val[2] = blue;
+    vst4q_u8(dst + 4 * i, texels);
+  }
+#endif
+  for (; i < texelCount; i++)
+  {
+    dst[4 * i + 0] = src[4 * i + 2];
+    dst[4 * i + 1] = src[4 * i + 1];
+    dst[4 * i + 2] = src[4 * i + 0];
+    dst[4 * i + 3] = src[4 * i + 3];
+  }
+}
+
+// the depth aspect of a D24 image is copied out as X8_D24 words
+static void unpackDepth24(float* restrict dst, const AtlrU32* restrict src, const AtlrU64 texelCount)
+{
+  const float scale = 1.0f / 16777215.0f;
+  AtlrU64 i = 0;
+#if defined(__SSE2__)
+  const __m128i depthMask = _mm_set1_epi32(0x00FFFFFF);
+  const __m128 scales = _mm_set1_ps(scale);
+  for (; i + 4 <= texelCount; i += 4)
+  {
+    const __m128i texels = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + i)), depthMask);
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(texels), scales));
+  }
+#elif defined(__ARM_NEON)
+  const uint32x4_t depthMask = vdupq_n_u32(0x00FFFFFF);
+  for (; i + 4 <= texelCount; i += 4)
+  {
+    const uint32x4_t texels = vandq_u32(vld1q_u32(src + i), depthMask);
+    vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_u32(texels), scale));
+  }
+#endif
+  for (; i < texelCount; i++)
+    dst[i] = (float)(src[i] & 0x00FFFFFF) * scale;
+}
+
+// Host reads from uncached memory are very slow, so cached memory is preferred;
+// without coherence the mapped ranges are invalidated before a frame is handed out.
+static AtlrU8 getReadbackMemoryProperties(VkMemoryPropertyFlags* restrict properties, const AtlrDevice* restrict device)
+{
+  const VkMemoryPropertyFlags choices[3] =
+  {
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+  };
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  vkGetPhysicalDeviceMemoryProperties(device->physical, &memoryProperties);
+  for (AtlrU32 c = 0; c < 3; c++)
+  {
+    for (AtlrU32 i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+      if ((memoryProperties.memoryTypes[i].propertyFlags & choices[c]) == choices[c])
+      {
+	*properties = choices[c];
+	return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+static AtlrU8 invalidateBuffer(const AtlrBuffer* restrict buffer)
+{
+  const VkMappedMemoryRange memoryRange =
+  {
+    .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+    .pNext = NULL,
+    .memory = buffer->memory,
+    .offset = 0,
+    .size = VK_WHOLE_SIZE
+  };
+  if (vkInvalidateMappedMemoryRanges(buffer->device->logical, 1, &memoryRange) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkInvalidateMappedMemoryRanges did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// The buffers stay mapped for the lifetime of the readback; on failure the slot is left with nothing to deinit.
+// Its command buffer is freed along with the command pool.
+static AtlrU8 initReadbackSlot(AtlrCanvasReadbackSlot* restrict slot, const AtlrCanvasReadback* restrict readback, const AtlrU64 texelCount,
+			       const VkMemoryPropertyFlags memoryProperties)
+{
+  const AtlrDevice* device = readback->canvas->device;
+  slot->index = 0;
+  slot->isPending = 0;
+  slot->depthBuffer.buffer = VK_NULL_HANDLE;
+  if (!atlrAllocatePrimaryCommandBuffers(&slot->commandBuffer, 1, readback->commandPool, device))
+  {
+    ATLR_ERROR_MSG("atlrAllocatePrimaryCommandBuffers returned 0.");
+    return 0;
+  }
+
+  const VkFenceCreateInfo fenceInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0
+  };
+  if (vkCreateFence(device->logical, &fenceInfo, device->instance->allocator, &slot->fence) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateFence did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  if (!atlrInitBuffer(&slot->colorBuffer, 4 * texelCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryProperties, device))
+  {
+    ATLR_ERROR_MSG("atlrInitBuffer returned 0.");
+    vkDestroyFence(device->logical, slot->fence, device->instance->allocator);
+    return 0;
+  }
+  if (!atlrMapBuffer(&slot->colorBuffer, 0, VK_WHOLE_SIZE, 0))
+  {
+    ATLR_ERROR_MSG("atlrMapBuffer returned 0.");
+    atlrDeinitBuffer(&slot->colorBuffer);
+    vkDestroyFence(device->logical, slot->fence, device->instance->allocator);
+    return 0;
+  }
+
+  if (!readback->hasDepth)
+    return 1;
+
+  if (!atlrInitBuffer(&slot->depthBuffer, 4 * texelCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryProperties, device))
+  {
+    ATLR_ERROR_MSG("atlrInitBuffer returned 0.");
+    atlrUnmapBuffer(&slot->colorBuffer);
+    atlrDeinitBuffer(&slot->colorBuffer);
+    vkDestroyFence(device->logical, slot->fence, device->instance->allocator);
+    return 0;
+  }
+  if (!atlrMapBuffer(&slot->depthBuffer, 0, VK_WHOLE_SIZE, 0))
+  {
+    ATLR_ERROR_MSG("atlrMapBuffer returned 0.");
+    atlrDeinitBuffer(&slot->depthBuffer);
+    atlrUnmapBuffer(&slot->colorBuffer);
+    atlrDeinitBuffer(&slot->colorBuffer);
+    vkDestroyFence(device->logical, slot->fence, device->instance->allocator);
+    return 0;
+  }
+
+  return 1;
+}
+
+// the slot's frame must no longer be in flight
+static void deinitReadbackSlot(AtlrCanvasReadbackSlot* restrict slot, const AtlrCanvasReadback* restrict readback)
+{
+  const AtlrDevice* device = readback->canvas->device;
+  if (readback->hasDepth)
+  {
+    atlrUnmapBuffer(&slot->depthBuffer);
+    atlrDeinitBuffer(&slot->depthBuffer);
+  }
+  atlrUnmapBuffer(&slot->colorBuffer);
+  atlrDeinitBuffer(&slot->colorBuffer);
+  vkDestroyFence(device->logical, slot->fence, device->instance->allocator);
+}
+
+// The canvas color format must be 8-bit RGBA or BGRA; RGBA frames are handed out straight from the mapped memory.
+// When the callback is NULL, frames are only delivered through atlrTryAcquireCanvasReadbackFrame.
+AtlrU8 atlrInitCanvasReadback(AtlrCanvasReadback* restrict readback, const AtlrOffscreenCanvas* restrict canvas, const AtlrU32 slotCount, const AtlrU8 hasDepth,
+			      const AtlrCanvasReadbackCallback callback, void* userData)
+{
+  const AtlrDevice* device = canvas->device;
+  readback->canvas = canvas;
+  readback->slotCount = slotCount;
+  readback->head = 0;
+  readback->tail = 0;
+  readback->pendingCount = 0;
+  readback->frameCount = 0;
+  readback->isAcquired = 0;
+  readback->hasDepth = hasDepth;
+  readback->rgba = NULL;
+  readback->depth = NULL;
+  readback->callback = callback;
+  readback->userData = userData;
+
+  if (!slotCount)
+  {
+    ATLR_ERROR_MSG("A canvas readback needs at least one slot.");
+    return 0;
+  }
+
+  switch (canvas->colorImage.format)
+  {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+      readback->isBgra = 0;
+      break;
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+      readback->isBgra = 1;
+      break;
+    default:
+      ATLR_ERROR_MSG("The canvas color format cannot be read back.");
+      return 0;
+  }
+  readback->isPackedDepth = hasDepth && (canvas->depthImage.format == VK_FORMAT_D24_UNORM_S8_UINT);
+
+  VkMemoryPropertyFlags memoryProperties;
+  if (!getReadbackMemoryProperties(&memoryProperties, device))
+  {
+    ATLR_ERROR_MSG("getReadbackMemoryProperties returned 0.");
+    return 0;
+  }
+  readback->isCoherent = (memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+  const AtlrU64 texelCount = (AtlrU64)canvas->extent.width * canvas->extent.height;
+  if (readback->isBgra && !(readback->rgba = malloc(4 * texelCount)))
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    return 0;
+  }
+  if (readback->isPackedDepth && !(readback->depth = malloc(texelCount * sizeof(float))))
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    free(readback->rgba);
+    return 0;
+  }
+
+  if (!atlrInitCommandPool(&readback->commandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, device->queueFamilyIndices.graphicsComputeIndex, device))
+  {
+    ATLR_ERROR_MSG("atlrInitCommandPool returned 0.");
+    free(readback->depth);
+    free(readback->rgba);
+    return 0;
+  }
+
+  readback->slots = malloc(slotCount * sizeof(AtlrCanvasReadbackSlot));
+  if (!readback->slots)
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    atlrDeinitCommandPool(readback->commandPool, device);
+    free(readback->depth);
+    free(readback->rgba);
+    return 0;
+  }
+  for (AtlrU32 i = 0; i < slotCount; i++)
+  {
+    if (!initReadbackSlot(readback->slots + i, readback, texelCount, memoryProperties))
+    {
+      ATLR_ERROR_MSG("initReadbackSlot returned 0.");
+      while (i--)
+	deinitReadbackSlot(readback->slots + i, readback);
+      free(readback->slots);
+      atlrDeinitCommandPool(readback->commandPool, device);
+      free(readback->depth);
+      free(readback->rgba);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+// frames still in flight are waited on and dropped
+void atlrDeinitCanvasReadback(AtlrCanvasReadback* restrict readback)
+{
+  const AtlrDevice* device = readback->canvas->device;
+  for (AtlrU32 i = 0; i < readback->slotCount; i++)
+  {
+    AtlrCanvasReadbackSlot* slot = readback->slots + i;
+    if (slot->isPending)
+      vkWaitForFences(device->logical, 1, &slot->fence, VK_TRUE, UINT64_MAX);
+    
+    deinitReadbackSlot(slot, readback);
+  }
+  atlrDeinitCommandPool(readback->commandPool, device);
+  free(readback->slots);
+  free(readback->rgba);
+  free(readback->depth);
+}
+
+// Begin recording the next frame into the returned command buffer; the canvas is rendered into it as usual.
+// If the ring is full, the oldest frame is waited on and delivered to the callback, or dropped when there is none.
+// Fails when the ring is full and the caller still holds the oldest frame from atlrTryAcquireCanvasReadbackFrame.
+VkCommandBuffer atlrBeginCanvasReadbackFrame(AtlrCanvasReadback* restrict readback)
+{
+  const AtlrDevice* device = readback->canvas->device;
+  AtlrCanvasReadbackSlot* slot = readback->slots + readback->head;
+  if (slot->isPending)
+  {
+    if (readback->isAcquired)
+    {
+      ATLR_ERROR_MSG("The oldest canvas readback frame is still acquired; release it before beginning another frame.");
+      return VK_NULL_HANDLE;
+    }
+    
+    if (device->pfnWaitForFences(device->logical, 1, &slot->fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+    {
+      ATLR_ERROR_MSG("vkWaitForFences did not return VK_SUCCESS.");
+      return VK_NULL_HANDLE;
+    }
+
+    if (readback->callback)
+    {
+      AtlrCanvasReadbackFrame frame;
+      if (!atlrTryAcquireCanvasReadbackFrame(readback, &frame))
+      {
+	ATLR_ERROR_MSG("atlrTryAcquireCanvasReadbackFrame returned 0.");
+	return VK_NULL_HANDLE;
+      }
+      readback->callback(&frame, readback->userData);
+    }
+    else
+      atlrLog(ATLR_LOG_WARN, "Dropped canvas readback frame %lu; the ring is full.", (unsigned long)slot->index);
+    atlrReleaseCanvasReadbackFrame(readback);
+  }
+
+  if (device->pfnResetCommandBuffer(slot->commandBuffer, 0) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkResetCommandBuffer did not return VK_SUCCESS.");
+    return VK_NULL_HANDLE;
+  }
+  if (!atlrBeginCommandRecording(slot->commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, device))
+  {
+    ATLR_ERROR_MSG("atlrBeginCommandRecording returned 0.");
+    return VK_NULL_HANDLE;
+  }
+
+  return slot->commandBuffer;
+}
+
+// Record the copies of the canvas attachments after rendering has ended and submit the frame without waiting on it.
+AtlrU8 atlrEndCanvasReadbackFrame(AtlrCanvasReadback* restrict readback)
+{
+  const AtlrOffscreenCanvas* canvas = readback->canvas;
+  const AtlrDevice* device = canvas->device;
+  AtlrCanvasReadbackSlot* slot = readback->slots + readback->head;
+  const VkCommandBuffer commandBuffer = slot->commandBuffer;
+
+  const VkImageSubresourceRange colorRange =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  const VkImageSubresourceRange depthRange =
+  {
+    .aspectMask = atlrGetDepthImageAspects(canvas->depthImage.format),
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  const VkExtent3D extent = {.width = canvas->extent.width, .height = canvas->extent.height, .depth = 1};
+  VkBufferImageCopy region =
+  {
+    .bufferOffset = 0,
+    .bufferRowLength = 0,
+    .bufferImageHeight = 0,
+    .imageSubresource = (VkImageSubresourceLayers)
+    {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .mipLevel = 0,
+      .baseArrayLayer = 0,
+      .layerCount = 1
+    },
+    .imageOffset = (VkOffset3D){.x = 0, .y = 0, .z = 0},
+    .imageExtent = extent
+  };
+
+  // the canvas ends rendering with its attachments in read only layouts
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, canvas->colorImage.image, &colorRange, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+  device->pfnCmdCopyImageToBuffer(commandBuffer, canvas->colorImage.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot->colorBuffer.buffer, 1, &region);
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, canvas->colorImage.image, &colorRange, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+  if (readback->hasDepth)
+  {
+    // a copy names a single aspect, so only the depth values are read back while the barriers cover the stencil aspect as well
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (!atlrCommandImageLayoutBarrier(commandBuffer, canvas->depthImage.image, &depthRange, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, device))
+    {
+      ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+      return 0;
+    }
+    device->pfnCmdCopyImageToBuffer(commandBuffer, canvas->depthImage.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot->depthBuffer.buffer, 1, &region);
+    if (!atlrCommandImageLayoutBarrier(commandBuffer, canvas->depthImage.image, &depthRange, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, device))
+    {
+      ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+      return 0;
+    }
+  }
+
+  // Make the copies visible to the host.
+  // The attachment stages are also made to wait on the copies, since the next frame discards the attachments with barriers that do not chain to the transfer stage.
+  const VkBufferMemoryBarrier bufferBarriers[2] =
+  {
+    {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      .pNext = NULL,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .buffer = slot->colorBuffer.buffer,
+      .offset = 0,
+      .size = VK_WHOLE_SIZE
+    },
+    {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      .pNext = NULL,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .buffer = slot->depthBuffer.buffer,
+      .offset = 0,
+      .size = VK_WHOLE_SIZE
+    }
+  };
+  const VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+    | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  device->pfnCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages, 0, 0, NULL, readback->hasDepth ? 2 : 1, bufferBarriers, 0, NULL);
+
+  if (!atlrEndCommandRecording(commandBuffer, device))
+  {
+    ATLR_ERROR_MSG("atlrEndCommandRecording returned 0.");
+    return 0;
+  }
+
+  if (device->pfnResetFences(device->logical, 1, &slot->fence) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkResetFences did not return VK_SUCCESS.");
+    return 0;
+  }
+  const VkSubmitInfo submitInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .pNext = NULL,
+    .waitSemaphoreCount = 0,
+    .pWaitSemaphores = NULL,
+    .pWaitDstStageMask = NULL,
+    .commandBufferCount = 1,
+    .pCommandBuffers = &commandBuffer,
+    .signalSemaphoreCount = 0,
+    .pSignalSemaphores = NULL
+  };
+  if (device->pfnQueueSubmit(device->graphicsComputeQueue, 1, &submitInfo, slot->fence) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkQueueSubmit did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  slot->index = readback->frameCount++;
+  slot->isPending = 1;
+  readback->head = (readback->head + 1) % readback->slotCount;
+  readback->pendingCount++;
+
+  return 1;
+}
+
+// Hand out the oldest frame if the GPU has finished with it; returns 0 without blocking otherwise.
+// The frame stays valid until atlrReleaseCanvasReadbackFrame is called.
+AtlrU8 atlrTryAcquireCanvasReadbackFrame(AtlrCanvasReadback* restrict readback, AtlrCanvasReadbackFrame* restrict frame)
+{
+  if (!readback->pendingCount)
+    return 0;
+
+  const AtlrDevice* device = readback->canvas->device;
+  const AtlrCanvasReadbackSlot* slot = readback->slots + readback->tail;
+  if (device->pfnGetFenceStatus(device->logical, slot->fence) != VK_SUCCESS)
+    return 0;
+
+  if (!readback->isCoherent && (!invalidateBuffer(&slot->colorBuffer) || (readback->hasDepth && !invalidateBuffer(&slot->depthBuffer))))
+  {
+    ATLR_ERROR_MSG("invalidateBuffer returned 0.");
+    return 0;
+  }
+
+  const VkExtent2D* extent = &readback->canvas->extent;
+  const AtlrU64 texelCount = (AtlrU64)extent->width * extent->height;
+  frame->index = slot->index;
+  frame->width = extent->width;
+  frame->height = extent->height;
+  if (readback->isBgra)
+  {
+    swizzleBgraToRgba(readback->rgba, slot->colorBuffer.data, texelCount);
+    frame->rgba = readback->rgba;
+  }
+  else
+    frame->rgba = slot->colorBuffer.data;
+  if (!readback->hasDepth)
+    frame->depth = NULL;
+  else if (readback->isPackedDepth)
+  {
+    unpackDepth24(readback->depth, slot->depthBuffer.data, texelCount);
+    frame->depth = readback->depth;
+  }
+  else
+    frame->depth = slot->depthBuffer.data;
+  readback->isAcquired = 1;
+
+  return 1;
+}
+
+// return the oldest frame's slot to the ring
+void atlrReleaseCanvasReadbackFrame(AtlrCanvasReadback* restrict readback)
+{
+  if (!readback->pendingCount)
+    return;
+
+  readback->isAcquired = 0;
+  readback->slots[readback->tail].isPending = 0;
+  readback->tail = (readback->tail + 1) % readback->slotCount;
+  readback->pendingCount--;
+}
+
+// Deliver every finished frame to the callback without blocking; returns the number of frames delivered.
+// Nothing is delivered while the caller holds an acquired frame.
+AtlrU32 atlrPollCanvasReadback(AtlrCanvasReadback* restrict readback)
+{
+  AtlrU32 count = 0;
+  AtlrCanvasReadbackFrame frame;
+  while (readback->callback && !readback->isAcquired && atlrTryAcquireCanvasReadbackFrame(readback, &frame))
+  {
+    readback->callback(&frame, readback->userData);
+    atlrReleaseCanvasReadbackFrame(readback);
+    count++;
+  }
+
+  return count;
+}
+
+// Wait on every frame in flight and deliver them to the callback in order.
+AtlrU8 atlrFlushCanvasReadback(AtlrCanvasReadback* restrict readback)
+{
+  const AtlrDevice* device = readback->canvas->device;
+  while (readback->pendingCount)
+  {
+    const AtlrCanvasReadbackSlot* slot = readback->slots + readback->tail;
+    if (device->pfnWaitForFences(device->logical, 1, &slot->fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+    {
+      ATLR_ERROR_MSG("vkWaitForFences did not return VK_SUCCESS.");
+      return 0;
+    }
+
+    AtlrCanvasReadbackFrame frame;
+    if (!atlrTryAcquireCanvasReadbackFrame(readback, &frame))
+    {
+      ATLR_ERROR_MSG("atlrTryAcquireCanvasReadbackFrame returned 0.");
+      return 0;
+    }
+    if (readback->callback)
+      readback->callback(&frame, readback->userData);
+    atlrReleaseCanvasReadbackFrame(readback);
+  }
+
+  return 1;
+}
@@ -66,7 +66,7 @@ AtlrU8 atlrAllocatePrimaryCommandBuffers(VkCommandBuffer* restrict commandBuffer
   return 1;
 }
 
-AtlrU8 atlrBeginCommandRecording(const VkCommandBuffer commandBuffer, const VkCommandBufferUsageFlags flags)
+AtlrU8 atlrBeginCommandRecording(const VkCommandBuffer commandBuffer, const VkCommandBufferUsageFlags flags, const AtlrDevice* restrict device)
 {
   const VkCommandBufferBeginInfo info =
   {
@@ -75,7 +75,7 @@ AtlrU8 atlrBeginCommandRecording(const VkCommandBuffer commandBuffer, const VkCo
     .flags = flags,
     .pInheritanceInfo = NULL
   };
-  if (vkBeginCommandBuffer(commandBuffer, &info) != VK_SUCCESS)
+  if (device->pfnBeginCommandBuffer(commandBuffer, &info) != VK_SUCCESS)
   {
     ATLR_ERROR_MSG("vkBeginCommandBuffer did not return VK_SUCCESS.");
     return 0;
@@ -84,9 +84,9 @@ AtlrU8 atlrBeginCommandRecording(const VkCommandBuffer commandBuffer, const VkCo
   return 1;
 }
 
-AtlrU8 atlrEndCommandRecording(const VkCommandBuffer commandBuffer)
+AtlrU8 atlrEndCommandRecording(const VkCommandBuffer commandBuffer, const AtlrDevice* restrict device)
 {
-  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+  if (device->pfnEndCommandBuffer(commandBuffer) != VK_SUCCESS)
   {
     ATLR_ERROR_MSG("vkEndCommandBuffer did not return VK_SUCCESS.");
     return 0;
@@ -97,7 +97,7 @@ AtlrU8 atlrEndCommandRecording(const VkCommandBuffer commandBuffer)
 
 #ifdef ATLR_DEBUG
 
-void atlrBeginCommandLabel(const VkCommandBuffer commandBuffer, const char* restrict labelName, const float* restrict color4, const AtlrInstance* restrict instance)
+void atlrBeginCommandLabel(const VkCommandBuffer commandBuffer, const char* restrict labelName, const float* restrict color4, const AtlrDevice* restrict device)
 {
   const VkDebugUtilsLabelEXT label =
   {
@@ -106,16 +106,12 @@ void atlrBeginCommandLabel(const VkCommandBuffer commandBuffer, const char* rest
     .pLabelName = labelName,
     .color = {color4[0], color4[1], color4[2], color4[3]}
   };
-  PFN_vkCmdBeginDebugUtilsLabelEXT pfnBegin =
-    (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance->instance, "vkCmdBeginDebugUtilsLabelEXT");
-  pfnBegin(commandBuffer, &label);
+  device->pfnCmdBeginDebugUtilsLabel(commandBuffer, &label);
 }
 
-void atlrEndCommandLabel(const VkCommandBuffer commandBuffer, const AtlrInstance* restrict instance)
+void atlrEndCommandLabel(const VkCommandBuffer commandBuffer, const AtlrDevice* restrict device)
 {
-  PFN_vkCmdEndDebugUtilsLabelEXT pfnEnd =
-    (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance->instance, "vkCmdEndDebugUtilsLabelEXT");
-  pfnEnd(commandBuffer);
+  device->pfnCmdEndDebugUtilsLabel(commandBuffer);
 }
 
 #endif
@@ -163,7 +159,7 @@ AtlrU8 atlrBeginSingleRecordCommands(VkCommandBuffer* restrict commandBuffer, co
     return 0;
   }
   
-  if (!atlrBeginCommandRecording(*commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT))
+  if (!atlrBeginCommandRecording(*commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, device))
   {
     ATLR_ERROR_MSG("altrBeginCommandRecording returned 0.");
     return 0;
@@ -175,7 +171,7 @@ AtlrU8 atlrBeginSingleRecordCommands(VkCommandBuffer* restrict commandBuffer, co
 AtlrU8 atlrEndSingleRecordCommands(const VkCommandBuffer commandBuffer, const AtlrSingleRecordCommandContext* restrict commandContext)
 {
   const AtlrDevice* device = commandContext->device;
-  if (!atlrEndCommandRecording(commandBuffer))
+  if (!atlrEndCommandRecording(commandBuffer, device))
   {
     ATLR_ERROR_MSG("atlrEndCommandRecording returned 0.");
     return 0;
@@ -193,21 +189,21 @@ AtlrU8 atlrEndSingleRecordCommands(const VkCommandBuffer commandBuffer, const At
     .signalSemaphoreCount = 0,
     .pSignalSemaphores = NULL
   };
-  if (vkQueueSubmit(commandContext->queue, 1, &submitInfo, fence) != VK_SUCCESS)
+  if (device->pfnQueueSubmit(commandContext->queue, 1, &submitInfo, fence) != VK_SUCCESS)
   {
     ATLR_ERROR_MSG("vkQueueSubmit did not return VK_SUCCESS.");
     return 0;
   }
 
-  vkWaitForFences(device->logical, 1, &fence, VK_TRUE, UINT64_MAX);
-  vkResetFences(device->logical, 1, &fence);
+  device->pfnWaitForFences(device->logical, 1, &fence, VK_TRUE, UINT64_MAX);
+  device->pfnResetFences(device->logical, 1, &fence);
 
   vkFreeCommandBuffers(device->logical, commandContext->commandPool, 1, &commandBuffer);
 
   return 1;
 }
 
-void atlrCommandSetViewport(const VkCommandBuffer commandBuffer, const float width, const float height)
+void atlrCommandSetViewport(const VkCommandBuffer commandBuffer, const float width, const float height, const AtlrDevice* restrict device)
 {
   const VkViewport viewport =
   {
@@ -218,17 +214,85 @@ void atlrCommandSetViewport(const VkCommandBuffer commandBuffer, const float wid
     .minDepth = 0.0f,
     .maxDepth = 1.0f
   };
-  vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+  device->pfnCmdSetViewport(commandBuffer, 0, 1, &viewport);
 }
 
-void atlrCommandSetScissor(const VkCommandBuffer commandBuffer, const VkOffset2D* restrict offset, const VkExtent2D* restrict extent)
+void atlrCommandSetScissor(const VkCommandBuffer commandBuffer, const VkOffset2D* restrict offset, const VkExtent2D* restrict extent, const AtlrDevice* restrict device)
 {
   const VkRect2D scissor =
   {
     .offset = *offset,
     .extent = *extent
   };
-  vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+  device->pfnCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+// defaults match the static pipeline state helpers in pipeline.c
+AtlrExtendedDynamicState atlrInitExtendedDynamicState()
+{
+  return (AtlrExtendedDynamicState)
+  {
+    .cullMode = VK_CULL_MODE_BACK_BIT,
+    .frontFace = VK_FRONT_FACE_CLOCKWISE,
+    .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+    .primitiveRestartEnable = VK_FALSE,
+    .rasterizerDiscardEnable = VK_FALSE,
+    .depthBiasEnable = VK_FALSE,
+    .depthTestEnable = VK_TRUE,
+    .depthWriteEnable = VK_TRUE,
+    .depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL, // reverse-z convention
+    .stencilTestEnable = VK_FALSE,
+    .polygonMode = VK_POLYGON_MODE_FILL,
+    .colorBlendEnable = VK_TRUE,
+    .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+  };
+}
+
+// set every extended dynamic state; needed after binding a pipeline created with atlrInitPipelineExtendedDynamicStateInfo
+void atlrCommandSetExtendedDynamicState(const VkCommandBuffer commandBuffer, const AtlrExtendedDynamicState* restrict state, const AtlrDevice* restrict device)
+{
+  device->pfnCmdSetCullMode(commandBuffer, state->cullMode);
+  device->pfnCmdSetFrontFace(commandBuffer, state->frontFace);
+  device->pfnCmdSetPrimitiveTopology(commandBuffer, state->topology);
+  device->pfnCmdSetPrimitiveRestartEnable(commandBuffer, state->primitiveRestartEnable);
+  device->pfnCmdSetRasterizerDiscardEnable(commandBuffer, state->rasterizerDiscardEnable);
+  device->pfnCmdSetDepthBiasEnable(commandBuffer, state->depthBiasEnable);
+  device->pfnCmdSetDepthTestEnable(commandBuffer, state->depthTestEnable);
+  device->pfnCmdSetDepthWriteEnable(commandBuffer, state->depthWriteEnable);
+  device->pfnCmdSetDepthCompareOp(commandBuffer, state->depthCompareOp);
+  device->pfnCmdSetStencilTestEnable(commandBuffer, state->stencilTestEnable);
+
+  if (device->features.extendedDynamicState3)
+  {
+    device->pfnCmdSetPolygonMode(commandBuffer, state->polygonMode);
+    device->pfnCmdSetColorBlendEnable(commandBuffer, 0, 1, &state->colorBlendEnable);
+    device->pfnCmdSetColorWriteMask(commandBuffer, 0, 1, &state->colorWriteMask);
+  }
+}
+
+// only record the states that differ from the current ones, then make the next state current
+void atlrCommandUpdateExtendedDynamicState(const VkCommandBuffer commandBuffer, AtlrExtendedDynamicState* restrict current, const AtlrExtendedDynamicState* restrict next,
+					   const AtlrDevice* restrict device)
+{
+  if (next->cullMode != current->cullMode)                               device->pfnCmdSetCullMode(commandBuffer, next->cullMode);
+  if (next->frontFace != current->frontFace)                             device->pfnCmdSetFrontFace(commandBuffer, next->frontFace);
+  if (next->topology != current->topology)                               device->pfnCmdSetPrimitiveTopology(commandBuffer, next->topology);
+  if (next->primitiveRestartEnable != current->primitiveRestartEnable)   device->pfnCmdSetPrimitiveRestartEnable(commandBuffer, next->primitiveRestartEnable);
+  if (next->rasterizerDiscardEnable != current->rasterizerDiscardEnable) device->pfnCmdSetRasterizerDiscardEnable(commandBuffer, next->rasterizerDiscardEnable);
+  if (next->depthBiasEnable != current->depthBiasEnable)                 device->pfnCmdSetDepthBiasEnable(commandBuffer, next->depthBiasEnable);
+  if (next->depthTestEnable != current->depthTestEnable)                 device->pfnCmdSetDepthTestEnable(commandBuffer, next->depthTestEnable);
+  if (next->depthWriteEnable != current->depthWriteEnable)               device->pfnCmdSetDepthWriteEnable(commandBuffer, next->depthWriteEnable);
+  if (next->depthCompareOp != current->depthCompareOp)                   device->pfnCmdSetDepthCompareOp(commandBuffer, next->depthCompareOp);
+  if (next->stencilTestEnable != current->stencilTestEnable)             device->pfnCmdSetStencilTestEnable(commandBuffer, next->stencilTestEnable);
+
+  if (device->features.extendedDynamicState3)
+  {
+    if (next->polygonMode != current->polygonMode)           device->pfnCmdSetPolygonMode(commandBuffer, next->polygonMode);
+    if (next->colorBlendEnable != current->colorBlendEnable) device->pfnCmdSetColorBlendEnable(commandBuffer, 0, 1, &next->colorBlendEnable);
+    if (next->colorWriteMask != current->colorWriteMask)     device->pfnCmdSetColorWriteMask(commandBuffer, 0, 1, &next->colorWriteMask);
+  }
+
+  *current = *next;
 }
 
 #ifdef ATLR_BUILD_HOST_GLFW
@@ -307,6 +371,8 @@ AtlrU8 atlrInitFrameCommandContextHostGLFW(AtlrFrameCommandContext* restrict com
   commandContext->currentFrame = 0;
   commandContext->frameCount = frameCount;
   commandContext->frames = frames;
+  commandContext->frameNumber = 0;
+  atlrInitDeletionQueue(&commandContext->deletionQueue, device);
 
   return 1;
 }
@@ -314,10 +380,12 @@ AtlrU8 atlrInitFrameCommandContextHostGLFW(AtlrFrameCommandContext* restrict com
 void atlrDeinitFrameCommandContextHostGLFW(AtlrFrameCommandContext* restrict commandContext)
 {
   const AtlrDevice* device = commandContext->swapchain->device;
+
+  atlrDeinitDeletionQueue(&commandContext->deletionQueue);
   
   for (AtlrU8 i = 0; i < commandContext->frameCount; i++)
   {
-    const AtlrFrame* frame = commandContext->frames + i;
+    AtlrFrame* frame = commandContext->frames + i;
     vkDestroyFence(device->logical, frame->inFlightFence, device->instance->allocator);
     vkDestroySemaphore(device->logical, frame->renderFinishedSemaphore, device->instance->allocator);
     vkDestroySemaphore(device->logical, frame->imageAvailableSemaphore, device->instance->allocator);
@@ -329,12 +397,16 @@ void atlrDeinitFrameCommandContextHostGLFW(AtlrFrameCommandContext* restrict com
 
 AtlrU8 atlrBeginFrameCommandsHostGLFW(AtlrFrameCommandContext* restrict commandContext)
 {
-  const AtlrFrame* frame = commandContext->frames + commandContext->currentFrame;
+  AtlrFrame* frame = commandContext->frames + commandContext->currentFrame;
   const VkCommandBuffer commandBuffer = frame->commandBuffer;
   AtlrSwapchain* swapchain = commandContext->swapchain;
   const AtlrDevice* device = swapchain->device;
   
-  vkWaitForFences(device->logical, 1, &frame->inFlightFence, VK_TRUE, UINT64_MAX);
+  device->pfnWaitForFences(device->logical, 1, &frame->inFlightFence, VK_TRUE, UINT64_MAX);
+
+  // the fence was last signaled by the frame frameCount frames ago, and queue submissions complete in order
+  if (commandContext->frameNumber >= commandContext->frameCount)
+    atlrFlushDeletionQueue(&commandContext->deletionQueue, commandContext->frameNumber - commandContext->frameCount);
 
   VkResult swapchainResult = atlrNextSwapchainImage(swapchain, frame->imageAvailableSemaphore, &commandContext->imageIndex);
   if (swapchainResult == VK_ERROR_OUT_OF_DATE_KHR)
@@ -355,10 +427,10 @@ AtlrU8 atlrBeginFrameCommandsHostGLFW(AtlrFrameCommandContext* restrict commandC
     return 0;
   }
   
-  vkResetFences(device->logical, 1, &frame->inFlightFence);
+  device->pfnResetFences(device->logical, 1, &frame->inFlightFence);
   
-  vkResetCommandBuffer(commandBuffer, 0);
-  if (!atlrBeginCommandRecording(commandBuffer, 0))
+  device->pfnResetCommandBuffer(commandBuffer, 0);
+  if (!atlrBeginCommandRecording(commandBuffer, 0, device))
   {
     ATLR_ERROR_MSG("atlrBeginCommandRecording returned 0.");
     return 0;
@@ -373,7 +445,7 @@ AtlrU8 atlrEndFrameCommandsHostGLFW(AtlrFrameCommandContext* restrict commandCon
   const VkCommandBuffer commandBuffer = frame->commandBuffer;
   AtlrSwapchain* swapchain = commandContext->swapchain;
 
-  atlrEndCommandRecording(commandBuffer);
+  atlrEndCommandRecording(commandBuffer, swapchain->device);
 
   if (atlrSwapchainSubmit(swapchain, commandBuffer,
 			  frame->imageAvailableSemaphore, frame->renderFinishedSemaphore, frame->inFlightFence) != VK_SUCCESS)
@@ -404,6 +476,7 @@ AtlrU8 atlrEndFrameCommandsHostGLFW(AtlrFrameCommandContext* restrict commandCon
   }
 
   commandContext->currentFrame = (commandContext->currentFrame + 1) % commandContext->frameCount;
+  commandContext->frameNumber++;
 
   return 1;
 }
@@ -418,8 +491,8 @@ AtlrU8 atlrFrameCommandContextBeginRenderPassHostGLFW(AtlrFrameCommandContext* r
   const VkFramebuffer framebuffer = swapchain->framebuffers[commandContext->imageIndex];
 
   atlrBeginRenderPass(&swapchain->renderPass, commandBuffer, framebuffer, &swapchain->extent);
-  atlrCommandSetViewport(commandBuffer, extent->width, extent->height);
-  atlrCommandSetScissor(commandBuffer, &offset, extent);
+  atlrCommandSetViewport(commandBuffer, extent->width, extent->height, swapchain->device);
+  atlrCommandSetScissor(commandBuffer, &offset, extent, swapchain->device);
 
   return 1;
 }
@@ -428,7 +501,82 @@ AtlrU8 atlrFrameCommandContextEndRenderPassHostGLFW(AtlrFrameCommandContext* res
 {
   const AtlrFrame* frame = commandContext->frames + commandContext->currentFrame;
   const VkCommandBuffer commandBuffer = frame->commandBuffer;
-  atlrEndRenderPass(commandBuffer);
+  atlrEndRenderPass(commandBuffer, commandContext->swapchain->device);
+
+  return 1;
+}
+
+// For swapchains initialized with atlrInitDynamicRenderingSwapchainHostGLFW.
+// The attachments are transitioned here, so no render pass or framebuffer is needed.
+AtlrU8 atlrFrameCommandContextBeginRenderingHostGLFW(AtlrFrameCommandContext* restrict commandContext)
+{
+  const AtlrFrame* frame = commandContext->frames + commandContext->currentFrame;
+  const VkCommandBuffer commandBuffer = frame->commandBuffer;
+  AtlrSwapchain* swapchain = commandContext->swapchain;
+  const AtlrDevice* device = swapchain->device;
+  const VkExtent2D* extent = &swapchain->extent;
+  const VkOffset2D offset = (VkOffset2D){.x = 0, .y = 0};
+  const VkImage swapchainImage = swapchain->images[commandContext->imageIndex];
+  const VkImageView swapchainImageView = swapchain->imageViews[commandContext->imageIndex];
+  const AtlrU8 isMultisampled = (device->msaaSamples != VK_SAMPLE_COUNT_1_BIT);
+
+  const VkImageSubresourceRange colorRange =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  const VkImageSubresourceRange depthRange =
+  {
+    .aspectMask = atlrGetDepthImageAspects(swapchain->depthImage.format),
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, swapchainImage, &colorRange, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, device)
+      || (isMultisampled && !atlrCommandImageLayoutBarrier(commandBuffer, swapchain->colorImage.image, &colorRange, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, device))
+      || !atlrCommandImageLayoutBarrier(commandBuffer, swapchain->depthImage.image, &depthRange, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+
+  // multisampled color is resolved into the swapchain image, otherwise the swapchain image is drawn to directly
+  const VkRenderingAttachmentInfo colorAttachment = isMultisampled ?
+    atlrGetColorRenderingAttachmentInfo(swapchain->colorImage.imageView, swapchainImageView, &swapchain->clearColor) :
+    atlrGetColorRenderingAttachmentInfo(swapchainImageView, VK_NULL_HANDLE, &swapchain->clearColor);
+  const VkRenderingAttachmentInfo depthAttachment = atlrGetDepthRenderingAttachmentInfo(swapchain->depthImage.imageView);
+  atlrBeginRendering(commandBuffer, 1, &colorAttachment, &depthAttachment, extent, device);
+  atlrCommandSetViewport(commandBuffer, extent->width, extent->height, device);
+  atlrCommandSetScissor(commandBuffer, &offset, extent, device);
+
+  return 1;
+}
+
+AtlrU8 atlrFrameCommandContextEndRenderingHostGLFW(AtlrFrameCommandContext* restrict commandContext)
+{
+  const AtlrFrame* frame = commandContext->frames + commandContext->currentFrame;
+  const VkCommandBuffer commandBuffer = frame->commandBuffer;
+  const AtlrSwapchain* swapchain = commandContext->swapchain;
+  atlrEndRendering(commandBuffer, swapchain->device);
+
+  const VkImageSubresourceRange colorRange =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, swapchain->images[commandContext->imageIndex], &colorRange,
+				     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, swapchain->device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
 
   return 1;
 }
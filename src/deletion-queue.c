@@ -0,0 +1,172 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+// Objects are deinitialized by atlrFlushDeletionQueue once the device has passed the value they were enqueued against,
+// so that runtime reallocations neither wait for the device to go idle nor free objects that submitted work still uses.
+// The queue copies the object, so its handles may be reinitialized right after enqueueing it.
+
+void atlrInitDeletionQueue(AtlrDeletionQueue* restrict queue, const AtlrDevice* restrict device)
+{
+  queue->device = device;
+  queue->capacity = 0;
+  queue->count = 0;
+  queue->deletions = NULL;
+}
+
+// The device must be idle, as every remaining object is deinitialized.
+void atlrDeinitDeletionQueue(AtlrDeletionQueue* restrict queue)
+{
+  atlrFlushDeletionQueue(queue, UINT64_MAX);
+  free(queue->deletions);
+  queue->capacity = 0;
+  queue->deletions = NULL;
+}
+
+static AtlrDeletion* enqueue(AtlrDeletionQueue* restrict queue, const AtlrDeletionType type, const AtlrU64 value)
+{
+  if (queue->count == queue->capacity)
+  {
+    const AtlrU32 capacity = queue->capacity ? 2 * queue->capacity : 8;
+    AtlrDeletion* deletions = realloc(queue->deletions, capacity * sizeof(AtlrDeletion));
+    if (!deletions)
+    {
+      ATLR_ERROR_MSG("realloc returned NULL.");
+      return NULL;
+    }
+    queue->capacity = capacity;
+    queue->deletions = deletions;
+  }
+
+  AtlrDeletion* deletion = queue->deletions + queue->count++;
+  deletion->type = type;
+  deletion->value = value;
+  return deletion;
+}
+
+AtlrU8 atlrDeferDeinitBuffer(AtlrDeletionQueue* restrict queue, const AtlrBuffer* restrict buffer, const AtlrU64 value)
+{
+  AtlrDeletion* deletion = enqueue(queue, ATLR_DELETION_TYPE_BUFFER, value);
+  if (!deletion)
+  {
+    ATLR_ERROR_MSG("enqueue returned NULL.");
+    return 0;
+  }
+  deletion->object.buffer = *buffer;
+
+  return 1;
+}
+
+AtlrU8 atlrDeferDeinitImage(AtlrDeletionQueue* restrict queue, const AtlrImage* restrict image, const AtlrU64 value)
+{
+  AtlrDeletion* deletion = enqueue(queue, ATLR_DELETION_TYPE_IMAGE, value);
+  if (!deletion)
+  {
+    ATLR_ERROR_MSG("enqueue returned NULL.");
+    return 0;
+  }
+  deletion->object.image = *image;
+
+  return 1;
+}
+
+AtlrU8 atlrDeferDeinitImageView(AtlrDeletionQueue* restrict queue, const VkImageView imageView, const AtlrU64 value)
+{
+  AtlrDeletion* deletion = enqueue(queue, ATLR_DELETION_TYPE_IMAGE_VIEW, value);
+  if (!deletion)
+  {
+    ATLR_ERROR_MSG("enqueue returned NULL.");
+    return 0;
+  }
+  deletion->object.imageView = imageView;
+
+  return 1;
+}
+
+// the sampler must come from atlrAcquireSampler; its reference is released once the value is reached
+AtlrU8 atlrDeferDeinitSampler(AtlrDeletionQueue* restrict queue, const VkSampler sampler, const AtlrU64 value)
+{
+  AtlrDeletion* deletion = enqueue(queue, ATLR_DELETION_TYPE_SAMPLER, value);
+  if (!deletion)
+  {
+    ATLR_ERROR_MSG("enqueue returned NULL.");
+    return 0;
+  }
+  deletion->object.sampler = sampler;
+
+  return 1;
+}
+
+AtlrU8 atlrDeferDeinitPipeline(AtlrDeletionQueue* restrict queue, const AtlrPipeline* restrict pipeline, const AtlrU64 value)
+{
+  AtlrDeletion* deletion = enqueue(queue, ATLR_DELETION_TYPE_PIPELINE, value);
+  if (!deletion)
+  {
+    ATLR_ERROR_MSG("enqueue returned NULL.");
+    return 0;
+  }
+  deletion->object.pipeline = *pipeline;
+
+  return 1;
+}
+
+// Deinitializes the objects enqueued against values up to and including completedValue.
+// For frame numbers, that is the last frame whose fence has been waited on; for a timeline semaphore, its counter value.
+void atlrFlushDeletionQueue(AtlrDeletionQueue* restrict queue, const AtlrU64 completedValue)
+{
+  const AtlrDevice* device = queue->device;
+
+  AtlrU32 keptCount = 0;
+  for (AtlrU32 i = 0; i < queue->count; i++)
+  {
+    AtlrDeletion* deletion = queue->deletions + i;
+    if (deletion->value > completedValue)
+    {
+      queue->deletions[keptCount++] = *deletion;
+      continue;
+    }
+
+    switch (deletion->type)
+    {
+      case ATLR_DELETION_TYPE_BUFFER:
+	atlrDeinitBuffer(&deletion->object.buffer);
+	break;
+
+      case ATLR_DELETION_TYPE_IMAGE:
+	atlrDeinitImage(&deletion->object.image);
+	break;
+
+      case ATLR_DELETION_TYPE_IMAGE_VIEW:
+	atlrDeinitImageView(deletion->object.imageView, device);
+	break;
+
+      case ATLR_DELETION_TYPE_SAMPLER:
+	atlrReleaseSampler(device, deletion->object.sampler);
+	break;
+
+      case ATLR_DELETION_TYPE_PIPELINE:
+	atlrDeinitPipeline(&deletion->object.pipeline);
+	break;
+    }
+  }
+  queue->count = keptCount;
+}
@@ -0,0 +1,419 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+#define MAX_SETS_PER_POOL 4096
+#define CACHE_INITIAL_CAPACITY 64
+#define WRITE_BATCH_SIZE 16
+
+static AtlrU8 addPool(AtlrDescriptorAllocator* restrict allocator, const AtlrU32 setCount)
+{
+  const AtlrDevice* device = allocator->device;
+
+  if (allocator->poolCount == allocator->poolCapacity)
+  {
+    const AtlrU32 poolCapacity = 2 * allocator->poolCapacity;
+    VkDescriptorPool* pools = realloc(allocator->pools, poolCapacity * sizeof(VkDescriptorPool));
+    if (!pools)
+    {
+      ATLR_ERROR_MSG("realloc returned NULL.");
+      return 0;
+    }
+    allocator->poolCapacity = poolCapacity;
+    allocator->pools = pools;
+  }
+
+  VkDescriptorPoolSize* poolSizes = allocator->poolSizes;
+  for (AtlrU32 i = 0; i < allocator->poolSizeCount; i++)
+    poolSizes[i] = atlrInitDescriptorPoolSize(allocator->poolSizeRatios[i].type, allocator->poolSizeRatios[i].descriptorCount * setCount);
+
+  AtlrDescriptorPool pool;
+  if (!atlrInitDescriptorPool(&pool, setCount, allocator->poolSizeCount, poolSizes, device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorPool returned 0.");
+    return 0;
+  }
+
+  allocator->pools[allocator->poolCount++] = pool.pool;
+  allocator->poolSetCapacity += setCount;
+  allocator->setsPerPool = setCount;
+  
+  return 1;
+}
+
+static void destroyPools(AtlrDescriptorAllocator* restrict allocator)
+{
+  const AtlrDevice* device = allocator->device;
+  for (AtlrU32 i = 0; i < allocator->poolCount; i++)
+    vkDestroyDescriptorPool(device->logical, allocator->pools[i], device->instance->allocator);
+  allocator->poolCount = 0;
+  allocator->poolSetCapacity = 0;
+}
+
+static void clearCache(AtlrDescriptorAllocator* restrict allocator)
+{
+  allocator->cacheCount = 0;
+  allocator->cacheKeyCount = 0;
+  memset(allocator->cacheHashes, 0, allocator->cacheCapacity * sizeof(AtlrU64));
+}
+
+// the slot arrays of a cache with the given capacity, all freed when any allocation fails
+static AtlrU8 allocCacheSlots(const AtlrU32 capacity, AtlrU64** restrict hashes, VkDescriptorSet** restrict sets,
+			      AtlrU32** restrict keyOffsets, AtlrU32** restrict keyLengths)
+{
+  *hashes = calloc(capacity, sizeof(AtlrU64));
+  *sets = malloc(capacity * sizeof(VkDescriptorSet));
+  *keyOffsets = malloc(capacity * sizeof(AtlrU32));
+  *keyLengths = malloc(capacity * sizeof(AtlrU32));
+  if (!*hashes || !*sets || !*keyOffsets || !*keyLengths)
+  {
+    free(*keyLengths);
+    free(*keyOffsets);
+    free(*sets);
+    free(*hashes);
+    return 0;
+  }
+
+  return 1;
+}
+
+// the number of words in the key of a set with the given writes
+static AtlrU32 getDescriptorKeyLength(const AtlrU32 writeCount, const VkWriteDescriptorSet* restrict writes)
+{
+  AtlrU32 length = 1;
+  for (AtlrU32 i = 0; i < writeCount; i++)
+  {
+    const VkWriteDescriptorSet* write = writes + i;
+    length += 2;
+    if (write->pImageInfo) length += 3 * write->descriptorCount;
+    if (write->pBufferInfo) length += 3 * write->descriptorCount;
+    if (write->pTexelBufferView) length += write->descriptorCount;
+  }
+  return length;
+}
+
+// The key holds the layout and everything the writes put in the set, so sets with equal keys are interchangeable.
+static void writeDescriptorKey(AtlrU64* restrict key, const VkDescriptorSetLayout setLayout, const AtlrU32 writeCount, const VkWriteDescriptorSet* restrict writes)
+{
+  *key++ = (AtlrU64)setLayout;
+  for (AtlrU32 i = 0; i < writeCount; i++)
+  {
+    const VkWriteDescriptorSet* write = writes + i;
+    *key++ = ((AtlrU64)write->dstArrayElement << 32) | write->dstBinding;
+    *key++ = ((AtlrU64)write->descriptorType << 32) | write->descriptorCount;
+    for (AtlrU32 j = 0; j < write->descriptorCount; j++)
+    {
+      if (write->pImageInfo)
+      {
+	const VkDescriptorImageInfo* imageInfo = write->pImageInfo + j;
+	*key++ = (AtlrU64)imageInfo->sampler;
+	*key++ = (AtlrU64)imageInfo->imageView;
+	*key++ = imageInfo->imageLayout;
+      }
+      if (write->pBufferInfo)
+      {
+	const VkDescriptorBufferInfo* bufferInfo = write->pBufferInfo + j;
+	*key++ = (AtlrU64)bufferInfo->buffer;
+	*key++ = bufferInfo->offset;
+	*key++ = bufferInfo->range;
+      }
+      if (write->pTexelBufferView)
+	*key++ = (AtlrU64)write->pTexelBufferView[j];
+    }
+  }
+}
+
+// Open addressing with linear probing; a zero hash marks an empty slot.
+// A slot matches when its hash and stored key both equal the given ones, so a hash collision only costs a longer probe.
+static AtlrU32 findCacheSlot(const AtlrDescriptorAllocator* restrict allocator, const AtlrU64 hash, const AtlrU64* restrict key, const AtlrU32 keyLength)
+{
+  const AtlrU32 mask = allocator->cacheCapacity - 1;
+  AtlrU32 slot = hash & mask;
+  while (allocator->cacheHashes[slot])
+  {
+    if ((allocator->cacheHashes[slot] == hash) && (allocator->cacheKeyLengths[slot] == keyLength)
+	&& !memcmp(allocator->cacheKeys + allocator->cacheKeyOffsets[slot], key, keyLength * sizeof(AtlrU64)))
+      break;
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+// Room for a key of the given length at the end of the stored keys; the key is only kept once insertCache is called.
+static AtlrU64* reserveCacheKey(AtlrDescriptorAllocator* restrict allocator, const AtlrU32 keyLength)
+{
+  if (allocator->cacheKeyCount + keyLength > allocator->cacheKeyCapacity)
+  {
+    AtlrU32 keyCapacity = 2 * allocator->cacheKeyCapacity;
+    if (keyCapacity < allocator->cacheKeyCount + keyLength) keyCapacity = allocator->cacheKeyCount + keyLength;
+    AtlrU64* keys = realloc(allocator->cacheKeys, keyCapacity * sizeof(AtlrU64));
+    if (!keys)
+    {
+      ATLR_ERROR_MSG("realloc returned NULL.");
+      return NULL;
+    }
+    allocator->cacheKeyCapacity = keyCapacity;
+    allocator->cacheKeys = keys;
+  }
+
+  return allocator->cacheKeys + allocator->cacheKeyCount;
+}
+
+// The key must be the one last returned by reserveCacheKey.
+static AtlrU8 insertCache(AtlrDescriptorAllocator* restrict allocator, const AtlrU64 hash, const AtlrU32 keyLength, const VkDescriptorSet set)
+{
+  // keep the load factor under one half
+  if (2 * (allocator->cacheCount + 1) > allocator->cacheCapacity)
+  {
+    const AtlrU32 capacity = 2 * allocator->cacheCapacity;
+    AtlrU64* hashes;
+    VkDescriptorSet* sets;
+    AtlrU32* keyOffsets;
+    AtlrU32* keyLengths;
+    if (!allocCacheSlots(capacity, &hashes, &sets, &keyOffsets, &keyLengths))
+    {
+      ATLR_ERROR_MSG("allocCacheSlots returned 0.");
+      return 0;
+    }
+
+    // the stored keys are distinct, so each only needs an empty slot
+    const AtlrU32 mask = capacity - 1;
+    for (AtlrU32 i = 0; i < allocator->cacheCapacity; i++)
+      if (allocator->cacheHashes[i])
+      {
+	AtlrU32 slot = allocator->cacheHashes[i] & mask;
+	while (hashes[slot])
+	  slot = (slot + 1) & mask;
+	hashes[slot] = allocator->cacheHashes[i];
+	sets[slot] = allocator->cacheSets[i];
+	keyOffsets[slot] = allocator->cacheKeyOffsets[i];
+	keyLengths[slot] = allocator->cacheKeyLengths[i];
+      }
+    free(allocator->cacheKeyLengths);
+    free(allocator->cacheKeyOffsets);
+    free(allocator->cacheSets);
+    free(allocator->cacheHashes);
+    allocator->cacheCapacity = capacity;
+    allocator->cacheHashes = hashes;
+    allocator->cacheSets = sets;
+    allocator->cacheKeyOffsets = keyOffsets;
+    allocator->cacheKeyLengths = keyLengths;
+  }
+
+  const AtlrU64* key = allocator->cacheKeys + allocator->cacheKeyCount;
+  const AtlrU32 slot = findCacheSlot(allocator, hash, key, keyLength);
+  allocator->cacheHashes[slot] = hash;
+  allocator->cacheSets[slot] = set;
+  allocator->cacheKeyOffsets[slot] = allocator->cacheKeyCount;
+  allocator->cacheKeyLengths[slot] = keyLength;
+  allocator->cacheKeyCount += keyLength;
+  allocator->cacheCount++;
+
+  return 1;
+}
+
+// Each pool holds setsPerPool sets with poolSizeRatios[i].descriptorCount descriptors of each type per set.
+// When a pool runs out, a pool twice as large is chained on, up to MAX_SETS_PER_POOL sets.
+AtlrU8 atlrInitDescriptorAllocator(AtlrDescriptorAllocator* restrict allocator, const AtlrU32 initialSetCount,
+				   const AtlrU32 poolSizeCount, const VkDescriptorPoolSize* restrict poolSizeRatios,
+				   const AtlrDevice* restrict device)
+{
+  allocator->device = device;
+  allocator->poolSizeCount = poolSizeCount;
+  allocator->poolSizeRatios = malloc(2 * poolSizeCount * sizeof(VkDescriptorPoolSize));
+  if (!allocator->poolSizeRatios)
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    return 0;
+  }
+  memcpy(allocator->poolSizeRatios, poolSizeRatios, poolSizeCount * sizeof(VkDescriptorPoolSize));
+  allocator->poolSizes = allocator->poolSizeRatios + poolSizeCount;
+  allocator->setsPerPool = 0;
+  allocator->poolCount = 0;
+  allocator->poolCapacity = 4;
+  allocator->pools = malloc(allocator->poolCapacity * sizeof(VkDescriptorPool));
+  if (!allocator->pools)
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    free(allocator->poolSizeRatios);
+    return 0;
+  }
+  allocator->poolSetCapacity = 0;
+  allocator->allocatedSetCount = 0;
+  allocator->cacheCount = 0;
+  allocator->cacheCapacity = CACHE_INITIAL_CAPACITY;
+  if (!allocCacheSlots(CACHE_INITIAL_CAPACITY, &allocator->cacheHashes, &allocator->cacheSets, &allocator->cacheKeyOffsets, &allocator->cacheKeyLengths))
+  {
+    ATLR_ERROR_MSG("allocCacheSlots returned 0.");
+    free(allocator->pools);
+    free(allocator->poolSizeRatios);
+    return 0;
+  }
+  allocator->cacheKeyCount = 0;
+  allocator->cacheKeyCapacity = 0;
+  allocator->cacheKeys = NULL;
+
+  if (!addPool(allocator, initialSetCount ? initialSetCount : 1))
+  {
+    ATLR_ERROR_MSG("addPool returned 0.");
+    atlrDeinitDescriptorAllocator(allocator);
+    return 0;
+  }
+
+  return 1;
+}
+
+void atlrDeinitDescriptorAllocator(const AtlrDescriptorAllocator* restrict allocator)
+{
+  const AtlrDevice* device = allocator->device;
+  for (AtlrU32 i = 0; i < allocator->poolCount; i++)
+    vkDestroyDescriptorPool(device->logical, allocator->pools[i], device->instance->allocator);
+  free(allocator->cacheKeys);
+  free(allocator->cacheKeyLengths);
+  free(allocator->cacheKeyOffsets);
+  free(allocator->cacheSets);
+  free(allocator->cacheHashes);
+  free(allocator->pools);
+  free(allocator->poolSizeRatios);
+}
+
+AtlrU8 atlrDescriptorAllocatorAlloc(AtlrDescriptorAllocator* restrict allocator, const AtlrU32 setCount, const VkDescriptorSetLayout* restrict setLayouts,
+				    VkDescriptorSet* restrict sets)
+{
+  VkDescriptorSetAllocateInfo setInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+    .pNext = NULL,
+    .descriptorPool = allocator->pools[allocator->poolCount - 1],
+    .descriptorSetCount = setCount,
+    .pSetLayouts = setLayouts
+  };
+
+  const VkDevice logical = allocator->device->logical;
+  VkResult result = vkAllocateDescriptorSets(logical, &setInfo, sets);
+  if ((result == VK_ERROR_OUT_OF_POOL_MEMORY) || (result == VK_ERROR_FRAGMENTED_POOL))
+  {
+    AtlrU32 setsPerPool = 2 * allocator->setsPerPool;
+    if (setsPerPool > MAX_SETS_PER_POOL) setsPerPool = MAX_SETS_PER_POOL;
+    if (setsPerPool < setCount) setsPerPool = setCount;
+    if (!addPool(allocator, setsPerPool))
+    {
+      ATLR_ERROR_MSG("addPool returned 0.");
+      return 0;
+    }
+    
+    setInfo.descriptorPool = allocator->pools[allocator->poolCount - 1];
+    result = vkAllocateDescriptorSets(logical, &setInfo, sets);
+  }
+  if (result != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkAllocateDescriptorSets did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  allocator->allocatedSetCount += setCount;
+  return 1;
+}
+
+// Returns a set holding exactly the given writes, whose dstSet fields are ignored.
+// A set previously made from the same layout and resources is reused, so nothing is allocated or written.
+AtlrU8 atlrDescriptorAllocatorGetSet(AtlrDescriptorAllocator* restrict allocator, const VkDescriptorSetLayout setLayout,
+				     const AtlrU32 writeCount, const VkWriteDescriptorSet* restrict writes, VkDescriptorSet* restrict set)
+{
+  const AtlrU32 keyLength = getDescriptorKeyLength(writeCount, writes);
+  AtlrU64* key = reserveCacheKey(allocator, keyLength);
+  if (!key)
+  {
+    ATLR_ERROR_MSG("reserveCacheKey returned NULL.");
+    return 0;
+  }
+  writeDescriptorKey(key, setLayout, writeCount, writes);
+  AtlrU64 hash = atlrHash(key, keyLength * sizeof(AtlrU64), ATLR_HASH_SEED);
+  if (!hash) hash = 1;
+
+  const AtlrU32 slot = findCacheSlot(allocator, hash, key, keyLength);
+  if (allocator->cacheHashes[slot])
+  {
+    *set = allocator->cacheSets[slot];
+    return 1;
+  }
+
+  if (!atlrDescriptorAllocatorAlloc(allocator, 1, &setLayout, set))
+  {
+    ATLR_ERROR_MSG("atlrDescriptorAllocatorAlloc returned 0.");
+    return 0;
+  }
+
+  // sets are made every frame, so the retargeted writes go through a small array on the stack in batches rather than the heap
+  VkWriteDescriptorSet setWrites[WRITE_BATCH_SIZE];
+  for (AtlrU32 i = 0; i < writeCount; i += WRITE_BATCH_SIZE)
+  {
+    const AtlrU32 batchCount = (writeCount - i < WRITE_BATCH_SIZE) ? writeCount - i : WRITE_BATCH_SIZE;
+    for (AtlrU32 j = 0; j < batchCount; j++)
+    {
+      setWrites[j] = writes[i + j];
+      setWrites[j].dstSet = *set;
+    }
+    vkUpdateDescriptorSets(allocator->device->logical, batchCount, setWrites, 0, NULL);
+  }
+
+  if (!insertCache(allocator, hash, keyLength, *set))
+  {
+    ATLR_ERROR_MSG("insertCache returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// Frees every set at once; the sets must no longer be in use by the device.
+// A chain of pools is merged into one pool large enough for the sets used since the last reset, up to MAX_SETS_PER_POOL sets,
+// so an allocator kept per frame in flight settles on a single vkResetDescriptorPool call per frame.
+AtlrU8 atlrResetDescriptorAllocator(AtlrDescriptorAllocator* restrict allocator)
+{
+  clearCache(allocator);
+  
+  if (allocator->poolCount > 1)
+  {
+    AtlrU32 setCount = allocator->poolSetCapacity;
+    if (setCount < allocator->allocatedSetCount) setCount = allocator->allocatedSetCount;
+    if (setCount > MAX_SETS_PER_POOL) setCount = MAX_SETS_PER_POOL;
+    destroyPools(allocator);
+    allocator->allocatedSetCount = 0;
+    if (!addPool(allocator, setCount))
+    {
+      ATLR_ERROR_MSG("addPool returned 0.");
+      return 0;
+    }
+    return 1;
+  }
+
+  const AtlrDevice* device = allocator->device;
+  if (vkResetDescriptorPool(device->logical, allocator->pools[0], 0) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkResetDescriptorPool did not return VK_SUCCESS.");
+    return 0;
+  }
+  allocator->allocatedSetCount = 0;
+
+  return 1;
+}
@@ -0,0 +1,256 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+static AtlrU64 alignUp(const AtlrU64 value, const AtlrU64 alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static AtlrU64 getDescriptorSize(const AtlrDescriptorBuffer* restrict descriptorBuffer, const VkDescriptorType type)
+{
+  const VkPhysicalDeviceDescriptorBufferPropertiesEXT* properties = &descriptorBuffer->properties;
+  switch (type)
+  {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+      return properties->samplerDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+      return properties->combinedImageSamplerDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+      return properties->sampledImageDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+      return properties->storageImageDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+      return properties->uniformTexelBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+      return properties->storageTexelBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      return properties->uniformBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+      return properties->storageBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+      return properties->inputAttachmentDescriptorSize;
+    default:
+      return 0;
+  }
+}
+
+AtlrU8 atlrInitDescriptorBufferSetLayout(AtlrDescriptorSetLayout* restrict setLayout, const AtlrU32 bindingCount, const VkDescriptorSetLayoutBinding* restrict bindings,
+					 const AtlrDevice* restrict device)
+{
+  setLayout->device = device;
+  
+  if (!device->features.descriptorBuffer)
+  {
+    ATLR_ERROR_MSG("Descriptor buffers are not enabled on the device.");
+    return 0;
+  }
+  
+  const VkDescriptorSetLayoutCreateInfo setLayoutInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .pNext = NULL,
+    .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT,
+    .bindingCount = bindingCount,
+    .pBindings = bindings
+  };
+
+  if(vkCreateDescriptorSetLayout(device->logical, &setLayoutInfo, device->instance->allocator, &setLayout->layout) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateDescriptorSetLayout did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// The buffer holds resource descriptors, and also sampler and combined image sampler descriptors when hasSamplers is set.
+// It stays mapped for its lifetime; descriptors are written straight into it and sets are carved out of it as a ring.
+AtlrU8 atlrInitDescriptorBuffer(AtlrDescriptorBuffer* restrict descriptorBuffer, const AtlrU64 size, const AtlrU8 hasSamplers, const AtlrDevice* restrict device)
+{
+  descriptorBuffer->device = device;
+  
+  if (!device->features.descriptorBuffer)
+  {
+    ATLR_ERROR_MSG("Descriptor buffers are not enabled on the device.");
+    return 0;
+  }
+
+  descriptorBuffer->properties = (VkPhysicalDeviceDescriptorBufferPropertiesEXT)
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT,
+    .pNext = NULL
+  };
+  VkPhysicalDeviceProperties2 properties2 =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+    .pNext = &descriptorBuffer->properties
+  };
+  vkGetPhysicalDeviceProperties2(device->physical, &properties2);
+  descriptorBuffer->properties.pNext = NULL;
+
+  descriptorBuffer->usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+  if (hasSamplers) descriptorBuffer->usage |= VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+  // a buffer holding both kinds of descriptors must fit in both address spaces
+  const VkDeviceSize resourceRange = descriptorBuffer->properties.resourceDescriptorBufferAddressSpaceSize;
+  const VkDeviceSize samplerRange = descriptorBuffer->properties.samplerDescriptorBufferAddressSpaceSize;
+  const AtlrU64 maxRange = (hasSamplers && (samplerRange < resourceRange)) ? samplerRange : resourceRange;
+  descriptorBuffer->size = (size < maxRange) ? size : maxRange;
+  descriptorBuffer->head = 0;
+  
+  if (!atlrInitBuffer(&descriptorBuffer->buffer, descriptorBuffer->size, descriptorBuffer->usage,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, device))
+  {
+    ATLR_ERROR_MSG("atlrInitBuffer returned 0.");
+    return 0;
+  }
+  if (!atlrMapBuffer(&descriptorBuffer->buffer, 0, descriptorBuffer->size, 0))
+  {
+    ATLR_ERROR_MSG("atlrMapBuffer returned 0.");
+    atlrDeinitBuffer(&descriptorBuffer->buffer);
+    return 0;
+  }
+  descriptorBuffer->address = atlrGetBufferDeviceAddress(&descriptorBuffer->buffer);
+
+  return 1;
+}
+
+void atlrDeinitDescriptorBuffer(AtlrDescriptorBuffer* restrict descriptorBuffer)
+{
+  atlrUnmapBuffer(&descriptorBuffer->buffer);
+  atlrDeinitBuffer(&descriptorBuffer->buffer);
+}
+
+// Carves the space for one set of the layout out of the ring, wrapping to the start when the end is reached.
+// The caller is responsible for the wrapped-over sets no longer being in use by the device, e.g. by sizing the ring for the sets of all frames in flight.
+AtlrU8 atlrDescriptorBufferAllocSet(AtlrDescriptorBuffer* restrict descriptorBuffer, const AtlrDescriptorSetLayout* restrict setLayout, AtlrU64* restrict offset)
+{
+  const AtlrDevice* device = descriptorBuffer->device;
+  
+  VkDeviceSize setSize;
+  device->pfnGetDescriptorSetLayoutSize(device->logical, setLayout->layout, &setSize);
+  setSize = alignUp(setSize, descriptorBuffer->properties.descriptorBufferOffsetAlignment);
+  if (setSize > descriptorBuffer->size)
+  {
+    ATLR_ERROR_MSG("The descriptor set does not fit in the descriptor buffer.");
+    return 0;
+  }
+
+  if (descriptorBuffer->head + setSize > descriptorBuffer->size) descriptorBuffer->head = 0;
+  *offset = descriptorBuffer->head;
+  descriptorBuffer->head += setSize;
+
+  return 1;
+}
+
+void atlrResetDescriptorBuffer(AtlrDescriptorBuffer* restrict descriptorBuffer)
+{
+  descriptorBuffer->head = 0;
+}
+
+static void writeDescriptor(const AtlrDescriptorBuffer* restrict descriptorBuffer, const AtlrU64 setOffset, const AtlrDescriptorSetLayout* restrict setLayout,
+			    const AtlrU32 binding, const AtlrU32 arrayElement, const VkDescriptorGetInfoEXT* restrict getInfo)
+{
+  const AtlrDevice* device = descriptorBuffer->device;
+  
+  VkDeviceSize bindingOffset;
+  device->pfnGetDescriptorSetLayoutBindingOffset(device->logical, setLayout->layout, binding, &bindingOffset);
+  const AtlrU64 descriptorSize = getDescriptorSize(descriptorBuffer, getInfo->type);
+  AtlrU8* descriptor = (AtlrU8*)descriptorBuffer->buffer.data + setOffset + bindingOffset + arrayElement * descriptorSize;
+  device->pfnGetDescriptor(device->logical, getInfo, descriptorSize, descriptor);
+}
+
+// type is either the uniform or storage buffer type, and range must be given explicitly since VK_WHOLE_SIZE is not allowed here
+void atlrDescriptorBufferWriteBuffer(const AtlrDescriptorBuffer* restrict descriptorBuffer, const AtlrU64 setOffset, const AtlrDescriptorSetLayout* restrict setLayout,
+				     const AtlrU32 binding, const AtlrU32 arrayElement, const VkDescriptorType type,
+				     const VkDeviceAddress address, const AtlrU64 range)
+{
+  const VkDescriptorAddressInfoEXT addressInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT,
+    .pNext = NULL,
+    .address = address,
+    .range = range,
+    .format = VK_FORMAT_UNDEFINED
+  };
+  VkDescriptorGetInfoEXT getInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+    .pNext = NULL,
+    .type = type
+  };
+  if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) getInfo.data.pUniformBuffer = &addressInfo;
+  else getInfo.data.pStorageBuffer = &addressInfo;
+  
+  writeDescriptor(descriptorBuffer, setOffset, setLayout, binding, arrayElement, &getInfo);
+}
+
+// type is one of the image types, or a combined image sampler, and the buffer must then have been created with samplers
+void atlrDescriptorBufferWriteImage(const AtlrDescriptorBuffer* restrict descriptorBuffer, const AtlrU64 setOffset, const AtlrDescriptorSetLayout* restrict setLayout,
+				    const AtlrU32 binding, const AtlrU32 arrayElement, const VkDescriptorType type,
+				    const VkDescriptorImageInfo* restrict imageInfo)
+{
+  VkDescriptorGetInfoEXT getInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+    .pNext = NULL,
+    .type = type
+  };
+  switch (type)
+  {
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+      getInfo.data.pCombinedImageSampler = imageInfo;
+      break;
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+      getInfo.data.pStorageImage = imageInfo;
+      break;
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+      getInfo.data.pInputAttachmentImage = imageInfo;
+      break;
+    default:
+      getInfo.data.pSampledImage = imageInfo;
+      break;
+  }
+  
+  writeDescriptor(descriptorBuffer, setOffset, setLayout, binding, arrayElement, &getInfo);
+}
+
+// binds the descriptor buffer as buffer index 0, sets are then selected with atlrCommandSetDescriptorBufferOffset
+void atlrCommandBindDescriptorBuffer(const VkCommandBuffer commandBuffer, const AtlrDescriptorBuffer* restrict descriptorBuffer)
+{
+  const VkDescriptorBufferBindingInfoEXT bindingInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+    .pNext = NULL,
+    .address = descriptorBuffer->address,
+    .usage = descriptorBuffer->usage
+  };
+  descriptorBuffer->device->pfnCmdBindDescriptorBuffers(commandBuffer, 1, &bindingInfo);
+}
+
+void atlrCommandSetDescriptorBufferOffset(const VkCommandBuffer commandBuffer, const VkPipelineBindPoint bindPoint, const VkPipelineLayout layout,
+					  const AtlrU32 set, const AtlrU64 setOffset, const AtlrDevice* restrict device)
+{
+  const AtlrU32 bufferIndex = 0;
+  const VkDeviceSize offset = setOffset;
+  device->pfnCmdSetDescriptorBufferOffsets(commandBuffer, bindPoint, layout, set, 1, &bufferIndex, &offset);
+}
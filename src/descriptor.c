@@ -173,3 +173,113 @@ VkWriteDescriptorSet atlrWriteImageDescriptorSet(const VkDescriptorSet set, cons
     .pTexelBufferView = NULL
   };
 }
+
+// the layout of sets written with atlrCommandPushDescriptorSet instead of being allocated from a pool
+AtlrU8 atlrInitPushDescriptorSetLayout(AtlrDescriptorSetLayout* restrict setLayout, const AtlrU32 bindingCount, const VkDescriptorSetLayoutBinding* restrict bindings,
+				       const AtlrDevice* restrict device)
+{
+  setLayout->device = device;
+  
+  if (!device->features.pushDescriptor)
+  {
+    ATLR_ERROR_MSG("Push descriptors are not enabled on the device.");
+    return 0;
+  }
+  
+  const VkDescriptorSetLayoutCreateInfo setLayoutInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .pNext = NULL,
+    .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR,
+    .bindingCount = bindingCount,
+    .pBindings = bindings
+  };
+
+  if(vkCreateDescriptorSetLayout(device->logical, &setLayoutInfo, device->instance->allocator, &setLayout->layout) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateDescriptorSetLayout did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// the dstSet fields of the writes are ignored
+void atlrCommandPushDescriptorSet(const VkCommandBuffer commandBuffer, const VkPipelineBindPoint bindPoint, const VkPipelineLayout layout, const AtlrU32 set,
+				  const AtlrU32 writeCount, const VkWriteDescriptorSet* restrict writes, const AtlrDevice* restrict device)
+{
+  device->pfnCmdPushDescriptorSet(commandBuffer, bindPoint, layout, set, writeCount, writes);
+}
+
+// Describes where the descriptors for a binding sit in a packed struct; use offsetof for the offset.
+// The stride separates the array elements of the binding.
+VkDescriptorUpdateTemplateEntry atlrInitDescriptorUpdateTemplateEntry(const AtlrU32 binding, const VkDescriptorType type, const AtlrU32 descriptorCount,
+								      const size_t offset, const size_t stride)
+{
+  return (VkDescriptorUpdateTemplateEntry)
+  {
+    .dstBinding = binding,
+    .dstArrayElement = 0,
+    .descriptorCount = descriptorCount,
+    .descriptorType = type,
+    .offset = offset,
+    .stride = stride
+  };
+}
+
+// The struct fields are VkDescriptorBufferInfo, VkDescriptorImageInfo or VkBufferView according to the descriptor types.
+// Templates for descriptor sets take a NULL pipeline layout; templates for push descriptors need the pipeline layout and set number they are pushed to.
+AtlrU8 atlrInitDescriptorUpdateTemplate(AtlrDescriptorUpdateTemplate* restrict updateTemplate,
+					const AtlrU32 entryCount, const VkDescriptorUpdateTemplateEntry* restrict entries,
+					const AtlrDescriptorSetLayout* restrict setLayout,
+					const VkPipelineBindPoint bindPoint, const VkPipelineLayout pipelineLayout, const AtlrU32 set,
+					const AtlrDevice* restrict device)
+{
+  updateTemplate->device = device;
+  updateTemplate->isPush = (pipelineLayout != VK_NULL_HANDLE);
+  
+  if (updateTemplate->isPush && !device->features.pushDescriptor)
+  {
+    ATLR_ERROR_MSG("Push descriptors are not enabled on the device.");
+    return 0;
+  }
+
+  const VkDescriptorUpdateTemplateCreateInfo templateInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .descriptorUpdateEntryCount = entryCount,
+    .pDescriptorUpdateEntries = entries,
+    .templateType = updateTemplate->isPush ? VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR : VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+    .descriptorSetLayout = setLayout->layout,
+    .pipelineBindPoint = bindPoint,
+    .pipelineLayout = pipelineLayout,
+    .set = set
+  };
+  if (vkCreateDescriptorUpdateTemplate(device->logical, &templateInfo, device->instance->allocator, &updateTemplate->updateTemplate) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateDescriptorUpdateTemplate did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  return 1;
+}
+
+void atlrDeinitDescriptorUpdateTemplate(const AtlrDescriptorUpdateTemplate* restrict updateTemplate)
+{
+  const AtlrDevice* device = updateTemplate->device;
+  vkDestroyDescriptorUpdateTemplate(device->logical, updateTemplate->updateTemplate, device->instance->allocator);
+}
+
+// writes every descriptor of the set from the packed struct in one call
+void atlrUpdateDescriptorSetWithTemplate(const AtlrDescriptorUpdateTemplate* restrict updateTemplate, const VkDescriptorSet set, const void* restrict data)
+{
+  vkUpdateDescriptorSetWithTemplate(updateTemplate->device->logical, set, updateTemplate->updateTemplate, data);
+}
+
+void atlrCommandPushDescriptorSetWithTemplate(const VkCommandBuffer commandBuffer, const AtlrDescriptorUpdateTemplate* restrict updateTemplate,
+					      const VkPipelineLayout layout, const AtlrU32 set, const void* restrict data)
+{
+  updateTemplate->device->pfnCmdPushDescriptorSetWithTemplate(commandBuffer, updateTemplate->updateTemplate, layout, set, data);
+}
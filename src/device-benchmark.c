@@ -0,0 +1,675 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+#include "offscreen-canvas.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#if defined(ATLR_BUILD_HOST_HEADLESS) || defined(ATLR_BUILD_HOST_GLFW)
+
+// every benchmark doubles its repetitions until one submission runs this long, or the repetitions reach the cap
+#define TARGET_NANOSECONDS 2000000
+#define MAX_REPEAT_COUNT 1024
+
+#define COPY_SIZE (32 * 1024 * 1024)
+// a million invocations keep every shader core of a large discrete GPU busy
+#define COMPUTE_GROUP_SIZE 64
+#define COMPUTE_GROUP_COUNT 16384
+#define COMPUTE_FLOPS_PER_INVOCATION (1024 * 16)
+#define FILL_EXTENT 1024
+
+#define CACHE_FILE_NAME "antler-device-benchmarks.bin"
+
+#define CACHE_RECORD_MAGIC 0x31424441 // "ADB1"
+
+// A short lived logical device on one candidate; the library's own helpers record and submit the benchmarks on it.
+typedef struct _BenchmarkProbe
+{
+  AtlrDevice device;
+  AtlrSingleRecordCommandContext commandContext;
+  VkQueryPool queryPool; // VK_NULL_HANDLE when the queue cannot write timestamps, in which case the host times the submissions
+  AtlrU64 timestampMask;
+  float timestampPeriod;
+  AtlrU32 computeGroupCount;
+
+} BenchmarkProbe;
+
+typedef void (*RecordBenchmark)(const VkCommandBuffer, const AtlrU32 repeatCount, const void* data);
+
+// A measured device is looked up by its UUID and driver version, so a driver update measures the device again.
+typedef struct _BenchmarkCacheRecord
+{
+  AtlrU32 magic;
+  AtlrU32 driverVersion;
+  AtlrU8 deviceUUID[VK_UUID_SIZE];
+  AtlrDeviceBenchmark benchmark;
+
+} BenchmarkCacheRecord;
+
+static const char* computeShaderSource =
+  "#version 450\n"
+  "layout(local_size_x = 64) in;\n"
+  "layout(std430, binding = 0) writeonly buffer Results { vec4 results[]; };\n"
+  "layout(push_constant) uniform Push { float seed; };\n"
+  "void main()\n"
+  "{\n"
+  "  vec4 a = vec4(gl_GlobalInvocationID.x) * seed;\n"
+  "  vec4 b = vec4(seed, 0.5 * seed, 0.25 * seed, 0.125 * seed);\n"
+  "  for (int i = 0; i < 1024; i++)\n"
+  "  {\n"
+  "    a = fma(a, b, b);\n"
+  "    b = fma(b, a, a);\n"
+  "  }\n"
+  "  results[gl_GlobalInvocationID.x] = a + b;\n"
+  "}\n";
+
+// one triangle covering the whole viewport
+static const char* fillVertexShaderSource =
+  "#version 450\n"
+  "void main()\n"
+  "{\n"
+  "  const vec2 positions[3] = vec2[](vec2(-1.0, -1.0), vec2(3.0, -1.0), vec2(-1.0, 3.0));\n"
+  "  gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);\n"
+  "}\n";
+
+static const char* fillFragmentShaderSource =
+  "#version 450\n"
+  "layout(location = 0) out vec4 outColor;\n"
+  "void main()\n"
+  "{\n"
+  "  outColor = vec4(0.5, 0.25, 0.125, 0.5);\n"
+  "}\n";
+
+static VkShaderModule initGlslShaderModule(const glslang_stage_t stage, const char* restrict glsl, const char* restrict name, const AtlrDevice* restrict device)
+{
+  AtlrSpirVBinary bin;
+  if (!atlrInitSpirVBinary(&bin, stage, glsl, name))
+  {
+    ATLR_ERROR_MSG("atlrInitSpirVBinary returned 0.");
+    return VK_NULL_HANDLE;
+  }
+
+  const VkShaderModuleCreateInfo moduleInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .codeSize = bin.codeSize,
+    .pCode = bin.code
+  };
+  VkShaderModule module;
+  const VkResult result = vkCreateShaderModule(device->logical, &moduleInfo, device->instance->allocator, &module);
+  atlrDeinitSpirVBinary(&bin);
+  if (result != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateShaderModule did not return VK_SUCCESS.");
+    return VK_NULL_HANDLE;
+  }
+
+  return module;
+}
+
+static void deinitBenchmarkProbe(BenchmarkProbe* restrict probe)
+{
+  AtlrDevice* device = &probe->device;
+  if (probe->queryPool != VK_NULL_HANDLE)
+    vkDestroyQueryPool(device->logical, probe->queryPool, device->instance->allocator);
+  atlrDeinitSingleRecordCommandContext(&probe->commandContext);
+  vkDestroyDevice(device->logical, device->instance->allocator);
+}
+
+// The probe has one queue from a family with both graphics and compute, and no optional features or extensions.
+static AtlrU8 initBenchmarkProbe(BenchmarkProbe* restrict probe, const VkPhysicalDevice physical, const AtlrInstance* restrict instance)
+{
+  {
+    BenchmarkProbe temp = {};
+    *probe = temp;
+  }
+  AtlrDevice* device = &probe->device;
+  device->instance = instance;
+  device->physical = physical;
+  device->msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  AtlrU32 timestampValidBits = 0;
+  {
+    AtlrU32 count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical, &count, NULL);
+    VkQueueFamilyProperties* properties = malloc(count * sizeof(VkQueueFamilyProperties));
+    if (!properties)
+    {
+      ATLR_ERROR_MSG("malloc returned NULL.");
+      return 0;
+    }
+    vkGetPhysicalDeviceQueueFamilyProperties(physical, &count, properties);
+    for (AtlrU32 i = 0; i < count; i++)
+    {
+      const VkQueueFlags queueFlags = properties[i].queueFlags;
+      if ((queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFlags & VK_QUEUE_COMPUTE_BIT))
+      {
+	device->queueFamilyIndices.isGraphicsCompute = 1;
+	device->queueFamilyIndices.graphicsComputeIndex = i;
+	timestampValidBits = properties[i].timestampValidBits;
+	break;
+      }
+    }
+    free(properties);
+  }
+  if (!device->queueFamilyIndices.isGraphicsCompute)
+  {
+    ATLR_ERROR_MSG("The physical device has no queue family supporting both graphics and compute.");
+    return 0;
+  }
+  const AtlrU32 queueFamilyIndex = device->queueFamilyIndices.graphicsComputeIndex;
+
+  const float priority = 1.0f;
+  const VkDeviceQueueCreateInfo queueInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .queueFamilyIndex = queueFamilyIndex,
+    .queueCount = 1,
+    .pQueuePriorities = &priority
+  };
+  const VkDeviceCreateInfo deviceInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .queueCreateInfoCount = 1,
+    .pQueueCreateInfos = &queueInfo,
+    .enabledExtensionCount = 0,
+    .ppEnabledExtensionNames = NULL,
+    .pEnabledFeatures = NULL
+  };
+  if (vkCreateDevice(physical, &deviceInfo, instance->allocator, &device->logical) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateDevice did not return VK_SUCCESS.");
+    return 0;
+  }
+  vkGetDeviceQueue(device->logical, queueFamilyIndex, 0, &device->graphicsComputeQueue);
+  atlrLoadDeviceCommands(device);
+
+  if (!atlrInitSingleRecordCommandContext(&probe->commandContext, queueFamilyIndex, device))
+  {
+    ATLR_ERROR_MSG("atlrInitSingleRecordCommandContext returned 0.");
+    vkDestroyDevice(device->logical, instance->allocator);
+    return 0;
+  }
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physical, &properties);
+  probe->queryPool = VK_NULL_HANDLE;
+  if (properties.limits.timestampComputeAndGraphics && timestampValidBits)
+  {
+    const VkQueryPoolCreateInfo queryPoolInfo =
+    {
+      .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .pNext = NULL,
+      .flags = 0,
+      .queryType = VK_QUERY_TYPE_TIMESTAMP,
+      .queryCount = 2,
+      .pipelineStatistics = 0
+    };
+    if (vkCreateQueryPool(device->logical, &queryPoolInfo, instance->allocator, &probe->queryPool) != VK_SUCCESS)
+      probe->queryPool = VK_NULL_HANDLE;
+    // only the low valid bits of a timestamp are written, and the counter wraps around within them
+    probe->timestampMask = (timestampValidBits >= 64) ? ~0ULL : ((1ULL << timestampValidBits) - 1);
+    probe->timestampPeriod = properties.limits.timestampPeriod;
+  }
+  probe->computeGroupCount = (properties.limits.maxComputeWorkGroupCount[0] < COMPUTE_GROUP_COUNT) ?
+    properties.limits.maxComputeWorkGroupCount[0] : COMPUTE_GROUP_COUNT;
+
+  return 1;
+}
+
+// the device time of one submission of repeatCount repetitions
+static AtlrU8 timeSubmission(AtlrU64* restrict nanoseconds, const BenchmarkProbe* restrict probe, const RecordBenchmark record, const void* data,
+			     const AtlrU32 repeatCount)
+{
+  VkCommandBuffer commandBuffer;
+  if (!atlrBeginSingleRecordCommands(&commandBuffer, &probe->commandContext))
+  {
+    ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+    return 0;
+  }
+  if (probe->queryPool != VK_NULL_HANDLE)
+  {
+    probe->device.pfnCmdResetQueryPool(commandBuffer, probe->queryPool, 0, 2);
+    probe->device.pfnCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, probe->queryPool, 0);
+  }
+  record(commandBuffer, repeatCount, data);
+  if (probe->queryPool != VK_NULL_HANDLE)
+    probe->device.pfnCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, probe->queryPool, 1);
+
+  const AtlrU64 start = atlrGetTimeNanoseconds();
+  if (!atlrEndSingleRecordCommands(commandBuffer, &probe->commandContext))
+  {
+    ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+    return 0;
+  }
+  *nanoseconds = atlrGetTimeNanoseconds() - start;
+  if (probe->queryPool == VK_NULL_HANDLE)
+    return 1;
+
+  AtlrU64 timestamps[2];
+  if (vkGetQueryPoolResults(probe->device.logical, probe->queryPool, 0, 2, sizeof(timestamps), timestamps, sizeof(AtlrU64),
+			    VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkGetQueryPoolResults did not return VK_SUCCESS.");
+    return 0;
+  }
+  *nanoseconds = (AtlrU64)(((timestamps[1] - timestamps[0]) & probe->timestampMask) * probe->timestampPeriod);
+  return 1;
+}
+
+// The repetitions double until a submission is long enough to time reliably, so fast and slow devices are both measured in a few submissions.
+// The short submissions at the start double as warm up. The rate is the work per nanosecond of the last submission.
+static AtlrU8 measureRate(float* restrict rate, const BenchmarkProbe* restrict probe, const RecordBenchmark record, const void* data, const double workPerRepeat)
+{
+  for (AtlrU32 repeatCount = 1; repeatCount <= MAX_REPEAT_COUNT; repeatCount *= 2)
+  {
+    AtlrU64 nanoseconds;
+    if (!timeSubmission(&nanoseconds, probe, record, data, repeatCount))
+    {
+      ATLR_ERROR_MSG("timeSubmission returned 0.");
+      return 0;
+    }
+    if ((nanoseconds >= TARGET_NANOSECONDS) || (repeatCount == MAX_REPEAT_COUNT))
+    {
+      *rate = nanoseconds ? (float)(workPerRepeat * repeatCount / nanoseconds) : 0.0f;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// The results of the repetitions are never read, so they are not ordered against each other.
+static void recordCopies(const VkCommandBuffer commandBuffer, const AtlrU32 repeatCount, const void* data)
+{
+  const AtlrBuffer* buffers = data;
+  const VkBufferCopy region =
+  {
+    .srcOffset = 0,
+    .dstOffset = 0,
+    .size = COPY_SIZE
+  };
+  for (AtlrU32 i = 0; i < repeatCount; i++)
+    buffers->device->pfnCmdCopyBuffer(commandBuffer, buffers[0].buffer, buffers[1].buffer, 1, &region);
+}
+
+// device local copy bandwidth in bytes per nanosecond (GB/s); each copy reads and writes every byte
+static AtlrU8 measureCopyBandwidth(float* restrict bandwidth, const BenchmarkProbe* restrict probe)
+{
+  const AtlrDevice* device = &probe->device;
+  const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  AtlrBuffer buffers[2];
+  if (!atlrInitBuffer(buffers, COPY_SIZE, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, device))
+  {
+    ATLR_ERROR_MSG("atlrInitBuffer returned 0.");
+    return 0;
+  }
+  if (!atlrInitBuffer(buffers + 1, COPY_SIZE, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, device))
+  {
+    ATLR_ERROR_MSG("atlrInitBuffer returned 0.");
+    atlrDeinitBuffer(buffers);
+    return 0;
+  }
+
+  const AtlrU8 isMeasured = measureRate(bandwidth, probe, recordCopies, buffers, 2.0 * COPY_SIZE);
+  atlrDeinitBuffer(buffers + 1);
+  atlrDeinitBuffer(buffers);
+  if (!isMeasured)
+  {
+    ATLR_ERROR_MSG("measureRate returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+typedef struct _ComputeBenchmark
+{
+  AtlrPipeline pipeline;
+  VkDescriptorSet set;
+  AtlrU32 groupCount;
+
+} ComputeBenchmark;
+
+static void recordDispatches(const VkCommandBuffer commandBuffer, const AtlrU32 repeatCount, const void* data)
+{
+  const ComputeBenchmark* compute = data;
+  const AtlrPipeline* pipeline = &compute->pipeline;
+  const AtlrDevice* device = pipeline->device;
+  const float seed = 0.5f;
+  device->pfnCmdBindPipeline(commandBuffer, pipeline->bindPoint, pipeline->pipeline);
+  device->pfnCmdBindDescriptorSets(commandBuffer, pipeline->bindPoint, pipeline->layout, 0, 1, &compute->set, 0, NULL);
+  device->pfnCmdPushConstants(commandBuffer, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(seed), &seed);
+  for (AtlrU32 i = 0; i < repeatCount; i++)
+    device->pfnCmdDispatch(commandBuffer, compute->groupCount, 1, 1);
+}
+
+// compute throughput in floating point operations per nanosecond (GFLOP/s), counting a fused multiply-add as two
+static AtlrU8 measureComputeThroughput(float* restrict throughput, const BenchmarkProbe* restrict probe)
+{
+  const AtlrDevice* device = &probe->device;
+  ComputeBenchmark compute;
+  compute.groupCount = probe->computeGroupCount;
+  const AtlrU64 invocationCount = (AtlrU64)compute.groupCount * COMPUTE_GROUP_SIZE;
+
+  AtlrBuffer results;
+  if (!atlrInitBuffer(&results, invocationCount * 4 * sizeof(float), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, device))
+  {
+    ATLR_ERROR_MSG("atlrInitBuffer returned 0.");
+    return 0;
+  }
+
+  AtlrDescriptorSetLayout setLayout;
+  const VkDescriptorSetLayoutBinding binding = atlrInitDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+  if (!atlrInitDescriptorSetLayout(&setLayout, 1, &binding, device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorSetLayout returned 0.");
+    atlrDeinitBuffer(&results);
+    return 0;
+  }
+  AtlrDescriptorPool pool;
+  const VkDescriptorPoolSize poolSize = atlrInitDescriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+  if (!atlrInitDescriptorPool(&pool, 1, 1, &poolSize, device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorPool returned 0.");
+    atlrDeinitDescriptorSetLayout(&setLayout);
+    atlrDeinitBuffer(&results);
+    return 0;
+  }
+  if (!atlrAllocDescriptorSets(&pool, 1, &setLayout.layout, &compute.set))
+  {
+    ATLR_ERROR_MSG("atlrAllocDescriptorSets returned 0.");
+    atlrDeinitDescriptorPool(&pool);
+    atlrDeinitDescriptorSetLayout(&setLayout);
+    atlrDeinitBuffer(&results);
+    return 0;
+  }
+  const VkDescriptorBufferInfo bufferInfo = atlrInitDescriptorBufferInfo(&results, VK_WHOLE_SIZE);
+  const VkWriteDescriptorSet write = atlrWriteBufferDescriptorSet(compute.set, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bufferInfo);
+  vkUpdateDescriptorSets(device->logical, 1, &write, 0, NULL);
+
+  AtlrU8 isMeasured = 0;
+  const VkShaderModule module = initGlslShaderModule(GLSLANG_STAGE_COMPUTE, computeShaderSource, "device benchmark compute", device);
+  if (module)
+  {
+    const VkPipelineShaderStageCreateInfo stageInfo = atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_COMPUTE_BIT, module);
+    const VkPushConstantRange pushConstantRange =
+    {
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      .offset = 0,
+      .size = sizeof(float)
+    };
+    const VkPipelineLayoutCreateInfo pipelineLayoutInfo = atlrInitPipelineLayoutInfo(1, &setLayout.layout, 1, &pushConstantRange);
+    const AtlrU8 isPipelineInit = atlrInitComputePipeline(&compute.pipeline, &stageInfo, &pipelineLayoutInfo, device);
+    atlrDeinitShaderModule(module, device);
+    if (isPipelineInit)
+    {
+      isMeasured = measureRate(throughput, probe, recordDispatches, &compute, (double)invocationCount * COMPUTE_FLOPS_PER_INVOCATION);
+      atlrDeinitPipeline(&compute.pipeline);
+    }
+    else
+      ATLR_ERROR_MSG("atlrInitComputePipeline returned 0.");
+  }
+  else
+    ATLR_ERROR_MSG("initGlslShaderModule returned VK_NULL_HANDLE.");
+
+  atlrDeinitDescriptorPool(&pool);
+  atlrDeinitDescriptorSetLayout(&setLayout);
+  atlrDeinitBuffer(&results);
+  return isMeasured;
+}
+
+typedef struct _FillBenchmark
+{
+  AtlrOffscreenCanvas canvas;
+  AtlrPipeline pipeline;
+
+} FillBenchmark;
+
+// every instance of the triangle covers the whole canvas
+static void recordFills(const VkCommandBuffer commandBuffer, const AtlrU32 repeatCount, const void* data)
+{
+  const FillBenchmark* fill = data;
+  const AtlrPipeline* pipeline = &fill->pipeline;
+  const AtlrDevice* device = pipeline->device;
+  atlrOffscreenCanvasBeginRenderPass(&fill->canvas, commandBuffer);
+  device->pfnCmdBindPipeline(commandBuffer, pipeline->bindPoint, pipeline->pipeline);
+  device->pfnCmdDraw(commandBuffer, 3, repeatCount, 0, 0);
+  atlrOffscreenCanvasEndRenderPass(&fill->canvas, commandBuffer);
+}
+
+// alpha blended fill rate in pixels per nanosecond (Gpixel/s)
+static AtlrU8 measureFillRate(float* restrict fillRate, const BenchmarkProbe* restrict probe)
+{
+  const AtlrDevice* device = &probe->device;
+  FillBenchmark fill;
+
+  const VkExtent2D extent = {.width = FILL_EXTENT, .height = FILL_EXTENT};
+  if (!atlrInitOffscreenCanvas(&fill.canvas, &extent, VK_FORMAT_R8G8B8A8_UNORM, 1, NULL, device))
+  {
+    ATLR_ERROR_MSG("atlrInitOffscreenCanvas returned 0.");
+    return 0;
+  }
+
+  const VkShaderModule vertexModule = initGlslShaderModule(GLSLANG_STAGE_VERTEX, fillVertexShaderSource, "device benchmark fill vertex", device);
+  const VkShaderModule fragmentModule = initGlslShaderModule(GLSLANG_STAGE_FRAGMENT, fillFragmentShaderSource, "device benchmark fill fragment", device);
+  AtlrU8 isPipelineInit = 0;
+  if (vertexModule && fragmentModule)
+  {
+    const VkPipelineShaderStageCreateInfo stageInfos[2] =
+    {
+      atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_VERTEX_BIT, vertexModule),
+      atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, fragmentModule)
+    };
+    const VkPipelineVertexInputStateCreateInfo vertexInputInfo = atlrInitVertexInputStateInfo(0, NULL, 0, NULL);
+    const VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo = atlrInitPipelineInputAssemblyStateInfo();
+    const VkPipelineViewportStateCreateInfo viewportInfo = atlrInitPipelineViewportStateInfo();
+    VkPipelineRasterizationStateCreateInfo rasterizationInfo = atlrInitPipelineRasterizationStateInfo();
+    rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+    const VkPipelineMultisampleStateCreateInfo multisampleInfo = atlrInitPipelineMultisampleStateInfo(VK_SAMPLE_COUNT_1_BIT);
+    // every instance must reach the color attachment, so the depth test is off
+    VkPipelineDepthStencilStateCreateInfo depthStencilInfo = atlrInitPipelineDepthStencilStateInfo();
+    depthStencilInfo.depthTestEnable = VK_FALSE;
+    depthStencilInfo.depthWriteEnable = VK_FALSE;
+    const VkPipelineColorBlendAttachmentState colorBlendAttachment = atlrInitPipelineColorBlendAttachmentStateAlpha();
+    const VkPipelineColorBlendStateCreateInfo colorBlendInfo = atlrInitPipelineColorBlendStateInfo(&colorBlendAttachment);
+    const VkPipelineDynamicStateCreateInfo dynamicInfo = atlrInitPipelineDynamicStateInfo();
+    const VkPipelineLayoutCreateInfo pipelineLayoutInfo = atlrInitPipelineLayoutInfo(0, NULL, 0, NULL);
+    isPipelineInit = atlrInitGraphicsPipeline(&fill.pipeline, 2, stageInfos, &vertexInputInfo, &inputAssemblyInfo, NULL, &viewportInfo, &rasterizationInfo,
+					      &multisampleInfo, &depthStencilInfo, &colorBlendInfo, &dynamicInfo, &pipelineLayoutInfo, device, &fill.canvas.renderPass);
+    if (!isPipelineInit)
+      ATLR_ERROR_MSG("atlrInitGraphicsPipeline returned 0.");
+  }
+  else
+    ATLR_ERROR_MSG("initGlslShaderModule returned VK_NULL_HANDLE.");
+  if (vertexModule) atlrDeinitShaderModule(vertexModule, device);
+  if (fragmentModule) atlrDeinitShaderModule(fragmentModule, device);
+
+  AtlrU8 isMeasured = 0;
+  if (isPipelineInit)
+  {
+    isMeasured = measureRate(fillRate, probe, recordFills, &fill, (double)FILL_EXTENT * FILL_EXTENT);
+    atlrDeinitPipeline(&fill.pipeline);
+  }
+  atlrDeinitOffscreenCanvas(&fill.canvas, 1);
+  return isMeasured;
+}
+
+// The UUID identifies the device across runs; Vulkan 1.0 devices fall back to the pipeline cache UUID, which also changes with the driver.
+static void getBenchmarkCacheKey(BenchmarkCacheRecord* restrict record, const VkPhysicalDevice physical, const AtlrInstance* restrict instance)
+{
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physical, &properties);
+  record->magic = CACHE_RECORD_MAGIC;
+  record->driverVersion = properties.driverVersion;
+  memcpy(record->deviceUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+  // vkGetPhysicalDeviceProperties2 is core for Vulkan 1.1 instances, and the device must report 1.1 for its ID properties
+  if ((instance->apiVersion < VK_API_VERSION_1_1) || (properties.apiVersion < VK_API_VERSION_1_1)) return;
+
+  VkPhysicalDeviceIDProperties idProperties =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+    .pNext = NULL
+  };
+  VkPhysicalDeviceProperties2 properties2 =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+    .pNext = &idProperties
+  };
+  vkGetPhysicalDeviceProperties2(physical, &properties2);
+  memcpy(record->deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+}
+
+// The cache lives in $XDG_CACHE_HOME, or ~/.cache without it, unless the build names a path with ATLR_DEVICE_BENCHMARK_CACHE_PATH.
+// Returns 0 when there is nowhere to keep it, in which case devices are measured on every run.
+static AtlrU8 getBenchmarkCachePath(char* restrict path, const size_t size)
+{
+#ifdef ATLR_DEVICE_BENCHMARK_CACHE_PATH
+  return snprintf(path, size, "%s", ATLR_DEVICE_BENCHMARK_CACHE_PATH) < (int)size;
+#else
+  const char* cacheHome = getenv("XDG_CACHE_HOME");
+  if (cacheHome && *cacheHome)
+    return snprintf(path, size, "%s/" CACHE_FILE_NAME, cacheHome) < (int)size;
+  const char* home = getenv("HOME");
+  if (home && *home)
+    return snprintf(path, size, "%s/.cache/" CACHE_FILE_NAME, home) < (int)size;
+  return 0;
+#endif
+}
+
+// Creates every missing directory above the file, readable only by the user as the cache describes their hardware.
+static AtlrU8 makeParentDirectories(char* restrict path)
+{
+  for (char* separator = strchr(path + 1, '/'); separator; separator = strchr(separator + 1, '/'))
+  {
+    *separator = '\0';
+    const int result = mkdir(path, 0700);
+    *separator = '/';
+    if (result && (errno != EEXIST)) return 0;
+  }
+  return 1;
+}
+
+static AtlrU8 isSameDevice(const BenchmarkCacheRecord* restrict a, const BenchmarkCacheRecord* restrict b)
+{
+  return (a->driverVersion == b->driverVersion) && !memcmp(a->deviceUUID, b->deviceUUID, VK_UUID_SIZE);
+}
+
+// The cache is a flat run of records. isValid is cleared when the file holds something else, so that storing rewrites it.
+static AtlrU8 readCachedBenchmark(BenchmarkCacheRecord* restrict key, AtlrU8* restrict isValid, const char* restrict path)
+{
+  *isValid = 1;
+  FILE* file = fopen(path, "rb");
+  if (!file) return 0;
+
+  AtlrU8 isFound = 0;
+  BenchmarkCacheRecord record;
+  while (fread(&record, sizeof(record), 1, file) == 1)
+  {
+    if (record.magic != CACHE_RECORD_MAGIC)
+    {
+      *isValid = 0;
+      break;
+    }
+    if (isSameDevice(&record, key))
+    {
+      key->benchmark = record.benchmark;
+      isFound = 1;
+      break;
+    }
+  }
+  if (!isFound && !feof(file))
+    *isValid = 0;
+  fclose(file);
+
+  return isFound;
+}
+
+static void writeCachedBenchmark(const BenchmarkCacheRecord* restrict record, const AtlrU8 isValid, char* restrict path)
+{
+  if (!makeParentDirectories(path))
+  {
+    atlrLog(ATLR_LOG_WARN, "Failed to create the directory of the device benchmark cache at path \"%s\".", path);
+    return;
+  }
+  FILE* file = fopen(path, isValid ? "ab" : "wb");
+  if (!file || (fwrite(record, sizeof(*record), 1, file) != 1))
+    atlrLog(ATLR_LOG_WARN, "Failed to write the device benchmark cache at path \"%s\".", path);
+  if (file) fclose(file);
+}
+
+// Results are read from the cache when the device and driver were measured before.
+// Otherwise a probe device runs a copy, a compute and a fill benchmark, and the results are added to the cache.
+// The score is the geometric mean of the three rates, so a device twice as fast at everything scores twice as high whatever the units.
+AtlrU8 atlrMeasurePhysicalDevice(AtlrDeviceBenchmark* restrict benchmark, const VkPhysicalDevice physical, const AtlrInstance* restrict instance)
+{
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physical, &properties);
+
+  BenchmarkCacheRecord record;
+  getBenchmarkCacheKey(&record, physical, instance);
+  char cachePath[4096];
+  const AtlrU8 hasCachePath = getBenchmarkCachePath(cachePath, sizeof(cachePath));
+  AtlrU8 isCacheValid = 0;
+  if (hasCachePath && readCachedBenchmark(&record, &isCacheValid, cachePath))
+  {
+    *benchmark = record.benchmark;
+    atlrLog(ATLR_LOG_DEBUG, "Physical device \"%s\" benchmarks read from the cache, with a score of %f.", properties.deviceName, benchmark->score);
+    return 1;
+  }
+
+  atlrLog(ATLR_LOG_INFO, "Benchmarking physical device \"%s\" ...", properties.deviceName);
+  BenchmarkProbe probe;
+  if (!initBenchmarkProbe(&probe, physical, instance))
+  {
+    ATLR_ERROR_MSG("initBenchmarkProbe returned 0.");
+    return 0;
+  }
+  const AtlrU8 isMeasured = measureCopyBandwidth(&benchmark->copyBandwidth, &probe)
+    && measureComputeThroughput(&benchmark->computeThroughput, &probe)
+    && measureFillRate(&benchmark->fillRate, &probe);
+  deinitBenchmarkProbe(&probe);
+  if (!isMeasured)
+  {
+    ATLR_ERROR_MSG("Failed to benchmark physical device \"%s\".", properties.deviceName);
+    return 0;
+  }
+  benchmark->score = cbrtf(benchmark->copyBandwidth * benchmark->computeThroughput * benchmark->fillRate);
+  atlrLog(ATLR_LOG_INFO, "Physical device \"%s\": copy %f GB/s, compute %f GFLOP/s, fill %f Gpixel/s, score %f.",
+	  properties.deviceName, benchmark->copyBandwidth, benchmark->computeThroughput, benchmark->fillRate, benchmark->score);
+
+  record.benchmark = *benchmark;
+  if (hasCachePath)
+    writeCachedBenchmark(&record, isCacheValid, cachePath);
+  return 1;
+}
+
+#endif
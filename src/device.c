@@ -60,8 +60,14 @@ static void initQueueFamilyIndices(AtlrQueueFamilyIndices* restrict indices, con
   free(properties);
 }
 
+// The details are taken again on every swapchain reinit, so their arrays come from the scratch arena rather than the heap.
 AtlrU8 atlrInitSwapchainSupportDetails(AtlrSwapchainSupportDetails* restrict support, const AtlrInstance* restrict instance, const VkPhysicalDevice physical)
 {
+  support->scratch = instance->scratch;
+  support->scratchMark = atlrGetArenaMark(instance->scratch);
+  support->formats = NULL;
+  support->presentModes = NULL;
+
   if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical, instance->surface, &support->capabilities) != VK_SUCCESS)
   {
     ATLR_ERROR_MSG("vkGetPhysicalDeviceSurfaceCapabilitiesKHR did not return VK_SUCCESS.");
@@ -75,7 +81,12 @@ AtlrU8 atlrInitSwapchainSupportDetails(AtlrSwapchainSupportDetails* restrict sup
   }
   if (support->formatCount)
   {
-    support->formats = malloc(support->formatCount * sizeof(VkSurfaceFormatKHR));
+    support->formats = atlrArenaAlloc(support->scratch, support->formatCount * sizeof(VkSurfaceFormatKHR), ATLR_ARENA_ALIGNMENT);
+    if (!support->formats)
+    {
+      ATLR_ERROR_MSG("atlrArenaAlloc returned NULL.");
+      return 0;
+    }
     if (vkGetPhysicalDeviceSurfaceFormatsKHR(physical, instance->surface, &support->formatCount, support->formats) != VK_SUCCESS)
     {
       ATLR_ERROR_MSG("vkGetPhysicalDeviceSurfaceFormatsKHR (second call) did not return VK_SUCCESS.");
@@ -90,7 +101,12 @@ AtlrU8 atlrInitSwapchainSupportDetails(AtlrSwapchainSupportDetails* restrict sup
   }
   if (support->presentModeCount)
   {
-    support->presentModes = malloc(support->presentModeCount * sizeof(VkPresentModeKHR));
+    support->presentModes = atlrArenaAlloc(support->scratch, support->presentModeCount * sizeof(VkPresentModeKHR), ATLR_ARENA_ALIGNMENT);
+    if (!support->presentModes)
+    {
+      ATLR_ERROR_MSG("atlrArenaAlloc returned NULL.");
+      return 0;
+    }
     if (vkGetPhysicalDeviceSurfacePresentModesKHR(physical, instance->surface, &support->presentModeCount,support->presentModes) != VK_SUCCESS)
     {
       ATLR_ERROR_MSG("vkGetPhysicalDeviceSurfacePresentModesKHR (second call) did not return VK_SUCCESS.");
@@ -103,8 +119,8 @@ AtlrU8 atlrInitSwapchainSupportDetails(AtlrSwapchainSupportDetails* restrict sup
 
 void atlrDeinitSwapchainSupportDetails(AtlrSwapchainSupportDetails* restrict support)
 {
-  free(support->formats);
-  free(support->presentModes);
+  if (support->scratch)
+    atlrRewindArena(support->scratch, support->scratchMark);
 }
 
 #if defined(ATLR_BUILD_HOST_HEADLESS) || defined(ATLR_BUILD_HOST_GLFW)
@@ -126,25 +142,70 @@ static const char* deviceCriterionNames[ATLR_DEVICE_CRITERION_TOT] =
 
   "SWAPCHAIN SUPPORT",
 
-  "GEOMETRY SHADER"
+  "GEOMETRY SHADER",
+
+  "DYNAMIC RENDERING",
+  "EXTENDED DYNAMIC STATE",
+  "EXTENDED DYNAMIC STATE 3",
+
+  "GRAPHICS PIPELINE LIBRARY",
+
+  "SHADER OBJECT",
+
+  "DESCRIPTOR INDEXING",
+
+  "PUSH DESCRIPTOR",
+
+  "DESCRIPTOR BUFFER",
+
+  "TEXTURE COMPRESSION BC",
+  "TEXTURE COMPRESSION ETC2",
+
+  "MEMORY BUDGET",
+
+  "HOST IMAGE COPY",
+
+  "EXTERNAL MEMORY HOST",
+
+  "TIMELINE SEMAPHORE",
+
+  "BUFFER DEVICE ADDRESS",
+
+  "SYNCHRONIZATION 2",
+
+  "MAINTENANCE 4",
+
+  "DEVICE LOCAL HEAP AT LEAST 2 GIB",
+  "DEVICE LOCAL HEAP AT LEAST 4 GIB",
+  "DEVICE LOCAL HEAP AT LEAST 8 GIB",
+
+  "MEASURED PERFORMANCE"
 };
 
-static AtlrU8 arePhysicalDeviceExtensionsAvailable(const VkPhysicalDevice physical, const char** restrict extensions, AtlrU32 extensionCount)
+// the caller frees the returned array
+static VkExtensionProperties* getPhysicalDeviceExtensions(const VkPhysicalDevice physical, AtlrU32* restrict count)
 {
-  AtlrU32 availableExtensionCount = 0;
-  if (vkEnumerateDeviceExtensionProperties(physical, NULL, &availableExtensionCount, NULL) != VK_SUCCESS)
+  *count = 0;
+  if (vkEnumerateDeviceExtensionProperties(physical, NULL, count, NULL) != VK_SUCCESS)
   {
     ATLR_ERROR_MSG("vkEnumerateDeviceExtensionProperties (first call) did not return VK_SUCCESS.");
-    return 0;
+    return NULL;
   }
-  VkExtensionProperties* availableExtensions = malloc(availableExtensionCount * sizeof(VkExtensionProperties));
-  if (vkEnumerateDeviceExtensionProperties(physical, NULL, &availableExtensionCount, availableExtensions) != VK_SUCCESS)
+  VkExtensionProperties* availableExtensions = malloc(*count * sizeof(VkExtensionProperties));
+  if (vkEnumerateDeviceExtensionProperties(physical, NULL, count, availableExtensions) != VK_SUCCESS)
   {
     ATLR_ERROR_MSG("vkEnumerateDeviceExtensionProperties (second call) did not return VK_SUCCESS.");
     free(availableExtensions);
-    return 0;
+    *count = 0;
+    return NULL;
   }
-   
+
+  return availableExtensions;
+}
+
+static AtlrU8 areExtensionsListed(const char* const* restrict extensions, const AtlrU32 extensionCount,
+				  const VkExtensionProperties* restrict availableExtensions, const AtlrU32 availableExtensionCount)
+{
   AtlrU8 extensionsFound = 1;
   for (AtlrU32 i = 0; i < extensionCount; i++)
   {
@@ -163,10 +224,227 @@ static AtlrU8 arePhysicalDeviceExtensionsAvailable(const VkPhysicalDevice physic
       }
   }
 
+  return extensionsFound;
+}
+
+static AtlrU8 arePhysicalDeviceExtensionsAvailable(const VkPhysicalDevice physical, const char** restrict extensions, AtlrU32 extensionCount)
+{
+  AtlrU32 availableExtensionCount;
+  VkExtensionProperties* availableExtensions = getPhysicalDeviceExtensions(physical, &availableExtensionCount);
+  if (!availableExtensions) return 0;
+  const AtlrU8 extensionsFound = areExtensionsListed(extensions, extensionCount, availableExtensions, availableExtensionCount);
   free(availableExtensions);
   return extensionsFound;
 }
 
+// Every optional feature is negotiated through this table: its criterion, its flag in AtlrDeviceFeatures,
+// the lowest Vulkan version it is offered on, and the device extensions it needs, which are enabled along with it.
+typedef struct _DeviceFeatureInfo
+{
+  AtlrDeviceCriterionType criterion;
+  size_t offset;
+  AtlrU32 minApiVersion;
+  AtlrU32 extensionCount;
+  const char* extensions[2];
+
+} DeviceFeatureInfo;
+
+// Features past Vulkan 1.0 are queried through vkGetPhysicalDeviceFeatures2, which is core in Vulkan 1.1.
+// Push descriptors need VK_KHR_get_physical_device_properties2 on Vulkan 1.0, which the instance does not enable, so they are offered from Vulkan 1.1.
+// Host image copy is only offered on Vulkan 1.3, where the copy commands 2 and format feature flags 2 extensions it depends on are core.
+static const DeviceFeatureInfo deviceFeatureInfos[] =
+{
+  {ATLR_DEVICE_CRITERION_GEOMETRY_SHADER,           offsetof(AtlrDeviceFeatures, geometryShader),          VK_API_VERSION_1_0, 0, {NULL, NULL}},
+  {ATLR_DEVICE_CRITERION_DYNAMIC_RENDERING,         offsetof(AtlrDeviceFeatures, dynamicRendering),        VK_API_VERSION_1_3, 0, {NULL, NULL}},
+  {ATLR_DEVICE_CRITERION_EXTENDED_DYNAMIC_STATE,    offsetof(AtlrDeviceFeatures, extendedDynamicState),    VK_API_VERSION_1_3, 0, {NULL, NULL}},
+  {ATLR_DEVICE_CRITERION_EXTENDED_DYNAMIC_STATE_3,  offsetof(AtlrDeviceFeatures, extendedDynamicState3),   VK_API_VERSION_1_1, 1,
+   {VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME, NULL}},
+  {ATLR_DEVICE_CRITERION_GRAPHICS_PIPELINE_LIBRARY, offsetof(AtlrDeviceFeatures, graphicsPipelineLibrary), VK_API_VERSION_1_1, 2,
+   {VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME}},
+  {ATLR_DEVICE_CRITERION_SHADER_OBJECT,             offsetof(AtlrDeviceFeatures, shaderObject),            VK_API_VERSION_1_1, 1,
+   {VK_EXT_SHADER_OBJECT_EXTENSION_NAME, NULL}},
+  {ATLR_DEVICE_CRITERION_DESCRIPTOR_INDEXING,       offsetof(AtlrDeviceFeatures, descriptorIndexing),      VK_API_VERSION_1_2, 0, {NULL, NULL}},
+  {ATLR_DEVICE_CRITERION_PUSH_DESCRIPTOR,           offsetof(AtlrDeviceFeatures, pushDescriptor),          VK_API_VERSION_1_1, 1,
+   {VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, NULL}},
+  {ATLR_DEVICE_CRITERION_DESCRIPTOR_BUFFER,         offsetof(AtlrDeviceFeatures, descriptorBuffer),        VK_API_VERSION_1_2, 1,
+   {VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME, NULL}},
+  {ATLR_DEVICE_CRITERION_TEXTURE_COMPRESSION_BC,    offsetof(AtlrDeviceFeatures, textureCompressionBC),    VK_API_VERSION_1_0, 0, {NULL, NULL}},
+  {ATLR_DEVICE_CRITERION_TEXTURE_COMPRESSION_ETC2,  offsetof(AtlrDeviceFeatures, textureCompressionETC2),  VK_API_VERSION_1_0, 0, {NULL, NULL}},
+  {ATLR_DEVICE_CRITERION_MEMORY_BUDGET,             offsetof(AtlrDeviceFeatures, memoryBudget),            VK_API_VERSION_1_1, 1,
+   {VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, NULL}},
+  {ATLR_DEVICE_CRITERION_HOST_IMAGE_COPY,           offsetof(AtlrDeviceFeatures, hostImageCopy),           VK_API_VERSION_1_3, 1,
+   {VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME, NULL}},
+  {ATLR_DEVICE_CRITERION_EXTERNAL_MEMORY_HOST,      offsetof(AtlrDeviceFeatures, externalMemoryHost),      VK_API_VERSION_1_1, 1,
+   {VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME, NULL}},
+  {ATLR_DEVICE_CRITERION_TIMELINE_SEMAPHORE,        offsetof(AtlrDeviceFeatures, timelineSemaphore),       VK_API_VERSION_1_2, 0, {NULL, NULL}},
+  {ATLR_DEVICE_CRITERION_BUFFER_DEVICE_ADDRESS,     offsetof(AtlrDeviceFeatures, bufferDeviceAddress),     VK_API_VERSION_1_2, 0, {NULL, NULL}},
+  {ATLR_DEVICE_CRITERION_SYNCHRONIZATION_2,         offsetof(AtlrDeviceFeatures, synchronization2),        VK_API_VERSION_1_3, 0, {NULL, NULL}},
+  {ATLR_DEVICE_CRITERION_MAINTENANCE_4,             offsetof(AtlrDeviceFeatures, maintenance4),            VK_API_VERSION_1_3, 0, {NULL, NULL}}
+};
+#define DEVICE_FEATURE_INFO_COUNT (sizeof(deviceFeatureInfos) / sizeof(deviceFeatureInfos[0]))
+
+static AtlrU8* getFeatureFlag(AtlrDeviceFeatures* restrict features, const DeviceFeatureInfo* restrict info)
+{
+  return (AtlrU8*)features + info->offset;
+}
+
+// the feature structures past Vulkan 1.0; the same chain queries support and then enables features
+typedef struct _DeviceFeatureChain
+{
+  VkPhysicalDeviceFeatures2 features2;
+  VkPhysicalDeviceVulkan12Features vulkan12;
+  VkPhysicalDeviceVulkan13Features vulkan13;
+  VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3;
+  VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibrary;
+  VkPhysicalDeviceShaderObjectFeaturesEXT shaderObject;
+  VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBuffer;
+  VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopy;
+
+} DeviceFeatureChain;
+
+static void linkFeatureStructure(VkPhysicalDeviceFeatures2* restrict features2, void* structure)
+{
+  VkBaseOutStructure* base = structure;
+  base->pNext = features2->pNext;
+  features2->pNext = base;
+}
+
+// Every structure starts zeroed. The core structures are chained when the version has them,
+// and the extension structures are chained when their flag in links is set.
+// Structures left out of the chain stay zeroed, so reading a feature from them reads unsupported.
+static void initDeviceFeatureChain(DeviceFeatureChain* restrict chain, const AtlrDeviceFeatures* restrict links, const AtlrU32 apiVersion)
+{
+  {
+    DeviceFeatureChain temp = {};
+    *chain = temp;
+  }
+  chain->features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  chain->vulkan12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  chain->vulkan13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+  chain->extendedDynamicState3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+  chain->graphicsPipelineLibrary.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+  chain->shaderObject.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT;
+  chain->descriptorBuffer.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+  chain->hostImageCopy.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+
+  if (links->extendedDynamicState3)   linkFeatureStructure(&chain->features2, &chain->extendedDynamicState3);
+  if (links->graphicsPipelineLibrary) linkFeatureStructure(&chain->features2, &chain->graphicsPipelineLibrary);
+  if (links->shaderObject)            linkFeatureStructure(&chain->features2, &chain->shaderObject);
+  if (links->descriptorBuffer)        linkFeatureStructure(&chain->features2, &chain->descriptorBuffer);
+  if (links->hostImageCopy)           linkFeatureStructure(&chain->features2, &chain->hostImageCopy);
+  if (apiVersion >= VK_API_VERSION_1_2) linkFeatureStructure(&chain->features2, &chain->vulkan12);
+  if (apiVersion >= VK_API_VERSION_1_3) linkFeatureStructure(&chain->features2, &chain->vulkan13);
+}
+
+// Features are offered up to the lower of the instance and device versions, since querying them also goes through the instance.
+static AtlrU32 getFeatureApiVersion(const AtlrInstance* restrict instance, const AtlrU32 deviceApiVersion)
+{
+  return (instance->apiVersion < deviceApiVersion) ? instance->apiVersion : deviceApiVersion;
+}
+
+// query which optional features the physical device supports
+static void getSupportedDeviceFeatures(AtlrDeviceFeatures* restrict supported, const VkPhysicalDevice physical, const AtlrU32 apiVersion)
+{
+  // a feature is available when the version offers it and every extension it needs is present
+  // the extensions are enumerated once for every feature
+  AtlrDeviceFeatures available = {};
+  {
+    AtlrU32 availableExtensionCount;
+    VkExtensionProperties* availableExtensions = getPhysicalDeviceExtensions(physical, &availableExtensionCount);
+    for (AtlrU32 i = 0; i < DEVICE_FEATURE_INFO_COUNT; i++)
+    {
+      const DeviceFeatureInfo* info = deviceFeatureInfos + i;
+      *getFeatureFlag(&available, info) = (apiVersion >= info->minApiVersion)
+	&& areExtensionsListed(info->extensions, info->extensionCount, availableExtensions, availableExtensionCount);
+    }
+    free(availableExtensions);
+  }
+
+  {
+    AtlrDeviceFeatures temp = {};
+    *supported = temp;
+  }
+
+  VkPhysicalDeviceFeatures features;
+  vkGetPhysicalDeviceFeatures(physical, &features);
+  supported->geometryShader = features.geometryShader;
+  supported->textureCompressionBC = features.textureCompressionBC;
+  supported->textureCompressionETC2 = features.textureCompressionETC2;
+  // push descriptors, the memory budget and host memory import have no feature structures; the extensions are enough
+  supported->pushDescriptor = available.pushDescriptor;
+  supported->memoryBudget = available.memoryBudget;
+  supported->externalMemoryHost = available.externalMemoryHost;
+
+  if (apiVersion < VK_API_VERSION_1_1) return;
+
+  DeviceFeatureChain chain;
+  initDeviceFeatureChain(&chain, &available, apiVersion);
+  vkGetPhysicalDeviceFeatures2(physical, &chain.features2);
+
+  const VkPhysicalDeviceVulkan12Features* vulkan12 = &chain.vulkan12;
+  supported->descriptorIndexing = vulkan12->descriptorIndexing
+    && vulkan12->runtimeDescriptorArray
+    && vulkan12->shaderSampledImageArrayNonUniformIndexing
+    && vulkan12->shaderStorageBufferArrayNonUniformIndexing
+    && vulkan12->descriptorBindingPartiallyBound
+    && vulkan12->descriptorBindingUpdateUnusedWhilePending
+    && vulkan12->descriptorBindingSampledImageUpdateAfterBind
+    && vulkan12->descriptorBindingStorageBufferUpdateAfterBind;
+  supported->timelineSemaphore = vulkan12->timelineSemaphore;
+  supported->bufferDeviceAddress = vulkan12->bufferDeviceAddress;
+
+  supported->dynamicRendering = chain.vulkan13.dynamicRendering;
+  supported->extendedDynamicState = available.extendedDynamicState; // extended dynamic state 1 and 2 are mandatory in Vulkan 1.3
+  supported->synchronization2 = chain.vulkan13.synchronization2;
+  supported->maintenance4 = chain.vulkan13.maintenance4;
+
+  supported->extendedDynamicState3 = chain.extendedDynamicState3.extendedDynamicState3PolygonMode
+    && chain.extendedDynamicState3.extendedDynamicState3ColorBlendEnable
+    && chain.extendedDynamicState3.extendedDynamicState3ColorWriteMask;
+  supported->graphicsPipelineLibrary = chain.graphicsPipelineLibrary.graphicsPipelineLibrary;
+  supported->hostImageCopy = chain.hostImageCopy.hostImageCopy;
+  // descriptor buffers are bound by device address, hold descriptor indexing arrays and are synchronized with synchronization 2 barriers,
+  // and shader objects only render with dynamic rendering and set their state with extended dynamic state commands
+  supported->descriptorBuffer = chain.descriptorBuffer.descriptorBuffer
+    && supported->bufferDeviceAddress && supported->descriptorIndexing && supported->synchronization2;
+  supported->shaderObject = chain.shaderObject.shaderObject && supported->dynamicRendering && supported->extendedDynamicState;
+}
+
+// a supported feature is enabled unless its criterion forbids it or penalizes it with a negative point shift
+static AtlrU8 isFeatureEnabled(const AtlrDeviceCriterion* restrict criterion, const AtlrU8 isSupported)
+{
+  switch (criterion->method)
+  {
+    case ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT:
+      return (criterion->pointShift >= 0) && isSupported;
+    case ATLR_DEVICE_CRITERION_METHOD_REQUIRED:
+      return isSupported;
+    case ATLR_DEVICE_CRITERION_METHOD_FORBIDDEN:
+      return 0;
+  }
+
+  return 0;
+}
+
+// features that build on others are dropped along with them
+static void applyFeatureDependencies(AtlrDeviceFeatures* restrict features, const AtlrDeviceFeatures* restrict enabled)
+{
+  features->shaderObject = features->shaderObject && enabled->dynamicRendering && enabled->extendedDynamicState;
+  features->descriptorBuffer = features->descriptorBuffer
+    && enabled->bufferDeviceAddress && enabled->descriptorIndexing && enabled->synchronization2;
+}
+
+// the same rules decide which features a device is graded on and which are enabled on the selected device
+static void getEnabledDeviceFeatures(AtlrDeviceFeatures* restrict enabled, AtlrDeviceFeatures* restrict supported, const AtlrDeviceCriterion* restrict criteria)
+{
+  for (AtlrU32 i = 0; i < DEVICE_FEATURE_INFO_COUNT; i++)
+  {
+    const DeviceFeatureInfo* info = deviceFeatureInfos + i;
+    *getFeatureFlag(enabled, info) = isFeatureEnabled(criteria + info->criterion, *getFeatureFlag(supported, info));
+  }
+  applyFeatureDependencies(enabled, enabled);
+}
+
 void atlrInitDeviceCriteria(AtlrDeviceCriterion* restrict criteria)
 {
   for (AtlrI32 i = 0; i < ATLR_DEVICE_CRITERION_TOT; i++)
@@ -186,6 +464,81 @@ AtlrU8 atlrSetDeviceCriterion(AtlrDeviceCriterion* restrict criteria, AtlrDevice
   return 1;
 }
 
+
+// Commands fetched through vkGetDeviceProcAddr dispatch straight to the driver, while the exported symbols first go through the loader.
+// Called once the logical device is created and its features are set.
+void atlrLoadDeviceCommands(AtlrDevice* restrict device)
+{
+  const VkDevice logical = device->logical;
+  device->pfnBeginCommandBuffer = (PFN_vkBeginCommandBuffer)vkGetDeviceProcAddr(logical, "vkBeginCommandBuffer");
+  device->pfnEndCommandBuffer = (PFN_vkEndCommandBuffer)vkGetDeviceProcAddr(logical, "vkEndCommandBuffer");
+  device->pfnResetCommandBuffer = (PFN_vkResetCommandBuffer)vkGetDeviceProcAddr(logical, "vkResetCommandBuffer");
+  device->pfnQueueSubmit = (PFN_vkQueueSubmit)vkGetDeviceProcAddr(logical, "vkQueueSubmit");
+  device->pfnWaitForFences = (PFN_vkWaitForFences)vkGetDeviceProcAddr(logical, "vkWaitForFences");
+  device->pfnResetFences = (PFN_vkResetFences)vkGetDeviceProcAddr(logical, "vkResetFences");
+  device->pfnCmdBindPipeline = (PFN_vkCmdBindPipeline)vkGetDeviceProcAddr(logical, "vkCmdBindPipeline");
+  device->pfnCmdBindDescriptorSets = (PFN_vkCmdBindDescriptorSets)vkGetDeviceProcAddr(logical, "vkCmdBindDescriptorSets");
+  device->pfnCmdBindVertexBuffers = (PFN_vkCmdBindVertexBuffers)vkGetDeviceProcAddr(logical, "vkCmdBindVertexBuffers");
+  device->pfnCmdBindIndexBuffer = (PFN_vkCmdBindIndexBuffer)vkGetDeviceProcAddr(logical, "vkCmdBindIndexBuffer");
+  device->pfnCmdPushConstants = (PFN_vkCmdPushConstants)vkGetDeviceProcAddr(logical, "vkCmdPushConstants");
+  device->pfnCmdSetViewport = (PFN_vkCmdSetViewport)vkGetDeviceProcAddr(logical, "vkCmdSetViewport");
+  device->pfnCmdSetScissor = (PFN_vkCmdSetScissor)vkGetDeviceProcAddr(logical, "vkCmdSetScissor");
+  device->pfnCmdSetLineWidth = (PFN_vkCmdSetLineWidth)vkGetDeviceProcAddr(logical, "vkCmdSetLineWidth");
+  device->pfnCmdSetDepthBias = (PFN_vkCmdSetDepthBias)vkGetDeviceProcAddr(logical, "vkCmdSetDepthBias");
+  device->pfnCmdDraw = (PFN_vkCmdDraw)vkGetDeviceProcAddr(logical, "vkCmdDraw");
+  device->pfnCmdDrawIndexed = (PFN_vkCmdDrawIndexed)vkGetDeviceProcAddr(logical, "vkCmdDrawIndexed");
+  device->pfnCmdDispatch = (PFN_vkCmdDispatch)vkGetDeviceProcAddr(logical, "vkCmdDispatch");
+  device->pfnCmdPipelineBarrier = (PFN_vkCmdPipelineBarrier)vkGetDeviceProcAddr(logical, "vkCmdPipelineBarrier");
+  device->pfnCmdCopyBuffer = (PFN_vkCmdCopyBuffer)vkGetDeviceProcAddr(logical, "vkCmdCopyBuffer");
+  device->pfnCmdCopyImage = (PFN_vkCmdCopyImage)vkGetDeviceProcAddr(logical, "vkCmdCopyImage");
+  device->pfnCmdCopyBufferToImage = (PFN_vkCmdCopyBufferToImage)vkGetDeviceProcAddr(logical, "vkCmdCopyBufferToImage");
+  device->pfnCmdCopyImageToBuffer = (PFN_vkCmdCopyImageToBuffer)vkGetDeviceProcAddr(logical, "vkCmdCopyImageToBuffer");
+  device->pfnCmdBlitImage = (PFN_vkCmdBlitImage)vkGetDeviceProcAddr(logical, "vkCmdBlitImage");
+  device->pfnCmdResetQueryPool = (PFN_vkCmdResetQueryPool)vkGetDeviceProcAddr(logical, "vkCmdResetQueryPool");
+  device->pfnCmdWriteTimestamp = (PFN_vkCmdWriteTimestamp)vkGetDeviceProcAddr(logical, "vkCmdWriteTimestamp");
+  device->pfnGetFenceStatus = (PFN_vkGetFenceStatus)vkGetDeviceProcAddr(logical, "vkGetFenceStatus");
+  if (device->hasSwapchainSupport)
+  {
+    device->pfnAcquireNextImage = (PFN_vkAcquireNextImageKHR)vkGetDeviceProcAddr(logical, "vkAcquireNextImageKHR");
+    device->pfnQueuePresent = (PFN_vkQueuePresentKHR)vkGetDeviceProcAddr(logical, "vkQueuePresentKHR");
+  }
+  device->pfnCmdBeginRenderPass = (PFN_vkCmdBeginRenderPass)vkGetDeviceProcAddr(logical, "vkCmdBeginRenderPass");
+  device->pfnCmdEndRenderPass = (PFN_vkCmdEndRenderPass)vkGetDeviceProcAddr(logical, "vkCmdEndRenderPass");
+
+  // dynamic rendering, synchronization 2 and extended dynamic state are only enabled on Vulkan 1.3 devices, which have the core commands
+  if (device->features.dynamicRendering)
+  {
+    device->pfnCmdBeginRendering = (PFN_vkCmdBeginRendering)vkGetDeviceProcAddr(logical, "vkCmdBeginRendering");
+    device->pfnCmdEndRendering = (PFN_vkCmdEndRendering)vkGetDeviceProcAddr(logical, "vkCmdEndRendering");
+  }
+  if (device->features.synchronization2)
+    device->pfnCmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2)vkGetDeviceProcAddr(logical, "vkCmdPipelineBarrier2");
+  if (device->features.extendedDynamicState)
+  {
+    device->pfnCmdSetCullMode = (PFN_vkCmdSetCullMode)vkGetDeviceProcAddr(logical, "vkCmdSetCullMode");
+    device->pfnCmdSetFrontFace = (PFN_vkCmdSetFrontFace)vkGetDeviceProcAddr(logical, "vkCmdSetFrontFace");
+    device->pfnCmdSetPrimitiveTopology = (PFN_vkCmdSetPrimitiveTopology)vkGetDeviceProcAddr(logical, "vkCmdSetPrimitiveTopology");
+    device->pfnCmdSetPrimitiveRestartEnable = (PFN_vkCmdSetPrimitiveRestartEnable)vkGetDeviceProcAddr(logical, "vkCmdSetPrimitiveRestartEnable");
+    device->pfnCmdSetRasterizerDiscardEnable = (PFN_vkCmdSetRasterizerDiscardEnable)vkGetDeviceProcAddr(logical, "vkCmdSetRasterizerDiscardEnable");
+    device->pfnCmdSetDepthBiasEnable = (PFN_vkCmdSetDepthBiasEnable)vkGetDeviceProcAddr(logical, "vkCmdSetDepthBiasEnable");
+    device->pfnCmdSetDepthTestEnable = (PFN_vkCmdSetDepthTestEnable)vkGetDeviceProcAddr(logical, "vkCmdSetDepthTestEnable");
+    device->pfnCmdSetDepthWriteEnable = (PFN_vkCmdSetDepthWriteEnable)vkGetDeviceProcAddr(logical, "vkCmdSetDepthWriteEnable");
+    device->pfnCmdSetDepthCompareOp = (PFN_vkCmdSetDepthCompareOp)vkGetDeviceProcAddr(logical, "vkCmdSetDepthCompareOp");
+    device->pfnCmdSetStencilTestEnable = (PFN_vkCmdSetStencilTestEnable)vkGetDeviceProcAddr(logical, "vkCmdSetStencilTestEnable");
+    device->pfnCmdSetViewportWithCount = (PFN_vkCmdSetViewportWithCount)vkGetDeviceProcAddr(logical, "vkCmdSetViewportWithCount");
+    device->pfnCmdSetScissorWithCount = (PFN_vkCmdSetScissorWithCount)vkGetDeviceProcAddr(logical, "vkCmdSetScissorWithCount");
+    device->pfnCmdSetDepthBoundsTestEnable = (PFN_vkCmdSetDepthBoundsTestEnable)vkGetDeviceProcAddr(logical, "vkCmdSetDepthBoundsTestEnable");
+  }
+
+#ifdef ATLR_DEBUG
+  // debug utils is an instance extension, so its commands come from the instance, but only once per device instead of once per call
+  const VkInstance instance = device->instance->instance;
+  device->pfnCmdBeginDebugUtilsLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT");
+  device->pfnCmdEndDebugUtilsLabel = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT");
+  device->pfnSetDebugUtilsObjectName = (PFN_vkSetDebugUtilsObjectNameEXT)vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT");
+#endif
+}
+
 AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restrict instance, const AtlrDeviceCriterion* restrict criteria)
 {
   {
@@ -219,6 +572,26 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
     return 0;
   }
 
+  // the measured performance criterion needs every device's score before any device is graded;
+  // forbidding it only asks that no device be measured, so that method skips the benchmarks
+  const AtlrDeviceCriterion* measuredCriterion = criteria + ATLR_DEVICE_CRITERION_MEASURED_PERFORMANCE;
+  const AtlrU8 isMeasured = (measuredCriterion->method == ATLR_DEVICE_CRITERION_METHOD_REQUIRED)
+    || ((measuredCriterion->method == ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT) && measuredCriterion->pointShift);
+  AtlrDeviceBenchmark* benchmarks = NULL;
+  float bestScore = 0.0f;
+  if (isMeasured)
+  {
+    benchmarks = malloc(physicalDeviceCount * sizeof(AtlrDeviceBenchmark));
+    for (AtlrU32 i = 0; i < physicalDeviceCount; i++)
+    {
+      AtlrDeviceBenchmark* benchmark = benchmarks + i;
+      if (!atlrMeasurePhysicalDevice(benchmark, physicalDevices[i], instance))
+	benchmark->score = 0.0f;
+      if (benchmark->score > bestScore)
+	bestScore = benchmark->score;
+    }
+  }
+
   // Check criteria and bestow each physical device a grade, the device with the best grade is selected
   AtlrI32 bestGrade = 0;
   AtlrU8 foundPhysicalDevice = 0;
@@ -234,10 +607,8 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
   { 
     const VkPhysicalDevice physical = physicalDevices[i];
     VkPhysicalDeviceProperties properties;
-    VkPhysicalDeviceFeatures features;
     VkPhysicalDeviceMemoryProperties memoryProperties;
     vkGetPhysicalDeviceProperties(physical, &properties);
-    vkGetPhysicalDeviceFeatures(physical, &features);
     vkGetPhysicalDeviceMemoryProperties(physical, &memoryProperties);
 
     atlrLog(ATLR_LOG_DEBUG, "Grading physical device \"%s\" ...", properties.deviceName);
@@ -246,6 +617,9 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
     const AtlrU32 versionMajor = VK_VERSION_MAJOR(version);
     const AtlrU32 versionMinor = VK_VERSION_MINOR(version);
 
+    AtlrDeviceFeatures features;
+    getSupportedDeviceFeatures(&features, physical, getFeatureApiVersion(instance, version));
+
     AtlrQueueFamilyIndices queueFamilyIndices;
     initQueueFamilyIndices(&queueFamilyIndices, instance, physical);
 
@@ -255,6 +629,15 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
       && arePhysicalDeviceExtensionsAvailable(physical, &swapchainExtension, 1)
       && atlrInitSwapchainSupportDetails(&swapchainSupportDetails, instance, physical);
 
+    AtlrU64 deviceLocalHeapSize = 0;
+    for (AtlrU32 j = 0; j < memoryProperties.memoryHeapCount; j++)
+    {
+      const VkMemoryHeap* heap = memoryProperties.memoryHeaps + j;
+      if ((heap->flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && (heap->size > deviceLocalHeapSize))
+	deviceLocalHeapSize = heap->size;
+    }
+    const float score = isMeasured ? benchmarks[i].score : 0.0f;
+
     AtlrI32 grade = 0;
     AtlrU8 isFailureLocked = 0;
 
@@ -303,11 +686,34 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
 	  criterionValues[j] = hasSwapchainSupport;
 	  break;
 
-        case ATLR_DEVICE_CRITERION_GEOMETRY_SHADER:
-	  criterionValues[j] = features.geometryShader;
+        case ATLR_DEVICE_CRITERION_DEVICE_LOCAL_HEAP_AT_LEAST_2_GIB:
+	  criterionValues[j] = deviceLocalHeapSize >= (2ULL << 30);
+	  break;
+        case ATLR_DEVICE_CRITERION_DEVICE_LOCAL_HEAP_AT_LEAST_4_GIB:
+	  criterionValues[j] = deviceLocalHeapSize >= (4ULL << 30);
+	  break;
+        case ATLR_DEVICE_CRITERION_DEVICE_LOCAL_HEAP_AT_LEAST_8_GIB:
+	  criterionValues[j] = deviceLocalHeapSize >= (8ULL << 30);
+	  break;
+
+        case ATLR_DEVICE_CRITERION_MEASURED_PERFORMANCE:
+	  criterionValues[j] = score > 0.0f;
+	  break;
+
+        default:
 	  break;
       }
     }
+    // a feature only counts as supported if the features it builds on would be enabled as well,
+    // so a required feature either fails the grade or ends up enabled
+    AtlrDeviceFeatures enabledFeatures;
+    getEnabledDeviceFeatures(&enabledFeatures, &features, criteria);
+    applyFeatureDependencies(&features, &enabledFeatures);
+    for (AtlrU32 j = 0; j < DEVICE_FEATURE_INFO_COUNT; j++)
+    {
+      const DeviceFeatureInfo* info = deviceFeatureInfos + j;
+      criterionValues[info->criterion] = *getFeatureFlag(&features, info);
+    }
 
     for (AtlrI32 j = 0; j < ATLR_DEVICE_CRITERION_TOT; j++)
     {
@@ -320,19 +726,22 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
 	{
 	  if (!criterion->pointShift) break;
 	  const char* met = criterionValue ? "is met" : "is not met";
+	  AtlrI32 pointShift = criterion->pointShift;
+	  if ((j == ATLR_DEVICE_CRITERION_MEASURED_PERFORMANCE) && criterionValue)
+	    pointShift = (AtlrI32)(pointShift * (score / bestScore));
 	  
 	  if (isFailureLocked)
 	  {
 	    atlrLog(ATLR_LOG_DEBUG, "Criterion (type: \"%s\", method: point-shift by %d) %s. "
 		       "The physical device is locked into a failing grade regardless.",
-		       criterionName, criterion->pointShift,  met);
+		       criterionName, pointShift,  met);
 	    break;
 	  }
 	  
-	  grade += criterionValue ? criterion->pointShift : 0;
+	  grade += criterionValue ? pointShift : 0;
 	  atlrLog(ATLR_LOG_DEBUG, "Criterion (type: \"%s\", method: point-shift by %d) %s. "
 		     "The current grade is %d.",
-		     criterionName, criterion->pointShift, met, grade);
+		     criterionName, pointShift, met, grade);
 	  break;
 	}
 
@@ -404,6 +813,7 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
     }
     atlrDeinitSwapchainSupportDetails(&swapchainSupportDetails);
   }
+  free(benchmarks);
   free(physicalDevices);
 
   if (!foundPhysicalDevice)
@@ -414,28 +824,22 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
   
   // set device info
   VkPhysicalDeviceFeatures deviceFeatures = {};
+  AtlrU32 apiVersion;
   {
     VkPhysicalDeviceProperties properties;
-    VkPhysicalDeviceFeatures features;
     vkGetPhysicalDeviceProperties(device->physical, &properties);
-    vkGetPhysicalDeviceFeatures(device->physical, &features);
+    apiVersion = getFeatureApiVersion(device->instance, properties.apiVersion);
     
     atlrLog(ATLR_LOG_INFO, "With the highest grade of %d, the physical device \"%s\" was selected.",
 	       bestGrade, properties.deviceName);
-    
-    AtlrDeviceCriterion geometryShaderCriterion = criteria[ATLR_DEVICE_CRITERION_GEOMETRY_SHADER];
-    switch (geometryShaderCriterion.method)
-    {
-      case ATLR_DEVICE_CRITERION_METHOD_POINT_SHIFT:
-	deviceFeatures.geometryShader = (geometryShaderCriterion.pointShift >= 0 && features.geometryShader) ? VK_TRUE : VK_FALSE;
-	break;
-      case ATLR_DEVICE_CRITERION_METHOD_REQUIRED:
-	deviceFeatures.geometryShader = VK_TRUE;
-	break;
-      case ATLR_DEVICE_CRITERION_METHOD_FORBIDDEN:
-	deviceFeatures.geometryShader = VK_FALSE;
-	break;
-    }
+
+    AtlrDeviceFeatures supported;
+    getSupportedDeviceFeatures(&supported, device->physical, apiVersion);
+    AtlrDeviceFeatures* enabled = &device->features;
+    getEnabledDeviceFeatures(enabled, &supported, criteria);
+    deviceFeatures.geometryShader = enabled->geometryShader ? VK_TRUE : VK_FALSE;
+    deviceFeatures.textureCompressionBC = enabled->textureCompressionBC ? VK_TRUE : VK_FALSE;
+    deviceFeatures.textureCompressionETC2 = enabled->textureCompressionETC2 ? VK_TRUE : VK_FALSE;
     
     VkSampleCountFlags countFlags = properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
     if (countFlags & VK_SAMPLE_COUNT_4_BIT)      device->msaaSamples = VK_SAMPLE_COUNT_4_BIT;
@@ -470,6 +874,46 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
       .pQueuePriorities = &priority
     };
 
+  // feature structures beyond Vulkan 1.0 are chained onto VkPhysicalDeviceFeatures2; each enabled flag is VK_TRUE or VK_FALSE
+  const AtlrDeviceFeatures* enabled = &device->features;
+  DeviceFeatureChain chain;
+  initDeviceFeatureChain(&chain, enabled, apiVersion);
+  chain.features2.features = deviceFeatures;
+  VkPhysicalDeviceVulkan12Features* vulkan12 = &chain.vulkan12;
+  vulkan12->descriptorIndexing = enabled->descriptorIndexing;
+  vulkan12->runtimeDescriptorArray = enabled->descriptorIndexing;
+  vulkan12->shaderSampledImageArrayNonUniformIndexing = enabled->descriptorIndexing;
+  vulkan12->shaderStorageBufferArrayNonUniformIndexing = enabled->descriptorIndexing;
+  vulkan12->descriptorBindingPartiallyBound = enabled->descriptorIndexing;
+  vulkan12->descriptorBindingUpdateUnusedWhilePending = enabled->descriptorIndexing;
+  vulkan12->descriptorBindingSampledImageUpdateAfterBind = enabled->descriptorIndexing;
+  vulkan12->descriptorBindingStorageBufferUpdateAfterBind = enabled->descriptorIndexing;
+  vulkan12->timelineSemaphore = enabled->timelineSemaphore;
+  vulkan12->bufferDeviceAddress = enabled->bufferDeviceAddress;
+  chain.vulkan13.dynamicRendering = enabled->dynamicRendering;
+  chain.vulkan13.synchronization2 = enabled->synchronization2;
+  chain.vulkan13.maintenance4 = enabled->maintenance4;
+  chain.extendedDynamicState3.extendedDynamicState3PolygonMode = enabled->extendedDynamicState3;
+  chain.extendedDynamicState3.extendedDynamicState3ColorBlendEnable = enabled->extendedDynamicState3;
+  chain.extendedDynamicState3.extendedDynamicState3ColorWriteMask = enabled->extendedDynamicState3;
+  chain.graphicsPipelineLibrary.graphicsPipelineLibrary = enabled->graphicsPipelineLibrary;
+  chain.shaderObject.shaderObject = enabled->shaderObject;
+  chain.descriptorBuffer.descriptorBuffer = enabled->descriptorBuffer;
+  chain.hostImageCopy.hostImageCopy = enabled->hostImageCopy;
+
+  // the extensions of every enabled feature, and the swapchain extension
+  const char* enabledExtensions[2 * DEVICE_FEATURE_INFO_COUNT + 1];
+  AtlrU32 enabledExtensionCount = 0;
+  if (device->hasSwapchainSupport)
+    enabledExtensions[enabledExtensionCount++] = swapchainExtension;
+  for (AtlrU32 i = 0; i < DEVICE_FEATURE_INFO_COUNT; i++)
+  {
+    const DeviceFeatureInfo* info = deviceFeatureInfos + i;
+    if (!*getFeatureFlag(&device->features, info)) continue;
+    for (AtlrU32 j = 0; j < info->extensionCount; j++)
+      enabledExtensions[enabledExtensionCount++] = info->extensions[j];
+  }
+
   // create logical device; enabledLayerCount and ppEnabledLayerNames are deprecated fields
   VkDeviceCreateInfo deviceInfo =
   {
@@ -478,17 +922,14 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
     .flags = 0,
     .queueCreateInfoCount = uniqueQueueFamilyIndicesCount,
     .pQueueCreateInfos = queueInfos,
+    .enabledExtensionCount = enabledExtensionCount,
+    .ppEnabledExtensionNames = enabledExtensionCount ? enabledExtensions : NULL,
     .pEnabledFeatures = &deviceFeatures
   };
-  if (device->hasSwapchainSupport)
+  if (apiVersion >= VK_API_VERSION_1_1)
   {
-    deviceInfo.enabledExtensionCount = 1;
-    deviceInfo.ppEnabledExtensionNames = &swapchainExtension;
-  }
-  else
-  {
-    deviceInfo.enabledExtensionCount = 0;
-    deviceInfo.ppEnabledExtensionNames = NULL;
+    deviceInfo.pNext = &chain.features2;
+    deviceInfo.pEnabledFeatures = NULL;
   }
   if (vkCreateDevice(device->physical, &deviceInfo, instance->allocator, &device->logical) != VK_SUCCESS)
   {
@@ -496,6 +937,46 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
     return 0;
   }
 
+  // shader objects expose the extended dynamic state 3 commands they need without the extension
+  if (device->features.extendedDynamicState3 || device->features.shaderObject)
+  {
+    device->pfnCmdSetPolygonMode = (PFN_vkCmdSetPolygonModeEXT)vkGetDeviceProcAddr(device->logical, "vkCmdSetPolygonModeEXT");
+    device->pfnCmdSetColorBlendEnable = (PFN_vkCmdSetColorBlendEnableEXT)vkGetDeviceProcAddr(device->logical, "vkCmdSetColorBlendEnableEXT");
+    device->pfnCmdSetColorWriteMask = (PFN_vkCmdSetColorWriteMaskEXT)vkGetDeviceProcAddr(device->logical, "vkCmdSetColorWriteMaskEXT");
+  }
+  if (device->features.shaderObject)
+  {
+    device->pfnCreateShaders = (PFN_vkCreateShadersEXT)vkGetDeviceProcAddr(device->logical, "vkCreateShadersEXT");
+    device->pfnDestroyShader = (PFN_vkDestroyShaderEXT)vkGetDeviceProcAddr(device->logical, "vkDestroyShaderEXT");
+    device->pfnCmdBindShaders = (PFN_vkCmdBindShadersEXT)vkGetDeviceProcAddr(device->logical, "vkCmdBindShadersEXT");
+    device->pfnCmdSetVertexInput = (PFN_vkCmdSetVertexInputEXT)vkGetDeviceProcAddr(device->logical, "vkCmdSetVertexInputEXT");
+    device->pfnCmdSetRasterizationSamples = (PFN_vkCmdSetRasterizationSamplesEXT)vkGetDeviceProcAddr(device->logical, "vkCmdSetRasterizationSamplesEXT");
+    device->pfnCmdSetSampleMask = (PFN_vkCmdSetSampleMaskEXT)vkGetDeviceProcAddr(device->logical, "vkCmdSetSampleMaskEXT");
+    device->pfnCmdSetAlphaToCoverageEnable = (PFN_vkCmdSetAlphaToCoverageEnableEXT)vkGetDeviceProcAddr(device->logical, "vkCmdSetAlphaToCoverageEnableEXT");
+    device->pfnCmdSetColorBlendEquation = (PFN_vkCmdSetColorBlendEquationEXT)vkGetDeviceProcAddr(device->logical, "vkCmdSetColorBlendEquationEXT");
+  }
+  if (device->features.pushDescriptor)
+  {
+    device->pfnCmdPushDescriptorSet = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device->logical, "vkCmdPushDescriptorSetKHR");
+    device->pfnCmdPushDescriptorSetWithTemplate = (PFN_vkCmdPushDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(device->logical, "vkCmdPushDescriptorSetWithTemplateKHR");
+  }
+  if (device->features.descriptorBuffer)
+  {
+    device->pfnGetDescriptorSetLayoutSize = (PFN_vkGetDescriptorSetLayoutSizeEXT)vkGetDeviceProcAddr(device->logical, "vkGetDescriptorSetLayoutSizeEXT");
+    device->pfnGetDescriptorSetLayoutBindingOffset = (PFN_vkGetDescriptorSetLayoutBindingOffsetEXT)vkGetDeviceProcAddr(device->logical, "vkGetDescriptorSetLayoutBindingOffsetEXT");
+    device->pfnGetDescriptor = (PFN_vkGetDescriptorEXT)vkGetDeviceProcAddr(device->logical, "vkGetDescriptorEXT");
+    device->pfnCmdBindDescriptorBuffers = (PFN_vkCmdBindDescriptorBuffersEXT)vkGetDeviceProcAddr(device->logical, "vkCmdBindDescriptorBuffersEXT");
+    device->pfnCmdSetDescriptorBufferOffsets = (PFN_vkCmdSetDescriptorBufferOffsetsEXT)vkGetDeviceProcAddr(device->logical, "vkCmdSetDescriptorBufferOffsetsEXT");
+  }
+  if (device->features.hostImageCopy)
+  {
+    device->pfnCopyMemoryToImage = (PFN_vkCopyMemoryToImageEXT)vkGetDeviceProcAddr(device->logical, "vkCopyMemoryToImageEXT");
+    device->pfnTransitionImageLayout = (PFN_vkTransitionImageLayoutEXT)vkGetDeviceProcAddr(device->logical, "vkTransitionImageLayoutEXT");
+  }
+  if (device->features.externalMemoryHost)
+    device->pfnGetMemoryHostPointerProperties = (PFN_vkGetMemoryHostPointerPropertiesEXT)vkGetDeviceProcAddr(device->logical, "vkGetMemoryHostPointerPropertiesEXT");
+  atlrLoadDeviceCommands(device);
+
   if (queueFamilyIndices->isGraphicsCompute)
     vkGetDeviceQueue(device->logical, queueFamilyIndices->graphicsComputeIndex, 0, &device->graphicsComputeQueue);
   else
@@ -505,6 +986,10 @@ AtlrU8 atlrInitDeviceHost(AtlrDevice* restrict device, const AtlrInstance* restr
   else
     device->presentQueue = VK_NULL_HANDLE;
 
+  // the cache is kept behind a pointer, so samplers can be acquired through the const device pointers passed around the library
+  device->samplerCache = malloc(sizeof(AtlrSamplerCache));
+  atlrInitSamplerCache(device->samplerCache);
+
   atlrLog(ATLR_LOG_INFO, "Done initializing antler device.");
   return 1;
 }
@@ -517,12 +1002,51 @@ void atlrDeinitDeviceHost(AtlrDevice* device)
   atlrLog(ATLR_LOG_INFO, "Deinitializing Antler device in host GLFW mode ...");
 #endif
 
+  atlrDeinitSamplerCache(device->samplerCache, device);
+  free(device->samplerCache);
   vkDestroyDevice(device->logical, device->instance->allocator);
 
   atlrLog(ATLR_LOG_INFO, "Done deinitializing antler device.");
 }
 #endif
 
+// Sum the budget and usage of the device local heaps. Without the memory budget feature the budget is the size of the heaps,
+// and the usage is unknown and reported as 0; the return value says whether the figures came from the device.
+AtlrU8 atlrGetDeviceLocalMemoryBudget(AtlrU64* restrict budget, AtlrU64* restrict usage, const AtlrDevice* restrict device)
+{
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+    .pNext = NULL
+  };
+  VkPhysicalDeviceMemoryProperties2 memoryProperties2 =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+    .pNext = &budgetProperties
+  };
+  const VkPhysicalDeviceMemoryProperties* memoryProperties = &memoryProperties2.memoryProperties;
+  if (device->features.memoryBudget)
+    vkGetPhysicalDeviceMemoryProperties2(device->physical, &memoryProperties2);
+  else
+    vkGetPhysicalDeviceMemoryProperties(device->physical, &memoryProperties2.memoryProperties);
+
+  *budget = 0;
+  *usage = 0;
+  for (AtlrU32 i = 0; i < memoryProperties->memoryHeapCount; i++)
+  {
+    if (!(memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+    if (device->features.memoryBudget)
+    {
+      *budget += budgetProperties.heapBudget[i];
+      *usage += budgetProperties.heapUsage[i];
+    }
+    else
+      *budget += memoryProperties->memoryHeaps[i].size;
+  }
+
+  return device->features.memoryBudget;
+}
+
 #ifdef ATLR_DEBUG
 void atlrSetObjectName(const VkObjectType objectType, const AtlrU64 objectHandle, const char* restrict objectName, const AtlrDevice* restrict device)
 {
@@ -534,8 +1058,6 @@ void atlrSetObjectName(const VkObjectType objectType, const AtlrU64 objectHandle
     .objectHandle = objectHandle,
     .pObjectName = objectName
   };
-  PFN_vkSetDebugUtilsObjectNameEXT pfnSetName =
-    (PFN_vkSetDebugUtilsObjectNameEXT)vkGetInstanceProcAddr(device->instance->instance, "vkSetDebugUtilsObjectNameEXT");
-  pfnSetName(device->logical, &nameInfo);
+  device->pfnSetDebugUtilsObjectName(device->logical, &nameInfo);
 }
 #endif
@@ -0,0 +1,442 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+#include <pthread.h>
+
+// All allocations but large ones live in 64 KiB chunks aligned to their size, so the chunk of a freed pointer is found by masking it.
+// Pooled chunks hold blocks of one power of two size class, from 16 to 512 bytes, each block aligned to its size,
+// followed by the scope of every block for the statistics. Blocks are never returned to the system before the allocator is deinitialized.
+// Arena chunks are bumped through by command scope allocations, which Vulkan frees by the end of the command,
+// and are reset or recycled once their last allocation is freed.
+// Large allocations carry a header in front of them instead.
+
+#define CHUNK_SIZE (64 * 1024)
+#define CLASS_COUNT 6
+#define MIN_CLASS_SIZE 16
+#define MAX_CLASS_SIZE (MIN_CLASS_SIZE << (CLASS_COUNT - 1))
+#define ARENA_KIND CLASS_COUNT
+#define ARENA_SIZE_HEADER 8
+
+typedef struct _ChunkHeader
+{
+  AtlrU32 kind;
+  AtlrU32 blockSize;
+  AtlrU32 firstBlock;
+  AtlrU32 top;
+  AtlrU32 liveCount;
+  struct _ChunkHeader* nextSpare;
+  
+} ChunkHeader;
+
+typedef struct _LargeHeader
+{
+  AtlrU64 size;
+  AtlrU32 offset;
+  AtlrU32 scope;
+  
+} LargeHeader;
+
+struct _AtlrHostAllocatorState
+{
+  pthread_mutex_t mutex;
+  AtlrHostAllocatorStats stats;
+  void* freeBlocks[CLASS_COUNT];
+  AtlrU32 chunkCapacity;
+  AtlrU32 chunkCount;
+  ChunkHeader** chunks; // sorted by address
+  ChunkHeader* arena;
+  ChunkHeader* spareArenas;
+};
+
+static const char* scopeNames[ATLR_ALLOCATION_SCOPE_COUNT] =
+{
+  "command",
+  "object",
+  "cache",
+  "device",
+  "instance"
+};
+
+static AtlrU64 roundUp(const AtlrU64 offset, const AtlrU64 alignment)
+{
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static void addBytes(AtlrHostAllocatorStats* restrict stats, const VkSystemAllocationScope scope, const AtlrU64 size)
+{
+  stats->bytes[scope] += size;
+  if (stats->bytes[scope] > stats->peakBytes[scope])
+    stats->peakBytes[scope] = stats->bytes[scope];
+}
+
+static ChunkHeader* findChunk(const struct _AtlrHostAllocatorState* restrict state, const void* memory)
+{
+  const ChunkHeader* base = (const ChunkHeader*)((uintptr_t)memory & ~(uintptr_t)(CHUNK_SIZE - 1));
+  AtlrU32 low = 0;
+  AtlrU32 high = state->chunkCount;
+  while (low < high)
+  {
+    const AtlrU32 middle = low + (high - low) / 2;
+    if (state->chunks[middle] == base)
+      return state->chunks[middle];
+    if ((uintptr_t)state->chunks[middle] < (uintptr_t)base)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return NULL;
+}
+
+static ChunkHeader* newChunk(struct _AtlrHostAllocatorState* restrict state, const AtlrU32 kind)
+{
+  if (state->chunkCount == state->chunkCapacity)
+  {
+    const AtlrU32 capacity = state->chunkCapacity ? 2 * state->chunkCapacity : 16;
+    ChunkHeader** chunks = realloc(state->chunks, capacity * sizeof(ChunkHeader*));
+    if (!chunks)
+      return NULL;
+    state->chunkCapacity = capacity;
+    state->chunks = chunks;
+  }
+
+  ChunkHeader* chunk = atlrAlignedMalloc(CHUNK_SIZE, CHUNK_SIZE);
+  if (!chunk)
+    return NULL;
+  AtlrU32 index = state->chunkCount++;
+  while (index && ((uintptr_t)state->chunks[index - 1] > (uintptr_t)chunk))
+  {
+    state->chunks[index] = state->chunks[index - 1];
+    index--;
+  }
+  state->chunks[index] = chunk;
+
+  chunk->kind = kind;
+  chunk->liveCount = 0;
+  chunk->nextSpare = NULL;
+  if (kind == ARENA_KIND)
+  {
+    chunk->blockSize = 0;
+    chunk->firstBlock = sizeof(ChunkHeader);
+  }
+  else
+  {
+    chunk->blockSize = MIN_CLASS_SIZE << kind;
+    chunk->firstBlock = roundUp(sizeof(ChunkHeader) + CHUNK_SIZE / chunk->blockSize, chunk->blockSize);
+  }
+  chunk->top = chunk->firstBlock;
+
+  return chunk;
+}
+
+static void* allocPooled(struct _AtlrHostAllocatorState* restrict state, const AtlrU32 kind, const VkSystemAllocationScope scope)
+{
+  if (!state->freeBlocks[kind])
+  {
+    ChunkHeader* chunk = newChunk(state, kind);
+    if (!chunk)
+      return NULL;
+    const AtlrU32 blockCount = (CHUNK_SIZE - chunk->firstBlock) / chunk->blockSize;
+    for (AtlrU32 i = blockCount; i > 0; i--)
+    {
+      void** block = (void**)((AtlrU8*)chunk + chunk->firstBlock + (i - 1) * chunk->blockSize);
+      *block = state->freeBlocks[kind];
+      state->freeBlocks[kind] = block;
+    }
+  }
+
+  void** block = state->freeBlocks[kind];
+  state->freeBlocks[kind] = *block;
+
+  ChunkHeader* chunk = findChunk(state, block);
+  AtlrU8* scopes = (AtlrU8*)(chunk + 1);
+  scopes[((AtlrU8*)block - (AtlrU8*)chunk - chunk->firstBlock) / chunk->blockSize] = scope;
+  chunk->liveCount++;
+  addBytes(&state->stats, scope, chunk->blockSize);
+
+  return block;
+}
+
+static ChunkHeader* takeArena(struct _AtlrHostAllocatorState* restrict state)
+{
+  ChunkHeader* chunk = state->spareArenas;
+  if (chunk)
+  {
+    state->spareArenas = chunk->nextSpare;
+    chunk->nextSpare = NULL;
+    chunk->top = chunk->firstBlock;
+    return chunk;
+  }
+
+  return newChunk(state, ARENA_KIND);
+}
+
+// Returns NULL without an error when the allocation is too large for an arena chunk.
+static void* allocArena(struct _AtlrHostAllocatorState* restrict state, const AtlrU64 size, const AtlrU64 alignment)
+{
+  const AtlrU64 headerAlignment = (alignment > ARENA_SIZE_HEADER) ? alignment : ARENA_SIZE_HEADER;
+  if (sizeof(ChunkHeader) + ARENA_SIZE_HEADER + headerAlignment + size > CHUNK_SIZE)
+    return NULL;
+
+  ChunkHeader* arena = state->arena;
+  AtlrU64 offset = arena ? roundUp(arena->top + ARENA_SIZE_HEADER, headerAlignment) : 0;
+  if (!arena || (offset + size > CHUNK_SIZE))
+  {
+    // the full arena still has live allocations, as it is reset when the last one is freed, and is recycled after that
+    arena = takeArena(state);
+    if (!arena)
+      return NULL;
+    state->arena = arena;
+    offset = roundUp(arena->top + ARENA_SIZE_HEADER, headerAlignment);
+  }
+
+  AtlrU8* memory = (AtlrU8*)arena + offset;
+  *(AtlrU64*)(memory - ARENA_SIZE_HEADER) = size;
+  arena->top = offset + size;
+  arena->liveCount++;
+  addBytes(&state->stats, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND, size);
+
+  return memory;
+}
+
+static void* allocLarge(struct _AtlrHostAllocatorState* restrict state, const AtlrU64 size, const AtlrU64 alignment, const VkSystemAllocationScope scope)
+{
+  const AtlrU64 offset = (alignment > sizeof(LargeHeader)) ? alignment : sizeof(LargeHeader);
+  AtlrU8* base = atlrAlignedMalloc(size + offset, offset);
+  if (!base)
+    return NULL;
+
+  AtlrU8* memory = base + offset;
+  LargeHeader* header = (LargeHeader*)(memory - sizeof(LargeHeader));
+  header->size = size;
+  header->offset = offset;
+  header->scope = scope;
+  addBytes(&state->stats, scope, size);
+
+  return memory;
+}
+
+static void* allocLocked(struct _AtlrHostAllocatorState* restrict state, const AtlrU64 size, const AtlrU64 alignment, const VkSystemAllocationScope scope)
+{
+  if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND)
+  {
+    void* memory = allocArena(state, size, alignment);
+    if (memory)
+      return memory;
+  }
+  else
+  {
+    const AtlrU64 classSize = (size > alignment) ? size : alignment;
+    if (classSize <= MAX_CLASS_SIZE)
+    {
+      AtlrU32 kind = 0;
+      while ((AtlrU64)(MIN_CLASS_SIZE << kind) < classSize)
+	kind++;
+      return allocPooled(state, kind, scope);
+    }
+  }
+
+  return allocLarge(state, size, alignment, scope);
+}
+
+// The usable size of a live allocation, which is what a reallocation copies.
+static AtlrU64 getSizeLocked(const struct _AtlrHostAllocatorState* restrict state, const void* memory)
+{
+  const ChunkHeader* chunk = findChunk(state, memory);
+  if (!chunk)
+    return ((const LargeHeader*)((const AtlrU8*)memory - sizeof(LargeHeader)))->size;
+  if (chunk->kind == ARENA_KIND)
+    return *(const AtlrU64*)((const AtlrU8*)memory - ARENA_SIZE_HEADER);
+  return chunk->blockSize;
+}
+
+// Returns the scope the memory was allocated in.
+static VkSystemAllocationScope freeLocked(struct _AtlrHostAllocatorState* restrict state, void* memory)
+{
+  ChunkHeader* chunk = findChunk(state, memory);
+  if (!chunk)
+  {
+    const LargeHeader* header = (const LargeHeader*)((AtlrU8*)memory - sizeof(LargeHeader));
+    const VkSystemAllocationScope scope = header->scope;
+    state->stats.bytes[scope] -= header->size;
+    atlrAlignedFree((AtlrU8*)memory - header->offset);
+    return scope;
+  }
+
+  if (chunk->kind == ARENA_KIND)
+  {
+    state->stats.bytes[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND] -= *(AtlrU64*)((AtlrU8*)memory - ARENA_SIZE_HEADER);
+    if (!--chunk->liveCount)
+    {
+      if (chunk == state->arena)
+	chunk->top = chunk->firstBlock;
+      else
+      {
+	chunk->nextSpare = state->spareArenas;
+	state->spareArenas = chunk;
+      }
+    }
+    return VK_SYSTEM_ALLOCATION_SCOPE_COMMAND;
+  }
+
+  const AtlrU8* scopes = (const AtlrU8*)(chunk + 1);
+  const VkSystemAllocationScope scope = scopes[((AtlrU8*)memory - (AtlrU8*)chunk - chunk->firstBlock) / chunk->blockSize];
+  state->stats.bytes[scope] -= chunk->blockSize;
+  chunk->liveCount--;
+  *(void**)memory = state->freeBlocks[chunk->kind];
+  state->freeBlocks[chunk->kind] = memory;
+
+  return scope;
+}
+
+static VKAPI_ATTR void* VKAPI_CALL allocation(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+  struct _AtlrHostAllocatorState* state = userData;
+  pthread_mutex_lock(&state->mutex);
+  void* memory = allocLocked(state, size, alignment, scope);
+  if (memory)
+    state->stats.allocationCount[scope]++;
+  pthread_mutex_unlock(&state->mutex);
+
+  return memory;
+}
+
+static VKAPI_ATTR void* VKAPI_CALL reallocation(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+  if (!original)
+    return allocation(userData, size, alignment, scope);
+
+  struct _AtlrHostAllocatorState* state = userData;
+  pthread_mutex_lock(&state->mutex);
+  void* memory = NULL;
+  if (size)
+  {
+    memory = allocLocked(state, size, alignment, scope);
+    if (memory)
+    {
+      const AtlrU64 originalSize = getSizeLocked(state, original);
+      memcpy(memory, original, (originalSize < size) ? originalSize : size);
+    }
+  }
+  // on failure the original allocation must stay valid
+  if (memory || !size)
+  {
+    freeLocked(state, original);
+    state->stats.reallocationCount[scope]++;
+  }
+  pthread_mutex_unlock(&state->mutex);
+
+  return memory;
+}
+
+static VKAPI_ATTR void VKAPI_CALL freeMemory(void* userData, void* memory)
+{
+  if (!memory)
+    return;
+  
+  struct _AtlrHostAllocatorState* state = userData;
+  pthread_mutex_lock(&state->mutex);
+  const VkSystemAllocationScope scope = freeLocked(state, memory);
+  state->stats.freeCount[scope]++;
+  pthread_mutex_unlock(&state->mutex);
+}
+
+static VKAPI_ATTR void VKAPI_CALL internalAllocation(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+  struct _AtlrHostAllocatorState* state = userData;
+  pthread_mutex_lock(&state->mutex);
+  state->stats.internalBytes[scope] += size;
+  pthread_mutex_unlock(&state->mutex);
+}
+
+static VKAPI_ATTR void VKAPI_CALL internalFree(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+  struct _AtlrHostAllocatorState* state = userData;
+  pthread_mutex_lock(&state->mutex);
+  state->stats.internalBytes[scope] -= size;
+  pthread_mutex_unlock(&state->mutex);
+}
+
+// Pass &allocator->callbacks to the instance init functions.
+AtlrU8 atlrInitHostAllocator(AtlrHostAllocator* restrict allocator)
+{
+  struct _AtlrHostAllocatorState* state = calloc(1, sizeof(struct _AtlrHostAllocatorState));
+  if (!state)
+  {
+    ATLR_ERROR_MSG("calloc returned NULL.");
+    return 0;
+  }
+  if (pthread_mutex_init(&state->mutex, NULL))
+  {
+    ATLR_ERROR_MSG("pthread_mutex_init failed.");
+    free(state);
+    return 0;
+  }
+  allocator->state = state;
+
+  allocator->callbacks = (VkAllocationCallbacks)
+  {
+    .pUserData = state,
+    .pfnAllocation = allocation,
+    .pfnReallocation = reallocation,
+    .pfnFree = freeMemory,
+    .pfnInternalAllocation = internalAllocation,
+    .pfnInternalFree = internalFree
+  };
+
+  return 1;
+}
+
+// Every object created with the callbacks must already be destroyed.
+void atlrDeinitHostAllocator(AtlrHostAllocator* restrict allocator)
+{
+  struct _AtlrHostAllocatorState* state = allocator->state;
+  for (AtlrU32 i = 0; i < ATLR_ALLOCATION_SCOPE_COUNT; i++)
+    if (state->stats.bytes[i])
+      atlrLog(ATLR_LOG_WARN, "The host allocator still holds %llu bytes in %s scope.", (unsigned long long)state->stats.bytes[i], scopeNames[i]);
+
+  for (AtlrU32 i = 0; i < state->chunkCount; i++)
+    atlrAlignedFree(state->chunks[i]);
+  free(state->chunks);
+  pthread_mutex_destroy(&state->mutex);
+  free(state);
+  allocator->state = NULL;
+}
+
+void atlrGetHostAllocatorStats(const AtlrHostAllocator* restrict allocator, AtlrHostAllocatorStats* restrict stats)
+{
+  struct _AtlrHostAllocatorState* state = allocator->state;
+  pthread_mutex_lock(&state->mutex);
+  *stats = state->stats;
+  pthread_mutex_unlock(&state->mutex);
+}
+
+void atlrLogHostAllocatorStats(const AtlrHostAllocator* restrict allocator)
+{
+  AtlrHostAllocatorStats stats;
+  atlrGetHostAllocatorStats(allocator, &stats);
+  for (AtlrU32 i = 0; i < ATLR_ALLOCATION_SCOPE_COUNT; i++)
+    atlrLog(ATLR_LOG_INFO, "Host allocations in %s scope: %llu allocations, %llu reallocations, %llu frees, %llu bytes held, %llu peak bytes, %llu internal bytes.",
+	    scopeNames[i],
+	    (unsigned long long)stats.allocationCount[i], (unsigned long long)stats.reallocationCount[i], (unsigned long long)stats.freeCount[i],
+	    (unsigned long long)stats.bytes[i], (unsigned long long)stats.peakBytes[i], (unsigned long long)stats.internalBytes[i]);
+}
@@ -0,0 +1,170 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+static AtlrU8 isHostCopyDstLayout(const VkImageLayout layout, const AtlrDevice* restrict device)
+{
+  VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProperties =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT,
+    .pNext = NULL,
+    .copySrcLayoutCount = 0,
+    .pCopySrcLayouts = NULL,
+    .copyDstLayoutCount = 0,
+    .pCopyDstLayouts = NULL
+  };
+  VkPhysicalDeviceProperties2 properties2 =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+    .pNext = &hostImageCopyProperties
+  };
+  vkGetPhysicalDeviceProperties2(device->physical, &properties2);
+  VkImageLayout* layouts = malloc(hostImageCopyProperties.copyDstLayoutCount * sizeof(VkImageLayout));
+  hostImageCopyProperties.pCopyDstLayouts = layouts;
+  vkGetPhysicalDeviceProperties2(device->physical, &properties2);
+
+  AtlrU8 isFound = 0;
+  for (AtlrU32 i = 0; i < hostImageCopyProperties.copyDstLayoutCount; i++)
+    if (layouts[i] == layout)
+    {
+      isFound = 1;
+      break;
+    }
+  free(layouts);
+
+  return isFound;
+}
+
+// Whether an optimal tiling 2D image of the format can be written from the host straight into the given layout.
+// The host transfer usage may also cost device access speed on some devices, and then the staging path is preferred.
+AtlrU8 atlrIsHostImageCopySupported(const VkFormat format, const VkImageUsageFlags usage, const VkImageLayout layout, const AtlrDevice* restrict device)
+{
+  if (!device->features.hostImageCopy)
+    return 0;
+
+  VkFormatProperties3 formatProperties3 =
+  {
+    .sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3,
+    .pNext = NULL
+  };
+  VkFormatProperties2 formatProperties2 =
+  {
+    .sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2,
+    .pNext = &formatProperties3
+  };
+  vkGetPhysicalDeviceFormatProperties2(device->physical, format, &formatProperties2);
+  if (!(formatProperties3.optimalTilingFeatures & VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT))
+    return 0;
+
+  VkHostImageCopyDevicePerformanceQueryEXT performanceQuery =
+  {
+    .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_COPY_DEVICE_PERFORMANCE_QUERY_EXT,
+    .pNext = NULL
+  };
+  VkImageFormatProperties2 imageFormatProperties2 =
+  {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+    .pNext = &performanceQuery
+  };
+  const VkPhysicalDeviceImageFormatInfo2 imageFormatInfo2 =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+    .pNext = NULL,
+    .format = format,
+    .type = VK_IMAGE_TYPE_2D,
+    .tiling = VK_IMAGE_TILING_OPTIMAL,
+    .usage = usage | VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT,
+    .flags = 0
+  };
+  if (vkGetPhysicalDeviceImageFormatProperties2(device->physical, &imageFormatInfo2, &imageFormatProperties2) != VK_SUCCESS)
+    return 0;
+  if (!performanceQuery.optimalDeviceAccess)
+  {
+    atlrLog(ATLR_LOG_DEBUG, "Host image copy usage would slow down device access to the image; staging instead.");
+    return 0;
+  }
+
+  return isHostCopyDstLayout(layout, device);
+}
+
+// Write tightly packed texels into the first level of an image created with VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT, leaving it in the given layout.
+// Both the layout transition and the copy happen on the host, so nothing is submitted; the image must not be in use by the device.
+AtlrU8 atlrHostCopyMemoryToImage(const AtlrImage* restrict image, const void* restrict texels, const VkImageLayout layout)
+{
+  const AtlrDevice* device = image->device;
+  const VkHostImageLayoutTransitionInfoEXT transitionInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT,
+    .pNext = NULL,
+    .image = image->image,
+    .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    .newLayout = layout,
+    .subresourceRange = (VkImageSubresourceRange)
+    {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = 0,
+      .levelCount = image->mipLevels,
+      .baseArrayLayer = 0,
+      .layerCount = image->layerCount
+    }
+  };
+  if (device->pfnTransitionImageLayout(device->logical, 1, &transitionInfo) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkTransitionImageLayoutEXT did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  const VkMemoryToImageCopyEXT region =
+  {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT,
+    .pNext = NULL,
+    .pHostPointer = texels,
+    .memoryRowLength = 0,
+    .memoryImageHeight = 0,
+    .imageSubresource = (VkImageSubresourceLayers)
+    {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .mipLevel = 0,
+      .baseArrayLayer = 0,
+      .layerCount = image->layerCount
+    },
+    .imageOffset = (VkOffset3D){.x = 0, .y = 0, .z = 0},
+    .imageExtent = (VkExtent3D){.width = image->width, .height = image->height, .depth = 1}
+  };
+  const VkCopyMemoryToImageInfoEXT copyInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT,
+    .pNext = NULL,
+    .flags = 0,
+    .dstImage = image->image,
+    .dstImageLayout = layout,
+    .regionCount = 1,
+    .pRegions = &region
+  };
+  if (device->pfnCopyMemoryToImage(device->logical, &copyInfo) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCopyMemoryToImageEXT did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  return 1;
+}
@@ -0,0 +1,206 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+// The alignment that imported host pointers and allocation sizes must have, or 0 when host memory cannot be imported.
+AtlrU64 atlrGetHostImportAlignment(const AtlrDevice* restrict device)
+{
+  if (!device->features.externalMemoryHost)
+    return 0;
+
+  VkPhysicalDeviceExternalMemoryHostPropertiesEXT externalMemoryHostProperties =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT,
+    .pNext = NULL
+  };
+  VkPhysicalDeviceProperties2 properties2 =
+  {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+    .pNext = &externalMemoryHostProperties
+  };
+  vkGetPhysicalDeviceProperties2(device->physical, &properties2);
+
+  return externalMemoryHostProperties.minImportedHostPointerAlignment;
+}
+
+// Allocates host memory that atlrInitHostImportBuffer can import; size is rounded up to the import alignment.
+// The memory is freed with atlrAlignedFree after every buffer importing it is deinitialized.
+void* atlrAllocHostImportMemory(AtlrU64* restrict size, const AtlrDevice* restrict device)
+{
+  const AtlrU64 alignment = atlrGetHostImportAlignment(device);
+  if (!alignment)
+  {
+    ATLR_ERROR_MSG("Host memory import is not enabled on the device.");
+    return NULL;
+  }
+  if (!atlrAlign(size, *size, alignment))
+  {
+    ATLR_ERROR_MSG("atlrAlign returned 0.");
+    return NULL;
+  }
+
+  return atlrAlignedMalloc(*size, alignment);
+}
+
+// Creates a buffer whose memory is the caller's host memory, so the device reads and writes it without staging copies.
+// The host pointer must be aligned to atlrGetHostImportAlignment, and the memory must stay valid up to size rounded up to that alignment;
+// an mmap'ed file qualifies, because mappings are page aligned and cover whole pages.
+// The host memory stays owned by the caller and must outlive the buffer.
+// The buffer is direct, so atlrStageBuffer writes in place, and device writes still need a host read barrier (atlrReadbackBuffer submits one) before the host reads them.
+AtlrU8 atlrInitHostImportBuffer(AtlrBuffer* restrict buffer, void* hostPointer, const AtlrU64 size, const VkBufferUsageFlags usage, const AtlrDevice* device)
+{
+  buffer->device = device;
+
+  const AtlrU64 alignment = atlrGetHostImportAlignment(device);
+  if (!alignment)
+  {
+    ATLR_ERROR_MSG("Host memory import is not enabled on the device.");
+    return 0;
+  }
+  if ((AtlrU64)(uintptr_t)hostPointer % alignment)
+  {
+    ATLR_ERROR_MSG("The host pointer is not aligned to %llu bytes.", (unsigned long long)alignment);
+    return 0;
+  }
+  AtlrU64 allocationSize;
+  if (!atlrAlign(&allocationSize, size, alignment))
+  {
+    ATLR_ERROR_MSG("atlrAlign returned 0.");
+    return 0;
+  }
+
+  const VkExternalMemoryBufferCreateInfo externalMemoryBufferInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+    .pNext = NULL,
+    .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT
+  };
+  const VkBufferCreateInfo bufferInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+    .pNext = &externalMemoryBufferInfo,
+    .flags = 0,
+    .size = size,
+    .usage = usage,
+    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    .queueFamilyIndexCount = 0,
+    .pQueueFamilyIndices = NULL
+  };
+  if (vkCreateBuffer(device->logical, &bufferInfo, device->instance->allocator, &buffer->buffer) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateBuffer did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  VkMemoryRequirements memoryRequirements;
+  vkGetBufferMemoryRequirements(device->logical, buffer->buffer, &memoryRequirements);
+  if (memoryRequirements.size > allocationSize)
+  {
+    ATLR_ERROR_MSG("The buffer needs %llu bytes, more than the %llu imported bytes.",
+		   (unsigned long long)memoryRequirements.size, (unsigned long long)allocationSize);
+    vkDestroyBuffer(device->logical, buffer->buffer, device->instance->allocator);
+    return 0;
+  }
+
+  VkMemoryHostPointerPropertiesEXT hostPointerProperties =
+  {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT,
+    .pNext = NULL
+  };
+  if (device->pfnGetMemoryHostPointerProperties(device->logical, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, hostPointer, &hostPointerProperties) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkGetMemoryHostPointerPropertiesEXT did not return VK_SUCCESS.");
+    vkDestroyBuffer(device->logical, buffer->buffer, device->instance->allocator);
+    return 0;
+  }
+
+  // a coherent type is required so that the in place accesses need no flushes, and a cached one is preferred for host reads
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  vkGetPhysicalDeviceMemoryProperties(device->physical, &memoryProperties);
+  const AtlrU32 typeBits = memoryRequirements.memoryTypeBits & hostPointerProperties.memoryTypeBits;
+  AtlrU32 memoryTypeIndex;
+  AtlrU8 isFound = 0;
+  buffer->isDirectCached = 0;
+  for (AtlrU32 i = 0; i < memoryProperties.memoryTypeCount; i++)
+  {
+    const VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+    if (!(typeBits & (1 << i)) || !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+      continue;
+
+    const AtlrU8 isTypeCached = (flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != 0;
+    if (!isFound || (isTypeCached && !buffer->isDirectCached))
+    {
+      memoryTypeIndex = i;
+      buffer->isDirectCached = isTypeCached;
+      isFound = 1;
+    }
+  }
+  if (!isFound)
+  {
+    ATLR_ERROR_MSG("No coherent memory type can import the host pointer.");
+    vkDestroyBuffer(device->logical, buffer->buffer, device->instance->allocator);
+    return 0;
+  }
+
+  // buffers used through device addresses need memory allocated for it
+  const VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+    .pNext = NULL,
+    .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+    .deviceMask = 0
+  };
+  const VkImportMemoryHostPointerInfoEXT importInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT,
+    .pNext = (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? &memoryAllocateFlagsInfo : NULL,
+    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+    .pHostPointer = hostPointer
+  };
+  const VkMemoryAllocateInfo memoryAllocateInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    .pNext = &importInfo,
+    .allocationSize = allocationSize,
+    .memoryTypeIndex = memoryTypeIndex
+  };
+  if (vkAllocateMemory(device->logical, &memoryAllocateInfo, device->instance->allocator, &buffer->memory) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkAllocateMemory did not return VK_SUCCESS.");
+    vkDestroyBuffer(device->logical, buffer->buffer, device->instance->allocator);
+    return 0;
+  }
+
+  if (vkBindBufferMemory(device->logical, buffer->buffer, buffer->memory, 0) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkBindBufferMemory did not return VK_SUCCESS.");
+    vkDestroyBuffer(device->logical, buffer->buffer, device->instance->allocator);
+    vkFreeMemory(device->logical, buffer->memory, device->instance->allocator);
+    return 0;
+  }
+
+  buffer->data = hostPointer;
+  buffer->isDirect = 1;
+  buffer->isImported = 1;
+
+  return 1;
+}
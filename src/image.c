@@ -52,7 +52,22 @@ VkFormat atlrGetSupportedDepthImageFormat(const VkPhysicalDevice physical, const
   return getSupportedImageFormat(physical, sizeof(depthFormatChoices) / sizeof(VkFormat), depthFormatChoices, tiling, features);
 }
 
-VkImageView atlrInitImageView(const VkImage image, const VkImageViewType viewType, const VkFormat format, const VkImageAspectFlags aspects, const AtlrU32 layerCount, const AtlrDevice* restrict device)
+// barriers on a combined depth stencil image must name both aspects
+VkImageAspectFlags atlrGetDepthImageAspects(const VkFormat format)
+{
+  switch (format)
+  {
+  case VK_FORMAT_D16_UNORM_S8_UINT:
+  case VK_FORMAT_D24_UNORM_S8_UINT:
+  case VK_FORMAT_D32_SFLOAT_S8_UINT:
+    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+  default:
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+  }
+}
+
+VkImageView atlrInitImageView(const VkImage image, const VkImageViewType viewType, const VkFormat format, const VkImageAspectFlags aspects,
+			      const AtlrU32 mipLevels, const AtlrU32 layerCount, const AtlrDevice* restrict device)
 {
   const VkImageViewCreateInfo imageViewInfo =
   {
@@ -73,7 +88,7 @@ VkImageView atlrInitImageView(const VkImage image, const VkImageViewType viewTyp
     {
       .aspectMask = aspects,
       .baseMipLevel = 0,
-      .levelCount = 1,
+      .levelCount = mipLevels,
       .baseArrayLayer = 0,
       .layerCount = layerCount
     }
@@ -93,57 +108,155 @@ void atlrDeinitImageView(const VkImageView imageView, const AtlrDevice* restrict
   vkDestroyImageView(device->logical, imageView, device->instance->allocator);
 }
 
-AtlrU8 atlrTransitionImageLayout(const AtlrImage* restrict image, const VkImageLayout oldLayout, const VkImageLayout newLayout, const AtlrSingleRecordCommandContext* restrict commandContext)
+// the pipeline stages and accesses that use an image in a given layout
+static AtlrU8 getImageLayoutSync(const VkImageLayout layout, VkPipelineStageFlags* restrict stage, VkAccessFlags* restrict access)
 {
-  VkCommandBuffer commandBuffer;
-  if (!atlrBeginSingleRecordCommands(&commandBuffer, commandContext))
+  switch (layout)
   {
-    ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+    case VK_IMAGE_LAYOUT_GENERAL:
+      *stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+      *access = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+      return 1;
+    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+      *access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+      return 1;
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      *access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      return 1;
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+      *access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+      return 1;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+      *access = VK_ACCESS_SHADER_READ_BIT;
+      return 1;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      *access = VK_ACCESS_TRANSFER_READ_BIT;
+      return 1;
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      *access = VK_ACCESS_TRANSFER_WRITE_BIT;
+      return 1;
+    case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+      // presentation is ordered by semaphores; the barrier only needs to happen before the end of the submission
+      *stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+      *access = 0;
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// Record a layout transition into a command buffer being recorded.
+// An undefined old layout discards the contents, but the barrier still waits on earlier writes in the stages that use the new layout;
+// this covers attachments that are reused every frame.
+AtlrU8 atlrCommandImageLayoutBarrier(const VkCommandBuffer commandBuffer, const VkImage image, const VkImageSubresourceRange* restrict range,
+				     const VkImageLayout oldLayout, const VkImageLayout newLayout, const AtlrDevice* restrict device)
+{
+  VkPipelineStageFlags srcStage, dstStage;
+  VkAccessFlags srcAccess, dstAccess;
+  if (!getImageLayoutSync(newLayout, &dstStage, &dstAccess))
+  {
+    ATLR_ERROR_MSG("Invalid image layout transition.");
+    return 0;
+  }
+  if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+  {
+    srcStage = (newLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : dstStage;
+    srcAccess = dstAccess & (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+  }
+  else if (oldLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+  {
+    // a presentable image is acquired with a semaphore waited on at the color attachment output stage
+    srcStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    srcAccess = 0;
+  }
+  else if (!getImageLayoutSync(oldLayout, &srcStage, &srcAccess))
+  {
+    ATLR_ERROR_MSG("Invalid image layout transition.");
     return 0;
   }
   
-  VkImageMemoryBarrier barrier =
+  // the legacy stage and access bits have the same values in their synchronization 2 counterparts
+  if (device->features.synchronization2)
+  {
+    const VkImageMemoryBarrier2 barrier2 =
+    {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+      .pNext = NULL,
+      .srcStageMask = srcStage,
+      .srcAccessMask = srcAccess,
+      .dstStageMask = dstStage,
+      .dstAccessMask = dstAccess,
+      .oldLayout = oldLayout,
+      .newLayout = newLayout,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image,
+      .subresourceRange = *range
+    };
+    const VkDependencyInfo dependencyInfo =
+    {
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .pNext = NULL,
+      .dependencyFlags = 0,
+      .memoryBarrierCount = 0,
+      .pMemoryBarriers = NULL,
+      .bufferMemoryBarrierCount = 0,
+      .pBufferMemoryBarriers = NULL,
+      .imageMemoryBarrierCount = 1,
+      .pImageMemoryBarriers = &barrier2
+    };
+    device->pfnCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+    return 1;
+  }
+  
+  const VkImageMemoryBarrier barrier =
   {
     .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
     .pNext = NULL,
+    .srcAccessMask = srcAccess,
+    .dstAccessMask = dstAccess,
     .oldLayout = oldLayout,
     .newLayout = newLayout,
     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-    .image = image->image,
-    .subresourceRange = (VkImageSubresourceRange)
-    {
-      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-      .baseMipLevel = 0,
-      .levelCount = 1,
-      .baseArrayLayer = 0,
-      .layerCount = image->layerCount
-    }
+    .image = image,
+    .subresourceRange = *range
   };
-  VkPipelineStageFlags srcStage = VK_PIPELINE_STAGE_NONE;
-  VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_NONE;
-  if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+  device->pfnCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+  return 1;
+}
+
+AtlrU8 atlrTransitionImageLayout(const AtlrImage* restrict image, const VkImageLayout oldLayout, const VkImageLayout newLayout, const AtlrSingleRecordCommandContext* restrict commandContext)
+{
+  VkCommandBuffer commandBuffer;
+  if (!atlrBeginSingleRecordCommands(&commandBuffer, commandContext))
   {
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+    return 0;
   }
-  else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+  
+  const VkImageSubresourceRange range =
   {
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  }
-  else
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = image->mipLevels,
+    .baseArrayLayer = 0,
+    .layerCount = image->layerCount
+  };
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, oldLayout, newLayout, image->device))
   {
-    ATLR_ERROR_MSG("Invalid image layout transition.");
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    atlrEndSingleRecordCommands(commandBuffer, commandContext);
     return 0;
   }
 
-  vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, NULL, 0, NULL, 1, &barrier);
-
   if (!atlrEndSingleRecordCommands(commandBuffer, commandContext))
   {
     ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
@@ -153,7 +266,21 @@ AtlrU8 atlrTransitionImageLayout(const AtlrImage* restrict image, const VkImageL
   return 1;
 }
 
-AtlrU8 atlrInitImage(AtlrImage* restrict image, const AtlrU32 width, const AtlrU32 height,
+// the number of levels in a full mip chain down to 1x1
+AtlrU32 atlrGetMipLevelCount(const AtlrU32 width, const AtlrU32 height)
+{
+  AtlrU32 size = (width > height) ? width : height;
+  AtlrU32 mipLevels = 1;
+  while (size > 1)
+  {
+    size >>= 1;
+    mipLevels++;
+  }
+  
+  return mipLevels;
+}
+
+AtlrU8 atlrInitImage(AtlrImage* restrict image, const AtlrU32 width, const AtlrU32 height, const AtlrU32 mipLevels,
 		     const AtlrU32 layerCount, const VkSampleCountFlagBits samples, const VkFormat format, const VkImageTiling tiling, const VkImageUsageFlags usage,
 		     const VkMemoryPropertyFlags properties, const VkImageViewType viewType, const VkImageAspectFlags aspects,
 		     const AtlrDevice* restrict device)
@@ -173,7 +300,7 @@ AtlrU8 atlrInitImage(AtlrImage* restrict image, const AtlrU32 width, const AtlrU
       .height = height,
       .depth = 1
     },
-    .mipLevels = 1,
+    .mipLevels = mipLevels,
     .arrayLayers = layerCount,
     .samples = samples,
     .tiling = tiling,
@@ -191,6 +318,7 @@ AtlrU8 atlrInitImage(AtlrImage* restrict image, const AtlrU32 width, const AtlrU
   image->format = format;
   image->width = width;
   image->height = height;
+  image->mipLevels = mipLevels;
   image->layerCount = layerCount;
 
   VkMemoryRequirements memoryRequirements;
@@ -220,7 +348,7 @@ AtlrU8 atlrInitImage(AtlrImage* restrict image, const AtlrU32 width, const AtlrU
     return 0;
   }
 
-  VkImageView imageView = atlrInitImageView(image->image, viewType, format, aspects, layerCount, device);
+  VkImageView imageView = atlrInitImageView(image->image, viewType, format, aspects, mipLevels, layerCount, device);
   if (imageView == VK_NULL_HANDLE)
   {
     ATLR_ERROR_MSG("atlrInitImageView returned VK_NULL_HANDLE.");
@@ -269,7 +397,9 @@ void atlrSetImageName(const AtlrImage* restrict image, const char* restrict imag
 }
 #endif
 
-AtlrU8 atlrInitImageRgbaTextureFromFile(AtlrImage* image, const char* filePath, const AtlrDevice* restrict device, const AtlrSingleRecordCommandContext* restrict commandContext)
+// with hasMips set the texture gets a full mip chain generated on the device
+AtlrU8 atlrInitImageRgbaTextureFromFile(AtlrImage* image, const char* filePath, const AtlrU8 hasMips,
+					const AtlrDevice* restrict device, const AtlrSingleRecordCommandContext* restrict commandContext)
 {
   int width, height, channels;
   stbi_uc* pixels = stbi_load(filePath, &width, &height, &channels, STBI_rgb_alpha);
@@ -280,9 +410,33 @@ AtlrU8 atlrInitImageRgbaTextureFromFile(AtlrImage* image, const char* filePath,
   }
 
   const VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
-  const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  const AtlrU32 mipLevels = hasMips ? atlrGetMipLevelCount(width, height) : 1;
   const VkMemoryPropertyFlags memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-  if (!atlrInitImage(image, width, height, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage, memoryProperties, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, device))
+
+  // Without mips the pixels can go straight from host memory into the image, with no staging buffer and no submissions.
+  // Mip generation needs the queue anyway, so mipmapped textures are always staged.
+  if (!hasMips && atlrIsHostImageCopySupported(format, VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, device))
+  {
+    const VkImageUsageFlags usage = VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (!atlrInitImage(image, width, height, 1, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage, memoryProperties, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, device))
+    {
+      ATLR_ERROR_MSG("atlrInitImage returned 0.");
+      stbi_image_free(pixels);
+      return 0;
+    }
+    const AtlrU8 isCopied = atlrHostCopyMemoryToImage(image, pixels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    stbi_image_free(pixels);
+    if (!isCopied)
+    {
+      ATLR_ERROR_MSG("atlrHostCopyMemoryToImage returned 0.");
+      return 0;
+    }
+
+    return 1;
+  }
+
+  const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (hasMips ? atlrGetMipmapImageUsage(device->physical, format) : 0);
+  if (!atlrInitImage(image, width, height, mipLevels, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage, memoryProperties, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, device))
   {
     ATLR_ERROR_MSG("atlrInitImage returned 0.");
     return 0;
@@ -310,7 +464,7 @@ AtlrU8 atlrInitImageRgbaTextureFromFile(AtlrImage* image, const char* filePath,
   const VkExtent2D extent          = {.width = width, .height = height};
   if (!atlrTransitionImageLayout(image, initLayout, secondLayout, commandContext) ||
       !atlrCopyBufferToImage(&stagingBuffer, image, &offset, &extent, commandContext) ||
-      !atlrTransitionImageLayout(image, secondLayout, finalLayout, commandContext))
+      (hasMips ? !atlrGenerateMipmaps(image, finalLayout, commandContext) : !atlrTransitionImageLayout(image, secondLayout, finalLayout, commandContext)))
   {
     ATLR_ERROR_MSG("Failed to stage texture image.");
     return 0;
@@ -186,14 +186,26 @@ static AtlrU8 areInstanceExtensionsAvailable(const char** restrict extensions, c
 }
 
 #ifdef ATLR_BUILD_HOST_HEADLESS
-AtlrU8 atlrInitInstanceHostHeadless(AtlrInstance* restrict instance, const char* restrict name)
+// The allocator is used for every host allocation made for the instance and its devices, or NULL for the driver's own.
+AtlrU8 atlrInitInstanceHostHeadless(AtlrInstance* restrict instance, const char* restrict name, VkAllocationCallbacks* allocator)
 {
   {
     AtlrInstance temp = {};
     *instance = temp;
   }
+  instance->allocator = allocator;
   atlrLog(ATLR_LOG_INFO, "Initializing Antler instance in host headless mode ...");
 
+  // the scratch arena comes first, so failing to create it leaves no Vulkan object or glslang process behind
+  instance->scratch = malloc(sizeof(AtlrArena));
+  if (!instance->scratch || !atlrInitArena(instance->scratch, ATLR_SCRATCH_ARENA_SIZE))
+  {
+    ATLR_ERROR_MSG("atlrInitArena returned 0.");
+    free(instance->scratch);
+    instance->scratch = NULL;
+    return 0;
+  }
+
   if (!glslang_initialize_process())
   {
     ATLR_ERROR_MSG("glslang_initialize_process returned 0.");
@@ -210,6 +222,7 @@ AtlrU8 atlrInitInstanceHostHeadless(AtlrInstance* restrict instance, const char*
     return 0;
   }
   instanceInfo.pApplicationInfo = &appInfo;
+  instance->apiVersion = appInfo.apiVersion;
 
   // validation layer
 #ifdef ATLR_DEBUG
@@ -276,6 +289,8 @@ void atlrDeinitInstanceHostHeadless(const AtlrInstance* restrict instance)
   deinitDebugMessenger(instance);
 #endif
   vkDestroyInstance(instance->instance, instance->allocator);
+  atlrDeinitArena(instance->scratch);
+  free(instance->scratch);
 
   glslang_finalize_process();
    
@@ -284,14 +299,26 @@ void atlrDeinitInstanceHostHeadless(const AtlrInstance* restrict instance)
 #endif
 
 #ifdef ATLR_BUILD_HOST_GLFW
-AtlrU8 atlrInitInstanceHostGLFW(AtlrInstance* restrict instance, const int width, const int height, const char* restrict name)
+// The allocator is used for every host allocation made for the instance and its devices, or NULL for the driver's own.
+AtlrU8 atlrInitInstanceHostGLFW(AtlrInstance* restrict instance, const int width, const int height, const char* restrict name, VkAllocationCallbacks* allocator)
 {
   {
     AtlrInstance temp = {};
     *instance = temp;
   }
+  instance->allocator = allocator;
   atlrLog(ATLR_LOG_INFO, "Initializing Antler instance in GLFW mode ...");
 
+  // the scratch arena comes first, so failing to create it leaves no Vulkan object or glslang process behind
+  instance->scratch = malloc(sizeof(AtlrArena));
+  if (!instance->scratch || !atlrInitArena(instance->scratch, ATLR_SCRATCH_ARENA_SIZE))
+  {
+    ATLR_ERROR_MSG("atlrInitArena returned 0.");
+    free(instance->scratch);
+    instance->scratch = NULL;
+    return 0;
+  }
+
   if (!glslang_initialize_process())
   {
     ATLR_ERROR_MSG("glslang_initialize_process returned 0.");
@@ -321,6 +348,7 @@ AtlrU8 atlrInitInstanceHostGLFW(AtlrInstance* restrict instance, const int width
     return 0;
   }
   instanceInfo.pApplicationInfo = &appInfo;
+  instance->apiVersion = appInfo.apiVersion;
 
   // validation layer
 #ifdef ATLR_DEBUG
@@ -394,6 +422,8 @@ void atlrDeinitInstanceHostGLFW(const AtlrInstance* restrict instance)
   deinitDebugMessenger(instance);
 #endif
   vkDestroyInstance(instance->instance, instance->allocator);
+  atlrDeinitArena(instance->scratch);
+  free(instance->scratch);
 
   GLFWwindow* window = instance->data;
   glfwDestroyWindow(window);
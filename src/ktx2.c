@@ -0,0 +1,393 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+#include <stdio.h>
+#include <string.h>
+
+// a 2D image has at most one level per bit of its extent
+#define MAX_LEVEL_COUNT 32
+
+static const AtlrU8 ktx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+// The fixed part of a KTX2 file, followed by the level index.
+// KTX2 is little endian, as is every host antler runs on, so both are read straight into these structures.
+typedef struct _Ktx2Header
+{
+  AtlrU8 identifier[12];
+  AtlrU32 vkFormat;
+  AtlrU32 typeSize;
+  AtlrU32 pixelWidth;
+  AtlrU32 pixelHeight;
+  AtlrU32 pixelDepth;
+  AtlrU32 layerCount;
+  AtlrU32 faceCount;
+  AtlrU32 levelCount;
+  AtlrU32 supercompressionScheme;
+  AtlrU32 dfdByteOffset;
+  AtlrU32 dfdByteLength;
+  AtlrU32 kvdByteOffset;
+  AtlrU32 kvdByteLength;
+  AtlrU64 sgdByteOffset;
+  AtlrU64 sgdByteLength;
+  
+} Ktx2Header;
+
+typedef struct _Ktx2Level
+{
+  AtlrU64 byteOffset;
+  AtlrU64 byteLength;
+  AtlrU64 uncompressedByteLength;
+  
+} Ktx2Level;
+
+// bytes per 4x4 block of the block-compressed formats the loader accepts, 0 for any other format
+AtlrU32 atlrGetCompressedFormatBlockSize(const VkFormat format)
+{
+  switch (format)
+  {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+      return 8;
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+// A block-compressed format is usable when its compression feature was enabled on the device
+// and the physical device can sample it with linear filtering from optimally tiled images.
+AtlrU8 atlrIsCompressedFormatSupported(const VkFormat format, const AtlrDevice* restrict device)
+{
+  if (!atlrGetCompressedFormatBlockSize(format)) return 0;
+
+  const AtlrU8 isBC = (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK) && (format <= VK_FORMAT_BC7_SRGB_BLOCK);
+  if (isBC ? !device->features.textureCompressionBC : !device->features.textureCompressionETC2) return 0;
+
+  const VkFormatFeatureFlags features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+  VkFormatProperties properties;
+  vkGetPhysicalDeviceFormatProperties(device->physical, format, &properties);
+  return (properties.optimalTilingFeatures & features) == features;
+}
+
+// only single 2D images without supercompression are accepted; the data must be uploadable as stored
+static AtlrU8 readKtx2Header(Ktx2Header* restrict header, FILE* file, const char* restrict filePath)
+{
+  if (fread(header, sizeof(Ktx2Header), 1, file) != 1 || memcmp(header->identifier, ktx2Identifier, sizeof(ktx2Identifier)))
+  {
+    atlrLog(ATLR_LOG_WARN, "\"%s\" is not a KTX2 file.", filePath);
+    return 0;
+  }
+
+  if (!header->pixelWidth || !header->pixelHeight || header->pixelDepth || header->layerCount > 1 || header->faceCount != 1)
+  {
+    atlrLog(ATLR_LOG_WARN, "The KTX2 file \"%s\" does not hold a single 2D image.", filePath);
+    return 0;
+  }
+
+  if (header->supercompressionScheme)
+  {
+    atlrLog(ATLR_LOG_WARN, "The KTX2 file \"%s\" is supercompressed, which is not supported.", filePath);
+    return 0;
+  }
+
+  if (!atlrGetCompressedFormatBlockSize(header->vkFormat))
+  {
+    atlrLog(ATLR_LOG_WARN, "The KTX2 file \"%s\" is not block-compressed.", filePath);
+    return 0;
+  }
+
+  // a level count of 0 asks the loader to generate mips, which block-compressed formats cannot do
+  if (!header->levelCount) header->levelCount = 1;
+  if (header->levelCount > atlrGetMipLevelCount(header->pixelWidth, header->pixelHeight))
+  {
+    atlrLog(ATLR_LOG_WARN, "The KTX2 file \"%s\" has more levels than its extent allows.", filePath);
+    return 0;
+  }
+
+  return 1;
+}
+
+static AtlrU32 getLevelExtent(const AtlrU32 extent, const AtlrU32 level)
+{
+  const AtlrU32 levelExtent = extent >> level;
+  return levelExtent ? levelExtent : 1;
+}
+
+// Open a KTX2 file and read its level index; the file stays open so that levels can be read on demand.
+AtlrU8 atlrInitKtx2File(AtlrKtx2File* restrict ktx2, const char* restrict filePath)
+{
+  FILE* file = fopen(filePath, "rb");
+  if (!file)
+  {
+    atlrLog(ATLR_LOG_WARN, "Failed to open the KTX2 file \"%s\".", filePath);
+    return 0;
+  }
+
+  Ktx2Header header;
+  if (!readKtx2Header(&header, file, filePath))
+  {
+    fclose(file);
+    return 0;
+  }
+
+  const AtlrU32 levelCount = header.levelCount;
+  Ktx2Level* levels = malloc(levelCount * sizeof(Ktx2Level));
+  if (fread(levels, sizeof(Ktx2Level), levelCount, file) != levelCount)
+  {
+    atlrLog(ATLR_LOG_WARN, "Failed to read the level index of the KTX2 file \"%s\".", filePath);
+    free(levels);
+    fclose(file);
+    return 0;
+  }
+
+  ktx2->file = file;
+  ktx2->format = header.vkFormat;
+  ktx2->width = header.pixelWidth;
+  ktx2->height = header.pixelHeight;
+  ktx2->levelCount = levelCount;
+  ktx2->levelOffsets = malloc(levelCount * sizeof(AtlrU64));
+  ktx2->levelLengths = malloc(levelCount * sizeof(AtlrU64));
+
+  // every level must hold all of its blocks at an offset that is a valid buffer offset for the copy
+  const AtlrU32 blockSize = atlrGetCompressedFormatBlockSize(header.vkFormat);
+  for (AtlrU32 i = 0; i < levelCount; i++)
+  {
+    const AtlrU32 width = getLevelExtent(header.pixelWidth, i);
+    const AtlrU32 height = getLevelExtent(header.pixelHeight, i);
+    const AtlrU64 length = (AtlrU64)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+    if (levels[i].byteLength < length || levels[i].byteOffset % blockSize)
+    {
+      atlrLog(ATLR_LOG_WARN, "The KTX2 file \"%s\" has an invalid level index.", filePath);
+      free(levels);
+      atlrDeinitKtx2File(ktx2);
+      return 0;
+    }
+    ktx2->levelOffsets[i] = levels[i].byteOffset;
+    ktx2->levelLengths[i] = length;
+  }
+  free(levels);
+
+  return 1;
+}
+
+void atlrDeinitKtx2File(const AtlrKtx2File* restrict ktx2)
+{
+  fclose(ktx2->file);
+  free(ktx2->levelOffsets);
+  free(ktx2->levelLengths);
+}
+
+// the bytes taken by the levels from baseLevel to the end of the mip chain, laid out back to back as they are staged
+AtlrU64 atlrGetKtx2LevelsSize(const AtlrKtx2File* restrict ktx2, const AtlrU32 baseLevel)
+{
+  AtlrU64 size = 0;
+  for (AtlrU32 i = baseLevel; i < ktx2->levelCount; i++)
+    size += ktx2->levelLengths[i];
+  return size;
+}
+
+// Record the upload of the file's levels from baseLevel up to endLevel into an image whose level 0 holds the file's imageBaseLevel.
+// The levels are read from the file straight into a new mapped staging buffer, which must outlive the recorded commands;
+// no decoding happens on the host. The image levels must be in the transfer destination layout.
+AtlrU8 atlrCommandCopyKtx2Levels(const VkCommandBuffer commandBuffer, AtlrBuffer* restrict stagingBuffer, const AtlrImage* restrict image, const AtlrU32 imageBaseLevel,
+				 const AtlrKtx2File* restrict ktx2, const AtlrU32 baseLevel, const AtlrU32 endLevel)
+{
+  if (baseLevel < imageBaseLevel || baseLevel >= endLevel || endLevel > ktx2->levelCount)
+  {
+    ATLR_ERROR_MSG("The levels are not part of both the KTX2 file and the image.");
+    return 0;
+  }
+
+  // block sizes are multiples of 4, so levels staged back to back keep valid buffer offsets
+  const AtlrU32 levelCount = endLevel - baseLevel;
+  const AtlrU64 size = atlrGetKtx2LevelsSize(ktx2, baseLevel) - atlrGetKtx2LevelsSize(ktx2, endLevel);
+  if (!atlrInitStagingBuffer(stagingBuffer, size, image->device))
+  {
+    ATLR_ERROR_MSG("atlrInitStagingBuffer returned 0.");
+    return 0;
+  }
+  if (!atlrMapBuffer(stagingBuffer, 0, size, 0))
+  {
+    ATLR_ERROR_MSG("atlrMapBuffer returned 0.");
+    atlrDeinitBuffer(stagingBuffer);
+    return 0;
+  }
+
+  // the level count of a file is bounded by its extent, so the regions fit on the stack
+  VkBufferImageCopy regions[MAX_LEVEL_COUNT];
+  AtlrU8 isRead = 1;
+  AtlrU64 offset = 0;
+  for (AtlrU32 i = 0; i < levelCount && isRead; i++)
+  {
+    const AtlrU32 level = baseLevel + i;
+    const AtlrU64 length = ktx2->levelLengths[level];
+    isRead = !fseek(ktx2->file, (long)ktx2->levelOffsets[level], SEEK_SET) && fread((AtlrU8*)stagingBuffer->data + offset, 1, length, ktx2->file) == length;
+    regions[i] = (VkBufferImageCopy)
+    {
+      .bufferOffset = offset,
+      .bufferRowLength = 0,
+      .bufferImageHeight = 0,
+      .imageSubresource = (VkImageSubresourceLayers)
+      {
+	.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	.mipLevel = level - imageBaseLevel,
+	.baseArrayLayer = 0,
+	.layerCount = 1
+      },
+      .imageOffset = (VkOffset3D){.x = 0, .y = 0, .z = 0},
+      .imageExtent = (VkExtent3D)
+      {
+	.width = getLevelExtent(ktx2->width, level),
+	.height = getLevelExtent(ktx2->height, level),
+	.depth = 1
+      }
+    };
+    offset += length;
+  }
+  atlrUnmapBuffer(stagingBuffer);
+  if (!isRead)
+  {
+    ATLR_ERROR_MSG("Failed to read the levels of the KTX2 file.");
+    atlrDeinitBuffer(stagingBuffer);
+    return 0;
+  }
+
+  image->device->pfnCmdCopyBufferToImage(commandBuffer, stagingBuffer->buffer, image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levelCount, regions);
+
+  return 1;
+}
+
+// Create an image holding the levels from baseLevel to the end of the mip chain, so its level 0 is the file's baseLevel.
+// The levels are transitioned, copied and made shader readable in one submission that is waited on.
+// The image is created with the given usage on top of the transfer destination and sampled usage the upload needs.
+AtlrU8 atlrInitImageKtx2Levels(AtlrImage* restrict image, const AtlrKtx2File* restrict ktx2, const AtlrU32 baseLevel, const VkImageUsageFlags usage,
+			       const AtlrDevice* restrict device, const AtlrSingleRecordCommandContext* restrict commandContext)
+{
+  if (baseLevel >= ktx2->levelCount)
+  {
+    ATLR_ERROR_MSG("The base level is past the mip chain of the KTX2 file.");
+    return 0;
+  }
+
+  const AtlrU32 levelCount = ktx2->levelCount - baseLevel;
+  const VkImageUsageFlags imageUsage = usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  if (!atlrInitImage(image, getLevelExtent(ktx2->width, baseLevel), getLevelExtent(ktx2->height, baseLevel), levelCount, 1, VK_SAMPLE_COUNT_1_BIT,
+		     ktx2->format, VK_IMAGE_TILING_OPTIMAL, imageUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, device))
+  {
+    ATLR_ERROR_MSG("atlrInitImage returned 0.");
+    return 0;
+  }
+
+  const VkImageSubresourceRange range =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = levelCount,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  VkCommandBuffer commandBuffer;
+  if (!atlrBeginSingleRecordCommands(&commandBuffer, commandContext))
+  {
+    ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+    atlrDeinitImage(image);
+    return 0;
+  }
+  AtlrBuffer stagingBuffer;
+  atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, device);
+  if (!atlrCommandCopyKtx2Levels(commandBuffer, &stagingBuffer, image, baseLevel, ktx2, baseLevel, ktx2->levelCount))
+  {
+    ATLR_ERROR_MSG("atlrCommandCopyKtx2Levels returned 0.");
+    atlrEndSingleRecordCommands(commandBuffer, commandContext);
+    atlrDeinitImage(image);
+    return 0;
+  }
+  atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, device);
+  if (!atlrEndSingleRecordCommands(commandBuffer, commandContext))
+  {
+    ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+    atlrDeinitBuffer(&stagingBuffer);
+    atlrDeinitImage(image);
+    return 0;
+  }
+
+  atlrDeinitBuffer(&stagingBuffer);
+
+  return 1;
+}
+
+// Load the first of the given KTX2 files whose format the device supports; the same texture can ship in several encodings,
+// for example BC7 and ETC2, listed in order of preference. The stored mip levels are uploaded without decoding on the host.
+AtlrU8 atlrInitImageKtx2TextureFromFiles(AtlrImage* restrict image, const AtlrU32 fileCount, const char* const* filePaths,
+					 const AtlrDevice* restrict device, const AtlrSingleRecordCommandContext* restrict commandContext)
+{
+  for (AtlrU32 i = 0; i < fileCount; i++)
+  {
+    const char* filePath = filePaths[i];
+    AtlrKtx2File ktx2;
+    if (!atlrInitKtx2File(&ktx2, filePath)) continue;
+    if (!atlrIsCompressedFormatSupported(ktx2.format, device))
+    {
+      atlrLog(ATLR_LOG_INFO, "The format %u of the KTX2 file \"%s\" is not supported by the device.", ktx2.format, filePath);
+      atlrDeinitKtx2File(&ktx2);
+      continue;
+    }
+
+    const AtlrU8 isUploaded = atlrInitImageKtx2Levels(image, &ktx2, 0, 0, device, commandContext);
+    atlrDeinitKtx2File(&ktx2);
+    if (!isUploaded)
+    {
+      ATLR_ERROR_MSG("atlrInitImageKtx2Levels returned 0.");
+      return 0;
+    }
+
+    atlrLog(ATLR_LOG_INFO, "Loaded the KTX2 texture \"%s\" with %u levels of format %u.", filePath, image->mipLevels, image->format);
+    return 1;
+  }
+
+  ATLR_ERROR_MSG("None of the KTX2 files have a format supported by the device.");
+  return 0;
+}
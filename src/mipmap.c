@@ -0,0 +1,496 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+#include <stdio.h>
+#include <string.h>
+
+// Each invocation averages a 2x2 block of the previous level; the last row and column are clamped for odd extents.
+// The storage format qualifier is filled in for the image being downsampled.
+static const char* downsampleShaderSource =
+  "#version 460\n"
+  "layout(local_size_x = 8, local_size_y = 8) in;\n"
+  "layout(binding = 0) uniform sampler2D srcLevel;\n"
+  "layout(binding = 1, %s) uniform writeonly image2D dstLevel;\n"
+  "layout(push_constant) uniform Extents { ivec2 src; ivec2 dst; } extents;\n"
+  "void main()\n"
+  "{\n"
+  "  const ivec2 texel = ivec2(gl_GlobalInvocationID.xy);\n"
+  "  if (any(greaterThanEqual(texel, extents.dst))) return;\n"
+  "  const ivec2 last = extents.src - 1;\n"
+  "  const ivec2 base = 2 * texel;\n"
+  "  const vec4 sum = texelFetch(srcLevel, min(base, last), 0) + texelFetch(srcLevel, min(base + ivec2(1, 0), last), 0)\n"
+  "    + texelFetch(srcLevel, min(base + ivec2(0, 1), last), 0) + texelFetch(srcLevel, min(base + ivec2(1, 1), last), 0);\n"
+  "  imageStore(dstLevel, texel, 0.25 * sum);\n"
+  "}\n";
+
+// the storage image formats the compute path can write, limited to float, unorm and snorm formats
+static const char* getStorageFormatQualifier(const VkFormat format)
+{
+  switch (format)
+  {
+    case VK_FORMAT_R8G8B8A8_UNORM:           return "rgba8";
+    case VK_FORMAT_R8G8B8A8_SNORM:           return "rgba8_snorm";
+    case VK_FORMAT_R8G8_UNORM:               return "rg8";
+    case VK_FORMAT_R8_UNORM:                 return "r8";
+    case VK_FORMAT_R16G16B16A16_UNORM:       return "rgba16";
+    case VK_FORMAT_R16G16B16A16_SFLOAT:      return "rgba16f";
+    case VK_FORMAT_R16G16_UNORM:             return "rg16";
+    case VK_FORMAT_R16G16_SFLOAT:            return "rg16f";
+    case VK_FORMAT_R16_UNORM:                return "r16";
+    case VK_FORMAT_R16_SFLOAT:               return "r16f";
+    case VK_FORMAT_R32G32B32A32_SFLOAT:      return "rgba32f";
+    case VK_FORMAT_R32G32_SFLOAT:            return "rg32f";
+    case VK_FORMAT_R32_SFLOAT:               return "r32f";
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32: return "rgb10_a2";
+    case VK_FORMAT_B10G11R11_UFLOAT_PACK32:  return "r11f_g11f_b10f";
+    default:                                 return NULL;
+  }
+}
+
+static AtlrU8 isMipmapComputeSupported(const VkPhysicalDevice physical, const VkFormat format)
+{
+  VkFormatProperties properties;
+  vkGetPhysicalDeviceFormatProperties(physical, format, &properties);
+  return getStorageFormatQualifier(format) && (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
+}
+
+AtlrU8 atlrIsMipmapBlitSupported(const VkPhysicalDevice physical, const VkFormat format)
+{
+  const VkFormatFeatureFlags features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+  VkFormatProperties properties;
+  vkGetPhysicalDeviceFormatProperties(physical, format, &properties);
+  return (properties.optimalTilingFeatures & features) == features;
+}
+
+// the usage flags an image needs, besides the transfer destination and sampled bits, to have its mips generated
+VkImageUsageFlags atlrGetMipmapImageUsage(const VkPhysicalDevice physical, const VkFormat format)
+{
+  if (atlrIsMipmapBlitSupported(physical, format)) return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  if (isMipmapComputeSupported(physical, format)) return VK_IMAGE_USAGE_STORAGE_BIT;
+  return 0;
+}
+
+static AtlrU32 getMipExtent(const AtlrU32 extent, const AtlrU32 level)
+{
+  const AtlrU32 mipExtent = extent >> level;
+  return mipExtent ? mipExtent : 1;
+}
+
+// Record the mip chain generation with linear blits, each level downsampled from the one before it.
+// Every level must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL with level 0 written, and all end up in finalLayout.
+AtlrU8 atlrCommandGenerateMipmapsBlit(const VkCommandBuffer commandBuffer, const AtlrImage* restrict image, const VkImageLayout finalLayout)
+{
+  VkImageSubresourceRange range =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = image->layerCount
+  };
+  
+  for (AtlrU32 i = 1; i < image->mipLevels; i++)
+  {
+    range.baseMipLevel = i - 1;
+    if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image->device))
+    {
+      ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+      return 0;
+    }
+
+    const VkImageBlit blit =
+    {
+      .srcSubresource = (VkImageSubresourceLayers)
+      {
+	.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	.mipLevel = i - 1,
+	.baseArrayLayer = 0,
+	.layerCount = image->layerCount
+      },
+      .srcOffsets = {{0, 0, 0}, {getMipExtent(image->width, i - 1), getMipExtent(image->height, i - 1), 1}},
+      .dstSubresource = (VkImageSubresourceLayers)
+      {
+	.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	.mipLevel = i,
+	.baseArrayLayer = 0,
+	.layerCount = image->layerCount
+      },
+      .dstOffsets = {{0, 0, 0}, {getMipExtent(image->width, i), getMipExtent(image->height, i), 1}}
+    };
+    image->device->pfnCmdBlitImage(commandBuffer, image->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+    if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, finalLayout, image->device))
+    {
+      ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+      return 0;
+    }
+  }
+
+  range.baseMipLevel = image->mipLevels - 1;
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout, image->device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// the transient objects of the compute path, all null handles until created
+typedef struct _MipmapCompute
+{
+  const AtlrDevice* device;
+  VkSampler sampler;
+  AtlrDescriptorSetLayout setLayout;
+  AtlrDescriptorPool pool;
+  VkDescriptorSet* sets;
+  AtlrPipeline pipeline;
+  VkImageView* levelViews;
+  AtlrU32 levelCount;
+  
+} MipmapCompute;
+
+static VkImageView initLevelView(const AtlrImage* restrict image, const AtlrU32 level)
+{
+  const AtlrDevice* device = image->device;
+  
+  const VkImageViewCreateInfo imageViewInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .image = image->image,
+    .viewType = VK_IMAGE_VIEW_TYPE_2D,
+    .format = image->format,
+    .components = (VkComponentMapping)
+    {
+      .r = VK_COMPONENT_SWIZZLE_IDENTITY,
+      .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+      .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+      .a = VK_COMPONENT_SWIZZLE_IDENTITY
+    },
+    .subresourceRange = (VkImageSubresourceRange)
+    {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = level,
+      .levelCount = 1,
+      .baseArrayLayer = 0,
+      .layerCount = 1
+    }
+  };
+  VkImageView imageView;
+  if(vkCreateImageView(device->logical, &imageViewInfo, device->instance->allocator, &imageView) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateImageView did not return VK_SUCCESS.");
+    return VK_NULL_HANDLE;
+  }
+
+  return imageView;
+}
+
+static VkShaderModule initDownsampleShaderModule(const VkFormat format, const AtlrDevice* restrict device)
+{
+  char glsl[2048];
+  snprintf(glsl, sizeof(glsl), downsampleShaderSource, getStorageFormatQualifier(format));
+  
+  AtlrSpirVBinary bin;
+  if (!atlrInitSpirVBinary(&bin, GLSLANG_STAGE_COMPUTE, glsl, "mipmap downsample"))
+  {
+    ATLR_ERROR_MSG("atlrInitSpirVBinary returned 0.");
+    return VK_NULL_HANDLE;
+  }
+
+  const VkShaderModuleCreateInfo moduleInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .codeSize = bin.codeSize,
+    .pCode = bin.code
+  };
+  VkShaderModule module;
+  const VkResult result = vkCreateShaderModule(device->logical, &moduleInfo, device->instance->allocator, &module);
+  atlrDeinitSpirVBinary(&bin);
+  if (result != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateShaderModule did not return VK_SUCCESS.");
+    return VK_NULL_HANDLE;
+  }
+
+  return module;
+}
+
+static void deinitMipmapCompute(const MipmapCompute* restrict compute)
+{
+  const AtlrDevice* device = compute->device;
+
+  for (AtlrU32 i = 0; i < compute->levelCount; i++)
+    atlrDeinitImageView(compute->levelViews[i], device);
+  free(compute->levelViews);
+  atlrDeinitPipeline(&compute->pipeline);
+  atlrDeinitDescriptorPool(&compute->pool);
+  free(compute->sets);
+  atlrDeinitDescriptorSetLayout(&compute->setLayout);
+  if (compute->sampler) atlrReleaseSampler(device, compute->sampler);
+}
+
+static AtlrU8 initMipmapCompute(MipmapCompute* restrict compute, const AtlrImage* restrict image)
+{
+  const AtlrDevice* device = image->device;
+  const AtlrU32 setCount = image->mipLevels - 1;
+
+  // every handle starts out null, so a partially initialized compute path can always be deinitialized
+  memset(compute, 0, sizeof(MipmapCompute));
+  compute->device = device;
+  compute->setLayout.device = device;
+  compute->pool.device = device;
+  compute->pipeline.device = device;
+  compute->levelViews = calloc(image->mipLevels, sizeof(VkImageView));
+  compute->sets = calloc(setCount, sizeof(VkDescriptorSet));
+  if (!compute->levelViews || !compute->sets)
+  {
+    ATLR_ERROR_MSG("calloc returned NULL.");
+    return 0;
+  }
+
+  for (AtlrU32 i = 0; i < image->mipLevels; i++)
+  {
+    compute->levelViews[i] = initLevelView(image, i);
+    if (!compute->levelViews[i])
+    {
+      ATLR_ERROR_MSG("initLevelView returned VK_NULL_HANDLE.");
+      return 0;
+    }
+    compute->levelCount++;
+  }
+
+  // the previous level is only read with texelFetch, so any sampler will do
+  const VkSamplerCreateInfo samplerInfo = atlrInitSamplerInfo(VK_FILTER_NEAREST, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+  compute->sampler = atlrAcquireSampler(device, &samplerInfo);
+  if (!compute->sampler)
+  {
+    ATLR_ERROR_MSG("atlrAcquireSampler returned VK_NULL_HANDLE.");
+    return 0;
+  }
+
+  const VkDescriptorSetLayoutBinding bindings[2] =
+  {
+    atlrInitImmutableSamplerDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, &compute->sampler),
+    atlrInitDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+  };
+  if (!atlrInitDescriptorSetLayout(&compute->setLayout, 2, bindings, device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorSetLayout returned 0.");
+    return 0;
+  }
+
+  const VkDescriptorPoolSize poolSizes[2] =
+  {
+    atlrInitDescriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount),
+    atlrInitDescriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setCount)
+  };
+  if (!atlrInitDescriptorPool(&compute->pool, setCount, 2, poolSizes, device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorPool returned 0.");
+    return 0;
+  }
+
+  VkDescriptorSetLayout* setLayouts = malloc(setCount * sizeof(VkDescriptorSetLayout));
+  if (!setLayouts)
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    return 0;
+  }
+  for (AtlrU32 i = 0; i < setCount; i++) setLayouts[i] = compute->setLayout.layout;
+  const AtlrU8 isAllocated = atlrAllocDescriptorSets(&compute->pool, setCount, setLayouts, compute->sets);
+  free(setLayouts);
+  if (!isAllocated)
+  {
+    ATLR_ERROR_MSG("atlrAllocDescriptorSets returned 0.");
+    return 0;
+  }
+
+  // set i reads level i and writes level i + 1
+  for (AtlrU32 i = 0; i < setCount; i++)
+  {
+    const VkDescriptorImageInfo srcInfo =
+    {
+      .sampler = VK_NULL_HANDLE,
+      .imageView = compute->levelViews[i],
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    };
+    const VkDescriptorImageInfo dstInfo =
+    {
+      .sampler = VK_NULL_HANDLE,
+      .imageView = compute->levelViews[i + 1],
+      .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+    };
+    const VkWriteDescriptorSet writes[2] =
+    {
+      atlrWriteImageDescriptorSet(compute->sets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &srcInfo),
+      atlrWriteImageDescriptorSet(compute->sets[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &dstInfo)
+    };
+    vkUpdateDescriptorSets(device->logical, 2, writes, 0, NULL);
+  }
+
+  const VkShaderModule module = initDownsampleShaderModule(image->format, device);
+  if (!module)
+  {
+    ATLR_ERROR_MSG("initDownsampleShaderModule returned VK_NULL_HANDLE.");
+    return 0;
+  }
+  const VkPipelineShaderStageCreateInfo stageInfo = atlrInitPipelineShaderStageInfo(VK_SHADER_STAGE_COMPUTE_BIT, module);
+  const VkPushConstantRange pushConstantRange =
+  {
+    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+    .offset = 0,
+    .size = 4 * sizeof(AtlrI32)
+  };
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo = atlrInitPipelineLayoutInfo(1, &compute->setLayout.layout, 1, &pushConstantRange);
+  const AtlrU8 isPipelineInit = atlrInitComputePipeline(&compute->pipeline, &stageInfo, &pipelineLayoutInfo, device);
+  atlrDeinitShaderModule(module, device);
+  if (!isPipelineInit)
+  {
+    ATLR_ERROR_MSG("atlrInitComputePipeline returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static AtlrU8 commandGenerateMipmapsCompute(const VkCommandBuffer commandBuffer, const MipmapCompute* restrict compute, const AtlrImage* restrict image,
+					   const VkImageLayout finalLayout)
+{
+  VkImageSubresourceRange range =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, image->device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+  range.baseMipLevel = 1;
+  range.levelCount = image->mipLevels - 1;
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, image->device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+
+  const AtlrPipeline* pipeline = &compute->pipeline;
+  const AtlrDevice* device = pipeline->device;
+  device->pfnCmdBindPipeline(commandBuffer, pipeline->bindPoint, pipeline->pipeline);
+  range.levelCount = 1;
+  for (AtlrU32 i = 1; i < image->mipLevels; i++)
+  {
+    const AtlrI32 extents[4] =
+    {
+      getMipExtent(image->width, i - 1), getMipExtent(image->height, i - 1),
+      getMipExtent(image->width, i), getMipExtent(image->height, i)
+    };
+    device->pfnCmdBindDescriptorSets(commandBuffer, pipeline->bindPoint, pipeline->layout, 0, 1, compute->sets + i - 1, 0, NULL);
+    device->pfnCmdPushConstants(commandBuffer, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(extents), extents);
+    device->pfnCmdDispatch(commandBuffer, (extents[2] + 7) / 8, (extents[3] + 7) / 8, 1);
+
+    // the level just written is read by the next dispatch
+    range.baseMipLevel = i;
+    if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, image->device))
+    {
+      ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+      return 0;
+    }
+  }
+
+  if (finalLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+  {
+    range.baseMipLevel = 0;
+    range.levelCount = image->mipLevels;
+    if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, finalLayout, image->device))
+    {
+      ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+// Generate the mip chain of an image with level 0 written and every level in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL; all levels end up in finalLayout.
+// Linear blits are used when the format supports them, otherwise a compute shader downsamples each level,
+// which needs the image created with the usage from atlrGetMipmapImageUsage.
+AtlrU8 atlrGenerateMipmaps(const AtlrImage* restrict image, const VkImageLayout finalLayout, const AtlrSingleRecordCommandContext* restrict commandContext)
+{
+  const AtlrDevice* device = image->device;
+  
+  const AtlrU8 isCompute = (image->mipLevels > 1) && !atlrIsMipmapBlitSupported(device->physical, image->format);
+  if (isCompute && !isMipmapComputeSupported(device->physical, image->format))
+  {
+    ATLR_ERROR_MSG("The image format supports neither linear blits nor storage writes, so its mips cannot be generated.");
+    return 0;
+  }
+  if (isCompute && (image->layerCount > 1))
+  {
+    ATLR_ERROR_MSG("Compute mip generation only supports single layer images.");
+    return 0;
+  }
+
+  MipmapCompute compute;
+  if (isCompute && !initMipmapCompute(&compute, image))
+  {
+    ATLR_ERROR_MSG("initMipmapCompute returned 0.");
+    deinitMipmapCompute(&compute);
+    return 0;
+  }
+  
+  VkCommandBuffer commandBuffer;
+  if (!atlrBeginSingleRecordCommands(&commandBuffer, commandContext))
+  {
+    ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+    if (isCompute) deinitMipmapCompute(&compute);
+    return 0;
+  }
+  
+  const AtlrU8 isRecorded = isCompute ?
+    commandGenerateMipmapsCompute(commandBuffer, &compute, image, finalLayout) :
+    atlrCommandGenerateMipmapsBlit(commandBuffer, image, finalLayout);
+  
+  // the submission is waited on, so the compute objects are free to go afterwards
+  const AtlrU8 isEnded = atlrEndSingleRecordCommands(commandBuffer, commandContext);
+  if (isCompute) deinitMipmapCompute(&compute);
+  if (!isRecorded)
+  {
+    ATLR_ERROR_MSG("Recording the mip generation returned 0.");
+    return 0;
+  }
+  if (!isEnded)
+  {
+    ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
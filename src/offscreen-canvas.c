@@ -21,21 +21,21 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "offscreen-canvas.h"
 #include <stdio.h>
 
-AtlrU8 atlrInitOffscreenCanvas(AtlrOffscreenCanvas* restrict canvas, const VkExtent2D* restrict extent, const VkFormat colorFormat, const AtlrU8 initRenderPass, const VkClearValue* restrict clearColor,
-			       const AtlrDevice* restrict device)
+static AtlrU8 initOffscreenCanvas(AtlrOffscreenCanvas* restrict canvas, const VkExtent2D* restrict extent, const VkFormat colorFormat, const AtlrU8 initRenderPass,
+				  const AtlrDevice* restrict device)
 {
   canvas->device = device;
   canvas->extent = *extent;
-  VkClearValue clearValue = clearColor ? *clearColor : (VkClearValue){.color = {.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}};
   
   const VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
   const VkMemoryPropertyFlags memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
   const VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
 
   // color image
-  const VkImageUsageFlags colorUsage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  // transfer source usage lets the readback ring copy the attachments to the host
+  const VkImageUsageFlags colorUsage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
   const VkImageAspectFlags colorAspect =  VK_IMAGE_ASPECT_COLOR_BIT;
-  if (!atlrInitImage(&canvas->colorImage, extent->width, extent->height, 1, VK_SAMPLE_COUNT_1_BIT, colorFormat, tiling, colorUsage, memoryProperties, viewType, colorAspect, device))
+  if (!atlrInitImage(&canvas->colorImage, extent->width, extent->height, 1, 1, VK_SAMPLE_COUNT_1_BIT, colorFormat, tiling, colorUsage, memoryProperties, viewType, colorAspect, device))
   {
     ATLR_ERROR_MSG("atlrInitImage returned 0.");
     return 0;
@@ -51,9 +51,9 @@ AtlrU8 atlrInitOffscreenCanvas(AtlrOffscreenCanvas* restrict canvas, const VkExt
     ATLR_ERROR_MSG("atlrGetSupportedDepthImageFormat returned VK_FORMAT_UNDEFINED.");
     return 0;
   }
-  const VkImageUsageFlags depthUsage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  const VkImageUsageFlags depthUsage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
   const VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
-  if (!atlrInitImage(&canvas->depthImage, extent->width, extent->height, 1, VK_SAMPLE_COUNT_1_BIT, depthFormat, tiling, depthUsage, memoryProperties, viewType, depthAspect, device))
+  if (!atlrInitImage(&canvas->depthImage, extent->width, extent->height, 1, 1, VK_SAMPLE_COUNT_1_BIT, depthFormat, tiling, depthUsage, memoryProperties, viewType, depthAspect, device))
   {
     ATLR_ERROR_MSG("atlrInitImage returned 0.");
     return 0;
@@ -62,6 +62,13 @@ AtlrU8 atlrInitOffscreenCanvas(AtlrOffscreenCanvas* restrict canvas, const VkExt
   atlrSetImageName(&canvas->depthImage, "Offscreen Canvas Framebuffer Depth Image");
 #endif
 
+  // dynamic rendering renders into the image views directly
+  if (canvas->isDynamicRendering)
+  {
+    canvas->framebuffer = VK_NULL_HANDLE;
+    return 1;
+  }
+
   if (initRenderPass)
   {
     const VkAttachmentDescription colorAttachment = atlrGetColorAttachmentDescription(colorFormat, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -76,7 +83,7 @@ AtlrU8 atlrInitOffscreenCanvas(AtlrOffscreenCanvas* restrict canvas, const VkExt
       .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
       .dependencyFlags = 0
     };
-    if (!atlrInitRenderPass(&canvas->renderPass, 1, &colorAttachment, NULL, &clearValue, &depthAttachment, 1, &dependency, device))
+    if (!atlrInitRenderPass(&canvas->renderPass, 1, &colorAttachment, NULL, &canvas->clearColor, &depthAttachment, 1, &dependency, device))
     {
       ATLR_ERROR_MSG("atlrInitRenderPass returned 0.");
       return 0;
@@ -117,11 +124,114 @@ AtlrU8 atlrInitOffscreenCanvas(AtlrOffscreenCanvas* restrict canvas, const VkExt
   return 1;
 }
 
+AtlrU8 atlrInitOffscreenCanvas(AtlrOffscreenCanvas* restrict canvas, const VkExtent2D* restrict extent, const VkFormat colorFormat, const AtlrU8 initRenderPass, const VkClearValue* restrict clearColor,
+			       const AtlrDevice* restrict device)
+{
+  canvas->isDynamicRendering = 0;
+  canvas->clearColor = clearColor ? *clearColor : (VkClearValue){.color = {.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}};
+  if (!initOffscreenCanvas(canvas, extent, colorFormat, initRenderPass, device))
+  {
+    ATLR_ERROR_MSG("initOffscreenCanvas returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// No render pass or framebuffer is created; draw between atlrOffscreenCanvasBeginRendering and atlrOffscreenCanvasEndRendering.
+// The final layouts match the render pass path, so the images can be sampled the same way afterwards.
+AtlrU8 atlrInitDynamicRenderingOffscreenCanvas(AtlrOffscreenCanvas* restrict canvas, const VkExtent2D* restrict extent, const VkFormat colorFormat, const VkClearValue* restrict clearColor,
+					       const AtlrDevice* restrict device)
+{
+  if (!device->features.dynamicRendering)
+  {
+    ATLR_ERROR_MSG("Dynamic rendering is not enabled on the device.");
+    return 0;
+  }
+  
+  canvas->isDynamicRendering = 1;
+  canvas->clearColor = clearColor ? *clearColor : (VkClearValue){.color = {.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}};
+  if (!initOffscreenCanvas(canvas, extent, colorFormat, 0, device))
+  {
+    ATLR_ERROR_MSG("initOffscreenCanvas returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
 void atlrDeinitOffscreenCanvas(const AtlrOffscreenCanvas* restrict canvas, const AtlrU8 deinitRenderPass)
 {
   const AtlrDevice* device = canvas->device;
-  vkDestroyFramebuffer(device->logical, canvas->framebuffer, device->instance->allocator);
+  if (!canvas->isDynamicRendering)
+    vkDestroyFramebuffer(device->logical, canvas->framebuffer, device->instance->allocator);
   if (deinitRenderPass) atlrDeinitRenderPass(&canvas->renderPass);
   atlrDeinitImage(&canvas->depthImage);
   atlrDeinitImage(&canvas->colorImage);
 }
+
+AtlrU8 atlrOffscreenCanvasBeginRendering(const AtlrOffscreenCanvas* restrict canvas, const VkCommandBuffer commandBuffer)
+{
+  const VkImageSubresourceRange colorRange =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  const VkImageSubresourceRange depthRange =
+  {
+    .aspectMask = atlrGetDepthImageAspects(canvas->depthImage.format),
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, canvas->colorImage.image, &colorRange, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, canvas->device)
+      || !atlrCommandImageLayoutBarrier(commandBuffer, canvas->depthImage.image, &depthRange, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, canvas->device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+
+  const VkExtent2D* extent = &canvas->extent;
+  const VkRenderingAttachmentInfo colorAttachment = atlrGetColorRenderingAttachmentInfo(canvas->colorImage.imageView, VK_NULL_HANDLE, &canvas->clearColor);
+  const VkRenderingAttachmentInfo depthAttachment = atlrGetDepthRenderingAttachmentInfo(canvas->depthImage.imageView);
+  atlrBeginRendering(commandBuffer, 1, &colorAttachment, &depthAttachment, extent, canvas->device);
+  atlrCommandSetViewport(commandBuffer, extent->width, extent->height, canvas->device);
+  VkOffset2D offset = (VkOffset2D){.x = 0, .y = 0};
+  atlrCommandSetScissor(commandBuffer, &offset, extent, canvas->device);
+
+  return 1;
+}
+
+AtlrU8 atlrOffscreenCanvasEndRendering(const AtlrOffscreenCanvas* restrict canvas, const VkCommandBuffer commandBuffer)
+{
+  atlrEndRendering(commandBuffer, canvas->device);
+  
+  const VkImageSubresourceRange colorRange =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  const VkImageSubresourceRange depthRange =
+  {
+    .aspectMask = atlrGetDepthImageAspects(canvas->depthImage.format),
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, canvas->colorImage.image, &colorRange, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, canvas->device)
+      || !atlrCommandImageLayoutBarrier(commandBuffer, canvas->depthImage.image, &depthRange, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, canvas->device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
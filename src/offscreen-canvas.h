@@ -9,21 +9,87 @@ typedef struct _AtlrOffscreenCanvas
   AtlrImage depthImage;
   AtlrRenderPass renderPass;
   VkFramebuffer framebuffer;
+  AtlrU8 isDynamicRendering;
+  VkClearValue clearColor;
   
 } AtlrOffscreenCanvas;
 
 AtlrU8 atlrInitOffscreenCanvas(AtlrOffscreenCanvas* restrict, const VkExtent2D* restrict extent, const VkFormat colorFormat, const AtlrU8 initRenderPass, const VkClearValue* restrict clearColor,
 				const AtlrDevice* restrict);
+AtlrU8 atlrInitDynamicRenderingOffscreenCanvas(AtlrOffscreenCanvas* restrict, const VkExtent2D* restrict extent, const VkFormat colorFormat, const VkClearValue* restrict clearColor,
+					       const AtlrDevice* restrict);
 void atlrDeinitOffscreenCanvas(const AtlrOffscreenCanvas* restrict, const AtlrU8 deinitRenderPass);
+AtlrU8 atlrOffscreenCanvasBeginRendering(const AtlrOffscreenCanvas* restrict, const VkCommandBuffer);
+AtlrU8 atlrOffscreenCanvasEndRendering(const AtlrOffscreenCanvas* restrict, const VkCommandBuffer);
 static inline void atlrOffscreenCanvasBeginRenderPass(const AtlrOffscreenCanvas* restrict canvas, const VkCommandBuffer commandBuffer)
 {
   const VkExtent2D* extent = &canvas->extent;
   atlrBeginRenderPass(&canvas->renderPass, commandBuffer, canvas->framebuffer, extent);
-  atlrCommandSetViewport(commandBuffer, extent->width, extent->height);
+  atlrCommandSetViewport(commandBuffer, extent->width, extent->height, canvas->device);
   VkOffset2D offset = (VkOffset2D){.x = 0, .y = 0};
-  atlrCommandSetScissor(commandBuffer, &offset, extent);
+  atlrCommandSetScissor(commandBuffer, &offset, extent, canvas->device);
 }
-static inline void atlrOffscreenCanvasEndRenderPass(const VkCommandBuffer commandBuffer)
+static inline void atlrOffscreenCanvasEndRenderPass(const AtlrOffscreenCanvas* restrict canvas, const VkCommandBuffer commandBuffer)
 {
-  atlrEndRenderPass(commandBuffer);
+  atlrEndRenderPass(commandBuffer, canvas->device);
 }
+
+// canvas-readback.c
+
+// a frame read back from the canvas, valid until it is released
+typedef struct _AtlrCanvasReadbackFrame
+{
+  AtlrU64 index;
+  AtlrU32 width;
+  AtlrU32 height;
+  const AtlrU8* rgba; // RGBA8 texels, tightly packed rows
+  const float* depth; // NULL unless the readback copies depth
+  
+} AtlrCanvasReadbackFrame;
+
+typedef void (*AtlrCanvasReadbackCallback)(const AtlrCanvasReadbackFrame* restrict, void* userData);
+
+typedef struct _AtlrCanvasReadbackSlot
+{
+  VkCommandBuffer commandBuffer;
+  VkFence fence;
+  AtlrBuffer colorBuffer;
+  AtlrBuffer depthBuffer;
+  AtlrU64 index;
+  AtlrU8 isPending;
+  
+} AtlrCanvasReadbackSlot;
+
+// A ring of persistently mapped buffers the canvas attachments are copied into at the end of each frame.
+// Frames are submitted without waiting, so the host only blocks when every slot still holds an undelivered frame.
+typedef struct _AtlrCanvasReadback
+{
+  const AtlrOffscreenCanvas* canvas;
+  VkCommandPool commandPool;
+  AtlrU32 slotCount;
+  AtlrCanvasReadbackSlot* slots;
+  AtlrU32 head;
+  AtlrU32 tail;
+  AtlrU32 pendingCount;
+  AtlrU64 frameCount;
+  AtlrU8 isAcquired;
+  AtlrU8 hasDepth;
+  AtlrU8 isBgra;
+  AtlrU8 isPackedDepth;
+  AtlrU8 isCoherent;
+  AtlrU8* rgba;
+  float* depth;
+  AtlrCanvasReadbackCallback callback;
+  void* userData;
+  
+} AtlrCanvasReadback;
+
+AtlrU8 atlrInitCanvasReadback(AtlrCanvasReadback* restrict, const AtlrOffscreenCanvas* restrict, const AtlrU32 slotCount, const AtlrU8 hasDepth,
+			      const AtlrCanvasReadbackCallback callback, void* userData);
+void atlrDeinitCanvasReadback(AtlrCanvasReadback* restrict);
+VkCommandBuffer atlrBeginCanvasReadbackFrame(AtlrCanvasReadback* restrict);
+AtlrU8 atlrEndCanvasReadbackFrame(AtlrCanvasReadback* restrict);
+AtlrU8 atlrTryAcquireCanvasReadbackFrame(AtlrCanvasReadback* restrict, AtlrCanvasReadbackFrame* restrict);
+void atlrReleaseCanvasReadbackFrame(AtlrCanvasReadback* restrict);
+AtlrU32 atlrPollCanvasReadback(AtlrCanvasReadback* restrict);
+AtlrU8 atlrFlushCanvasReadback(AtlrCanvasReadback* restrict);
@@ -0,0 +1,341 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+#include "antler.h"
+#include <pthread.h>
+
+struct _AtlrPipelineLinkJob
+{
+  const AtlrDevice* device;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  AtlrU8 isDone;
+  VkResult result;
+  AtlrU32 libraryCount;
+  VkPipeline* libraries;
+  VkPipelineLayout layout;
+  VkPipeline pipeline;
+};
+
+static AtlrU8 initPipelineLibrary(AtlrPipelineLibrary* restrict library, const VkGraphicsPipelineLibraryFlagsEXT flags, VkGraphicsPipelineCreateInfo* restrict pipelineInfo,
+				  const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+				  const AtlrRenderPass* restrict renderPass, const VkPipelineRenderingCreateInfo* restrict renderingInfo,
+				  const AtlrDevice* restrict device)
+{
+  if (!device->features.graphicsPipelineLibrary)
+  {
+    ATLR_ERROR_MSG("The graphics pipeline library is not enabled on the device.");
+    return 0;
+  }
+  
+  library->device = device;
+  library->flags = flags;
+  library->layout = VK_NULL_HANDLE;
+  if (pipelineLayoutInfo && (vkCreatePipelineLayout(device->logical, pipelineLayoutInfo, device->instance->allocator, &library->layout) != VK_SUCCESS))
+  {
+    ATLR_ERROR_MSG("vkCreatePipelineLayout did not return VK_SUCCESS.");
+    return 0;
+  }
+
+  const VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+    .pNext = (void*)renderingInfo,
+    .flags = flags
+  };
+  pipelineInfo->sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipelineInfo->pNext = &libraryInfo;
+  // retaining the link-time optimization info allows an optimized link later on
+  pipelineInfo->flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+  pipelineInfo->layout = library->layout;
+  pipelineInfo->renderPass = renderPass ? renderPass->renderPass : VK_NULL_HANDLE;
+  pipelineInfo->subpass = 0;
+  pipelineInfo->basePipelineHandle = VK_NULL_HANDLE;
+  pipelineInfo->basePipelineIndex = -1;
+  if (vkCreateGraphicsPipelines(device->logical, VK_NULL_HANDLE, 1, pipelineInfo, device->instance->allocator, &library->pipeline) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateGraphicsPipelines did not return VK_SUCCESS.");
+    vkDestroyPipelineLayout(device->logical, library->layout, device->instance->allocator);
+    return 0;
+  }
+
+  return 1;
+}
+
+AtlrU8 atlrInitVertexInputPipelineLibrary(AtlrPipelineLibrary* restrict library,
+					  const VkPipelineVertexInputStateCreateInfo* restrict vertexInputInfo,
+					  const VkPipelineInputAssemblyStateCreateInfo* restrict inputAssemblyInfo,
+					  const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
+					  const AtlrDevice* restrict device)
+{
+  VkGraphicsPipelineCreateInfo pipelineInfo =
+  {
+    .pVertexInputState = vertexInputInfo,
+    .pInputAssemblyState = inputAssemblyInfo,
+    .pDynamicState = dynamicInfo
+  };
+  if (!initPipelineLibrary(library, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, &pipelineInfo, NULL, NULL, NULL, device))
+  {
+    ATLR_ERROR_MSG("initPipelineLibrary returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+AtlrU8 atlrInitPreRasterizationPipelineLibrary(AtlrPipelineLibrary* restrict library,
+					       const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict stageInfos,
+					       const VkPipelineTessellationStateCreateInfo* restrict tessellationInfo,
+					       const VkPipelineViewportStateCreateInfo* restrict viewportInfo,
+					       const VkPipelineRasterizationStateCreateInfo* restrict rasterizationInfo,
+					       const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
+					       const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+					       const AtlrRenderPass* restrict renderPass, const VkPipelineRenderingCreateInfo* restrict renderingInfo,
+					       const AtlrDevice* restrict device)
+{
+  VkGraphicsPipelineCreateInfo pipelineInfo =
+  {
+    .stageCount = stageCount,
+    .pStages = stageInfos,
+    .pTessellationState = tessellationInfo,
+    .pViewportState = viewportInfo,
+    .pRasterizationState = rasterizationInfo,
+    .pDynamicState = dynamicInfo
+  };
+  if (!initPipelineLibrary(library, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, &pipelineInfo, pipelineLayoutInfo, renderPass, renderingInfo, device))
+  {
+    ATLR_ERROR_MSG("initPipelineLibrary returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+AtlrU8 atlrInitFragmentShaderPipelineLibrary(AtlrPipelineLibrary* restrict library,
+					     const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict stageInfos,
+					     const VkPipelineMultisampleStateCreateInfo* restrict multisampleInfo,
+					     const VkPipelineDepthStencilStateCreateInfo* restrict depthStencilInfo,
+					     const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
+					     const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+					     const AtlrRenderPass* restrict renderPass, const VkPipelineRenderingCreateInfo* restrict renderingInfo,
+					     const AtlrDevice* restrict device)
+{
+  VkGraphicsPipelineCreateInfo pipelineInfo =
+  {
+    .stageCount = stageCount,
+    .pStages = stageInfos,
+    .pMultisampleState = multisampleInfo,
+    .pDepthStencilState = depthStencilInfo,
+    .pDynamicState = dynamicInfo
+  };
+  if (!initPipelineLibrary(library, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, &pipelineInfo, pipelineLayoutInfo, renderPass, renderingInfo, device))
+  {
+    ATLR_ERROR_MSG("initPipelineLibrary returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// the multisample state must match the one given to the fragment shader part
+AtlrU8 atlrInitFragmentOutputPipelineLibrary(AtlrPipelineLibrary* restrict library,
+					     const VkPipelineMultisampleStateCreateInfo* restrict multisampleInfo,
+					     const VkPipelineColorBlendStateCreateInfo* restrict colorBlendInfo,
+					     const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
+					     const AtlrRenderPass* restrict renderPass, const VkPipelineRenderingCreateInfo* restrict renderingInfo,
+					     const AtlrDevice* restrict device)
+{
+  VkGraphicsPipelineCreateInfo pipelineInfo =
+  {
+    .pMultisampleState = multisampleInfo,
+    .pColorBlendState = colorBlendInfo,
+    .pDynamicState = dynamicInfo
+  };
+  if (!initPipelineLibrary(library, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, &pipelineInfo, NULL, renderPass, renderingInfo, device))
+  {
+    ATLR_ERROR_MSG("initPipelineLibrary returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+void atlrDeinitPipelineLibrary(const AtlrPipelineLibrary* restrict library)
+{
+  const AtlrDevice* device = library->device;
+  vkDestroyPipelineLayout(device->logical, library->layout, device->instance->allocator);
+  vkDestroyPipeline(device->logical, library->pipeline, device->instance->allocator);
+}
+
+static VkResult linkPipeline(VkPipeline* restrict pipeline, const AtlrU32 libraryCount, const VkPipeline* restrict libraries, const VkPipelineLayout layout,
+			     const AtlrU8 isOptimized, const AtlrDevice* restrict device)
+{
+  const VkPipelineLibraryCreateInfoKHR libraryInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+    .pNext = NULL,
+    .libraryCount = libraryCount,
+    .pLibraries = libraries
+  };
+  const VkGraphicsPipelineCreateInfo pipelineInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+    .pNext = &libraryInfo,
+    .flags = isOptimized ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0,
+    .layout = layout,
+    .renderPass = VK_NULL_HANDLE,
+    .subpass = 0,
+    .basePipelineHandle = VK_NULL_HANDLE,
+    .basePipelineIndex = -1
+  };
+  return vkCreateGraphicsPipelines(device->logical, VK_NULL_HANDLE, 1, &pipelineInfo, device->instance->allocator, pipeline);
+}
+
+// Without optimization the link is fast enough to do on first use; the libraries must outlive the linked pipeline.
+AtlrU8 atlrLinkGraphicsPipeline(AtlrPipeline* restrict pipeline, const AtlrU32 libraryCount, const AtlrPipelineLibrary* restrict libraries,
+				const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo, const AtlrU8 isOptimized, const AtlrDevice* restrict device)
+{
+  pipeline->device = device;
+  
+  VkPipeline libraryPipelines[4];
+  if (libraryCount > 4)
+  {
+    ATLR_ERROR_MSG("A graphics pipeline is linked from at most 4 libraries.");
+    return 0;
+  }
+  for (AtlrU32 i = 0; i < libraryCount; i++)
+    libraryPipelines[i] = libraries[i].pipeline;
+
+  if (vkCreatePipelineLayout(device->logical, pipelineLayoutInfo, device->instance->allocator, &pipeline->layout) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreatePipelineLayout did not return VK_SUCCESS.");
+    return 0;
+  }
+  
+  if (linkPipeline(&pipeline->pipeline, libraryCount, libraryPipelines, pipeline->layout, isOptimized, device) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateGraphicsPipelines did not return VK_SUCCESS.");
+    vkDestroyPipelineLayout(device->logical, pipeline->layout, device->instance->allocator);
+    pipeline->layout = VK_NULL_HANDLE;
+    return 0;
+  }
+
+  pipeline->bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+  return 1;
+}
+
+static void* linkOptimizedPipeline(void* data)
+{
+  struct _AtlrPipelineLinkJob* job = data;
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  const VkResult result = linkPipeline(&pipeline, job->libraryCount, job->libraries, job->layout, 1, job->device);
+
+  pthread_mutex_lock(&job->mutex);
+  job->pipeline = pipeline;
+  job->result = result;
+  job->isDone = 1;
+  pthread_mutex_unlock(&job->mutex);
+
+  return NULL;
+}
+
+static void finishLinkJob(AtlrLinkedPipeline* restrict linked)
+{
+  struct _AtlrPipelineLinkJob* job = linked->job;
+  pthread_join(job->thread, NULL);
+  if (job->result == VK_SUCCESS)
+  {
+    linked->optimized = linked->fast;
+    linked->optimized.pipeline = job->pipeline;
+    linked->isOptimized = 1;
+  }
+  else
+    atlrLog(ATLR_LOG_WARN, "The optimized pipeline link failed; the fast-linked pipeline stays in use.");
+
+  pthread_mutex_destroy(&job->mutex);
+  free(job->libraries);
+  free(job);
+  linked->job = NULL;
+}
+
+// Fast link now and start the optimized link on a background thread.
+// The libraries must not be deinitialized before atlrDeinitLinkedPipeline.
+AtlrU8 atlrInitLinkedPipeline(AtlrLinkedPipeline* restrict linked, const AtlrU32 libraryCount, const AtlrPipelineLibrary* restrict libraries,
+			      const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo, const AtlrDevice* restrict device)
+{
+  linked->isOptimized = 0;
+  linked->job = NULL;
+  if (!atlrLinkGraphicsPipeline(&linked->fast, libraryCount, libraries, pipelineLayoutInfo, 0, device))
+  {
+    ATLR_ERROR_MSG("atlrLinkGraphicsPipeline returned 0.");
+    return 0;
+  }
+
+  struct _AtlrPipelineLinkJob* job = malloc(sizeof(struct _AtlrPipelineLinkJob));
+  job->device = device;
+  job->isDone = 0;
+  job->result = VK_NOT_READY;
+  job->libraryCount = libraryCount;
+  job->libraries = malloc(libraryCount * sizeof(VkPipeline));
+  for (AtlrU32 i = 0; i < libraryCount; i++)
+    job->libraries[i] = libraries[i].pipeline;
+  job->layout = linked->fast.layout;
+  job->pipeline = VK_NULL_HANDLE;
+  pthread_mutex_init(&job->mutex, NULL);
+  if (pthread_create(&job->thread, NULL, linkOptimizedPipeline, job))
+  {
+    // not fatal, the fast-linked pipeline is still valid
+    atlrLog(ATLR_LOG_WARN, "pthread_create failed; the pipeline will not be optimized.");
+    pthread_mutex_destroy(&job->mutex);
+    free(job->libraries);
+    free(job);
+    return 1;
+  }
+  linked->job = job;
+
+  return 1;
+}
+
+// Returns the optimized pipeline once its background link is done, otherwise the fast-linked pipeline.
+// Call when recording commands; the fast-linked pipeline stays alive until deinit so frames in flight can still use it.
+const AtlrPipeline* atlrGetLinkedPipeline(AtlrLinkedPipeline* restrict linked)
+{
+  struct _AtlrPipelineLinkJob* job = linked->job;
+  if (job)
+  {
+    pthread_mutex_lock(&job->mutex);
+    const AtlrU8 isDone = job->isDone;
+    pthread_mutex_unlock(&job->mutex);
+    if (isDone) finishLinkJob(linked);
+  }
+
+  return linked->isOptimized ? &linked->optimized : &linked->fast;
+}
+
+void atlrDeinitLinkedPipeline(AtlrLinkedPipeline* restrict linked)
+{
+  if (linked->job) finishLinkJob(linked);
+  
+  const AtlrDevice* device = linked->fast.device;
+  if (linked->isOptimized)
+    vkDestroyPipeline(device->logical, linked->optimized.pipeline, device->instance->allocator);
+  atlrDeinitPipeline(&linked->fast);
+}
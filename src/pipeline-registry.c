@@ -0,0 +1,937 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+// Objects are looked up by a hash of their creation state and matched by comparing the state itself, stored as a key with each entry.
+// The pNext chains of the state structures are not part of the key.
+// Handles are never part of a key since Vulkan may reuse them after destruction; shader modules and descriptor set layouts
+// must come from the registry and immutable samplers from the sampler cache, so the key holds their own keys instead.
+// Render passes are the exception, they are keyed by their compatibility hash.
+struct _AtlrPipelineRegistryEntry
+{
+  AtlrU64 hash;
+  AtlrU64 handle;
+  struct _AtlrPipelineRegistryEntry* next;       // in the bucket of its hash
+  struct _AtlrPipelineRegistryEntry* handleNext; // in the bucket of its handle
+  AtlrU32 refCount;
+  VkShaderModule module;
+  AtlrDescriptorSetLayout setLayout;
+  VkPipelineLayout pipelineLayout;
+  AtlrPipeline pipeline;
+  struct _AtlrPipelineRegistryEntry* layoutEntry;
+  AtlrU64 keySize;
+  AtlrU8 key[];
+};
+typedef struct _AtlrPipelineRegistryEntry AtlrPipelineRegistryEntry;
+
+#define TABLE_INITIAL_BUCKET_COUNT 16
+#define KEY_INITIAL_CAPACITY 1024
+
+// A key is written into the registry's key buffer, which is reused between lookups.
+typedef struct _KeyWriter
+{
+  AtlrPipelineRegistry* registry;
+  AtlrU64 size;
+  AtlrU8 isValid; // cleared when the key buffer cannot grow
+  
+} KeyWriter;
+
+static void initKeyWriter(KeyWriter* restrict writer, AtlrPipelineRegistry* restrict registry)
+{
+  writer->registry = registry;
+  writer->size = 0;
+  writer->isValid = 1;
+}
+
+static void appendKey(KeyWriter* restrict writer, const void* restrict data, const AtlrU64 size)
+{
+  if (!writer->isValid || !size) return;
+
+  AtlrPipelineRegistry* registry = writer->registry;
+  if (writer->size + size > registry->keyCapacity)
+  {
+    AtlrU64 capacity = registry->keyCapacity ? 2 * registry->keyCapacity : KEY_INITIAL_CAPACITY;
+    while (capacity < writer->size + size)
+      capacity *= 2;
+    AtlrU8* keyData = realloc(registry->keyData, capacity);
+    if (!keyData)
+    {
+      ATLR_ERROR_MSG("realloc returned NULL.");
+      writer->isValid = 0;
+      return;
+    }
+    registry->keyCapacity = capacity;
+    registry->keyData = keyData;
+  }
+
+  memcpy(registry->keyData + writer->size, data, size);
+  writer->size += size;
+}
+
+static void appendU32(KeyWriter* restrict writer, const AtlrU32 value)
+{
+  appendKey(writer, &value, sizeof(AtlrU32));
+}
+
+static void appendFloat(KeyWriter* restrict writer, const float value)
+{
+  appendKey(writer, &value, sizeof(float));
+}
+
+// absent state structures key differently from any present ones
+static void appendPresence(KeyWriter* restrict writer, const void* restrict state)
+{
+  appendU32(writer, state ? 1 : 0);
+}
+
+static void appendEntryKey(KeyWriter* restrict writer, const AtlrPipelineRegistryEntry* restrict entry)
+{
+  appendKey(writer, &entry->keySize, sizeof(AtlrU64));
+  appendKey(writer, entry->key, entry->keySize);
+}
+
+static AtlrU64 hashHandle(const AtlrU64 handle)
+{
+  return atlrHash(&handle, sizeof(AtlrU64), ATLR_HASH_SEED);
+}
+
+static AtlrU8 initTable(AtlrPipelineRegistryTable* restrict table)
+{
+  table->count = 0;
+  table->bucketCount = TABLE_INITIAL_BUCKET_COUNT;
+  table->buckets = calloc(2 * TABLE_INITIAL_BUCKET_COUNT, sizeof(AtlrPipelineRegistryEntry*));
+  if (!table->buckets)
+  {
+    ATLR_ERROR_MSG("calloc returned NULL.");
+    return 0;
+  }
+  table->handleBuckets = table->buckets + TABLE_INITIAL_BUCKET_COUNT;
+
+  return 1;
+}
+
+// the key is the one last written to the registry's key buffer
+static AtlrPipelineRegistryEntry* findEntry(const AtlrPipelineRegistryTable* restrict table, const AtlrU64 hash, const KeyWriter* restrict writer)
+{
+  AtlrPipelineRegistryEntry* entry = table->buckets[hash & (table->bucketCount - 1)];
+  for (; entry; entry = entry->next)
+    if ((entry->hash == hash) && (entry->keySize == writer->size) && !memcmp(entry->key, writer->registry->keyData, writer->size))
+      return entry;
+  return NULL;
+}
+
+static AtlrPipelineRegistryEntry* findHandleEntry(const AtlrPipelineRegistryTable* restrict table, const AtlrU64 handle)
+{
+  AtlrPipelineRegistryEntry* entry = table->handleBuckets[hashHandle(handle) & (table->bucketCount - 1)];
+  for (; entry; entry = entry->handleNext)
+    if (entry->handle == handle) return entry;
+  return NULL;
+}
+
+// The entry takes a copy of the key last written, so that acquiring the objects it depends on may write other keys.
+static AtlrPipelineRegistryEntry* allocEntry(const KeyWriter* restrict writer, const AtlrU64 hash)
+{
+  AtlrPipelineRegistryEntry* entry = calloc(1, sizeof(AtlrPipelineRegistryEntry) + writer->size);
+  if (!entry)
+  {
+    ATLR_ERROR_MSG("calloc returned NULL.");
+    return NULL;
+  }
+  entry->hash = hash;
+  entry->refCount = 1;
+  entry->keySize = writer->size;
+  memcpy(entry->key, writer->registry->keyData, writer->size);
+  return entry;
+}
+
+// The buckets double once there are more entries than buckets; when they cannot, the chains only get longer.
+static void insertEntry(AtlrPipelineRegistryTable* restrict table, AtlrPipelineRegistryEntry* restrict entry, const AtlrU64 handle)
+{
+  if (table->count == table->bucketCount)
+  {
+    const AtlrU32 bucketCount = 2 * table->bucketCount;
+    AtlrPipelineRegistryEntry** buckets = calloc(2 * bucketCount, sizeof(AtlrPipelineRegistryEntry*));
+    if (buckets)
+    {
+      AtlrPipelineRegistryEntry** handleBuckets = buckets + bucketCount;
+      for (AtlrU32 i = 0; i < table->bucketCount; i++)
+	for (AtlrPipelineRegistryEntry* next, *current = table->buckets[i]; current; current = next)
+	{
+	  next = current->next;
+	  AtlrPipelineRegistryEntry** bucket = buckets + (current->hash & (bucketCount - 1));
+	  current->next = *bucket;
+	  *bucket = current;
+	  bucket = handleBuckets + (hashHandle(current->handle) & (bucketCount - 1));
+	  current->handleNext = *bucket;
+	  *bucket = current;
+	}
+      free(table->buckets);
+      table->bucketCount = bucketCount;
+      table->buckets = buckets;
+      table->handleBuckets = handleBuckets;
+    }
+    else
+      atlrLog(ATLR_LOG_WARN, "Pipeline registry buckets could not grow past %u.", table->bucketCount);
+  }
+
+  entry->handle = handle;
+  AtlrPipelineRegistryEntry** bucket = table->buckets + (entry->hash & (table->bucketCount - 1));
+  entry->next = *bucket;
+  *bucket = entry;
+  bucket = table->handleBuckets + (hashHandle(handle) & (table->bucketCount - 1));
+  entry->handleNext = *bucket;
+  *bucket = entry;
+  table->count++;
+}
+
+static void removeEntry(AtlrPipelineRegistryTable* restrict table, AtlrPipelineRegistryEntry* restrict entry)
+{
+  AtlrPipelineRegistryEntry** link = table->buckets + (entry->hash & (table->bucketCount - 1));
+  while (*link != entry)
+    link = &(*link)->next;
+  *link = entry->next;
+
+  link = table->handleBuckets + (hashHandle(entry->handle) & (table->bucketCount - 1));
+  while (*link != entry)
+    link = &(*link)->handleNext;
+  *link = entry->handleNext;
+
+  table->count--;
+  free(entry);
+}
+
+// frees every entry after calling deinitEntry on it
+static void deinitTable(AtlrPipelineRegistryTable* restrict table, const AtlrDevice* restrict device,
+			void (*deinitEntry)(AtlrPipelineRegistryEntry* restrict, const AtlrDevice* restrict))
+{
+  for (AtlrU32 i = 0; i < table->bucketCount; i++)
+    for (AtlrPipelineRegistryEntry* next, *entry = table->buckets[i]; entry; entry = next)
+    {
+      next = entry->next;
+      deinitEntry(entry, device);
+      free(entry);
+    }
+  free(table->buckets);
+}
+
+static void deinitPipelineEntry(AtlrPipelineRegistryEntry* restrict entry, const AtlrDevice* restrict device)
+{
+  vkDestroyPipeline(device->logical, entry->pipeline.pipeline, device->instance->allocator);
+}
+
+static void deinitPipelineLayoutEntry(AtlrPipelineRegistryEntry* restrict entry, const AtlrDevice* restrict device)
+{
+  vkDestroyPipelineLayout(device->logical, entry->pipelineLayout, device->instance->allocator);
+}
+
+static void deinitDescriptorSetLayoutEntry(AtlrPipelineRegistryEntry* restrict entry, const AtlrDevice* restrict device)
+{
+  atlrDeinitDescriptorSetLayout(&entry->setLayout);
+}
+
+static void deinitShaderModuleEntry(AtlrPipelineRegistryEntry* restrict entry, const AtlrDevice* restrict device)
+{
+  atlrDeinitShaderModule(entry->module, device);
+}
+
+static const AtlrSamplerCacheEntry* findSamplerCacheEntry(const AtlrDevice* restrict device, const VkSampler sampler)
+{
+  const AtlrSamplerCache* cache = device->samplerCache;
+  for (AtlrU32 i = 0; i < cache->count; i++)
+    if (cache->entries[i].sampler == sampler) return cache->entries + i;
+  return NULL;
+}
+
+// modules are keyed by their SPIR-V
+static AtlrU8 writeShaderStageKey(KeyWriter* restrict writer, const VkPipelineShaderStageCreateInfo* restrict stageInfo)
+{
+  const AtlrPipelineRegistryEntry* moduleEntry = findHandleEntry(&writer->registry->shaderModules, (AtlrU64)stageInfo->module);
+  if (!moduleEntry)
+  {
+    ATLR_ERROR_MSG("The shader module is not in the pipeline registry.");
+    return 0;
+  }
+
+  appendU32(writer, stageInfo->flags);
+  appendU32(writer, stageInfo->stage);
+  appendEntryKey(writer, moduleEntry);
+  const AtlrU32 nameLength = strlen(stageInfo->pName);
+  appendU32(writer, nameLength);
+  appendKey(writer, stageInfo->pName, nameLength);
+  const VkSpecializationInfo* specializationInfo = stageInfo->pSpecializationInfo;
+  appendPresence(writer, specializationInfo);
+  if (specializationInfo)
+  {
+    appendU32(writer, specializationInfo->mapEntryCount);
+    for (AtlrU32 i = 0; i < specializationInfo->mapEntryCount; i++)
+    {
+      const VkSpecializationMapEntry* mapEntry = specializationInfo->pMapEntries + i;
+      appendU32(writer, mapEntry->constantID);
+      appendU32(writer, mapEntry->offset);
+      appendU32(writer, mapEntry->size);
+    }
+    const AtlrU64 dataSize = specializationInfo->dataSize;
+    appendKey(writer, &dataSize, sizeof(AtlrU64));
+    appendKey(writer, specializationInfo->pData, dataSize);
+  }
+  return 1;
+}
+
+// immutable samplers are keyed by their sampler state
+static AtlrU8 writeDescriptorSetLayoutKey(KeyWriter* restrict writer, const AtlrU32 bindingCount, const VkDescriptorSetLayoutBinding* restrict bindings)
+{
+  const AtlrDevice* device = writer->registry->device;
+  appendU32(writer, bindingCount);
+  for (AtlrU32 i = 0; i < bindingCount; i++)
+  {
+    const VkDescriptorSetLayoutBinding* binding = bindings + i;
+    appendU32(writer, binding->binding);
+    appendU32(writer, binding->descriptorType);
+    appendU32(writer, binding->descriptorCount);
+    appendU32(writer, binding->stageFlags);
+    appendPresence(writer, binding->pImmutableSamplers);
+    if (binding->pImmutableSamplers)
+      for (AtlrU32 j = 0; j < binding->descriptorCount; j++)
+      {
+	const AtlrSamplerCacheEntry* samplerEntry = findSamplerCacheEntry(device, binding->pImmutableSamplers[j]);
+	if (!samplerEntry)
+	{
+	  ATLR_ERROR_MSG("The immutable sampler is not in the sampler cache.");
+	  return 0;
+	}
+	appendKey(writer, &samplerEntry->key, sizeof(VkSamplerCreateInfo));
+      }
+  }
+  return 1;
+}
+
+// set layouts are keyed by their bindings
+static AtlrU8 writePipelineLayoutKey(KeyWriter* restrict writer, const VkPipelineLayoutCreateInfo* restrict layoutInfo)
+{
+  appendU32(writer, layoutInfo->flags);
+  appendU32(writer, layoutInfo->setLayoutCount);
+  for (AtlrU32 i = 0; i < layoutInfo->setLayoutCount; i++)
+  {
+    const AtlrPipelineRegistryEntry* setLayoutEntry = findHandleEntry(&writer->registry->descriptorSetLayouts, (AtlrU64)layoutInfo->pSetLayouts[i]);
+    if (!setLayoutEntry)
+    {
+      ATLR_ERROR_MSG("The descriptor set layout is not in the pipeline registry.");
+      return 0;
+    }
+    appendEntryKey(writer, setLayoutEntry);
+  }
+  appendU32(writer, layoutInfo->pushConstantRangeCount);
+  for (AtlrU32 i = 0; i < layoutInfo->pushConstantRangeCount; i++)
+  {
+    const VkPushConstantRange* range = layoutInfo->pPushConstantRanges + i;
+    appendU32(writer, range->stageFlags);
+    appendU32(writer, range->offset);
+    appendU32(writer, range->size);
+  }
+  return 1;
+}
+
+static void writeVertexInputStateKey(KeyWriter* restrict writer, const VkPipelineVertexInputStateCreateInfo* restrict info)
+{
+  appendPresence(writer, info);
+  if (!info) return;
+  
+  appendU32(writer, info->vertexBindingDescriptionCount);
+  for (AtlrU32 i = 0; i < info->vertexBindingDescriptionCount; i++)
+  {
+    const VkVertexInputBindingDescription* binding = info->pVertexBindingDescriptions + i;
+    appendU32(writer, binding->binding);
+    appendU32(writer, binding->stride);
+    appendU32(writer, binding->inputRate);
+  }
+  appendU32(writer, info->vertexAttributeDescriptionCount);
+  for (AtlrU32 i = 0; i < info->vertexAttributeDescriptionCount; i++)
+  {
+    const VkVertexInputAttributeDescription* attribute = info->pVertexAttributeDescriptions + i;
+    appendU32(writer, attribute->location);
+    appendU32(writer, attribute->binding);
+    appendU32(writer, attribute->format);
+    appendU32(writer, attribute->offset);
+  }
+}
+
+static void writeFixedFunctionStateKey(KeyWriter* restrict writer,
+				       const VkPipelineInputAssemblyStateCreateInfo* restrict inputAssemblyInfo,
+				       const VkPipelineTessellationStateCreateInfo* restrict tessellationInfo,
+				       const VkPipelineViewportStateCreateInfo* restrict viewportInfo,
+				       const VkPipelineRasterizationStateCreateInfo* restrict rasterizationInfo,
+				       const VkPipelineMultisampleStateCreateInfo* restrict multisampleInfo,
+				       const VkPipelineDepthStencilStateCreateInfo* restrict depthStencilInfo)
+{
+  appendPresence(writer, inputAssemblyInfo);
+  if (inputAssemblyInfo)
+  {
+    appendU32(writer, inputAssemblyInfo->topology);
+    appendU32(writer, inputAssemblyInfo->primitiveRestartEnable);
+  }
+
+  appendPresence(writer, tessellationInfo);
+  if (tessellationInfo)
+    appendU32(writer, tessellationInfo->patchControlPoints);
+
+  appendPresence(writer, viewportInfo);
+  if (viewportInfo)
+  {
+    appendU32(writer, viewportInfo->viewportCount);
+    appendU32(writer, viewportInfo->scissorCount);
+    appendPresence(writer, viewportInfo->pViewports);
+    if (viewportInfo->pViewports)
+      for (AtlrU32 i = 0; i < viewportInfo->viewportCount; i++)
+      {
+	const VkViewport* viewport = viewportInfo->pViewports + i;
+	appendFloat(writer, viewport->x);
+	appendFloat(writer, viewport->y);
+	appendFloat(writer, viewport->width);
+	appendFloat(writer, viewport->height);
+	appendFloat(writer, viewport->minDepth);
+	appendFloat(writer, viewport->maxDepth);
+      }
+    appendPresence(writer, viewportInfo->pScissors);
+    if (viewportInfo->pScissors)
+      appendKey(writer, viewportInfo->pScissors, viewportInfo->scissorCount * sizeof(VkRect2D));
+  }
+
+  appendPresence(writer, rasterizationInfo);
+  if (rasterizationInfo)
+  {
+    appendU32(writer, rasterizationInfo->depthClampEnable);
+    appendU32(writer, rasterizationInfo->rasterizerDiscardEnable);
+    appendU32(writer, rasterizationInfo->polygonMode);
+    appendU32(writer, rasterizationInfo->cullMode);
+    appendU32(writer, rasterizationInfo->frontFace);
+    appendU32(writer, rasterizationInfo->depthBiasEnable);
+    appendFloat(writer, rasterizationInfo->depthBiasConstantFactor);
+    appendFloat(writer, rasterizationInfo->depthBiasClamp);
+    appendFloat(writer, rasterizationInfo->depthBiasSlopeFactor);
+    appendFloat(writer, rasterizationInfo->lineWidth);
+  }
+
+  appendPresence(writer, multisampleInfo);
+  if (multisampleInfo)
+  {
+    appendU32(writer, multisampleInfo->rasterizationSamples);
+    appendU32(writer, multisampleInfo->sampleShadingEnable);
+    appendFloat(writer, multisampleInfo->minSampleShading);
+    appendU32(writer, multisampleInfo->alphaToCoverageEnable);
+    appendU32(writer, multisampleInfo->alphaToOneEnable);
+    appendPresence(writer, multisampleInfo->pSampleMask);
+    if (multisampleInfo->pSampleMask)
+      appendKey(writer, multisampleInfo->pSampleMask, ((multisampleInfo->rasterizationSamples + 31) / 32) * sizeof(VkSampleMask));
+  }
+
+  appendPresence(writer, depthStencilInfo);
+  if (depthStencilInfo)
+  {
+    appendU32(writer, depthStencilInfo->depthTestEnable);
+    appendU32(writer, depthStencilInfo->depthWriteEnable);
+    appendU32(writer, depthStencilInfo->depthCompareOp);
+    appendU32(writer, depthStencilInfo->depthBoundsTestEnable);
+    appendU32(writer, depthStencilInfo->stencilTestEnable);
+    appendKey(writer, &depthStencilInfo->front, sizeof(VkStencilOpState));
+    appendKey(writer, &depthStencilInfo->back, sizeof(VkStencilOpState));
+    appendFloat(writer, depthStencilInfo->minDepthBounds);
+    appendFloat(writer, depthStencilInfo->maxDepthBounds);
+  }
+}
+
+static void writeOutputStateKey(KeyWriter* restrict writer,
+				const VkPipelineColorBlendStateCreateInfo* restrict colorBlendInfo,
+				const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
+				const AtlrRenderPass* restrict renderPass, const VkPipelineRenderingCreateInfo* restrict renderingInfo)
+{
+  appendPresence(writer, colorBlendInfo);
+  if (colorBlendInfo)
+  {
+    appendU32(writer, colorBlendInfo->logicOpEnable);
+    appendU32(writer, colorBlendInfo->logicOp);
+    appendU32(writer, colorBlendInfo->attachmentCount);
+    appendKey(writer, colorBlendInfo->pAttachments, colorBlendInfo->attachmentCount * sizeof(VkPipelineColorBlendAttachmentState));
+    appendKey(writer, colorBlendInfo->blendConstants, 4 * sizeof(float));
+  }
+
+  appendPresence(writer, dynamicInfo);
+  if (dynamicInfo)
+  {
+    appendU32(writer, dynamicInfo->dynamicStateCount);
+    appendKey(writer, dynamicInfo->pDynamicStates, dynamicInfo->dynamicStateCount * sizeof(VkDynamicState));
+  }
+
+  // pipelines are interchangeable between compatible render passes
+  appendPresence(writer, renderPass);
+  if (renderPass)
+    appendKey(writer, &renderPass->compatibilityHash, sizeof(AtlrU64));
+  appendPresence(writer, renderingInfo);
+  if (renderingInfo)
+  {
+    appendU32(writer, renderingInfo->viewMask);
+    appendU32(writer, renderingInfo->colorAttachmentCount);
+    appendKey(writer, renderingInfo->pColorAttachmentFormats, renderingInfo->colorAttachmentCount * sizeof(VkFormat));
+    appendU32(writer, renderingInfo->depthAttachmentFormat);
+    appendU32(writer, renderingInfo->stencilAttachmentFormat);
+  }
+}
+
+static AtlrU64 hashKey(const KeyWriter* restrict writer)
+{
+  return atlrHash(writer->registry->keyData, writer->size, ATLR_HASH_SEED);
+}
+
+AtlrU8 atlrInitPipelineRegistry(AtlrPipelineRegistry* restrict registry, const AtlrDevice* restrict device)
+{
+  registry->device = device;
+  registry->keyCapacity = 0;
+  registry->keyData = NULL;
+  if (!initTable(&registry->shaderModules))
+  {
+    ATLR_ERROR_MSG("initTable returned 0.");
+    return 0;
+  }
+  if (!initTable(&registry->descriptorSetLayouts))
+  {
+    ATLR_ERROR_MSG("initTable returned 0.");
+    free(registry->shaderModules.buckets);
+    return 0;
+  }
+  if (!initTable(&registry->pipelineLayouts))
+  {
+    ATLR_ERROR_MSG("initTable returned 0.");
+    free(registry->descriptorSetLayouts.buckets);
+    free(registry->shaderModules.buckets);
+    return 0;
+  }
+  if (!initTable(&registry->pipelines))
+  {
+    ATLR_ERROR_MSG("initTable returned 0.");
+    free(registry->pipelineLayouts.buckets);
+    free(registry->descriptorSetLayouts.buckets);
+    free(registry->shaderModules.buckets);
+    return 0;
+  }
+  
+  return 1;
+}
+
+// destroys every registered object, whether or not it is still referenced
+void atlrDeinitPipelineRegistry(AtlrPipelineRegistry* restrict registry)
+{
+  const AtlrDevice* device = registry->device;
+  
+  deinitTable(&registry->pipelines, device, deinitPipelineEntry);
+  deinitTable(&registry->pipelineLayouts, device, deinitPipelineLayoutEntry);
+  deinitTable(&registry->descriptorSetLayouts, device, deinitDescriptorSetLayoutEntry);
+  deinitTable(&registry->shaderModules, device, deinitShaderModuleEntry);
+  free(registry->keyData);
+}
+
+VkShaderModule atlrPipelineRegistryAcquireShaderModule(AtlrPipelineRegistry* restrict registry, const AtlrSpirVBinary* restrict bin)
+{
+  KeyWriter writer;
+  initKeyWriter(&writer, registry);
+  appendKey(&writer, bin->code, bin->codeSize);
+  if (!writer.isValid)
+  {
+    ATLR_ERROR_MSG("appendKey failed.");
+    return VK_NULL_HANDLE;
+  }
+  const AtlrU64 hash = hashKey(&writer);
+  AtlrPipelineRegistryEntry* entry = findEntry(&registry->shaderModules, hash, &writer);
+  if (entry)
+  {
+    entry->refCount++;
+    return entry->module;
+  }
+
+  entry = allocEntry(&writer, hash);
+  if (!entry)
+  {
+    ATLR_ERROR_MSG("allocEntry returned NULL.");
+    return VK_NULL_HANDLE;
+  }
+
+  const AtlrDevice* device = registry->device;
+  VkShaderModule module;
+  const VkShaderModuleCreateInfo moduleInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .codeSize = bin->codeSize,
+    .pCode = bin->code
+  };
+  if (vkCreateShaderModule(device->logical, &moduleInfo, device->instance->allocator, &module) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateShaderModule did not return VK_SUCCESS.");
+    free(entry);
+    return VK_NULL_HANDLE;
+  }
+
+  entry->module = module;
+  insertEntry(&registry->shaderModules, entry, (AtlrU64)module);
+  return module;
+}
+
+VkShaderModule atlrPipelineRegistryAcquireShaderModuleFromFile(AtlrPipelineRegistry* restrict registry, const char* restrict path)
+{
+  AtlrSpirVBinary bin;
+  if (!atlrInitSpirVBinaryFromFile(&bin, path))
+  {
+    ATLR_ERROR_MSG("atlrInitSpirVBinaryFromFile returned 0.");
+    return VK_NULL_HANDLE;
+  }
+
+  const VkShaderModule module = atlrPipelineRegistryAcquireShaderModule(registry, &bin);
+  atlrDeinitSpirVBinary(&bin);
+  return module;
+}
+
+void atlrPipelineRegistryReleaseShaderModule(AtlrPipelineRegistry* restrict registry, const VkShaderModule module)
+{
+  AtlrPipelineRegistryTable* table = &registry->shaderModules;
+  AtlrPipelineRegistryEntry* entry = findHandleEntry(table, (AtlrU64)module);
+  if (!entry)
+  {
+    ATLR_ERROR_MSG("The shader module is not in the pipeline registry.");
+    return;
+  }
+  if (--entry->refCount) return;
+    
+  atlrDeinitShaderModule(module, registry->device);
+  removeEntry(table, entry);
+}
+
+const AtlrDescriptorSetLayout* atlrPipelineRegistryAcquireDescriptorSetLayout(AtlrPipelineRegistry* restrict registry,
+									      const AtlrU32 bindingCount, const VkDescriptorSetLayoutBinding* restrict bindings)
+{
+  KeyWriter writer;
+  initKeyWriter(&writer, registry);
+  if (!writeDescriptorSetLayoutKey(&writer, bindingCount, bindings) || !writer.isValid)
+  {
+    ATLR_ERROR_MSG("writeDescriptorSetLayoutKey failed.");
+    return NULL;
+  }
+  const AtlrU64 hash = hashKey(&writer);
+  AtlrPipelineRegistryEntry* entry = findEntry(&registry->descriptorSetLayouts, hash, &writer);
+  if (entry)
+  {
+    entry->refCount++;
+    return &entry->setLayout;
+  }
+
+  entry = allocEntry(&writer, hash);
+  if (!entry)
+  {
+    ATLR_ERROR_MSG("allocEntry returned NULL.");
+    return NULL;
+  }
+  if (!atlrInitDescriptorSetLayout(&entry->setLayout, bindingCount, bindings, registry->device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorSetLayout returned 0.");
+    free(entry);
+    return NULL;
+  }
+
+  insertEntry(&registry->descriptorSetLayouts, entry, (AtlrU64)entry->setLayout.layout);
+  return &entry->setLayout;
+}
+
+void atlrPipelineRegistryReleaseDescriptorSetLayout(AtlrPipelineRegistry* restrict registry, const AtlrDescriptorSetLayout* restrict setLayout)
+{
+  AtlrPipelineRegistryTable* table = &registry->descriptorSetLayouts;
+  AtlrPipelineRegistryEntry* entry = findHandleEntry(table, (AtlrU64)setLayout->layout);
+  if (!entry || (&entry->setLayout != setLayout))
+  {
+    ATLR_ERROR_MSG("The descriptor set layout is not in the pipeline registry.");
+    return;
+  }
+  if (--entry->refCount) return;
+    
+  atlrDeinitDescriptorSetLayout(&entry->setLayout);
+  removeEntry(table, entry);
+}
+
+static AtlrPipelineRegistryEntry* acquirePipelineLayoutEntry(AtlrPipelineRegistry* restrict registry, const VkPipelineLayoutCreateInfo* restrict layoutInfo)
+{
+  KeyWriter writer;
+  initKeyWriter(&writer, registry);
+  if (!writePipelineLayoutKey(&writer, layoutInfo) || !writer.isValid)
+  {
+    ATLR_ERROR_MSG("writePipelineLayoutKey failed.");
+    return NULL;
+  }
+  const AtlrU64 hash = hashKey(&writer);
+  AtlrPipelineRegistryEntry* entry = findEntry(&registry->pipelineLayouts, hash, &writer);
+  if (entry)
+  {
+    entry->refCount++;
+    return entry;
+  }
+
+  entry = allocEntry(&writer, hash);
+  if (!entry)
+  {
+    ATLR_ERROR_MSG("allocEntry returned NULL.");
+    return NULL;
+  }
+  const AtlrDevice* device = registry->device;
+  if (vkCreatePipelineLayout(device->logical, layoutInfo, device->instance->allocator, &entry->pipelineLayout) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreatePipelineLayout did not return VK_SUCCESS.");
+    free(entry);
+    return NULL;
+  }
+
+  insertEntry(&registry->pipelineLayouts, entry, (AtlrU64)entry->pipelineLayout);
+  return entry;
+}
+
+static void releasePipelineLayoutEntry(AtlrPipelineRegistry* restrict registry, AtlrPipelineRegistryEntry* restrict entry)
+{
+  if (--entry->refCount) return;
+
+  const AtlrDevice* device = registry->device;
+  vkDestroyPipelineLayout(device->logical, entry->pipelineLayout, device->instance->allocator);
+  removeEntry(&registry->pipelineLayouts, entry);
+}
+
+VkPipelineLayout atlrPipelineRegistryAcquirePipelineLayout(AtlrPipelineRegistry* restrict registry, const VkPipelineLayoutCreateInfo* restrict layoutInfo)
+{
+  AtlrPipelineRegistryEntry* entry = acquirePipelineLayoutEntry(registry, layoutInfo);
+  if (!entry)
+  {
+    ATLR_ERROR_MSG("acquirePipelineLayoutEntry returned NULL.");
+    return VK_NULL_HANDLE;
+  }
+  
+  return entry->pipelineLayout;
+}
+
+void atlrPipelineRegistryReleasePipelineLayout(AtlrPipelineRegistry* restrict registry, const VkPipelineLayout layout)
+{
+  AtlrPipelineRegistryEntry* entry = findHandleEntry(&registry->pipelineLayouts, (AtlrU64)layout);
+  if (!entry)
+  {
+    ATLR_ERROR_MSG("The pipeline layout is not in the pipeline registry.");
+    return;
+  }
+  releasePipelineLayoutEntry(registry, entry);
+}
+
+// Takes the same state as atlrInitGraphicsPipeline, with either a render pass or a dynamic rendering info, the other being NULL.
+// The returned pipeline is shared; hand it back with atlrPipelineRegistryReleasePipeline instead of calling atlrDeinitPipeline.
+const AtlrPipeline* atlrPipelineRegistryAcquireGraphicsPipeline(AtlrPipelineRegistry* restrict registry,
+								const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict stageInfos,
+								const VkPipelineVertexInputStateCreateInfo* restrict vertexInputInfo,
+								const VkPipelineInputAssemblyStateCreateInfo* restrict inputAssemblyInfo,
+								const VkPipelineTessellationStateCreateInfo* restrict tessellationInfo,
+								const VkPipelineViewportStateCreateInfo* restrict viewportInfo,
+								const VkPipelineRasterizationStateCreateInfo* restrict rasterizationInfo,
+								const VkPipelineMultisampleStateCreateInfo* restrict multisampleInfo,
+								const VkPipelineDepthStencilStateCreateInfo* restrict depthStencilInfo,
+								const VkPipelineColorBlendStateCreateInfo* restrict colorBlendInfo,
+								const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
+								const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+								const AtlrRenderPass* restrict renderPass, const VkPipelineRenderingCreateInfo* restrict renderingInfo)
+{
+  const AtlrDevice* device = registry->device;
+  if (renderingInfo && !device->features.dynamicRendering)
+  {
+    ATLR_ERROR_MSG("Dynamic rendering is not enabled on the device.");
+    return NULL;
+  }
+  
+  KeyWriter writer;
+  initKeyWriter(&writer, registry);
+  appendU32(&writer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+  appendU32(&writer, stageCount);
+  for (AtlrU32 i = 0; i < stageCount; i++)
+    if (!writeShaderStageKey(&writer, stageInfos + i))
+    {
+      ATLR_ERROR_MSG("writeShaderStageKey returned 0.");
+      return NULL;
+    }
+  writeVertexInputStateKey(&writer, vertexInputInfo);
+  writeFixedFunctionStateKey(&writer, inputAssemblyInfo, tessellationInfo, viewportInfo, rasterizationInfo, multisampleInfo, depthStencilInfo);
+  writeOutputStateKey(&writer, colorBlendInfo, dynamicInfo, renderPass, renderingInfo);
+  if (!writePipelineLayoutKey(&writer, pipelineLayoutInfo) || !writer.isValid)
+  {
+    ATLR_ERROR_MSG("writePipelineLayoutKey failed.");
+    return NULL;
+  }
+
+  const AtlrU64 hash = hashKey(&writer);
+  AtlrPipelineRegistryEntry* entry = findEntry(&registry->pipelines, hash, &writer);
+  if (entry)
+  {
+    entry->refCount++;
+    return &entry->pipeline;
+  }
+
+  entry = allocEntry(&writer, hash);
+  if (!entry)
+  {
+    ATLR_ERROR_MSG("allocEntry returned NULL.");
+    return NULL;
+  }
+  AtlrPipelineRegistryEntry* layoutEntry = acquirePipelineLayoutEntry(registry, pipelineLayoutInfo);
+  if (!layoutEntry)
+  {
+    ATLR_ERROR_MSG("acquirePipelineLayoutEntry returned NULL.");
+    free(entry);
+    return NULL;
+  }
+
+  const VkGraphicsPipelineCreateInfo pipelineInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+    .pNext = renderingInfo,
+    .flags = 0,
+    .stageCount = stageCount,
+    .pStages = stageInfos,
+    .pVertexInputState = vertexInputInfo,
+    .pInputAssemblyState = inputAssemblyInfo,
+    .pTessellationState = tessellationInfo,
+    .pViewportState = viewportInfo,
+    .pRasterizationState = rasterizationInfo,
+    .pMultisampleState = multisampleInfo,
+    .pDepthStencilState = depthStencilInfo,
+    .pColorBlendState = colorBlendInfo,
+    .pDynamicState = dynamicInfo,
+    .layout = layoutEntry->pipelineLayout,
+    .renderPass = renderPass ? renderPass->renderPass : VK_NULL_HANDLE,
+    .subpass = 0,
+    .basePipelineHandle = VK_NULL_HANDLE,
+    .basePipelineIndex = -1
+  };
+  VkPipeline pipeline;
+  if (vkCreateGraphicsPipelines(device->logical, VK_NULL_HANDLE, 1, &pipelineInfo, device->instance->allocator, &pipeline) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateGraphicsPipelines did not return VK_SUCCESS.");
+    releasePipelineLayoutEntry(registry, layoutEntry);
+    free(entry);
+    return NULL;
+  }
+
+  entry->pipeline = (AtlrPipeline)
+  {
+    .device = device,
+    .layout = layoutEntry->pipelineLayout,
+    .pipeline = pipeline,
+    .bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS
+  };
+  entry->layoutEntry = layoutEntry;
+  insertEntry(&registry->pipelines, entry, (AtlrU64)pipeline);
+  return &entry->pipeline;
+}
+
+const AtlrPipeline* atlrPipelineRegistryAcquireComputePipeline(AtlrPipelineRegistry* restrict registry,
+							       const VkPipelineShaderStageCreateInfo* restrict stageInfo,
+							       const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo)
+{
+  KeyWriter writer;
+  initKeyWriter(&writer, registry);
+  appendU32(&writer, VK_PIPELINE_BIND_POINT_COMPUTE);
+  if (!writeShaderStageKey(&writer, stageInfo))
+  {
+    ATLR_ERROR_MSG("writeShaderStageKey returned 0.");
+    return NULL;
+  }
+  if (!writePipelineLayoutKey(&writer, pipelineLayoutInfo) || !writer.isValid)
+  {
+    ATLR_ERROR_MSG("writePipelineLayoutKey failed.");
+    return NULL;
+  }
+
+  const AtlrU64 hash = hashKey(&writer);
+  AtlrPipelineRegistryEntry* entry = findEntry(&registry->pipelines, hash, &writer);
+  if (entry)
+  {
+    entry->refCount++;
+    return &entry->pipeline;
+  }
+
+  entry = allocEntry(&writer, hash);
+  if (!entry)
+  {
+    ATLR_ERROR_MSG("allocEntry returned NULL.");
+    return NULL;
+  }
+  AtlrPipelineRegistryEntry* layoutEntry = acquirePipelineLayoutEntry(registry, pipelineLayoutInfo);
+  if (!layoutEntry)
+  {
+    ATLR_ERROR_MSG("acquirePipelineLayoutEntry returned NULL.");
+    free(entry);
+    return NULL;
+  }
+
+  const AtlrDevice* device = registry->device;
+  const VkComputePipelineCreateInfo pipelineInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .stage = *stageInfo,
+    .layout = layoutEntry->pipelineLayout,
+    .basePipelineHandle = VK_NULL_HANDLE,
+    .basePipelineIndex = -1
+  };
+  VkPipeline pipeline;
+  if (vkCreateComputePipelines(device->logical, VK_NULL_HANDLE, 1, &pipelineInfo, device->instance->allocator, &pipeline) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateComputePipelines did not return VK_SUCCESS.");
+    releasePipelineLayoutEntry(registry, layoutEntry);
+    free(entry);
+    return NULL;
+  }
+
+  entry->pipeline = (AtlrPipeline)
+  {
+    .device = device,
+    .layout = layoutEntry->pipelineLayout,
+    .pipeline = pipeline,
+    .bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE
+  };
+  entry->layoutEntry = layoutEntry;
+  insertEntry(&registry->pipelines, entry, (AtlrU64)pipeline);
+  return &entry->pipeline;
+}
+
+void atlrPipelineRegistryReleasePipeline(AtlrPipelineRegistry* restrict registry, const AtlrPipeline* restrict pipeline)
+{
+  AtlrPipelineRegistryTable* table = &registry->pipelines;
+  AtlrPipelineRegistryEntry* entry = findHandleEntry(table, (AtlrU64)pipeline->pipeline);
+  if (!entry || (&entry->pipeline != pipeline))
+  {
+    ATLR_ERROR_MSG("The pipeline is not in the pipeline registry.");
+    return;
+  }
+  if (--entry->refCount) return;
+
+  const AtlrDevice* device = registry->device;
+  vkDestroyPipeline(device->logical, entry->pipeline.pipeline, device->instance->allocator);
+  releasePipelineLayoutEntry(registry, entry->layoutEntry);
+  removeEntry(table, entry);
+}
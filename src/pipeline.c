@@ -27,36 +27,49 @@ static const VkDynamicState dynamicStates[] =
   VK_DYNAMIC_STATE_SCISSOR
 };
 
+// the extended dynamic state 3 states are last so they can be left off when the device lacks them
+static const VkDynamicState extendedDynamicStates[] =
+{
+  VK_DYNAMIC_STATE_VIEWPORT,
+  VK_DYNAMIC_STATE_SCISSOR,
+  VK_DYNAMIC_STATE_CULL_MODE,
+  VK_DYNAMIC_STATE_FRONT_FACE,
+  VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+  VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE,
+  VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE,
+  VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE,
+  VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+  VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+  VK_DYNAMIC_STATE_DEPTH_COMPARE_OP,
+  VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE,
+  VK_DYNAMIC_STATE_POLYGON_MODE_EXT,
+  VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT,
+  VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT
+};
+#define EXTENDED_DYNAMIC_STATE_3_COUNT 3
+
 VkShaderModule atlrInitShaderModule(const char* restrict path, const AtlrDevice* restrict device)
 {
-  FILE* file = fopen(path, "rb");
-  if (!file)
+  AtlrSpirVBinary bin;
+  if (!atlrInitSpirVBinaryFromFile(&bin, path))
   {
-    ATLR_ERROR_MSG("Failed to open file at path \"%s\".", path);
+    ATLR_ERROR_MSG("atlrInitSpirVBinaryFromFile returned 0.");
     return VK_NULL_HANDLE;
   }
-  fseek(file, 0, SEEK_END);
-  const long int codeSize = ftell(file);
-  rewind(file);
-  char* bytes = malloc((codeSize + 1) * sizeof(char));
-  bytes[codeSize] = '\0';
-  fread(bytes, codeSize, 1, file);
-  fclose(file);
 
   VkShaderModule module;
-  AtlrU32* code = (AtlrU32*)bytes;
   const VkShaderModuleCreateInfo moduleInfo =
   {
     .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
     .pNext = NULL,
     .flags = 0,
-    .codeSize = codeSize,
-    .pCode = code
+    .codeSize = bin.codeSize,
+    .pCode = bin.code
   };
   if (vkCreateShaderModule(device->logical, &moduleInfo, device->instance->allocator, &module) != VK_SUCCESS)
   {
     ATLR_ERROR_MSG("vkCreateShaderModule did not return VK_SUCCESS.");
-    free(bytes);
+    atlrDeinitSpirVBinary(&bin);
     return VK_NULL_HANDLE;
   }
 #ifdef ATLR_DEBUG
@@ -66,8 +79,7 @@ VkShaderModule atlrInitShaderModule(const char* restrict path, const AtlrDevice*
   free(shaderString);
 #endif
   
-
-  free(bytes);
+  atlrDeinitSpirVBinary(&bin);
   return module;
 }
 
@@ -243,6 +255,44 @@ VkPipelineDynamicStateCreateInfo atlrInitPipelineDynamicStateInfo()
   };
 }
 
+// Requires the extended dynamic state device feature; without it only viewport and scissor are made dynamic.
+// The pipeline's topology only fixes the topology class (point, line, triangle or patch); the exact topology is set per draw.
+VkPipelineDynamicStateCreateInfo atlrInitPipelineExtendedDynamicStateInfo(const AtlrDevice* restrict device)
+{
+  if (!device->features.extendedDynamicState)
+  {
+    ATLR_ERROR_MSG("Extended dynamic state is not enabled on the device.");
+    return atlrInitPipelineDynamicStateInfo();
+  }
+  
+  AtlrU32 count = sizeof(extendedDynamicStates) / sizeof(VkDynamicState);
+  if (!device->features.extendedDynamicState3) count -= EXTENDED_DYNAMIC_STATE_3_COUNT;
+  
+  return (VkPipelineDynamicStateCreateInfo)
+  {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .dynamicStateCount = count,
+    .pDynamicStates = extendedDynamicStates
+  };
+}
+
+// attachment formats for pipelines that render with dynamic rendering instead of a render pass
+VkPipelineRenderingCreateInfo atlrInitPipelineRenderingInfo(const AtlrU32 colorAttachmentCount, const VkFormat* restrict colorFormats, const VkFormat depthFormat)
+{
+  return (VkPipelineRenderingCreateInfo)
+  {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+    .pNext = NULL,
+    .viewMask = 0,
+    .colorAttachmentCount = colorAttachmentCount,
+    .pColorAttachmentFormats = colorFormats,
+    .depthAttachmentFormat = depthFormat,
+    .stencilAttachmentFormat = VK_FORMAT_UNDEFINED
+  };
+}
+
 VkPipelineLayoutCreateInfo atlrInitPipelineLayoutInfo(const AtlrU32 setLayoutCount, const VkDescriptorSetLayout* restrict setLayouts,
 						      const AtlrU32 pushConstantRangeCount, const VkPushConstantRange* restrict pushConstantRanges)
 {
@@ -258,19 +308,20 @@ VkPipelineLayoutCreateInfo atlrInitPipelineLayoutInfo(const AtlrU32 setLayoutCou
   };
 }
 
-AtlrU8 atlrInitGraphicsPipeline(AtlrPipeline* restrict pipeline,
-				const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict stageInfos,
-				const VkPipelineVertexInputStateCreateInfo* restrict vertexInputInfo,
-				const VkPipelineInputAssemblyStateCreateInfo* restrict inputAssemblyInfo,
-				const VkPipelineTessellationStateCreateInfo* restrict tessellationInfo,
-				const VkPipelineViewportStateCreateInfo* restrict viewportInfo,
-				const VkPipelineRasterizationStateCreateInfo* restrict rasterizationInfo,
-				const VkPipelineMultisampleStateCreateInfo* restrict multisampleInfo,
-				const VkPipelineDepthStencilStateCreateInfo* restrict depthStencilInfo,
-				const VkPipelineColorBlendStateCreateInfo* restrict colorBlendInfo,
-				const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
-				const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
-				const AtlrDevice* restrict device, const AtlrRenderPass* restrict renderPass)
+static AtlrU8 initGraphicsPipeline(AtlrPipeline* restrict pipeline,
+				   const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict stageInfos,
+				   const VkPipelineVertexInputStateCreateInfo* restrict vertexInputInfo,
+				   const VkPipelineInputAssemblyStateCreateInfo* restrict inputAssemblyInfo,
+				   const VkPipelineTessellationStateCreateInfo* restrict tessellationInfo,
+				   const VkPipelineViewportStateCreateInfo* restrict viewportInfo,
+				   const VkPipelineRasterizationStateCreateInfo* restrict rasterizationInfo,
+				   const VkPipelineMultisampleStateCreateInfo* restrict multisampleInfo,
+				   const VkPipelineDepthStencilStateCreateInfo* restrict depthStencilInfo,
+				   const VkPipelineColorBlendStateCreateInfo* restrict colorBlendInfo,
+				   const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
+				   const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+				   const void* pNext, const VkRenderPass renderPass,
+				   const AtlrDevice* restrict device)
 {
   pipeline->device = device;
   
@@ -283,7 +334,7 @@ AtlrU8 atlrInitGraphicsPipeline(AtlrPipeline* restrict pipeline,
   const VkGraphicsPipelineCreateInfo pipelineInfo =
   {
     .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-    .pNext = NULL,
+    .pNext = pNext,
     .flags = 0,
     .stageCount = stageCount,
     .pStages = stageInfos,
@@ -297,7 +348,7 @@ AtlrU8 atlrInitGraphicsPipeline(AtlrPipeline* restrict pipeline,
     .pColorBlendState = colorBlendInfo,
     .pDynamicState = dynamicInfo,
     .layout = pipeline->layout,
-    .renderPass = renderPass->renderPass,
+    .renderPass = renderPass,
     .subpass = 0,
     .basePipelineHandle = VK_NULL_HANDLE,
     .basePipelineIndex = -1
@@ -313,10 +364,67 @@ AtlrU8 atlrInitGraphicsPipeline(AtlrPipeline* restrict pipeline,
   return 1;
 }
 
-AtlrU8 atlrInitComputePipeline(AtlrPipeline* restrict pipeline,
-			       const VkPipelineShaderStageCreateInfo* restrict stageInfo,
-			       const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
-			       const AtlrDevice* restrict device)
+AtlrU8 atlrInitGraphicsPipeline(AtlrPipeline* restrict pipeline,
+				const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict stageInfos,
+				const VkPipelineVertexInputStateCreateInfo* restrict vertexInputInfo,
+				const VkPipelineInputAssemblyStateCreateInfo* restrict inputAssemblyInfo,
+				const VkPipelineTessellationStateCreateInfo* restrict tessellationInfo,
+				const VkPipelineViewportStateCreateInfo* restrict viewportInfo,
+				const VkPipelineRasterizationStateCreateInfo* restrict rasterizationInfo,
+				const VkPipelineMultisampleStateCreateInfo* restrict multisampleInfo,
+				const VkPipelineDepthStencilStateCreateInfo* restrict depthStencilInfo,
+				const VkPipelineColorBlendStateCreateInfo* restrict colorBlendInfo,
+				const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
+				const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+				const AtlrDevice* restrict device, const AtlrRenderPass* restrict renderPass)
+{
+  if (!initGraphicsPipeline(pipeline, stageCount, stageInfos, vertexInputInfo, inputAssemblyInfo, tessellationInfo, viewportInfo, rasterizationInfo,
+			    multisampleInfo, depthStencilInfo, colorBlendInfo, dynamicInfo, pipelineLayoutInfo, NULL, renderPass->renderPass, device))
+  {
+    ATLR_ERROR_MSG("initGraphicsPipeline returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// the pipeline is not tied to any render pass; it is compatible with any dynamic rendering instance using the same attachment formats
+AtlrU8 atlrInitGraphicsPipelineDynamicRendering(AtlrPipeline* restrict pipeline,
+						const AtlrU32 stageCount, const VkPipelineShaderStageCreateInfo* restrict stageInfos,
+						const VkPipelineVertexInputStateCreateInfo* restrict vertexInputInfo,
+						const VkPipelineInputAssemblyStateCreateInfo* restrict inputAssemblyInfo,
+						const VkPipelineTessellationStateCreateInfo* restrict tessellationInfo,
+						const VkPipelineViewportStateCreateInfo* restrict viewportInfo,
+						const VkPipelineRasterizationStateCreateInfo* restrict rasterizationInfo,
+						const VkPipelineMultisampleStateCreateInfo* restrict multisampleInfo,
+						const VkPipelineDepthStencilStateCreateInfo* restrict depthStencilInfo,
+						const VkPipelineColorBlendStateCreateInfo* restrict colorBlendInfo,
+						const VkPipelineDynamicStateCreateInfo* restrict dynamicInfo,
+						const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+						const VkPipelineRenderingCreateInfo* restrict renderingInfo,
+						const AtlrDevice* restrict device)
+{
+  if (!device->features.dynamicRendering)
+  {
+    ATLR_ERROR_MSG("Dynamic rendering is not enabled on the device.");
+    return 0;
+  }
+
+  if (!initGraphicsPipeline(pipeline, stageCount, stageInfos, vertexInputInfo, inputAssemblyInfo, tessellationInfo, viewportInfo, rasterizationInfo,
+			    multisampleInfo, depthStencilInfo, colorBlendInfo, dynamicInfo, pipelineLayoutInfo, renderingInfo, VK_NULL_HANDLE, device))
+  {
+    ATLR_ERROR_MSG("initGraphicsPipeline returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static AtlrU8 initComputePipeline(AtlrPipeline* restrict pipeline,
+				  const VkPipelineShaderStageCreateInfo* restrict stageInfo,
+				  const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+				  const VkPipelineCreateFlags flags,
+				  const AtlrDevice* restrict device)
 {
   pipeline->device = device;
   
@@ -330,7 +438,7 @@ AtlrU8 atlrInitComputePipeline(AtlrPipeline* restrict pipeline,
   {
     .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
     .pNext = NULL,
-    .flags = 0,
+    .flags = flags,
     .stage = *stageInfo,
     .layout = pipeline->layout,
     .basePipelineHandle = VK_NULL_HANDLE,
@@ -347,6 +455,29 @@ AtlrU8 atlrInitComputePipeline(AtlrPipeline* restrict pipeline,
   return 1;
 }
 
+AtlrU8 atlrInitComputePipeline(AtlrPipeline* restrict pipeline,
+			       const VkPipelineShaderStageCreateInfo* restrict stageInfo,
+			       const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+			       const AtlrDevice* restrict device)
+{
+  return initComputePipeline(pipeline, stageInfo, pipelineLayoutInfo, 0, device);
+}
+
+// the set layouts in pipelineLayoutInfo must be created with atlrInitDescriptorBufferSetLayout
+AtlrU8 atlrInitDescriptorBufferComputePipeline(AtlrPipeline* restrict pipeline,
+					       const VkPipelineShaderStageCreateInfo* restrict stageInfo,
+					       const VkPipelineLayoutCreateInfo* restrict pipelineLayoutInfo,
+					       const AtlrDevice* restrict device)
+{
+  if (!device->features.descriptorBuffer)
+  {
+    ATLR_ERROR_MSG("Descriptor buffers are not enabled on the device.");
+    return 0;
+  }
+
+  return initComputePipeline(pipeline, stageInfo, pipelineLayoutInfo, VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT, device);
+}
+
 void atlrDeinitPipeline(const AtlrPipeline* restrict pipeline)
 {
   const AtlrDevice* device = pipeline->device;
@@ -72,14 +72,22 @@ AtlrU8 atlrInitRenderPass(AtlrRenderPass* renderPass,
   if (depthAttachment) attachmentCount++;
   if (resolveAttachments) attachmentCount += colorAttachmentCount;
 
-  VkAttachmentDescription* attachments = malloc(attachmentCount * sizeof(VkAttachmentDescription));
+  AtlrArena* scratch = device->instance->scratch;
+  const AtlrU64 scratchMark = atlrGetArenaMark(scratch);
+  VkAttachmentDescription* attachments = atlrArenaAlloc(scratch, attachmentCount * sizeof(VkAttachmentDescription), ATLR_ARENA_ALIGNMENT);
+  VkAttachmentReference* references = atlrArenaAlloc(scratch, attachmentCount * sizeof(VkAttachmentReference), ATLR_ARENA_ALIGNMENT);
+  if (!attachments || !references)
+  {
+    ATLR_ERROR_MSG("atlrArenaAlloc returned NULL.");
+    atlrRewindArena(scratch, scratchMark);
+    return 0;
+  }
   memcpy(attachments, colorAttachments, colorAttachmentCount * sizeof(VkAttachmentDescription));
   if (depthAttachment)
     memcpy(attachments + colorAttachmentCount, depthAttachment, sizeof(VkAttachmentDescription));
   if (resolveAttachments)
     memcpy(attachments + colorAttachmentCount + 1, resolveAttachments, colorAttachmentCount * sizeof(VkAttachmentDescription));
 
-  VkAttachmentReference* references = malloc(attachmentCount * sizeof(VkAttachmentReference));
   for (AtlrU32 i = 0; i < colorAttachmentCount; i++)
     references[i] = (VkAttachmentReference)
     {
@@ -128,8 +136,7 @@ AtlrU8 atlrInitRenderPass(AtlrRenderPass* renderPass,
   if (vkCreateRenderPass(device->logical, &renderPassInfo, device->instance->allocator, &renderPass->renderPass) != VK_SUCCESS)
   {
     ATLR_ERROR_MSG("vkCreateRenderPass did not return VK_SUCCESS.");
-    free(references);
-    free(attachments);
+    atlrRewindArena(scratch, scratchMark);
     return 0;
   }
 
@@ -140,9 +147,19 @@ AtlrU8 atlrInitRenderPass(AtlrRenderPass* renderPass,
     clearValues[colorAttachmentCount] = clearDepth;
   renderPass->clearValueCount = attachmentCount;
   renderPass->clearValues = clearValues;
+
+  // Compatibility only depends on the formats and sample counts of the attachments each subpass references.
+  // Load and store operations, layouts and dependencies are left out.
+  AtlrU64 hash = atlrHash(&colorAttachmentCount, sizeof(AtlrU32), ATLR_HASH_SEED);
+  for (AtlrU32 i = 0; i < attachmentCount; i++)
+  {
+    hash = atlrHash(&attachments[i].format, sizeof(VkFormat), hash);
+    hash = atlrHash(&attachments[i].samples, sizeof(VkSampleCountFlagBits), hash);
+  }
+  const AtlrU8 attachmentPresence[2] = {depthAttachment ? 1 : 0, resolveAttachments ? 1 : 0};
+  renderPass->compatibilityHash = atlrHash(attachmentPresence, sizeof(attachmentPresence), hash);
   
-  free(references);
-  free(attachments);
+  atlrRewindArena(scratch, scratchMark);
   return 1;
 }
 
@@ -177,10 +194,76 @@ void atlrBeginRenderPass(const AtlrRenderPass* restrict renderPass,
     .clearValueCount = renderPass->clearValueCount,
     .pClearValues = renderPass->clearValues
   };
-  vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+  renderPass->device->pfnCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void atlrEndRenderPass(const VkCommandBuffer commandBuffer, const AtlrDevice* restrict device)
+{
+  device->pfnCmdEndRenderPass(commandBuffer);
+}
+
+// Dynamic rendering renders straight into image views without render pass or framebuffer objects.
+// With a NULL clear color the attachment contents are loaded instead of cleared.
+VkRenderingAttachmentInfo atlrGetColorRenderingAttachmentInfo(const VkImageView imageView, const VkImageView resolveImageView, const VkClearValue* restrict clearColor)
+{
+  return (VkRenderingAttachmentInfo)
+  {
+    .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+    .pNext = NULL,
+    .imageView = imageView,
+    .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    .resolveMode = (resolveImageView != VK_NULL_HANDLE) ? VK_RESOLVE_MODE_AVERAGE_BIT : VK_RESOLVE_MODE_NONE,
+    .resolveImageView = resolveImageView,
+    .resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    .loadOp = clearColor ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD,
+    .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+    .clearValue = clearColor ? *clearColor : (VkClearValue){}
+  };
+}
+
+VkRenderingAttachmentInfo atlrGetDepthRenderingAttachmentInfo(const VkImageView imageView)
+{
+  return (VkRenderingAttachmentInfo)
+  {
+    .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+    .pNext = NULL,
+    .imageView = imageView,
+    .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+    .resolveMode = VK_RESOLVE_MODE_NONE,
+    .resolveImageView = VK_NULL_HANDLE,
+    .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+    .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+    .clearValue = clearDepth
+  };
+}
+
+// the attachments must already be in the layouts named by their attachment infos
+void atlrBeginRendering(const VkCommandBuffer commandBuffer,
+			const AtlrU32 colorAttachmentCount, const VkRenderingAttachmentInfo* restrict colorAttachments,
+			const VkRenderingAttachmentInfo* restrict depthAttachment, const VkExtent2D* restrict extent, const AtlrDevice* restrict device)
+{
+  const VkRenderingInfo renderingInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .renderArea = (VkRect2D)
+    {
+      .offset = {0, 0},
+      .extent = *extent
+    },
+    .layerCount = 1,
+    .viewMask = 0,
+    .colorAttachmentCount = colorAttachmentCount,
+    .pColorAttachments = colorAttachments,
+    .pDepthAttachment = depthAttachment,
+    .pStencilAttachment = NULL
+  };
+  device->pfnCmdBeginRendering(commandBuffer, &renderingInfo);
 }
 
-void atlrEndRenderPass(const VkCommandBuffer commandBuffer)
+void atlrEndRendering(const VkCommandBuffer commandBuffer, const AtlrDevice* restrict device)
 {
-  vkCmdEndRenderPass(commandBuffer);
+  device->pfnCmdEndRendering(commandBuffer);
 }
@@ -0,0 +1,525 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+// Pools own their resources in parallel arrays, so per-frame passes over all buffers, images or pipelines walk contiguous memory,
+// and the device pointer is stored once per pool instead of once per resource.
+// Pooled resources are read back into the usual structs with atlrGetPooled*, which fails for stale handles.
+
+#define GENERATION_MASK ((1u << (32 - ATLR_HANDLE_INDEX_BITS)) - 1)
+
+static AtlrU8 initHandlePool(AtlrHandlePool* restrict pool, const AtlrU32 capacity)
+{
+  if (capacity > (1u << ATLR_HANDLE_INDEX_BITS))
+  {
+    ATLR_ERROR_MSG("The pool capacity %u exceeds the %u slots a handle can index.", capacity, 1u << ATLR_HANDLE_INDEX_BITS);
+    return 0;
+  }
+
+  pool->capacity = capacity;
+  pool->count = 0;
+  pool->slotCount = 0;
+  pool->freeCount = 0;
+  pool->freeSlots = malloc(capacity * sizeof(AtlrU32));
+  pool->generations = malloc(capacity * sizeof(AtlrU32));
+  pool->denseIndices = malloc(capacity * sizeof(AtlrU32));
+  pool->slots = malloc(capacity * sizeof(AtlrU32));
+  if (capacity && (!pool->freeSlots || !pool->generations || !pool->denseIndices || !pool->slots))
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    free(pool->slots);
+    free(pool->denseIndices);
+    free(pool->generations);
+    free(pool->freeSlots);
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitHandlePool(AtlrHandlePool* restrict pool)
+{
+  free(pool->slots);
+  free(pool->denseIndices);
+  free(pool->generations);
+  free(pool->freeSlots);
+}
+
+// The new resource's dense index is always the previous count, so its arrays are filled in at index.
+static AtlrU8 takeHandle(AtlrHandlePool* restrict pool, AtlrHandle* restrict handle, AtlrU32* restrict index)
+{
+  AtlrU32 slot;
+  if (pool->freeCount)
+    slot = pool->freeSlots[--pool->freeCount];
+  else if (pool->slotCount < pool->capacity)
+  {
+    slot = pool->slotCount++;
+    pool->generations[slot] = 1;
+  }
+  else
+  {
+    ATLR_ERROR_MSG("The pool is full at %u resources.", pool->capacity);
+    return 0;
+  }
+
+  *index = pool->count++;
+  pool->denseIndices[slot] = *index;
+  pool->slots[*index] = slot;
+  *handle = (pool->generations[slot] << ATLR_HANDLE_INDEX_BITS) | slot;
+
+  return 1;
+}
+
+// Returns the dense index of the last resource, which the caller moves into the removed index when they differ.
+static AtlrU32 giveHandle(AtlrHandlePool* restrict pool, const AtlrU32 index)
+{
+  const AtlrU32 slot = pool->slots[index];
+  pool->generations[slot] = (pool->generations[slot] + 1) & GENERATION_MASK;
+  if (!pool->generations[slot])
+    pool->generations[slot] = 1;
+  pool->freeSlots[pool->freeCount++] = slot;
+
+  const AtlrU32 last = --pool->count;
+  if (index != last)
+  {
+    pool->slots[index] = pool->slots[last];
+    pool->denseIndices[pool->slots[index]] = index;
+  }
+
+  return last;
+}
+
+// Finds the dense index of a live handle, returning 0 for the null handle and stale handles.
+AtlrU8 atlrGetPooledIndex(const AtlrHandlePool* restrict pool, const AtlrHandle handle, AtlrU32* restrict index)
+{
+  const AtlrU32 slot = handle & ((1u << ATLR_HANDLE_INDEX_BITS) - 1);
+  const AtlrU32 generation = handle >> ATLR_HANDLE_INDEX_BITS;
+  if (slot >= pool->slotCount || pool->generations[slot] != generation)
+    return 0;
+
+  const AtlrU32 denseIndex = pool->denseIndices[slot];
+  if (denseIndex >= pool->count || pool->slots[denseIndex] != slot)
+    return 0;
+
+  *index = denseIndex;
+  return 1;
+}
+
+AtlrU8 atlrInitBufferPool(AtlrBufferPool* restrict pool, const AtlrU32 capacity, const AtlrDevice* restrict device)
+{
+  pool->device = device;
+  if (!initHandlePool(&pool->handles, capacity))
+  {
+    ATLR_ERROR_MSG("initHandlePool returned 0.");
+    return 0;
+  }
+
+  pool->buffers = malloc(capacity * sizeof(VkBuffer));
+  pool->memories = malloc(capacity * sizeof(VkDeviceMemory));
+  pool->data = malloc(capacity * sizeof(void*));
+  pool->isDirect = malloc(capacity * sizeof(AtlrU8));
+  pool->isDirectCached = malloc(capacity * sizeof(AtlrU8));
+  pool->isImported = malloc(capacity * sizeof(AtlrU8));
+  if (capacity && (!pool->buffers || !pool->memories || !pool->data || !pool->isDirect || !pool->isDirectCached || !pool->isImported))
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    free(pool->isImported);
+    free(pool->isDirectCached);
+    free(pool->isDirect);
+    free(pool->data);
+    free(pool->memories);
+    free(pool->buffers);
+    deinitHandlePool(&pool->handles);
+    return 0;
+  }
+
+  return 1;
+}
+
+static void gatherBuffer(const AtlrBufferPool* restrict pool, const AtlrU32 index, AtlrBuffer* restrict buffer)
+{
+  buffer->device = pool->device;
+  buffer->buffer = pool->buffers[index];
+  buffer->memory = pool->memories[index];
+  buffer->data = pool->data[index];
+  buffer->isDirect = pool->isDirect[index];
+  buffer->isDirectCached = pool->isDirectCached[index];
+  buffer->isImported = pool->isImported[index];
+}
+
+// The device must be idle, as the remaining buffers are deinitialized.
+void atlrDeinitBufferPool(AtlrBufferPool* restrict pool)
+{
+  for (AtlrU32 i = 0; i < pool->handles.count; i++)
+  {
+    AtlrBuffer buffer;
+    gatherBuffer(pool, i, &buffer);
+    atlrDeinitBuffer(&buffer);
+  }
+
+  free(pool->isImported);
+  free(pool->isDirectCached);
+  free(pool->isDirect);
+  free(pool->data);
+  free(pool->memories);
+  free(pool->buffers);
+  deinitHandlePool(&pool->handles);
+}
+
+// The pool takes ownership of an initialized buffer.
+AtlrU8 atlrAddPooledBuffer(AtlrBufferPool* restrict pool, AtlrHandle* restrict handle, const AtlrBuffer* restrict buffer)
+{
+  if (buffer->device != pool->device)
+  {
+    ATLR_ERROR_MSG("The buffer belongs to a different device than the pool.");
+    return 0;
+  }
+
+  AtlrU32 index;
+  if (!takeHandle(&pool->handles, handle, &index))
+  {
+    ATLR_ERROR_MSG("takeHandle returned 0.");
+    return 0;
+  }
+  pool->buffers[index] = buffer->buffer;
+  pool->memories[index] = buffer->memory;
+  pool->data[index] = buffer->data;
+  pool->isDirect[index] = buffer->isDirect;
+  pool->isDirectCached[index] = buffer->isDirectCached;
+  pool->isImported[index] = buffer->isImported;
+
+  return 1;
+}
+
+AtlrU8 atlrGetPooledBuffer(const AtlrBufferPool* restrict pool, const AtlrHandle handle, AtlrBuffer* restrict buffer)
+{
+  AtlrU32 index;
+  if (!atlrGetPooledIndex(&pool->handles, handle, &index))
+  {
+    ATLR_ERROR_MSG("Stale or invalid buffer handle 0x%x.", handle);
+    return 0;
+  }
+  gatherBuffer(pool, index, buffer);
+
+  return 1;
+}
+
+// The buffer is deinitialized right away when the queue is NULL, otherwise once the device passes value.
+AtlrU8 atlrRemovePooledBuffer(AtlrBufferPool* restrict pool, const AtlrHandle handle, AtlrDeletionQueue* restrict queue, const AtlrU64 value)
+{
+  AtlrBuffer buffer;
+  if (!atlrGetPooledBuffer(pool, handle, &buffer))
+  {
+    ATLR_ERROR_MSG("atlrGetPooledBuffer returned 0.");
+    return 0;
+  }
+  if (queue)
+  {
+    if (!atlrDeferDeinitBuffer(queue, &buffer, value))
+    {
+      ATLR_ERROR_MSG("atlrDeferDeinitBuffer returned 0.");
+      return 0;
+    }
+  }
+  else
+    atlrDeinitBuffer(&buffer);
+
+  AtlrU32 index;
+  atlrGetPooledIndex(&pool->handles, handle, &index);
+  const AtlrU32 last = giveHandle(&pool->handles, index);
+  if (index != last)
+  {
+    pool->buffers[index] = pool->buffers[last];
+    pool->memories[index] = pool->memories[last];
+    pool->data[index] = pool->data[last];
+    pool->isDirect[index] = pool->isDirect[last];
+    pool->isDirectCached[index] = pool->isDirectCached[last];
+    pool->isImported[index] = pool->isImported[last];
+  }
+
+  return 1;
+}
+
+AtlrU8 atlrInitImagePool(AtlrImagePool* restrict pool, const AtlrU32 capacity, const AtlrDevice* restrict device)
+{
+  pool->device = device;
+  if (!initHandlePool(&pool->handles, capacity))
+  {
+    ATLR_ERROR_MSG("initHandlePool returned 0.");
+    return 0;
+  }
+
+  pool->images = malloc(capacity * sizeof(VkImage));
+  pool->memories = malloc(capacity * sizeof(VkDeviceMemory));
+  pool->imageViews = malloc(capacity * sizeof(VkImageView));
+  pool->formats = malloc(capacity * sizeof(VkFormat));
+  pool->widths = malloc(capacity * sizeof(AtlrU32));
+  pool->heights = malloc(capacity * sizeof(AtlrU32));
+  pool->mipLevels = malloc(capacity * sizeof(AtlrU32));
+  pool->layerCounts = malloc(capacity * sizeof(AtlrU32));
+  if (capacity && (!pool->images || !pool->memories || !pool->imageViews || !pool->formats
+		   || !pool->widths || !pool->heights || !pool->mipLevels || !pool->layerCounts))
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    free(pool->layerCounts);
+    free(pool->mipLevels);
+    free(pool->heights);
+    free(pool->widths);
+    free(pool->formats);
+    free(pool->imageViews);
+    free(pool->memories);
+    free(pool->images);
+    deinitHandlePool(&pool->handles);
+    return 0;
+  }
+
+  return 1;
+}
+
+static void gatherImage(const AtlrImagePool* restrict pool, const AtlrU32 index, AtlrImage* restrict image)
+{
+  image->device = pool->device;
+  image->image = pool->images[index];
+  image->memory = pool->memories[index];
+  image->imageView = pool->imageViews[index];
+  image->format = pool->formats[index];
+  image->width = pool->widths[index];
+  image->height = pool->heights[index];
+  image->mipLevels = pool->mipLevels[index];
+  image->layerCount = pool->layerCounts[index];
+}
+
+// The device must be idle, as the remaining images are deinitialized.
+void atlrDeinitImagePool(AtlrImagePool* restrict pool)
+{
+  for (AtlrU32 i = 0; i < pool->handles.count; i++)
+  {
+    AtlrImage image;
+    gatherImage(pool, i, &image);
+    atlrDeinitImage(&image);
+  }
+
+  free(pool->layerCounts);
+  free(pool->mipLevels);
+  free(pool->heights);
+  free(pool->widths);
+  free(pool->formats);
+  free(pool->imageViews);
+  free(pool->memories);
+  free(pool->images);
+  deinitHandlePool(&pool->handles);
+}
+
+// The pool takes ownership of an initialized image.
+AtlrU8 atlrAddPooledImage(AtlrImagePool* restrict pool, AtlrHandle* restrict handle, const AtlrImage* restrict image)
+{
+  if (image->device != pool->device)
+  {
+    ATLR_ERROR_MSG("The image belongs to a different device than the pool.");
+    return 0;
+  }
+
+  AtlrU32 index;
+  if (!takeHandle(&pool->handles, handle, &index))
+  {
+    ATLR_ERROR_MSG("takeHandle returned 0.");
+    return 0;
+  }
+  pool->images[index] = image->image;
+  pool->memories[index] = image->memory;
+  pool->imageViews[index] = image->imageView;
+  pool->formats[index] = image->format;
+  pool->widths[index] = image->width;
+  pool->heights[index] = image->height;
+  pool->mipLevels[index] = image->mipLevels;
+  pool->layerCounts[index] = image->layerCount;
+
+  return 1;
+}
+
+AtlrU8 atlrGetPooledImage(const AtlrImagePool* restrict pool, const AtlrHandle handle, AtlrImage* restrict image)
+{
+  AtlrU32 index;
+  if (!atlrGetPooledIndex(&pool->handles, handle, &index))
+  {
+    ATLR_ERROR_MSG("Stale or invalid image handle 0x%x.", handle);
+    return 0;
+  }
+  gatherImage(pool, index, image);
+
+  return 1;
+}
+
+// The image is deinitialized right away when the queue is NULL, otherwise once the device passes value.
+AtlrU8 atlrRemovePooledImage(AtlrImagePool* restrict pool, const AtlrHandle handle, AtlrDeletionQueue* restrict queue, const AtlrU64 value)
+{
+  AtlrImage image;
+  if (!atlrGetPooledImage(pool, handle, &image))
+  {
+    ATLR_ERROR_MSG("atlrGetPooledImage returned 0.");
+    return 0;
+  }
+  if (queue)
+  {
+    if (!atlrDeferDeinitImage(queue, &image, value))
+    {
+      ATLR_ERROR_MSG("atlrDeferDeinitImage returned 0.");
+      return 0;
+    }
+  }
+  else
+    atlrDeinitImage(&image);
+
+  AtlrU32 index;
+  atlrGetPooledIndex(&pool->handles, handle, &index);
+  const AtlrU32 last = giveHandle(&pool->handles, index);
+  if (index != last)
+  {
+    pool->images[index] = pool->images[last];
+    pool->memories[index] = pool->memories[last];
+    pool->imageViews[index] = pool->imageViews[last];
+    pool->formats[index] = pool->formats[last];
+    pool->widths[index] = pool->widths[last];
+    pool->heights[index] = pool->heights[last];
+    pool->mipLevels[index] = pool->mipLevels[last];
+    pool->layerCounts[index] = pool->layerCounts[last];
+  }
+
+  return 1;
+}
+
+AtlrU8 atlrInitPipelinePool(AtlrPipelinePool* restrict pool, const AtlrU32 capacity, const AtlrDevice* restrict device)
+{
+  pool->device = device;
+  if (!initHandlePool(&pool->handles, capacity))
+  {
+    ATLR_ERROR_MSG("initHandlePool returned 0.");
+    return 0;
+  }
+
+  pool->layouts = malloc(capacity * sizeof(VkPipelineLayout));
+  pool->pipelines = malloc(capacity * sizeof(VkPipeline));
+  pool->bindPoints = malloc(capacity * sizeof(VkPipelineBindPoint));
+  if (capacity && (!pool->layouts || !pool->pipelines || !pool->bindPoints))
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    free(pool->bindPoints);
+    free(pool->pipelines);
+    free(pool->layouts);
+    deinitHandlePool(&pool->handles);
+    return 0;
+  }
+
+  return 1;
+}
+
+static void gatherPipeline(const AtlrPipelinePool* restrict pool, const AtlrU32 index, AtlrPipeline* restrict pipeline)
+{
+  pipeline->device = pool->device;
+  pipeline->layout = pool->layouts[index];
+  pipeline->pipeline = pool->pipelines[index];
+  pipeline->bindPoint = pool->bindPoints[index];
+}
+
+// The device must be idle, as the remaining pipelines are deinitialized.
+void atlrDeinitPipelinePool(AtlrPipelinePool* restrict pool)
+{
+  for (AtlrU32 i = 0; i < pool->handles.count; i++)
+  {
+    AtlrPipeline pipeline;
+    gatherPipeline(pool, i, &pipeline);
+    atlrDeinitPipeline(&pipeline);
+  }
+
+  free(pool->bindPoints);
+  free(pool->pipelines);
+  free(pool->layouts);
+  deinitHandlePool(&pool->handles);
+}
+
+// The pool takes ownership of an initialized pipeline.
+AtlrU8 atlrAddPooledPipeline(AtlrPipelinePool* restrict pool, AtlrHandle* restrict handle, const AtlrPipeline* restrict pipeline)
+{
+  if (pipeline->device != pool->device)
+  {
+    ATLR_ERROR_MSG("The pipeline belongs to a different device than the pool.");
+    return 0;
+  }
+
+  AtlrU32 index;
+  if (!takeHandle(&pool->handles, handle, &index))
+  {
+    ATLR_ERROR_MSG("takeHandle returned 0.");
+    return 0;
+  }
+  pool->layouts[index] = pipeline->layout;
+  pool->pipelines[index] = pipeline->pipeline;
+  pool->bindPoints[index] = pipeline->bindPoint;
+
+  return 1;
+}
+
+AtlrU8 atlrGetPooledPipeline(const AtlrPipelinePool* restrict pool, const AtlrHandle handle, AtlrPipeline* restrict pipeline)
+{
+  AtlrU32 index;
+  if (!atlrGetPooledIndex(&pool->handles, handle, &index))
+  {
+    ATLR_ERROR_MSG("Stale or invalid pipeline handle 0x%x.", handle);
+    return 0;
+  }
+  gatherPipeline(pool, index, pipeline);
+
+  return 1;
+}
+
+// The pipeline is deinitialized right away when the queue is NULL, otherwise once the device passes value.
+AtlrU8 atlrRemovePooledPipeline(AtlrPipelinePool* restrict pool, const AtlrHandle handle, AtlrDeletionQueue* restrict queue, const AtlrU64 value)
+{
+  AtlrPipeline pipeline;
+  if (!atlrGetPooledPipeline(pool, handle, &pipeline))
+  {
+    ATLR_ERROR_MSG("atlrGetPooledPipeline returned 0.");
+    return 0;
+  }
+  if (queue)
+  {
+    if (!atlrDeferDeinitPipeline(queue, &pipeline, value))
+    {
+      ATLR_ERROR_MSG("atlrDeferDeinitPipeline returned 0.");
+      return 0;
+    }
+  }
+  else
+    atlrDeinitPipeline(&pipeline);
+
+  AtlrU32 index;
+  atlrGetPooledIndex(&pool->handles, handle, &index);
+  const AtlrU32 last = giveHandle(&pool->handles, index);
+  if (index != last)
+  {
+    pool->layouts[index] = pool->layouts[last];
+    pool->pipelines[index] = pool->pipelines[last];
+    pool->bindPoints[index] = pool->bindPoints[last];
+  }
+
+  return 1;
+}
@@ -0,0 +1,183 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+#include <string.h>
+
+// the key keeps only the sampler state, so that two infos with the same state compare and hash equal byte for byte
+static VkSamplerCreateInfo initSamplerKey(const VkSamplerCreateInfo* restrict samplerInfo)
+{
+  VkSamplerCreateInfo key;
+  memset(&key, 0, sizeof(VkSamplerCreateInfo));
+  key.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  key.flags = samplerInfo->flags;
+  key.magFilter = samplerInfo->magFilter;
+  key.minFilter = samplerInfo->minFilter;
+  key.mipmapMode = samplerInfo->mipmapMode;
+  key.addressModeU = samplerInfo->addressModeU;
+  key.addressModeV = samplerInfo->addressModeV;
+  key.addressModeW = samplerInfo->addressModeW;
+  key.mipLodBias = samplerInfo->mipLodBias;
+  key.anisotropyEnable = samplerInfo->anisotropyEnable;
+  key.maxAnisotropy = samplerInfo->maxAnisotropy;
+  key.compareEnable = samplerInfo->compareEnable;
+  key.compareOp = samplerInfo->compareOp;
+  key.minLod = samplerInfo->minLod;
+  key.maxLod = samplerInfo->maxLod;
+  key.borderColor = samplerInfo->borderColor;
+  key.unnormalizedCoordinates = samplerInfo->unnormalizedCoordinates;
+  
+  return key;
+}
+
+// The sampler most of the library and samples use, only the filter and address mode tend to vary.
+// The lod is left unclamped, so images with mip chains sample all their levels and single level images are unaffected.
+VkSamplerCreateInfo atlrInitSamplerInfo(const VkFilter filter, const VkSamplerAddressMode addressMode)
+{
+  const VkSamplerCreateInfo samplerInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .magFilter = filter,
+    .minFilter = filter,
+    .mipmapMode = (filter == VK_FILTER_NEAREST) ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR,
+    .addressModeU = addressMode,
+    .addressModeV = addressMode,
+    .addressModeW = addressMode,
+    .mipLodBias = 0.0f,
+    .anisotropyEnable = VK_FALSE,
+    .maxAnisotropy = 1.0f,
+    .compareEnable = VK_FALSE,
+    .compareOp = VK_COMPARE_OP_ALWAYS,
+    .minLod = 0.0f,
+    .maxLod = VK_LOD_CLAMP_NONE,
+    .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
+    .unnormalizedCoordinates = VK_FALSE
+  };
+
+  return samplerInfo;
+}
+
+void atlrInitSamplerCache(AtlrSamplerCache* restrict cache)
+{
+  cache->count = 0;
+  cache->capacity = 0;
+  cache->entries = NULL;
+}
+
+// samplers still acquired at this point are destroyed along with the cache
+void atlrDeinitSamplerCache(AtlrSamplerCache* restrict cache, const AtlrDevice* restrict device)
+{
+  if (cache->count)
+    atlrLog(ATLR_LOG_WARN, "%u samplers were not released before the sampler cache was deinitialized.", cache->count);
+  
+  for (AtlrU32 i = 0; i < cache->count; i++)
+    vkDestroySampler(device->logical, cache->entries[i].sampler, device->instance->allocator);
+  free(cache->entries);
+  atlrInitSamplerCache(cache);
+}
+
+// Samplers are shared by every caller asking for the same state; each acquire must be paired with an atlrReleaseSampler.
+// Infos with a pNext chain are not cached, since the chained state cannot be compared.
+VkSampler atlrAcquireSampler(const AtlrDevice* restrict device, const VkSamplerCreateInfo* restrict samplerInfo)
+{
+  AtlrSamplerCache* cache = device->samplerCache;
+  
+  if (samplerInfo->pNext)
+  {
+    ATLR_ERROR_MSG("Sampler infos with a pNext chain are not supported by the sampler cache.");
+    return VK_NULL_HANDLE;
+  }
+
+  const VkSamplerCreateInfo key = initSamplerKey(samplerInfo);
+  const AtlrU64 hash = atlrHash(&key, sizeof(VkSamplerCreateInfo), ATLR_HASH_SEED);
+  for (AtlrU32 i = 0; i < cache->count; i++)
+  {
+    AtlrSamplerCacheEntry* entry = cache->entries + i;
+    if ((entry->hash == hash) && !memcmp(&entry->key, &key, sizeof(VkSamplerCreateInfo)))
+    {
+      entry->referenceCount++;
+      return entry->sampler;
+    }
+  }
+
+  if (cache->count == cache->capacity)
+  {
+    const AtlrU32 capacity = cache->capacity ? 2 * cache->capacity : 8;
+    AtlrSamplerCacheEntry* entries = realloc(cache->entries, capacity * sizeof(AtlrSamplerCacheEntry));
+    if (!entries)
+    {
+      ATLR_ERROR_MSG("realloc returned NULL.");
+      return VK_NULL_HANDLE;
+    }
+    cache->entries = entries;
+    cache->capacity = capacity;
+  }
+
+  VkSampler sampler;
+  if (vkCreateSampler(device->logical, &key, device->instance->allocator, &sampler) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateSampler did not return VK_SUCCESS.");
+    return VK_NULL_HANDLE;
+  }
+  
+  cache->entries[cache->count++] = (AtlrSamplerCacheEntry)
+  {
+    .key = key,
+    .hash = hash,
+    .sampler = sampler,
+    .referenceCount = 1
+  };
+  
+  return sampler;
+}
+
+// the sampler is destroyed once its last reference is released, so it must no longer be in use by the device
+void atlrReleaseSampler(const AtlrDevice* restrict device, const VkSampler sampler)
+{
+  AtlrSamplerCache* cache = device->samplerCache;
+  
+  for (AtlrU32 i = 0; i < cache->count; i++)
+  {
+    AtlrSamplerCacheEntry* entry = cache->entries + i;
+    if (entry->sampler != sampler) continue;
+
+    if (--entry->referenceCount) return;
+    
+    vkDestroySampler(device->logical, sampler, device->instance->allocator);
+    *entry = cache->entries[--cache->count];
+    return;
+  }
+
+  ATLR_ERROR_MSG("The sampler was not acquired from the sampler cache.");
+}
+
+// Bakes the sampler into the set layout, so descriptor writes for the binding leave the sampler out.
+// The sampler pointer has to stay valid until the set layout is created, and the sampler must outlive the set layout.
+VkDescriptorSetLayoutBinding atlrInitImmutableSamplerDescriptorSetLayoutBinding(const AtlrU32 binding, const VkDescriptorType type, const VkShaderStageFlags stageFlags,
+										 const VkSampler* restrict sampler)
+{
+  VkDescriptorSetLayoutBinding setLayoutBinding = atlrInitDescriptorSetLayoutBinding(binding, type, stageFlags);
+  setLayoutBinding.pImmutableSamplers = sampler;
+  
+  return setLayoutBinding;
+}
@@ -0,0 +1,201 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+// the graphics stages vkCmdBindShadersEXT is given; stages without a shader are bound to VK_NULL_HANDLE
+static const VkShaderStageFlagBits graphicsStages[] =
+{
+  VK_SHADER_STAGE_VERTEX_BIT,
+  VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+  VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+  VK_SHADER_STAGE_GEOMETRY_BIT,
+  VK_SHADER_STAGE_FRAGMENT_BIT
+};
+#define GRAPHICS_STAGE_COUNT (sizeof(graphicsStages) / sizeof(VkShaderStageFlagBits))
+
+VkShaderCreateInfoEXT atlrInitShaderObjectInfo(const VkShaderStageFlagBits stage, const VkShaderStageFlags nextStage, const AtlrSpirVBinary* restrict bin,
+					       const AtlrU32 setLayoutCount, const VkDescriptorSetLayout* restrict setLayouts,
+					       const AtlrU32 pushConstantRangeCount, const VkPushConstantRange* restrict pushConstantRanges)
+{
+  return (VkShaderCreateInfoEXT)
+  {
+    .sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
+    .pNext = NULL,
+    .flags = 0,
+    .stage = stage,
+    .nextStage = nextStage,
+    .codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT,
+    .codeSize = bin->codeSize,
+    .pCode = bin->code,
+    .pName = "main",
+    .setLayoutCount = setLayoutCount,
+    .pSetLayouts = setLayouts,
+    .pushConstantRangeCount = pushConstantRangeCount,
+    .pPushConstantRanges = pushConstantRanges,
+    .pSpecializationInfo = NULL
+  };
+}
+
+// Linked shaders are compiled together and may be optimized across stages, but they must then always be bound together.
+AtlrU8 atlrInitShaderObjects(AtlrShaderObject* restrict shaders, const AtlrU32 shaderCount, const VkShaderCreateInfoEXT* restrict infos,
+			     const AtlrU8 isLinked, const AtlrDevice* restrict device)
+{
+  if (!device->features.shaderObject)
+  {
+    ATLR_ERROR_MSG("The shader object feature is not enabled on the device.");
+    return 0;
+  }
+
+  VkShaderCreateInfoEXT* shaderInfos = malloc(shaderCount * sizeof(VkShaderCreateInfoEXT));
+  VkShaderEXT* handles = malloc(shaderCount * sizeof(VkShaderEXT));
+  if (!shaderInfos || !handles)
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    free(handles);
+    free(shaderInfos);
+    return 0;
+  }
+  for (AtlrU32 i = 0; i < shaderCount; i++)
+  {
+    shaderInfos[i] = infos[i];
+    if (isLinked && (shaderCount > 1)) shaderInfos[i].flags |= VK_SHADER_CREATE_LINK_STAGE_BIT_EXT;
+  }
+
+  if (device->pfnCreateShaders(device->logical, shaderCount, shaderInfos, device->instance->allocator, handles) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateShadersEXT did not return VK_SUCCESS.");
+    // on failure the handles that were created are still valid and must be destroyed
+    for (AtlrU32 i = 0; i < shaderCount; i++)
+      if (handles[i] != VK_NULL_HANDLE) device->pfnDestroyShader(device->logical, handles[i], device->instance->allocator);
+    free(handles);
+    free(shaderInfos);
+    return 0;
+  }
+
+  for (AtlrU32 i = 0; i < shaderCount; i++)
+    shaders[i] = (AtlrShaderObject)
+    {
+      .device = device,
+      .shader = handles[i],
+      .stage = shaderInfos[i].stage
+    };
+
+#ifdef ATLR_DEBUG
+  for (AtlrU32 i = 0; i < shaderCount; i++)
+    atlrSetObjectName(VK_OBJECT_TYPE_SHADER_EXT, (AtlrU64)shaders[i].shader, "Shader Object", device);
+#endif
+
+  free(handles);
+  free(shaderInfos);
+  return 1;
+}
+
+void atlrDeinitShaderObject(const AtlrShaderObject* restrict shader)
+{
+  const AtlrDevice* device = shader->device;
+  device->pfnDestroyShader(device->logical, shader->shader, device->instance->allocator);
+}
+
+// A compute shader is bound on its own; graphics shaders replace every graphics stage, so stages missing from the list are unbound.
+void atlrCommandBindShaderObjects(const VkCommandBuffer commandBuffer, const AtlrU32 shaderCount, const AtlrShaderObject* restrict shaders, const AtlrDevice* restrict device)
+{
+  VkShaderEXT graphicsShaders[GRAPHICS_STAGE_COUNT] = {};
+  AtlrU8 isGraphics = 0;
+  for (AtlrU32 i = 0; i < shaderCount; i++)
+  {
+    const AtlrShaderObject* shader = shaders + i;
+    if (shader->stage == VK_SHADER_STAGE_COMPUTE_BIT)
+    {
+      device->pfnCmdBindShaders(commandBuffer, 1, &shader->stage, &shader->shader);
+      continue;
+    }
+    for (AtlrU32 j = 0; j < GRAPHICS_STAGE_COUNT; j++)
+      if (shader->stage == graphicsStages[j])
+      {
+	graphicsShaders[j] = shader->shader;
+	isGraphics = 1;
+	break;
+      }
+  }
+
+  if (isGraphics) device->pfnCmdBindShaders(commandBuffer, GRAPHICS_STAGE_COUNT, graphicsStages, graphicsShaders);
+}
+
+// replaces the shader bound to a single stage, leaving the other stages as they are
+void atlrCommandBindShaderObject(const VkCommandBuffer commandBuffer, const AtlrShaderObject* restrict shader, const AtlrDevice* restrict device)
+{
+  device->pfnCmdBindShaders(commandBuffer, 1, &shader->stage, &shader->shader);
+}
+
+// Shader objects have no baked state, so every state a draw consumes is recorded here.
+// Stencil operations are left to the caller when the stencil test is enabled.
+void atlrCommandSetShaderObjectState(const VkCommandBuffer commandBuffer, const AtlrExtendedDynamicState* restrict state, const VkExtent2D extent,
+				     const VkSampleCountFlagBits samples,
+				     const AtlrU32 vertexBindingCount, const VkVertexInputBindingDescription2EXT* restrict vertexBindings,
+				     const AtlrU32 vertexAttributeCount, const VkVertexInputAttributeDescription2EXT* restrict vertexAttributes,
+				     const AtlrDevice* restrict device)
+{
+  const VkViewport viewport =
+  {
+    .x = 0.0f,
+    .y = 0.0f,
+    .width = extent.width,
+    .height = extent.height,
+    .minDepth = 0.0f,
+    .maxDepth = 1.0f
+  };
+  const VkRect2D scissor =
+  {
+    .offset = {0, 0},
+    .extent = extent
+  };
+  device->pfnCmdSetViewportWithCount(commandBuffer, 1, &viewport);
+  device->pfnCmdSetScissorWithCount(commandBuffer, 1, &scissor);
+  device->pfnCmdSetLineWidth(commandBuffer, 1.0f);
+  device->pfnCmdSetDepthBias(commandBuffer, 0.0f, 0.0f, 0.0f);
+  device->pfnCmdSetDepthBoundsTestEnable(commandBuffer, VK_FALSE);
+
+  atlrCommandSetExtendedDynamicState(commandBuffer, state, device);
+  if (!device->features.extendedDynamicState3)
+  {
+    device->pfnCmdSetPolygonMode(commandBuffer, state->polygonMode);
+    device->pfnCmdSetColorBlendEnable(commandBuffer, 0, 1, &state->colorBlendEnable);
+    device->pfnCmdSetColorWriteMask(commandBuffer, 0, 1, &state->colorWriteMask);
+  }
+
+  // the same blend equation as atlrInitPipelineColorBlendAttachmentStateAlpha; it only applies while blending is enabled
+  const VkColorBlendEquationEXT colorBlendEquation =
+  {
+    .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+    .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+    .colorBlendOp = VK_BLEND_OP_ADD,
+    .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+    .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+    .alphaBlendOp = VK_BLEND_OP_ADD
+  };
+  const VkSampleMask sampleMask[2] = {0xFFFFFFFF, 0xFFFFFFFF};
+  device->pfnCmdSetColorBlendEquation(commandBuffer, 0, 1, &colorBlendEquation);
+  device->pfnCmdSetRasterizationSamples(commandBuffer, samples);
+  device->pfnCmdSetSampleMask(commandBuffer, samples, sampleMask);
+  device->pfnCmdSetAlphaToCoverageEnable(commandBuffer, VK_FALSE);
+  device->pfnCmdSetVertexInput(commandBuffer, vertexBindingCount, vertexBindings, vertexAttributeCount, vertexAttributes);
+}
@@ -0,0 +1,169 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+static AtlrU32 getTexelSize(const VkFormat format)
+{
+  switch (format)
+  {
+    case VK_FORMAT_R8_UNORM:
+      return 1;
+    case VK_FORMAT_R8G8_UNORM:
+      return 2;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+      return 4;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+      return 8;
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+// The images start out black and in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, so they can be bound to descriptors right away.
+AtlrU8 atlrInitStreamingTexture(AtlrStreamingTexture* restrict texture, const AtlrU32 width, const AtlrU32 height, const VkFormat format, const AtlrU8 frameCount,
+				const AtlrDevice* restrict device, const AtlrSingleRecordCommandContext* restrict commandContext)
+{
+  const AtlrU32 texelSize = getTexelSize(format);
+  if (!texelSize)
+  {
+    ATLR_ERROR_MSG("Unsupported streaming texture format.");
+    return 0;
+  }
+
+  texture->device = device;
+  texture->frameCount = frameCount;
+  texture->frameSize = (AtlrU64)texelSize * width * height;
+  texture->images = malloc(frameCount * sizeof(AtlrImage));
+  texture->stagingBuffers = malloc(frameCount * sizeof(AtlrBuffer));
+
+  const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  for (AtlrU8 i = 0; i < frameCount; i++)
+  {
+    if (!atlrInitImage(texture->images + i, width, height, 1, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage,
+		       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, device))
+    {
+      ATLR_ERROR_MSG("atlrInitImage returned 0.");
+      return 0;
+    }
+
+    // the staging buffers stay mapped for the lifetime of the texture
+    AtlrBuffer* stagingBuffer = texture->stagingBuffers + i;
+    if (!atlrInitStagingBuffer(stagingBuffer, texture->frameSize, device) || !atlrMapBuffer(stagingBuffer, 0, texture->frameSize, 0))
+    {
+      ATLR_ERROR_MSG("Failed to create a mapped streaming texture staging buffer.");
+      return 0;
+    }
+    memset(stagingBuffer->data, 0, texture->frameSize);
+  }
+
+  VkCommandBuffer commandBuffer;
+  if (!atlrBeginSingleRecordCommands(&commandBuffer, commandContext))
+  {
+    ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+    return 0;
+  }
+  for (AtlrU8 i = 0; i < frameCount; i++)
+  {
+    if (!atlrCommandUploadStreamingTexture(texture, commandBuffer, i))
+    {
+      ATLR_ERROR_MSG("atlrCommandUploadStreamingTexture returned 0.");
+      return 0;
+    }
+  }
+  if (!atlrEndSingleRecordCommands(commandBuffer, commandContext))
+  {
+    ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+void atlrDeinitStreamingTexture(const AtlrStreamingTexture* restrict texture)
+{
+  for (AtlrU8 i = 0; i < texture->frameCount; i++)
+  {
+    atlrDeinitImage(texture->images + i);
+    atlrUnmapBuffer(texture->stagingBuffers + i);
+    atlrDeinitBuffer(texture->stagingBuffers + i);
+  }
+  free(texture->images);
+  free(texture->stagingBuffers);
+}
+
+// The mapped staging memory of a frame, tightly packed rows of texels.
+// It may only be written once the frame's previous submission has finished, e.g. after its in flight fence has been waited on.
+void* atlrGetStreamingTextureData(const AtlrStreamingTexture* restrict texture, const AtlrU8 frame)
+{
+  return texture->stagingBuffers[frame].data;
+}
+
+// Record the upload of a frame's staging memory into its image, outside of any render pass.
+// Host writes made before the submission are visible to the copy without a barrier, and the image is left ready for fragment and compute shaders.
+// A frame that is not uploaded keeps the contents of its last upload.
+AtlrU8 atlrCommandUploadStreamingTexture(const AtlrStreamingTexture* restrict texture, const VkCommandBuffer commandBuffer, const AtlrU8 frame)
+{
+  const AtlrImage* image = texture->images + frame;
+  const VkImageSubresourceRange range =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  const VkBufferImageCopy region =
+  {
+    .bufferOffset = 0,
+    .bufferRowLength = 0,
+    .bufferImageHeight = 0,
+    .imageSubresource = (VkImageSubresourceLayers)
+    {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .mipLevel = 0,
+      .baseArrayLayer = 0,
+      .layerCount = 1
+    },
+    .imageOffset = (VkOffset3D){.x = 0, .y = 0, .z = 0},
+    .imageExtent = (VkExtent3D){.width = image->width, .height = image->height, .depth = 1}
+  };
+
+  // the whole image is overwritten, so its old contents are discarded
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, image->device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+  image->device->pfnCmdCopyBufferToImage(commandBuffer, texture->stagingBuffers[frame].buffer, image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+  if (!atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, image->device))
+  {
+    ATLR_ERROR_MSG("atlrCommandImageLayoutBarrier returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
@@ -74,12 +74,12 @@ static VkExtent2D getExtent(const VkSurfaceCapabilitiesKHR* restrict capabilitie
   return extent;
 }
 
-AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8 initRenderPass, AtlrU8 (*onReinit)(void*), void* reinitData, const VkClearValue* restrict clearColor,
-				 const AtlrDevice* restrict device)
+// the rendering mode and clear color are set before the first call and kept across reinitialization
+static AtlrU8 initSwapchain(AtlrSwapchain* restrict swapchain, const AtlrU8 initRenderPass, AtlrU8 (*onReinit)(void*), void* reinitData,
+			    const AtlrDevice* restrict device)
 {
   swapchain->onReinit = onReinit;
   swapchain->reinitData = reinitData;
-  VkClearValue clearValue = clearColor ? *clearColor : (VkClearValue){.color = {.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}};
   
   VkPhysicalDeviceProperties properties;
   vkGetPhysicalDeviceProperties(device->physical, &properties);
@@ -98,7 +98,12 @@ AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8
 
   // support details need to be initialized whenever the swap chain is (re)created, the support details can change on window resize
   AtlrSwapchainSupportDetails supportDetails;
-  atlrInitSwapchainSupportDetails(&supportDetails, device->instance, device->physical);
+  if (!atlrInitSwapchainSupportDetails(&supportDetails, device->instance, device->physical))
+  {
+    ATLR_ERROR_MSG("atlrInitSwapchainSupportDetails returned 0.");
+    atlrDeinitSwapchainSupportDetails(&supportDetails);
+    return 0;
+  }
   const VkExtent2D extent = getExtent(&supportDetails.capabilities, device->instance);
   const VkSurfaceFormatKHR surfaceFormat = getSurfaceFormat(supportDetails.formats, supportDetails.formatCount);
   const VkPresentModeKHR presentMode = getPresetMode(supportDetails.presentModes, supportDetails.presentModeCount);
@@ -151,6 +156,7 @@ AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8
   if (vkCreateSwapchainKHR(device->logical, &swapchainInfo, device->instance->allocator, &swapchain->swapchain) != VK_SUCCESS)
   {
     ATLR_ERROR_MSG("vkCreateSwapchainKHR did not return VK_SUCCESS.");
+    atlrDeinitSwapchainSupportDetails(&supportDetails);
     return 0;
   }
   swapchain->format = surfaceFormat.format;
@@ -172,7 +178,7 @@ AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8
   VkImageView* imageViews = malloc(imageCount * sizeof(VkImageView));
   for (AtlrU32 i = 0; i < imageCount; i++)
   {
-    VkImageView imageView = atlrInitImageView(images[i], VK_IMAGE_VIEW_TYPE_2D, surfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1, device);
+    VkImageView imageView = atlrInitImageView(images[i], VK_IMAGE_VIEW_TYPE_2D, surfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, device);
     if (imageView == VK_NULL_HANDLE)
     {
       ATLR_ERROR_MSG("atlrInitImageView returned VK_NULL_HANDLE.");
@@ -200,7 +206,7 @@ AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8
   // color image for multisample anti-aliasing 
   const VkImageUsageFlags colorUsage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
   const VkImageAspectFlags colorAspect =  VK_IMAGE_ASPECT_COLOR_BIT;
-  if(!atlrInitImage(&swapchain->colorImage, extent.width, extent.height, 1, device->msaaSamples, swapchain->format, tiling, colorUsage, memoryProperties, viewType, colorAspect, device))
+  if(!atlrInitImage(&swapchain->colorImage, extent.width, extent.height, 1, 1, device->msaaSamples, swapchain->format, tiling, colorUsage, memoryProperties, viewType, colorAspect, device))
   {
     ATLR_ERROR_MSG("atlrInitImage returned 0.");
     return 0;
@@ -218,7 +224,7 @@ AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8
   }
   const VkImageUsageFlags depthUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
   const VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
-  if (!atlrInitImage(&swapchain->depthImage, extent.width, extent.height, 1, device->msaaSamples, depthFormat, tiling, depthUsage, memoryProperties, viewType, depthAspect, device))
+  if (!atlrInitImage(&swapchain->depthImage, extent.width, extent.height, 1, 1, device->msaaSamples, depthFormat, tiling, depthUsage, memoryProperties, viewType, depthAspect, device))
   {
     ATLR_ERROR_MSG("atlrInitImage returned 0.");
     return 0;
@@ -227,6 +233,14 @@ AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8
   atlrSetImageName(&swapchain->depthImage, "Swapchain Framebuffer Depth Image");
 #endif
 
+  if (swapchain->isDynamicRendering)
+  {
+    // dynamic rendering renders into the image views directly
+    swapchain->framebuffers = NULL;
+    atlrLog(ATLR_LOG_INFO, "Done initializing Antler swapchain.");
+    return 1;
+  }
+
   if (initRenderPass)
   {
     const VkAttachmentDescription colorAttachment = atlrGetColorAttachmentDescription(swapchain->format, device->msaaSamples, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
@@ -242,7 +256,7 @@ AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8
       .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
       .dependencyFlags = 0
     };
-    if (!atlrInitRenderPass(&swapchain->renderPass, 1, &colorAttachment, &colorAttachmentResolve, &clearValue, &depthAttachment, 1, &dependency, device))
+    if (!atlrInitRenderPass(&swapchain->renderPass, 1, &colorAttachment, &colorAttachmentResolve, &swapchain->clearColor, &depthAttachment, 1, &dependency, device))
     {
       ATLR_ERROR_MSG("atlrInitRenderPass returned 0.");
       return 0;
@@ -291,13 +305,51 @@ AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8
   return 1;
 }
 
+AtlrU8 atlrInitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8 initRenderPass, AtlrU8 (*onReinit)(void*), void* reinitData, const VkClearValue* restrict clearColor,
+				 const AtlrDevice* restrict device)
+{
+  swapchain->isDynamicRendering = 0;
+  swapchain->clearColor = clearColor ? *clearColor : (VkClearValue){.color = {.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}};
+  if (!initSwapchain(swapchain, initRenderPass, onReinit, reinitData, device))
+  {
+    ATLR_ERROR_MSG("initSwapchain returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+// No render pass or framebuffers are created; frames are drawn with atlrFrameCommandContextBeginRenderingHostGLFW.
+// Deinitialize with deinitRenderPass set to 0.
+AtlrU8 atlrInitDynamicRenderingSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, AtlrU8 (*onReinit)(void*), void* reinitData, const VkClearValue* restrict clearColor,
+						 const AtlrDevice* restrict device)
+{
+  if (!device->features.dynamicRendering)
+  {
+    ATLR_ERROR_MSG("Dynamic rendering is not enabled on the device.");
+    return 0;
+  }
+  
+  swapchain->isDynamicRendering = 1;
+  swapchain->clearColor = clearColor ? *clearColor : (VkClearValue){.color = {.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}};
+  if (!initSwapchain(swapchain, 0, onReinit, reinitData, device))
+  {
+    ATLR_ERROR_MSG("initSwapchain returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
 void atlrDeinitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain, const AtlrU8 deinitRenderPass)
 { 
   const AtlrDevice* device = swapchain->device;
   atlrLog(ATLR_LOG_INFO, "Deinitializing Antler swapchain in host GLFW mode ...");
 
-  for (AtlrU32 i = 0; i < swapchain->imageCount; i++)
-    vkDestroyFramebuffer(device->logical, swapchain->framebuffers[i], device->instance->allocator);
+  if (!swapchain->isDynamicRendering)
+    for (AtlrU32 i = 0; i < swapchain->imageCount; i++)
+      vkDestroyFramebuffer(device->logical, swapchain->framebuffers[i], device->instance->allocator);
+  free(swapchain->framebuffers);
 
   if (deinitRenderPass)
     atlrDeinitRenderPass(&swapchain->renderPass);
@@ -332,9 +384,9 @@ AtlrU8 atlrReinitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain)
   vkDeviceWaitIdle(device->logical);
   
   atlrDeinitSwapchainHostGLFW(swapchain, 0);
-  if (!atlrInitSwapchainHostGLFW(swapchain, 0, onReinit, reinitData, NULL, device))
+  if (!initSwapchain(swapchain, 0, onReinit, reinitData, device))
   {
-    ATLR_ERROR_MSG("atlrInitSwapchainHostGLFW returned 0.");
+    ATLR_ERROR_MSG("initSwapchain returned 0.");
     return 0;
   }
 
@@ -349,7 +401,7 @@ AtlrU8 atlrReinitSwapchainHostGLFW(AtlrSwapchain* restrict swapchain)
 
 VkResult atlrNextSwapchainImage(const AtlrSwapchain* restrict swapchain, const VkSemaphore imageAvailableSemaphore, AtlrU32* imageIndex)
 {
-  return vkAcquireNextImageKHR(swapchain->device->logical, swapchain->swapchain, UINT64_MAX,
+  return swapchain->device->pfnAcquireNextImage(swapchain->device->logical, swapchain->swapchain, UINT64_MAX,
 			       imageAvailableSemaphore, VK_NULL_HANDLE, imageIndex);
 }
 
@@ -370,7 +422,7 @@ VkResult atlrSwapchainSubmit(const AtlrSwapchain* restrict swapchain, const VkCo
     .pSignalSemaphores = &renderFinishedSemaphore
   };
   
-  return vkQueueSubmit(swapchain->device->graphicsComputeQueue, 1, &submitInfo, fence);
+  return swapchain->device->pfnQueueSubmit(swapchain->device->graphicsComputeQueue, 1, &submitInfo, fence);
 }
 
 VkResult atlrSwapchainPresent(const AtlrSwapchain* restrict swapchain, const VkSemaphore renderFinishedSemaphore, const AtlrU32* restrict imageIndex)
@@ -387,6 +439,6 @@ VkResult atlrSwapchainPresent(const AtlrSwapchain* restrict swapchain, const VkS
     .pResults = NULL
   };
   
-  return vkQueuePresentKHR(swapchain->device->presentQueue, &presentInfo);
+  return swapchain->device->pfnQueuePresent(swapchain->device->presentQueue, &presentInfo);
 }
 #endif
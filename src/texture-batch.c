@@ -0,0 +1,341 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "stb_image.h"
+
+#define MAX_DECODE_THREADS 16
+
+typedef struct _DecodeJob
+{
+  pthread_mutex_t mutex;
+  AtlrU32 nextFile;
+  AtlrU32 fileCount;
+  const char* const* filePaths;
+  const int* widths;
+  const int* heights;
+  const AtlrU64* offsets;
+  AtlrU8* staging;
+  AtlrU8 hasFailed;
+  
+} DecodeJob;
+
+// Each worker takes the next file until none are left and decodes it into its slice of the mapped staging buffer.
+static void* decodeFiles(void* data)
+{
+  DecodeJob* job = data;
+  for (;;)
+  {
+    pthread_mutex_lock(&job->mutex);
+    const AtlrU32 i = job->nextFile++;
+    pthread_mutex_unlock(&job->mutex);
+    if (i >= job->fileCount) break;
+
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load(job->filePaths[i], &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels || width != job->widths[i] || height != job->heights[i])
+    {
+      ATLR_ERROR_MSG("Failed to decode \"%s\".", job->filePaths[i]);
+      stbi_image_free(pixels);
+      pthread_mutex_lock(&job->mutex);
+      job->hasFailed = 1;
+      pthread_mutex_unlock(&job->mutex);
+      continue;
+    }
+    memcpy(job->staging + job->offsets[i], pixels, (AtlrU64)width * height * 4);
+    stbi_image_free(pixels);
+  }
+
+  return NULL;
+}
+
+static AtlrU8 decodeIntoStaging(DecodeJob* restrict job)
+{
+  long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+  if (threadCount < 1) threadCount = 1;
+  if (threadCount > MAX_DECODE_THREADS) threadCount = MAX_DECODE_THREADS;
+  if (threadCount > (long)job->fileCount) threadCount = job->fileCount;
+
+  // the calling thread decodes too, and covers everything if no worker could be started
+  pthread_t threads[MAX_DECODE_THREADS];
+  AtlrU32 startedCount = 0;
+  for (long i = 1; i < threadCount; i++)
+  {
+    if (pthread_create(threads + startedCount, NULL, decodeFiles, job))
+    {
+      atlrLog(ATLR_LOG_WARN, "pthread_create failed; decoding continues with %u worker threads.", startedCount + 1);
+      break;
+    }
+    startedCount++;
+  }
+  decodeFiles(job);
+  for (AtlrU32 i = 0; i < startedCount; i++)
+    pthread_join(threads[i], NULL);
+
+  return !job->hasFailed;
+}
+
+static AtlrU8 initTimestampQueryPool(VkQueryPool* restrict queryPool, float* restrict timestampPeriod, const AtlrDevice* restrict device)
+{
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device->physical, &properties);
+  if (!properties.limits.timestampComputeAndGraphics) return 0;
+  *timestampPeriod = properties.limits.timestampPeriod;
+
+  const VkQueryPoolCreateInfo queryPoolInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .queryType = VK_QUERY_TYPE_TIMESTAMP,
+    .queryCount = 3,
+    .pipelineStatistics = 0
+  };
+  return vkCreateQueryPool(device->logical, &queryPoolInfo, device->instance->allocator, queryPool) == VK_SUCCESS;
+}
+
+// Record the transitions, copies and mip generation of every texture into one command buffer.
+// Timestamps, when supported, bracket the copies and the whole recording.
+static void recordUploads(const VkCommandBuffer commandBuffer, const AtlrU32 fileCount, const AtlrImage* restrict images, const AtlrBuffer* restrict stagingBuffer,
+			  const AtlrU64* restrict offsets, const VkQueryPool queryPool, const AtlrDevice* restrict device)
+{
+  if (queryPool != VK_NULL_HANDLE)
+  {
+    device->pfnCmdResetQueryPool(commandBuffer, queryPool, 0, 3);
+    device->pfnCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+  }
+
+  for (AtlrU32 i = 0; i < fileCount; i++)
+  {
+    const VkImageSubresourceRange range =
+    {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = 0,
+      .levelCount = images[i].mipLevels,
+      .baseArrayLayer = 0,
+      .layerCount = 1
+    };
+    atlrCommandImageLayoutBarrier(commandBuffer, images[i].image, &range, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, images[i].device);
+  }
+
+  for (AtlrU32 i = 0; i < fileCount; i++)
+  {
+    const VkBufferImageCopy copyRegion =
+    {
+      .bufferOffset = offsets[i],
+      .bufferRowLength = 0,
+      .bufferImageHeight = 0,
+      .imageSubresource = (VkImageSubresourceLayers)
+      {
+	.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	.mipLevel = 0,
+	.baseArrayLayer = 0,
+	.layerCount = 1
+      },
+      .imageOffset = (VkOffset3D){.x = 0, .y = 0, .z = 0},
+      .imageExtent = (VkExtent3D){.width = images[i].width, .height = images[i].height, .depth = 1}
+    };
+    images[i].device->pfnCmdCopyBufferToImage(commandBuffer, stagingBuffer->buffer, images[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+  }
+
+  if (queryPool != VK_NULL_HANDLE)
+    device->pfnCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, queryPool, 1);
+
+  for (AtlrU32 i = 0; i < fileCount; i++)
+  {
+    const AtlrImage* image = images + i;
+    if (image->mipLevels > 1)
+      atlrCommandGenerateMipmapsBlit(commandBuffer, image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    else
+    {
+      const VkImageSubresourceRange range =
+      {
+	.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	.baseMipLevel = 0,
+	.levelCount = 1,
+	.baseArrayLayer = 0,
+	.layerCount = 1
+      };
+      atlrCommandImageLayoutBarrier(commandBuffer, image->image, &range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, image->device);
+    }
+  }
+
+  if (queryPool != VK_NULL_HANDLE)
+    device->pfnCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 2);
+}
+
+// Load a batch of RGBA textures. The files are decoded on a pool of worker threads, each writing into its own slice of one mapped staging buffer,
+// then every transition, copy and mip blit is recorded into a single submission. The textures are resident when this returns.
+// Mips are only generated when the device can blit the texture format; otherwise the textures keep a single level.
+// The timings may be NULL; the device timings are 0 when the queue does not support timestamps.
+AtlrU8 atlrInitImageRgbaTexturesFromFiles(AtlrImage* restrict images, const AtlrU32 fileCount, const char* const* filePaths, const AtlrU8 hasMips,
+					  AtlrTextureBatchTimings* restrict timings, const AtlrDevice* restrict device,
+					  const AtlrSingleRecordCommandContext* restrict commandContext)
+{
+  if (timings)
+  {
+    AtlrTextureBatchTimings temp = {};
+    *timings = temp;
+  }
+  if (!fileCount) return 1;
+
+  const VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+  const AtlrU8 isMipmapped = hasMips && atlrIsMipmapBlitSupported(device->physical, format);
+  if (hasMips && !isMipmapped)
+    atlrLog(ATLR_LOG_WARN, "The device cannot blit the texture format; the batch is loaded without mips.");
+
+  // the headers are read up front so that every texture has its place in the staging buffer before decoding starts
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device->physical, &properties);
+  const AtlrU64 alignment = (properties.limits.optimalBufferCopyOffsetAlignment > 4) ? properties.limits.optimalBufferCopyOffsetAlignment : 4;
+  int* widths = malloc(fileCount * sizeof(int));
+  int* heights = malloc(fileCount * sizeof(int));
+  AtlrU64* offsets = malloc(fileCount * sizeof(AtlrU64));
+  AtlrU64 size = 0;
+  for (AtlrU32 i = 0; i < fileCount; i++)
+  {
+    int channels;
+    if (!stbi_info(filePaths[i], widths + i, heights + i, &channels))
+    {
+      ATLR_ERROR_MSG("stbi_info failed on \"%s\".", filePaths[i]);
+      free(widths);
+      free(heights);
+      free(offsets);
+      return 0;
+    }
+    offsets[i] = (size + alignment - 1) / alignment * alignment;
+    size = offsets[i] + (AtlrU64)widths[i] * heights[i] * 4;
+  }
+
+  AtlrBuffer stagingBuffer;
+  if (!atlrInitStagingBuffer(&stagingBuffer, size, device))
+  {
+    ATLR_ERROR_MSG("atlrInitStagingBuffer returned 0.");
+    free(widths);
+    free(heights);
+    free(offsets);
+    return 0;
+  }
+  if (!atlrMapBuffer(&stagingBuffer, 0, size, 0))
+  {
+    ATLR_ERROR_MSG("atlrMapBuffer returned 0.");
+    atlrDeinitBuffer(&stagingBuffer);
+    free(widths);
+    free(heights);
+    free(offsets);
+    return 0;
+  }
+
+  DecodeJob job =
+  {
+    .nextFile = 0,
+    .fileCount = fileCount,
+    .filePaths = filePaths,
+    .widths = widths,
+    .heights = heights,
+    .offsets = offsets,
+    .staging = stagingBuffer.data,
+    .hasFailed = 0
+  };
+  pthread_mutex_init(&job.mutex, NULL);
+  const AtlrU64 decodeStart = atlrGetTimeNanoseconds();
+  const AtlrU8 isDecoded = decodeIntoStaging(&job);
+  const AtlrU64 decodeEnd = atlrGetTimeNanoseconds();
+  pthread_mutex_destroy(&job.mutex);
+  atlrUnmapBuffer(&stagingBuffer);
+  if (!isDecoded)
+  {
+    ATLR_ERROR_MSG("decodeIntoStaging returned 0.");
+    atlrDeinitBuffer(&stagingBuffer);
+    free(widths);
+    free(heights);
+    free(offsets);
+    return 0;
+  }
+  if (timings) timings->decodeNanoseconds = decodeEnd - decodeStart;
+
+  const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (isMipmapped ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+  for (AtlrU32 i = 0; i < fileCount; i++)
+  {
+    const AtlrU32 mipLevels = isMipmapped ? atlrGetMipLevelCount(widths[i], heights[i]) : 1;
+    if (!atlrInitImage(images + i, widths[i], heights[i], mipLevels, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage,
+		       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, device))
+    {
+      ATLR_ERROR_MSG("atlrInitImage returned 0.");
+      for (AtlrU32 j = 0; j < i; j++)
+	atlrDeinitImage(images + j);
+      atlrDeinitBuffer(&stagingBuffer);
+      free(widths);
+      free(heights);
+      free(offsets);
+      return 0;
+    }
+  }
+  free(widths);
+  free(heights);
+
+  VkQueryPool queryPool = VK_NULL_HANDLE;
+  float timestampPeriod = 0.0f;
+  if (timings && !initTimestampQueryPool(&queryPool, &timestampPeriod, device))
+    queryPool = VK_NULL_HANDLE;
+
+  VkCommandBuffer commandBuffer;
+  if (!atlrBeginSingleRecordCommands(&commandBuffer, commandContext))
+  {
+    ATLR_ERROR_MSG("atlrBeginSingleRecordCommands returned 0.");
+    if (queryPool != VK_NULL_HANDLE) vkDestroyQueryPool(device->logical, queryPool, device->instance->allocator);
+    for (AtlrU32 i = 0; i < fileCount; i++)
+      atlrDeinitImage(images + i);
+    atlrDeinitBuffer(&stagingBuffer);
+    free(offsets);
+    return 0;
+  }
+  recordUploads(commandBuffer, fileCount, images, &stagingBuffer, offsets, queryPool, device);
+  free(offsets);
+  const AtlrU8 isUploaded = atlrEndSingleRecordCommands(commandBuffer, commandContext);
+  atlrDeinitBuffer(&stagingBuffer);
+
+  if (queryPool != VK_NULL_HANDLE)
+  {
+    AtlrU64 timestamps[3];
+    if (isUploaded && vkGetQueryPoolResults(device->logical, queryPool, 0, 3, sizeof(timestamps), timestamps, sizeof(AtlrU64),
+					    VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) == VK_SUCCESS)
+    {
+      timings->copyNanoseconds = (AtlrU64)((timestamps[1] - timestamps[0]) * timestampPeriod);
+      timings->gpuNanoseconds = (AtlrU64)((timestamps[2] - timestamps[0]) * timestampPeriod);
+    }
+    vkDestroyQueryPool(device->logical, queryPool, device->instance->allocator);
+  }
+
+  if (!isUploaded)
+  {
+    ATLR_ERROR_MSG("atlrEndSingleRecordCommands returned 0.");
+    for (AtlrU32 i = 0; i < fileCount; i++)
+      atlrDeinitImage(images + i);
+    return 0;
+  }
+
+  return 1;
+}
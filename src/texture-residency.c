@@ -0,0 +1,521 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+#include "antler.h"
+
+// levels no larger than this form the mip tail that stays resident for as long as the texture exists
+#define TAIL_EXTENT 64
+
+// the share of the reported device local budget that may be filled, leaving headroom for the driver and new allocations
+#define BUDGET_FRACTION 0.9
+
+// a 2D image has at most one level per bit of its extent
+#define MAX_LEVEL_COUNT 32
+
+// resident levels are copied out of the image they are replacing, so every image can be a transfer source
+#define IMAGE_USAGE (VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT)
+
+static AtlrU32 getLevelExtent(const AtlrU32 extent, const AtlrU32 level)
+{
+  const AtlrU32 levelExtent = extent >> level;
+  return levelExtent ? levelExtent : 1;
+}
+
+// The device memory an image holding the levels from the given one to the end of the mip chain takes, found without allocating it.
+// Every size the residency counts comes from here, so the budget compares like with like.
+static AtlrU8 getLevelsImageSize(AtlrU64* restrict size, const AtlrKtx2File* restrict ktx2, const AtlrU32 level, const AtlrDevice* restrict device)
+{
+  const VkImageCreateInfo imageInfo =
+  {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0,
+    .imageType = VK_IMAGE_TYPE_2D,
+    .format = ktx2->format,
+    .extent = (VkExtent3D)
+    {
+      .width = getLevelExtent(ktx2->width, level),
+      .height = getLevelExtent(ktx2->height, level),
+      .depth = 1
+    },
+    .mipLevels = ktx2->levelCount - level,
+    .arrayLayers = 1,
+    .samples = VK_SAMPLE_COUNT_1_BIT,
+    .tiling = VK_IMAGE_TILING_OPTIMAL,
+    .usage = IMAGE_USAGE,
+    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    .queueFamilyIndexCount = 0,
+    .pQueueFamilyIndices = NULL,
+    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+  };
+  VkImage image;
+  if (vkCreateImage(device->logical, &imageInfo, device->instance->allocator, &image) != VK_SUCCESS)
+  {
+    ATLR_ERROR_MSG("vkCreateImage did not return VK_SUCCESS.");
+    return 0;
+  }
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements(device->logical, image, &requirements);
+  vkDestroyImage(device->logical, image, device->instance->allocator);
+  *size = requirements.size;
+
+  return 1;
+}
+
+// Room for a retired texture is made before anything that may need retiring is created, so retiring itself cannot fail.
+static AtlrU8 reserveRetired(AtlrTextureResidency* restrict residency)
+{
+  if (residency->retiredCount < residency->retiredCapacity) return 1;
+
+  const AtlrU32 retiredCapacity = residency->retiredCapacity ? 2 * residency->retiredCapacity : 8;
+  AtlrRetiredTexture* retired = realloc(residency->retired, retiredCapacity * sizeof(AtlrRetiredTexture));
+  if (!retired)
+  {
+    ATLR_ERROR_MSG("realloc returned NULL.");
+    return 0;
+  }
+  residency->retiredCapacity = retiredCapacity;
+  residency->retired = retired;
+
+  return 1;
+}
+
+// Any of the image, its size, the staging buffer and the handle may be missing; the image is counted against the budget until it is released.
+// Room must have been reserved with reserveRetired.
+static void retire(AtlrTextureResidency* restrict residency, const AtlrImage* restrict image, const AtlrU64 size, const AtlrBuffer* restrict stagingBuffer,
+		   const AtlrU8 hasHandle, const AtlrU32 handle)
+{
+  AtlrRetiredTexture* retired = residency->retired + residency->retiredCount++;
+  retired->hasImage = image != NULL;
+  if (image) retired->image = *image;
+  retired->size = image ? size : 0;
+  retired->hasStagingBuffer = stagingBuffer != NULL;
+  if (stagingBuffer) retired->stagingBuffer = *stagingBuffer;
+  retired->hasHandle = hasHandle;
+  retired->handle = handle;
+  retired->frame = residency->frame;
+  residency->retiredSize += retired->size;
+}
+
+static void releaseRetired(AtlrTextureResidency* restrict residency, const AtlrU8 isAll)
+{
+  AtlrU32 keptCount = 0;
+  for (AtlrU32 i = 0; i < residency->retiredCount; i++)
+  {
+    const AtlrRetiredTexture* retired = residency->retired + i;
+    if (isAll || retired->frame + residency->framesInFlight <= residency->frame)
+    {
+      if (retired->hasImage) atlrDeinitImage(&retired->image);
+      if (retired->hasStagingBuffer) atlrDeinitBuffer(&retired->stagingBuffer);
+      if (retired->hasHandle) atlrBindlessTableRemoveImage(residency->table, retired->handle);
+      residency->retiredSize -= retired->size;
+    }
+    else
+      residency->retired[keptCount++] = *retired;
+  }
+  residency->retiredCount = keptCount;
+}
+
+// Point the texture at new resident levels, or back at its mip tail when the image is NULL.
+// Frames in flight may still sample through the old handle, so a new handle is taken and the old one is retired along with the old image
+// and the staging buffer the new levels were uploaded from.
+static AtlrU8 replaceResidentImage(AtlrTextureResidency* restrict residency, AtlrStreamedTexture* restrict texture, const AtlrImage* restrict image,
+				   const AtlrBuffer* restrict stagingBuffer, const AtlrU32 level, const AtlrU64 size)
+{
+  AtlrU32 handle;
+  if (!atlrBindlessTableAddImage(residency->table, &handle, image ? image : &texture->tail, residency->sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL))
+  {
+    ATLR_ERROR_MSG("atlrBindlessTableAddImage returned 0.");
+    return 0;
+  }
+
+  retire(residency, texture->isStreamed ? &texture->image : NULL, texture->residentSize, stagingBuffer, 1, texture->handle);
+  residency->residentSize -= texture->residentSize;
+  texture->handle = handle;
+  texture->isStreamed = image != NULL;
+  if (image) texture->image = *image;
+  texture->residentLevel = level;
+  texture->residentSize = size;
+  residency->residentSize += size;
+
+  return 1;
+}
+
+// Record a new image holding the levels from the given one to the end of the mip chain into the command buffer and make it the texture's,
+// or fall back to the mip tail at the tail level. Levels the resident image already holds are copied on the device,
+// so only the finer levels are read from the file.
+static AtlrU8 changeResidentLevel(AtlrTextureResidency* restrict residency, AtlrStreamedTexture* restrict texture, const AtlrU32 level,
+				  const VkCommandBuffer commandBuffer)
+{
+  // at most one texture is retired whether or not the change succeeds
+  if (!reserveRetired(residency))
+  {
+    ATLR_ERROR_MSG("reserveRetired returned 0.");
+    return 0;
+  }
+  if (level == texture->tailLevel) return replaceResidentImage(residency, texture, NULL, NULL, level, 0);
+
+  const AtlrDevice* device = residency->device;
+  const AtlrKtx2File* ktx2 = &texture->ktx2;
+  const AtlrImage* residentImage = texture->isStreamed ? &texture->image : &texture->tail;
+  const AtlrU32 residentLevel = texture->residentLevel;
+  const AtlrU32 levelCount = ktx2->levelCount - level;
+  AtlrImage image;
+  if (!atlrInitImage(&image, getLevelExtent(ktx2->width, level), getLevelExtent(ktx2->height, level), levelCount, 1, VK_SAMPLE_COUNT_1_BIT,
+		     ktx2->format, VK_IMAGE_TILING_OPTIMAL, IMAGE_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, device))
+  {
+    ATLR_ERROR_MSG("atlrInitImage returned 0.");
+    return 0;
+  }
+
+  // the levels both images hold
+  const AtlrU32 copiedLevel = (level > residentLevel) ? level : residentLevel;
+  const AtlrU32 copiedCount = ktx2->levelCount - copiedLevel;
+  const VkImageSubresourceRange range =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = levelCount,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  const VkImageSubresourceRange residentRange =
+  {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = copiedLevel - residentLevel,
+    .levelCount = copiedCount,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+  VkImageCopy regions[MAX_LEVEL_COUNT];
+  for (AtlrU32 i = 0; i < copiedCount; i++)
+  {
+    const AtlrU32 copyLevel = copiedLevel + i;
+    regions[i] = (VkImageCopy)
+    {
+      .srcSubresource = (VkImageSubresourceLayers)
+      {
+	.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	.mipLevel = copyLevel - residentLevel,
+	.baseArrayLayer = 0,
+	.layerCount = 1
+      },
+      .srcOffset = (VkOffset3D){.x = 0, .y = 0, .z = 0},
+      .dstSubresource = (VkImageSubresourceLayers)
+      {
+	.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	.mipLevel = copyLevel - level,
+	.baseArrayLayer = 0,
+	.layerCount = 1
+      },
+      .dstOffset = (VkOffset3D){.x = 0, .y = 0, .z = 0},
+      .extent = (VkExtent3D)
+      {
+	.width = getLevelExtent(ktx2->width, copyLevel),
+	.height = getLevelExtent(ktx2->height, copyLevel),
+	.depth = 1
+      }
+    };
+  }
+
+  // the resident image goes back to being shader readable, since the tail is sampled again whenever the texture is evicted
+  atlrCommandImageLayoutBarrier(commandBuffer, image.image, &range, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, device);
+  atlrCommandImageLayoutBarrier(commandBuffer, residentImage->image, &residentRange,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, device);
+  device->pfnCmdCopyImage(commandBuffer, residentImage->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			  copiedCount, regions);
+  atlrCommandImageLayoutBarrier(commandBuffer, residentImage->image, &residentRange,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, device);
+
+  // the command buffer already refers to the new image, so from here on it is retired rather than destroyed on failure
+  AtlrBuffer stagingBuffer;
+  const AtlrU8 hasStagingBuffer = level < residentLevel;
+  if (hasStagingBuffer && !atlrCommandCopyKtx2Levels(commandBuffer, &stagingBuffer, &image, level, ktx2, level, residentLevel))
+  {
+    ATLR_ERROR_MSG("atlrCommandCopyKtx2Levels returned 0.");
+    retire(residency, &image, texture->levelSizes[level], NULL, 0, 0);
+    return 0;
+  }
+  atlrCommandImageLayoutBarrier(commandBuffer, image.image, &range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, device);
+
+  const AtlrBuffer* retiredStagingBuffer = hasStagingBuffer ? &stagingBuffer : NULL;
+  if (!replaceResidentImage(residency, texture, &image, retiredStagingBuffer, level, texture->levelSizes[level]))
+  {
+    ATLR_ERROR_MSG("replaceResidentImage returned 0.");
+    retire(residency, &image, texture->levelSizes[level], retiredStagingBuffer, 0, 0);
+    return 0;
+  }
+
+  return 1;
+}
+
+// Drop the resident mips that have gone unused the longest, among those not used this frame. The finest resident level of each texture
+// is its least recently used one, and the levels last used in the same frame as it are dropped along with it.
+static AtlrU8 evictLeastRecentlyUsed(AtlrTextureResidency* restrict residency, const VkCommandBuffer commandBuffer)
+{
+  AtlrStreamedTexture* victim = NULL;
+  AtlrU64 victimFrame = 0;
+  for (AtlrU32 i = 0; i < residency->count; i++)
+  {
+    AtlrStreamedTexture* texture = residency->textures + i;
+    if (!texture->isStreamed) continue;
+    const AtlrU64 usedFrame = texture->levelUsedFrames[texture->residentLevel];
+    if (usedFrame < residency->frame && (!victim || usedFrame < victimFrame))
+    {
+      victim = texture;
+      victimFrame = usedFrame;
+    }
+  }
+  if (!victim) return 0;
+
+  AtlrU32 level = victim->residentLevel + 1;
+  while (level < victim->tailLevel && victim->levelUsedFrames[level] <= victimFrame) level++;
+  return changeResidentLevel(residency, victim, level, commandBuffer);
+}
+
+// The streamed levels are held to the residency budget, and further to what the device reports is left of its local memory budget.
+static AtlrU64 getStreamingLimit(const AtlrTextureResidency* restrict residency)
+{
+  AtlrU64 budget, usage;
+  if (!atlrGetDeviceLocalMemoryBudget(&budget, &usage, residency->device)) return residency->budget;
+
+  // memory held by anything else stays put, the streamed levels may grow into the rest
+  const AtlrU64 streamedSize = residency->residentSize + residency->retiredSize;
+  const AtlrU64 usableBudget = (AtlrU64)(BUDGET_FRACTION * budget);
+  const AtlrU64 otherUsage = (usage > streamedSize) ? usage - streamedSize : 0;
+  const AtlrU64 available = (usableBudget > otherUsage) ? usableBudget - otherUsage : 0;
+  return (available < residency->budget) ? available : residency->budget;
+}
+
+// Streamed levels are held within the budget in bytes of device memory, not counting the mip tails but counting replaced images
+// until they are released, and at most uploadLimit bytes are read from the files per update.
+// Retired images and handles are released framesInFlight updates later, so the table needs spare image handles for them.
+AtlrU8 atlrInitTextureResidency(AtlrTextureResidency* restrict residency, const AtlrU32 capacity, const AtlrU64 budget, const AtlrU64 uploadLimit,
+				const AtlrU32 framesInFlight, AtlrBindlessTable* restrict table, const AtlrSingleRecordCommandContext* restrict commandContext,
+				const AtlrDevice* restrict device)
+{
+  residency->device = device;
+  residency->table = table;
+  residency->commandContext = commandContext;
+  residency->budget = budget;
+  residency->uploadLimit = uploadLimit;
+  residency->residentSize = 0;
+  residency->retiredSize = 0;
+  residency->frame = 0;
+  residency->framesInFlight = framesInFlight;
+
+  const VkSamplerCreateInfo samplerInfo = atlrInitSamplerInfo(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT);
+  residency->sampler = atlrAcquireSampler(device, &samplerInfo);
+  if (residency->sampler == VK_NULL_HANDLE)
+  {
+    ATLR_ERROR_MSG("atlrAcquireSampler returned VK_NULL_HANDLE.");
+    return 0;
+  }
+
+  residency->capacity = capacity;
+  residency->count = 0;
+  residency->textures = malloc(capacity * sizeof(AtlrStreamedTexture));
+  if (!residency->textures)
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    atlrReleaseSampler(device, residency->sampler);
+    return 0;
+  }
+  residency->retiredCapacity = 0;
+  residency->retiredCount = 0;
+  residency->retired = NULL;
+
+  if (!device->features.memoryBudget)
+    atlrLog(ATLR_LOG_INFO, "The memory budget feature is not enabled; texture streaming is bounded by its own budget only.");
+
+  return 1;
+}
+
+// the device must be idle
+void atlrDeinitTextureResidency(AtlrTextureResidency* restrict residency)
+{
+  releaseRetired(residency, 1);
+  for (AtlrU32 i = 0; i < residency->count; i++)
+  {
+    AtlrStreamedTexture* texture = residency->textures + i;
+    atlrBindlessTableRemoveImage(residency->table, texture->handle);
+    if (texture->isStreamed) atlrDeinitImage(&texture->image);
+    atlrDeinitImage(&texture->tail);
+    atlrDeinitKtx2File(&texture->ktx2);
+    free(texture->levelSizes);
+    free(texture->levelUsedFrames);
+  }
+  free(residency->retired);
+  free(residency->textures);
+  atlrReleaseSampler(residency->device, residency->sampler);
+}
+
+// Only the mip tail is loaded now, waiting on the device; finer levels follow as they are requested.
+AtlrU8 atlrAddStreamedTexture(AtlrTextureResidency* restrict residency, AtlrU32* restrict index, const char* restrict filePath)
+{
+  if (residency->count == residency->capacity)
+  {
+    ATLR_ERROR_MSG("The texture residency is full.");
+    return 0;
+  }
+
+  AtlrStreamedTexture* texture = residency->textures + residency->count;
+  AtlrKtx2File* ktx2 = &texture->ktx2;
+  if (!atlrInitKtx2File(ktx2, filePath))
+  {
+    ATLR_ERROR_MSG("atlrInitKtx2File returned 0.");
+    return 0;
+  }
+  if (!atlrIsCompressedFormatSupported(ktx2->format, residency->device))
+  {
+    ATLR_ERROR_MSG("The format of the KTX2 file \"%s\" is not supported by the device.", filePath);
+    atlrDeinitKtx2File(ktx2);
+    return 0;
+  }
+
+  AtlrU32 tailLevel = 0;
+  while (tailLevel + 1 < ktx2->levelCount && ((ktx2->width >> tailLevel) > TAIL_EXTENT || (ktx2->height >> tailLevel) > TAIL_EXTENT))
+    tailLevel++;
+  texture->levelSizes = malloc(tailLevel * sizeof(AtlrU64));
+  texture->levelUsedFrames = malloc(tailLevel * sizeof(AtlrU64));
+  if (tailLevel && (!texture->levelSizes || !texture->levelUsedFrames))
+  {
+    ATLR_ERROR_MSG("malloc returned NULL.");
+    free(texture->levelSizes);
+    free(texture->levelUsedFrames);
+    atlrDeinitKtx2File(ktx2);
+    return 0;
+  }
+  for (AtlrU32 i = 0; i < tailLevel; i++)
+  {
+    if (!getLevelsImageSize(texture->levelSizes + i, ktx2, i, residency->device))
+    {
+      ATLR_ERROR_MSG("getLevelsImageSize returned 0.");
+      free(texture->levelSizes);
+      free(texture->levelUsedFrames);
+      atlrDeinitKtx2File(ktx2);
+      return 0;
+    }
+    texture->levelUsedFrames[i] = residency->frame;
+  }
+  if (!atlrInitImageKtx2Levels(&texture->tail, ktx2, tailLevel, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, residency->device, residency->commandContext))
+  {
+    ATLR_ERROR_MSG("atlrInitImageKtx2Levels returned 0.");
+    free(texture->levelSizes);
+    free(texture->levelUsedFrames);
+    atlrDeinitKtx2File(ktx2);
+    return 0;
+  }
+  if (!atlrBindlessTableAddImage(residency->table, &texture->handle, &texture->tail, residency->sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL))
+  {
+    ATLR_ERROR_MSG("atlrBindlessTableAddImage returned 0.");
+    atlrDeinitImage(&texture->tail);
+    free(texture->levelSizes);
+    free(texture->levelUsedFrames);
+    atlrDeinitKtx2File(ktx2);
+    return 0;
+  }
+
+  texture->tailLevel = tailLevel;
+  texture->isStreamed = 0;
+  texture->residentLevel = tailLevel;
+  texture->residentSize = 0;
+  texture->requestedLevel = tailLevel;
+  texture->lastUsedFrame = residency->frame;
+  *index = residency->count++;
+
+  return 1;
+}
+
+// Mark the texture as used this frame down to the given level, counted in levels of the full texture; the finest level requested in a frame wins.
+void atlrRequestStreamedTextureLevel(AtlrTextureResidency* restrict residency, const AtlrU32 index, const AtlrU32 level)
+{
+  AtlrStreamedTexture* texture = residency->textures + index;
+  const AtlrU32 clampedLevel = (level < texture->tailLevel) ? level : texture->tailLevel;
+  if (texture->lastUsedFrame != residency->frame || clampedLevel < texture->requestedLevel)
+    texture->requestedLevel = clampedLevel;
+  texture->lastUsedFrame = residency->frame;
+  for (AtlrU32 i = clampedLevel; i < texture->tailLevel; i++)
+    texture->levelUsedFrames[i] = residency->frame;
+}
+
+// The handle changes as levels stream in and out, so read it again every frame after the update.
+AtlrU32 atlrGetStreamedTextureHandle(const AtlrTextureResidency* restrict residency, const AtlrU32 index)
+{
+  return residency->textures[index].handle;
+}
+
+// Call once per frame with the frame's command buffer being recorded, after waiting on the frame's fence and before recording draws that use the handles.
+// Images no frame in flight can use anymore are released, then the textures requested this frame are streamed in, those missing the most levels first.
+// Mips not used this frame are evicted least recently used first to stay within budget; if that is not enough, coarser levels are loaded instead.
+// Every upload and copy is recorded into the command buffer, so nothing here waits on the device.
+AtlrU8 atlrUpdateTextureResidency(AtlrTextureResidency* restrict residency, const VkCommandBuffer commandBuffer)
+{
+  releaseRetired(residency, 0);
+  const AtlrU64 limit = getStreamingLimit(residency);
+
+  // the limit can shrink when other allocations grow, so even without requests memory may have to be given back
+  while (residency->residentSize > limit && evictLeastRecentlyUsed(residency, commandBuffer));
+
+  AtlrU64 uploadedSize = 0;
+  for (;;)
+  {
+    AtlrStreamedTexture* texture = NULL;
+    for (AtlrU32 i = 0; i < residency->count; i++)
+    {
+      AtlrStreamedTexture* candidate = residency->textures + i;
+      if (candidate->lastUsedFrame != residency->frame || candidate->requestedLevel >= candidate->residentLevel) continue;
+      if (!texture || candidate->residentLevel - candidate->requestedLevel > texture->residentLevel - texture->requestedLevel)
+	texture = candidate;
+    }
+    if (!texture) break;
+
+    // only the levels finer than the resident ones are read from the file
+    const AtlrU64 residentUploadSize = atlrGetKtx2LevelsSize(&texture->ktx2, texture->residentLevel);
+    AtlrU32 level = texture->requestedLevel;
+    if (uploadedSize && uploadedSize + atlrGetKtx2LevelsSize(&texture->ktx2, level) - residentUploadSize > residency->uploadLimit) break;
+
+    while (level < texture->residentLevel && residency->residentSize - texture->residentSize + texture->levelSizes[level] > limit)
+    {
+      if (evictLeastRecentlyUsed(residency, commandBuffer)) continue;
+      level++;
+    }
+
+    // the request is settled for this frame whether or not anything finer fits
+    texture->requestedLevel = texture->residentLevel;
+    if (level >= texture->residentLevel) continue;
+
+    // the replaced image lives on for the frames in flight, so the new one has to fit alongside every retired image as well;
+    // otherwise the request is left for a later frame, once they are released
+    if (residency->residentSize + residency->retiredSize + texture->levelSizes[level] > limit) continue;
+
+    const AtlrU64 uploadSize = atlrGetKtx2LevelsSize(&texture->ktx2, level) - residentUploadSize;
+    if (!changeResidentLevel(residency, texture, level, commandBuffer))
+    {
+      atlrLog(ATLR_LOG_WARN, "Streamed texture %u failed to load finer levels; it keeps its resident levels.", (AtlrU32)(texture - residency->textures));
+      continue;
+    }
+    uploadedSize += uploadSize;
+  }
+
+  residency->frame++;
+  return 1;
+}
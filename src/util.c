@@ -20,6 +20,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "antler.h"
 #include <glslang/Public/resource_limits_c.h>
+#include <stdio.h>
+#include <time.h>
 
 float atlrClampFloat(const float x, const float min, const float max)
 {
@@ -57,7 +59,7 @@ AtlrU8 atlrAlign(AtlrU64* aligned, const AtlrU64 offset, const AtlrU64 alignment
     return 1;
   }
   
-  AtlrU8 isPowerofTwo = alignment & (alignment - 1);
+  AtlrU8 isPowerofTwo = !(alignment & (alignment - 1));
   if (!isPowerofTwo)
   {
     ATLR_ERROR_MSG("align must be zero or a power of two.");
@@ -159,7 +161,61 @@ AtlrU8 atlrInitSpirVBinary(AtlrSpirVBinary* restrict bin, glslang_stage_t stage,
   return 1;
 }
 
+// reads precompiled SPIR-V, such as the output of glslangValidator
+AtlrU8 atlrInitSpirVBinaryFromFile(AtlrSpirVBinary* restrict bin, const char* restrict path)
+{
+  FILE* file = fopen(path, "rb");
+  if (!file)
+  {
+    ATLR_ERROR_MSG("Failed to open file at path \"%s\".", path);
+    return 0;
+  }
+  fseek(file, 0, SEEK_END);
+  const long int codeSize = ftell(file);
+  rewind(file);
+  if ((codeSize <= 0) || (codeSize % sizeof(AtlrU32)))
+  {
+    ATLR_ERROR_MSG("File at path \"%s\" is not a SPIR-V binary.", path);
+    fclose(file);
+    return 0;
+  }
+
+  bin->codeSize = codeSize;
+  bin->code = malloc(codeSize);
+  const size_t readCount = fread(bin->code, codeSize, 1, file);
+  fclose(file);
+  if (readCount != 1)
+  {
+    ATLR_ERROR_MSG("Failed to read file at path \"%s\".", path);
+    free(bin->code);
+    return 0;
+  }
+
+  return 1;
+}
+
 void atlrDeinitSpirVBinary(AtlrSpirVBinary* restrict bin)
 {
   free(bin->code);
 }
+
+// 64-bit FNV-1a; start from ATLR_HASH_SEED and pass the result back in to hash several pieces of data as one
+AtlrU64 atlrHash(const void* restrict data, const AtlrU64 size, const AtlrU64 hash)
+{
+  const AtlrU8* bytes = data;
+  AtlrU64 result = hash;
+  for (AtlrU64 i = 0; i < size; i++)
+  {
+    result ^= bytes[i];
+    result *= 0x100000001b3ULL;
+  }
+  return result;
+}
+
+// monotonic clock for timing host-side work
+AtlrU64 atlrGetTimeNanoseconds()
+{
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (AtlrU64)time.tv_sec * 1000000000 + (AtlrU64)time.tv_nsec;
+}
@@ -0,0 +1,259 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+
+#include "../../src/antler.h"
+#include "../../src/offscreen-canvas.h"
+
+// Runs headless frames through the descriptor allocator and canvas readback paths and fails if either reaches the heap once warmed up.
+// The GLFW frame command context, its deletion queue and the ImGui context need a window, so they are not covered here.
+// The executable is linked with --wrap for the allocation functions, so every call from the test and the statically linked library
+// is counted here; the driver's own allocations are not.
+// Each frame gets a descriptor set from a per-slot descriptor allocator, renders to an offscreen canvas and is read back without blocking.
+#define SLOT_COUNT 3
+#define WARM_UP_FRAME_COUNT 16
+#define FRAME_COUNT 256
+
+// the return code CTest reports as skipped, for machines without a usable Vulkan device
+#define SKIP_RETURN_CODE 77
+
+void* __real_malloc(size_t);
+void* __real_calloc(size_t, size_t);
+void* __real_realloc(void*, size_t);
+int __real_posix_memalign(void**, size_t, size_t);
+
+static AtlrU8 isCounting = 0;
+static AtlrU64 allocationCount = 0;
+
+void* __wrap_malloc(size_t size)
+{
+  if (isCounting) allocationCount++;
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+  if (isCounting) allocationCount++;
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* data, size_t size)
+{
+  if (isCounting) allocationCount++;
+  return __real_realloc(data, size);
+}
+
+int __wrap_posix_memalign(void** data, size_t alignment, size_t size)
+{
+  if (isCounting) allocationCount++;
+  return __real_posix_memalign(data, alignment, size);
+}
+
+static AtlrInstance instance;
+static AtlrDevice device;
+static AtlrOffscreenCanvas canvas;
+static AtlrCanvasReadback readback;
+static AtlrDescriptorSetLayout setLayout;
+static AtlrDescriptorAllocator descriptorAllocators[SLOT_COUNT];
+static AtlrBuffer uniformBuffer;
+static AtlrU64 deliveredCount = 0;
+
+static void onFrame(const AtlrCanvasReadbackFrame* restrict frame, void* userData)
+{
+  deliveredCount++;
+}
+
+static AtlrU8 initFrameAllocations()
+{
+  if (!atlrInitInstanceHostHeadless(&instance, "Frame Allocations Test", NULL))
+  {
+    ATLR_ERROR_MSG("atlrInitInstanceHostHeadless returned 0.");
+    return 0;
+  }
+
+  AtlrDeviceCriteria deviceCriteria;
+  atlrInitDeviceCriteria(deviceCriteria);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_QUEUE_FAMILY_GRAPHICS_SUPPORT,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  atlrSetDeviceCriterion(deviceCriteria,
+			 ATLR_DEVICE_CRITERION_DYNAMIC_RENDERING,
+			 ATLR_DEVICE_CRITERION_METHOD_REQUIRED,
+			 0);
+  if (!atlrInitDeviceHost(&device, &instance, deviceCriteria))
+  {
+    ATLR_ERROR_MSG("atlrInitDeviceHost returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static AtlrU8 initFrameResources()
+{
+  const VkExtent2D extent = {.width = 256, .height = 256};
+  if (!atlrInitDynamicRenderingOffscreenCanvas(&canvas, &extent, VK_FORMAT_R8G8B8A8_UNORM, NULL, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDynamicRenderingOffscreenCanvas returned 0.");
+    return 0;
+  }
+  if (!atlrInitCanvasReadback(&readback, &canvas, SLOT_COUNT, 0, onFrame, NULL))
+  {
+    ATLR_ERROR_MSG("atlrInitCanvasReadback returned 0.");
+    return 0;
+  }
+
+  const VkDescriptorSetLayoutBinding binding = atlrInitDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
+  if (!atlrInitDescriptorSetLayout(&setLayout, 1, &binding, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitDescriptorSetLayout returned 0.");
+    return 0;
+  }
+  const VkDescriptorPoolSize poolSizeRatio = atlrInitDescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1);
+  for (AtlrU32 i = 0; i < SLOT_COUNT; i++)
+  {
+    if (!atlrInitDescriptorAllocator(descriptorAllocators + i, 4, 1, &poolSizeRatio, &device))
+    {
+      ATLR_ERROR_MSG("atlrInitDescriptorAllocator returned 0.");
+      return 0;
+    }
+  }
+  if (!atlrInitBuffer(&uniformBuffer, 256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &device))
+  {
+    ATLR_ERROR_MSG("atlrInitBuffer returned 0.");
+    return 0;
+  }
+
+  return 1;
+}
+
+static void deinitFrameAllocations()
+{
+  vkDeviceWaitIdle(device.logical);
+
+  atlrDeinitBuffer(&uniformBuffer);
+  for (AtlrU32 i = 0; i < SLOT_COUNT; i++)
+    atlrDeinitDescriptorAllocator(descriptorAllocators + i);
+  atlrDeinitDescriptorSetLayout(&setLayout);
+  atlrDeinitCanvasReadback(&readback);
+  atlrDeinitOffscreenCanvas(&canvas, 0);
+  atlrDeinitDeviceHost(&device);
+  atlrDeinitInstanceHostHeadless(&instance);
+}
+
+// A slot's previous frame has finished once its command buffer is handed out again, so the slot's descriptor allocator can be reset then.
+static AtlrU8 runFrame()
+{
+  const VkCommandBuffer commandBuffer = atlrBeginCanvasReadbackFrame(&readback);
+  if (!commandBuffer)
+  {
+    ATLR_ERROR_MSG("atlrBeginCanvasReadbackFrame returned VK_NULL_HANDLE.");
+    return 0;
+  }
+
+  AtlrDescriptorAllocator* descriptorAllocator = descriptorAllocators + readback.head;
+  if (!atlrResetDescriptorAllocator(descriptorAllocator))
+  {
+    ATLR_ERROR_MSG("atlrResetDescriptorAllocator returned 0.");
+    return 0;
+  }
+  const VkDescriptorBufferInfo bufferInfo = atlrInitDescriptorBufferInfo(&uniformBuffer, 256);
+  const VkWriteDescriptorSet write = atlrWriteBufferDescriptorSet(VK_NULL_HANDLE, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &bufferInfo);
+  VkDescriptorSet set;
+  if (!atlrDescriptorAllocatorGetSet(descriptorAllocator, setLayout.layout, 1, &write, &set))
+  {
+    ATLR_ERROR_MSG("atlrDescriptorAllocatorGetSet returned 0.");
+    return 0;
+  }
+
+  if (!atlrOffscreenCanvasBeginRendering(&canvas, commandBuffer) || !atlrOffscreenCanvasEndRendering(&canvas, commandBuffer))
+  {
+    ATLR_ERROR_MSG("Failed to record the canvas rendering.");
+    return 0;
+  }
+  if (!atlrEndCanvasReadbackFrame(&readback))
+  {
+    ATLR_ERROR_MSG("atlrEndCanvasReadbackFrame returned 0.");
+    return 0;
+  }
+  atlrPollCanvasReadback(&readback);
+
+  return 1;
+}
+
+int main()
+{
+  if (!initFrameAllocations())
+  {
+    atlrLog(ATLR_LOG_WARN, "No usable Vulkan device; skipping the frame allocations test.");
+    return SKIP_RETURN_CODE;
+  }
+  if (!initFrameResources())
+  {
+    ATLR_FATAL_MSG("initFrameResources returned 0.");
+    return -1;
+  }
+
+  // the first frames size the descriptor pools and caches, which may allocate
+  for (AtlrU32 i = 0; i < WARM_UP_FRAME_COUNT; i++)
+  {
+    if (!runFrame())
+    {
+      ATLR_FATAL_MSG("runFrame returned 0.");
+      return -1;
+    }
+  }
+
+  isCounting = 1;
+  for (AtlrU32 i = 0; i < FRAME_COUNT; i++)
+  {
+    if (!runFrame())
+    {
+      isCounting = 0;
+      ATLR_FATAL_MSG("runFrame returned 0.");
+      return -1;
+    }
+  }
+  isCounting = 0;
+
+  if (!atlrFlushCanvasReadback(&readback))
+  {
+    ATLR_FATAL_MSG("atlrFlushCanvasReadback returned 0.");
+    return -1;
+  }
+  const AtlrU64 deliveredFrameCount = deliveredCount;
+  deinitFrameAllocations();
+
+  if (deliveredFrameCount != WARM_UP_FRAME_COUNT + FRAME_COUNT)
+  {
+    ATLR_FATAL_MSG("Only %llu of %u frames were read back.", (unsigned long long)deliveredFrameCount, WARM_UP_FRAME_COUNT + FRAME_COUNT);
+    return -1;
+  }
+  if (allocationCount)
+  {
+    ATLR_FATAL_MSG("%llu heap allocations over %u frames after warm up; expected none.", (unsigned long long)allocationCount, FRAME_COUNT);
+    return -1;
+  }
+  atlrLog(ATLR_LOG_INFO, "No heap allocations over %u frames after warm up.", FRAME_COUNT);
+  return 0;
+}
@@ -0,0 +1,359 @@
+/*
+
+This file is part of antler.
+Copyright (C) 2024 Taylor Wampler 
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  
+*/
+
+
+// Convert a PNG or JPG image to a block-compressed KTX2 texture with a full mip chain, ready for atlrInitImageKtx2TextureFromFiles.
+// The mips are box filtered, in linear space for sRGB textures, and every level is compressed with stb_dxt.
+
+#include "../../src/antler.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// stb_image is compiled into the antler library
+#include "stb_image.h"
+#define STB_DXT_IMPLEMENTATION
+#include "stb_dxt.h"
+
+typedef enum
+{
+  BLOCK_FORMAT_BC1,
+  BLOCK_FORMAT_BC3,
+  BLOCK_FORMAT_BC5
+  
+} BlockFormat;
+
+// data format descriptor values from the Khronos Data Format Specification
+#define DF_MODEL_BC1A 128
+#define DF_MODEL_BC3 130
+#define DF_MODEL_BC5 132
+#define DF_PRIMARIES_BT709 1
+#define DF_TRANSFER_LINEAR 1
+#define DF_TRANSFER_SRGB 2
+#define DF_CHANNEL_COLOR 0
+#define DF_CHANNEL_RED 0
+#define DF_CHANNEL_GREEN 1
+#define DF_CHANNEL_ALPHA 15
+#define DF_SAMPLE_LINEAR 0x10
+
+static const AtlrU8 ktx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+static const char ktx2Writer[] = "KTXwriter\0antler ktx2-convert";
+
+static float srgbToLinear(const float x)
+{
+  return (x <= 0.04045f) ? x / 12.92f : powf((x + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgb(const float x)
+{
+  return (x <= 0.0031308f) ? 12.92f * x : 1.055f * powf(x, 1.0f / 2.4f) - 0.055f;
+}
+
+static AtlrU32 getLevelExtent(const AtlrU32 extent, const AtlrU32 level)
+{
+  const AtlrU32 levelExtent = extent >> level;
+  return levelExtent ? levelExtent : 1;
+}
+
+// average 2x2 texels of the previous level, clamping the last row and column of odd extents
+static void downsample(float* restrict dst, const float* restrict src, const AtlrU32 srcWidth, const AtlrU32 srcHeight)
+{
+  const AtlrU32 dstWidth = (srcWidth > 1) ? srcWidth / 2 : 1;
+  const AtlrU32 dstHeight = (srcHeight > 1) ? srcHeight / 2 : 1;
+  for (AtlrU32 y = 0; y < dstHeight; y++)
+    for (AtlrU32 x = 0; x < dstWidth; x++)
+    {
+      const AtlrU32 x0 = 2 * x < srcWidth ? 2 * x : srcWidth - 1;
+      const AtlrU32 x1 = 2 * x + 1 < srcWidth ? 2 * x + 1 : srcWidth - 1;
+      const AtlrU32 y0 = 2 * y < srcHeight ? 2 * y : srcHeight - 1;
+      const AtlrU32 y1 = 2 * y + 1 < srcHeight ? 2 * y + 1 : srcHeight - 1;
+      for (AtlrU32 c = 0; c < 4; c++)
+	dst[4 * (y * dstWidth + x) + c] = 0.25f * (src[4 * (y0 * srcWidth + x0) + c] + src[4 * (y0 * srcWidth + x1) + c]
+						   + src[4 * (y1 * srcWidth + x0) + c] + src[4 * (y1 * srcWidth + x1) + c]);
+    }
+}
+
+static AtlrU8 toUnorm8(const float x)
+{
+  const float clamped = atlrClampFloat(x, 0.0f, 1.0f);
+  return (AtlrU8)(255.0f * clamped + 0.5f);
+}
+
+// compress one level, reading 4x4 blocks with the texels past the right and bottom edges clamped
+static void compressLevel(AtlrU8* restrict dst, const float* restrict texels, const AtlrU32 width, const AtlrU32 height,
+			  const BlockFormat blockFormat, const AtlrU8 isSrgb)
+{
+  const AtlrU32 blockSize = (blockFormat == BLOCK_FORMAT_BC1) ? 8 : 16;
+  for (AtlrU32 by = 0; by < height; by += 4)
+    for (AtlrU32 bx = 0; bx < width; bx += 4)
+    {
+      AtlrU8 block[64];
+      for (AtlrU32 j = 0; j < 4; j++)
+	for (AtlrU32 i = 0; i < 4; i++)
+	{
+	  const AtlrU32 x = (bx + i < width) ? bx + i : width - 1;
+	  const AtlrU32 y = (by + j < height) ? by + j : height - 1;
+	  const float* texel = texels + 4 * (y * width + x);
+	  AtlrU8* blockTexel = block + 4 * (4 * j + i);
+	  for (AtlrU32 c = 0; c < 3; c++)
+	    blockTexel[c] = toUnorm8(isSrgb ? linearToSrgb(texel[c]) : texel[c]);
+	  blockTexel[3] = toUnorm8(texel[3]);
+	}
+
+      switch (blockFormat)
+      {
+        case BLOCK_FORMAT_BC1:
+	  stb_compress_dxt_block(dst, block, 0, STB_DXT_HIGHQUAL);
+	  break;
+        case BLOCK_FORMAT_BC3:
+	  stb_compress_dxt_block(dst, block, 1, STB_DXT_HIGHQUAL);
+	  break;
+        case BLOCK_FORMAT_BC5:
+	{
+	  AtlrU8 redGreen[32];
+	  for (AtlrU32 i = 0; i < 16; i++)
+	  {
+	    redGreen[2 * i] = block[4 * i];
+	    redGreen[2 * i + 1] = block[4 * i + 1];
+	  }
+	  stb_compress_bc5_block(dst, redGreen);
+	  break;
+	}
+      }
+      dst += blockSize;
+    }
+}
+
+static void writeU32(FILE* file, const AtlrU32 x)
+{
+  fwrite(&x, sizeof(AtlrU32), 1, file);
+}
+
+static void writeU64(FILE* file, const AtlrU64 x)
+{
+  fwrite(&x, sizeof(AtlrU64), 1, file);
+}
+
+static void writeSample(FILE* file, const AtlrU32 bitOffset, const AtlrU32 channelType)
+{
+  writeU32(file, bitOffset | (63 << 16) | (channelType << 24));
+  writeU32(file, 0);
+  writeU32(file, 0);
+  writeU32(file, 0xFFFFFFFF);
+}
+
+static AtlrU8 writeKtx2(const char* restrict filePath, const VkFormat format, const BlockFormat blockFormat, const AtlrU8 isSrgb,
+			const AtlrU32 width, const AtlrU32 height, const AtlrU32 levelCount, AtlrU8* const* levels, const AtlrU64* restrict levelSizes)
+{
+  FILE* file = fopen(filePath, "wb");
+  if (!file)
+  {
+    ATLR_ERROR_MSG("Failed to open \"%s\" for writing.", filePath);
+    return 0;
+  }
+
+  const AtlrU32 blockSize = (blockFormat == BLOCK_FORMAT_BC1) ? 8 : 16;
+  const AtlrU32 sampleCount = (blockFormat == BLOCK_FORMAT_BC1) ? 1 : 2;
+  const AtlrU32 dfdOffset = 80 + 24 * levelCount;
+  const AtlrU32 dfdLength = 4 + 24 + 16 * sampleCount;
+  const AtlrU32 kvdOffset = dfdOffset + dfdLength;
+  const AtlrU32 kvdEntryLength = sizeof(ktx2Writer);
+  const AtlrU32 kvdLength = (4 + kvdEntryLength + 3) & ~3u;
+
+  // levels are stored smallest first, each aligned to the block size
+  AtlrU64 levelOffsets[32];
+  AtlrU64 offset = kvdOffset + kvdLength;
+  for (AtlrI32 i = levelCount - 1; i >= 0; i--)
+  {
+    offset = (offset + blockSize - 1) / blockSize * blockSize;
+    levelOffsets[i] = offset;
+    offset += levelSizes[i];
+  }
+
+  // header and index
+  fwrite(ktx2Identifier, 1, sizeof(ktx2Identifier), file);
+  writeU32(file, format);
+  writeU32(file, 1);
+  writeU32(file, width);
+  writeU32(file, height);
+  writeU32(file, 0);
+  writeU32(file, 0);
+  writeU32(file, 1);
+  writeU32(file, levelCount);
+  writeU32(file, 0);
+  writeU32(file, dfdOffset);
+  writeU32(file, dfdLength);
+  writeU32(file, kvdOffset);
+  writeU32(file, kvdLength);
+  writeU64(file, 0);
+  writeU64(file, 0);
+  for (AtlrU32 i = 0; i < levelCount; i++)
+  {
+    writeU64(file, levelOffsets[i]);
+    writeU64(file, levelSizes[i]);
+    writeU64(file, levelSizes[i]);
+  }
+
+  // data format descriptor with a single basic block
+  const AtlrU32 model = (blockFormat == BLOCK_FORMAT_BC1) ? DF_MODEL_BC1A : (blockFormat == BLOCK_FORMAT_BC3) ? DF_MODEL_BC3 : DF_MODEL_BC5;
+  const AtlrU32 transfer = isSrgb ? DF_TRANSFER_SRGB : DF_TRANSFER_LINEAR;
+  writeU32(file, dfdLength);
+  writeU32(file, 0);
+  writeU32(file, 2 | ((dfdLength - 4) << 16));
+  writeU32(file, model | (DF_PRIMARIES_BT709 << 8) | (transfer << 16));
+  writeU32(file, 3 | (3 << 8));
+  writeU32(file, blockSize);
+  writeU32(file, 0);
+  switch (blockFormat)
+  {
+    case BLOCK_FORMAT_BC1:
+      writeSample(file, 0, DF_CHANNEL_COLOR);
+      break;
+    case BLOCK_FORMAT_BC3:
+      writeSample(file, 0, DF_CHANNEL_ALPHA | (isSrgb ? DF_SAMPLE_LINEAR : 0));
+      writeSample(file, 64, DF_CHANNEL_COLOR);
+      break;
+    case BLOCK_FORMAT_BC5:
+      writeSample(file, 0, DF_CHANNEL_RED);
+      writeSample(file, 64, DF_CHANNEL_GREEN);
+      break;
+  }
+
+  // key value data naming the writer
+  const AtlrU8 padding[16] = {};
+  writeU32(file, kvdEntryLength);
+  fwrite(ktx2Writer, 1, kvdEntryLength, file);
+  fwrite(padding, 1, kvdLength - 4 - kvdEntryLength, file);
+
+  AtlrU64 position = kvdOffset + kvdLength;
+  for (AtlrI32 i = levelCount - 1; i >= 0; i--)
+  {
+    fwrite(padding, 1, levelOffsets[i] - position, file);
+    fwrite(levels[i], 1, levelSizes[i], file);
+    position = levelOffsets[i] + levelSizes[i];
+  }
+
+  if (ferror(file))
+  {
+    ATLR_ERROR_MSG("Failed to write \"%s\".", filePath);
+    fclose(file);
+    return 0;
+  }
+  fclose(file);
+
+  return 1;
+}
+
+static AtlrU8 convert(const char* restrict inputPath, const char* restrict outputPath, const BlockFormat blockFormat, const AtlrU8 isSrgb)
+{
+  int width, height, channels;
+  stbi_uc* pixels = stbi_load(inputPath, &width, &height, &channels, STBI_rgb_alpha);
+  if (!pixels)
+  {
+    ATLR_ERROR_MSG("stbi_load returned NULL.");
+    return 0;
+  }
+
+  VkFormat format;
+  switch (blockFormat)
+  {
+    case BLOCK_FORMAT_BC1: format = isSrgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK; break;
+    case BLOCK_FORMAT_BC3: format = isSrgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK; break;
+    default:               format = VK_FORMAT_BC5_UNORM_BLOCK; break;
+  }
+  const AtlrU32 blockSize = atlrGetCompressedFormatBlockSize(format);
+  const AtlrU32 levelCount = atlrGetMipLevelCount(width, height);
+
+  // the mip chain is filtered in floating point, in linear space for sRGB textures
+  float* texels = malloc(4 * width * height * sizeof(float));
+  float* nextTexels = malloc(4 * width * height * sizeof(float));
+  for (AtlrU32 i = 0; i < 4 * (AtlrU32)(width * height); i++)
+  {
+    const float x = pixels[i] / 255.0f;
+    texels[i] = (isSrgb && i % 4 != 3) ? srgbToLinear(x) : x;
+  }
+  stbi_image_free(pixels);
+
+  AtlrU8* levels[32];
+  AtlrU64 levelSizes[32];
+  AtlrU64 uncompressedSize = 0;
+  AtlrU64 compressedSize = 0;
+  for (AtlrU32 i = 0; i < levelCount; i++)
+  {
+    const AtlrU32 levelWidth = getLevelExtent(width, i);
+    const AtlrU32 levelHeight = getLevelExtent(height, i);
+    if (i)
+    {
+      downsample(nextTexels, texels, getLevelExtent(width, i - 1), getLevelExtent(height, i - 1));
+      float* temp = texels;
+      texels = nextTexels;
+      nextTexels = temp;
+    }
+
+    levelSizes[i] = (AtlrU64)((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize;
+    levels[i] = malloc(levelSizes[i]);
+    compressLevel(levels[i], texels, levelWidth, levelHeight, blockFormat, isSrgb);
+    uncompressedSize += (AtlrU64)4 * levelWidth * levelHeight;
+    compressedSize += levelSizes[i];
+  }
+  free(texels);
+  free(nextTexels);
+
+  const AtlrU8 isWritten = writeKtx2(outputPath, format, blockFormat, isSrgb, width, height, levelCount, levels, levelSizes);
+  for (AtlrU32 i = 0; i < levelCount; i++)
+    free(levels[i]);
+  if (!isWritten)
+  {
+    ATLR_ERROR_MSG("writeKtx2 returned 0.");
+    return 0;
+  }
+
+  atlrLog(ATLR_LOG_INFO, "Wrote \"%s\": %ux%u, %u levels, %llu bytes against %llu bytes of RGBA8.",
+	  outputPath, width, height, levelCount, (unsigned long long)compressedSize, (unsigned long long)uncompressedSize);
+  return 1;
+}
+
+int main(int argc, char* argv[])
+{
+  const AtlrU8 isSrgb = (argc == 5) && !strcmp(argv[4], "-srgb");
+  if (argc != 4 && !isSrgb)
+  {
+    ATLR_FATAL_MSG("Usage: %s <input-image-path> <output-ktx2-path> <bc1|bc3|bc5> [-srgb]\n-srgb marks color textures; it does not apply to bc5.", argv[0]);
+    return -1;
+  }
+
+  BlockFormat blockFormat;
+  if (!strcmp(argv[3], "bc1"))      blockFormat = BLOCK_FORMAT_BC1;
+  else if (!strcmp(argv[3], "bc3")) blockFormat = BLOCK_FORMAT_BC3;
+  else if (!strcmp(argv[3], "bc5") && !isSrgb) blockFormat = BLOCK_FORMAT_BC5;
+  else
+  {
+    ATLR_FATAL_MSG("Unknown block format \"%s\"; expected bc1, bc3 or bc5 (bc5 without -srgb).", argv[3]);
+    return -1;
+  }
+
+  if (!convert(argv[1], argv[2], blockFormat, isSrgb))
+  {
+    ATLR_FATAL_MSG("convert returned 0.");
+    return -1;
+  }
+
+  return 0;
+}